@@ -48,6 +48,20 @@ private:
     return data{any_};
   }
 
+  [[nodiscard]] caf::expected<data> save() const override {
+    return data{any_};
+  }
+
+  [[nodiscard]] caf::error merge(const data& state) override {
+    if (caf::holds_alternative<caf::none_t>(state))
+      return {};
+    const auto* other = caf::get_if<bool>(&state);
+    if (!other)
+      return make_state_error(state);
+    any_ = any_.value_or(false) || *other;
+    return {};
+  }
+
   std::optional<bool> any_ = {};
 };
 
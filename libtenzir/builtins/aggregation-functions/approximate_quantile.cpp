@@ -0,0 +1,215 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2024 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <tenzir/aggregation_function.hpp>
+#include <tenzir/plugin.hpp>
+#include <tenzir/tdigest.hpp>
+
+#include <cmath>
+#include <optional>
+#include <vector>
+
+namespace tenzir::plugins::approximate_quantile {
+
+namespace {
+
+template <basic_type Type>
+class approximate_quantile_function final : public aggregation_function {
+public:
+  approximate_quantile_function(type input_type, double quantile) noexcept
+    : aggregation_function(std::move(input_type)),
+      quantile_{quantile},
+      tdigest_{} {
+    // nop
+  }
+
+private:
+  auto output_type() const -> type override {
+    return input_type();
+  }
+
+  auto add(const data_view& view) -> void override {
+    using view_type = tenzir::view<type_to_data_t<Type>>;
+    if (caf::holds_alternative<caf::none_t>(view)) {
+      return;
+    }
+    const auto x = static_cast<double>(caf::get<view_type>(view));
+    if constexpr (std::is_same_v<Type, double_type>) {
+      if (std::isnan(x)) {
+        return;
+      }
+    }
+    tdigest_.add(x);
+  }
+
+  auto add(const arrow::Array& array) -> void override {
+    const auto& typed_array = caf::get<type_to_arrow_array_t<Type>>(array);
+    for (auto&& value : values(Type{}, typed_array)) {
+      if (not value) {
+        continue;
+      }
+      if constexpr (std::is_same_v<Type, double_type>) {
+        if (std::isnan(*value)) {
+          continue;
+        }
+      }
+      tdigest_.add(static_cast<double>(*value));
+    }
+  }
+
+  auto finish() && -> caf::expected<data> override {
+    if (tdigest_.empty()) {
+      return data{};
+    }
+    return data{
+      static_cast<type_to_data_t<Type>>(tdigest_.quantile(quantile_))};
+  }
+
+  auto save() const -> caf::expected<data> override {
+    if (tdigest_.empty()) {
+      return data{};
+    }
+    auto digest = tdigest_;
+    auto centroids = list{};
+    for (const auto& centroid : digest.centroids()) {
+      centroids.emplace_back(list{centroid.mean, centroid.weight});
+    }
+    return record{
+      {"min", digest.min()},
+      {"max", digest.max()},
+      {"centroids", std::move(centroids)},
+    };
+  }
+
+  auto merge(const data& state) -> caf::error override {
+    if (caf::holds_alternative<caf::none_t>(state)) {
+      return {};
+    }
+    const auto* other = caf::get_if<record>(&state);
+    if (not other) {
+      return make_state_error(state);
+    }
+    const auto* min = get_if<double>(other, "min");
+    const auto* max = get_if<double>(other, "max");
+    const auto* centroids = get_if<list>(other, "centroids");
+    if (not min or not max or not centroids) {
+      return make_state_error(state);
+    }
+    auto result = std::vector<tdigest::centroid>{};
+    result.reserve(centroids->size());
+    for (const auto& centroid : *centroids) {
+      const auto* pair = caf::get_if<list>(&centroid);
+      if (not pair or pair->size() != 2
+          or not caf::holds_alternative<double>((*pair)[0])
+          or not caf::holds_alternative<double>((*pair)[1])) {
+        return make_state_error(state);
+      }
+      result.push_back({caf::get<double>((*pair)[0]),
+                        caf::get<double>((*pair)[1])});
+    }
+    tdigest_.merge(result, *min, *max);
+    return {};
+  }
+
+  double quantile_;
+  tdigest tdigest_;
+};
+
+/// Instantiates the aggregation function for an input type.
+auto make_function(const type& input_type, double quantile)
+  -> caf::expected<std::unique_ptr<aggregation_function>> {
+  auto f = detail::overload{
+    [&](const uint64_type&)
+      -> caf::expected<std::unique_ptr<aggregation_function>> {
+      return std::make_unique<approximate_quantile_function<uint64_type>>(
+        input_type, quantile);
+    },
+    [&](const int64_type&)
+      -> caf::expected<std::unique_ptr<aggregation_function>> {
+      return std::make_unique<approximate_quantile_function<int64_type>>(
+        input_type, quantile);
+    },
+    [&](const double_type&)
+      -> caf::expected<std::unique_ptr<aggregation_function>> {
+      return std::make_unique<approximate_quantile_function<double_type>>(
+        input_type, quantile);
+    },
+    [](const concrete_type auto& type)
+      -> caf::expected<std::unique_ptr<aggregation_function>> {
+      return caf::make_error(ec::invalid_configuration,
+                             fmt::format("approximate quantile aggregation "
+                                         "functions do not support type {}",
+                                         type));
+    },
+  };
+  return caf::visit(f, input_type);
+}
+
+class approximate_median_plugin : public virtual aggregation_function_plugin {
+  auto name() const -> std::string override {
+    return "approximate_median";
+  };
+
+  auto make_aggregation_function(const type& input_type) const
+    -> caf::expected<std::unique_ptr<aggregation_function>> override {
+    return make_function(input_type, 0.5);
+  }
+
+  auto aggregation_default() const -> data override {
+    return caf::none;
+  }
+};
+
+class approximate_quantile_plugin : public virtual aggregation_function_plugin {
+  auto name() const -> std::string override {
+    return "approximate_quantile";
+  };
+
+  auto make_aggregation_function(const type& input_type) const
+    -> caf::expected<std::unique_ptr<aggregation_function>> override {
+    (void)input_type;
+    return caf::make_error(ec::invalid_argument,
+                           "approximate_quantile aggregation function "
+                           "requires a quantile argument, e.g., "
+                           "`approximate_quantile(x, 0.99)`");
+  }
+
+  auto make_aggregation_function_with_argument(const type& input_type,
+                                               const data& argument) const
+    -> caf::expected<std::unique_ptr<aggregation_function>> override {
+    auto quantile = std::optional<double>{};
+    if (const auto* x = caf::get_if<double>(&argument)) {
+      quantile = *x;
+    } else if (const auto* x = caf::get_if<int64_t>(&argument)) {
+      quantile = static_cast<double>(*x);
+    } else if (const auto* x = caf::get_if<uint64_t>(&argument)) {
+      quantile = static_cast<double>(*x);
+    }
+    if (not quantile or not(*quantile >= 0.0 and *quantile <= 1.0)) {
+      return caf::make_error(ec::invalid_argument,
+                             fmt::format("approximate_quantile aggregation "
+                                         "function requires a quantile "
+                                         "between 0 and 1, but got `{}`",
+                                         argument));
+    }
+    return make_function(input_type, *quantile);
+  }
+
+  auto aggregation_default() const -> data override {
+    return caf::none;
+  }
+};
+
+} // namespace
+
+} // namespace tenzir::plugins::approximate_quantile
+
+TENZIR_REGISTER_PLUGIN(
+  tenzir::plugins::approximate_quantile::approximate_median_plugin)
+TENZIR_REGISTER_PLUGIN(
+  tenzir::plugins::approximate_quantile::approximate_quantile_plugin)
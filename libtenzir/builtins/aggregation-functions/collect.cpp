@@ -31,7 +31,8 @@ private:
     if (caf::holds_alternative<caf::none_t>(view)) {
       return;
     }
-    result_.push_back(materialize(caf::get<view_type>(view)));
+    payload_ += heap_memusage(
+      result_.emplace_back(materialize(caf::get<view_type>(view))));
   }
 
   auto add(const arrow::Array& array) -> void override {
@@ -42,7 +43,7 @@ private:
       if (not value) {
         continue;
       }
-      result_.push_back(materialize(*value));
+      payload_ += heap_memusage(result_.emplace_back(materialize(*value)));
     }
   }
 
@@ -50,7 +51,41 @@ private:
     return data{std::exchange(result_, {})};
   }
 
+  auto save() const -> caf::expected<data> override {
+    return data{result_};
+  }
+
+  auto merge(const data& state) -> caf::error override {
+    const auto* other = caf::get_if<list>(&state);
+    if (not other) {
+      return make_state_error(state);
+    }
+    result_.insert(result_.end(), other->begin(), other->end());
+    for (const auto& value : *other) {
+      payload_ += heap_memusage(value);
+    }
+    return {};
+  }
+
+  auto merge_instance(const aggregation_function& other)
+    -> caf::error override {
+    const auto* that = dynamic_cast<const collect_function*>(&other);
+    if (not that) {
+      return aggregation_function::merge_instance(other);
+    }
+    result_.insert(result_.end(), that->result_.begin(), that->result_.end());
+    payload_ += that->payload_;
+    return {};
+  }
+
+  auto memusage() const -> size_t override {
+    return result_.capacity() * sizeof(data) + payload_;
+  }
+
   list result_ = {};
+
+  /// The heap memory owned by the collected values.
+  size_t payload_ = {};
 };
 
 class plugin : public virtual aggregation_function_plugin {
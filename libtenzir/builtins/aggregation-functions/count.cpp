@@ -38,10 +38,33 @@ private:
     count_ += array.length() - array.null_count();
   }
 
+  void add(const arrow::Array& array,
+           std::span<const int64_t> selection) override {
+    if (array.null_count() == 0) {
+      count_ += selection.size();
+      return;
+    }
+    for (auto row : selection) {
+      count_ += array.IsValid(row) ? 1 : 0;
+    }
+  }
+
   [[nodiscard]] caf::expected<data> finish() && override {
     return count_;
   }
 
+  [[nodiscard]] caf::expected<data> save() const override {
+    return count_;
+  }
+
+  [[nodiscard]] caf::error merge(const data& state) override {
+    const auto* other = caf::get_if<uint64_t>(&state);
+    if (!other)
+      return make_state_error(state);
+    count_ += *other;
+    return {};
+  }
+
   uint64_t count_ = {};
 };
 
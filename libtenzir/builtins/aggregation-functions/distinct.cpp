@@ -73,6 +73,7 @@ private:
     if (!distinct_.contains(typed_view)) {
       const auto [it, inserted] = distinct_.insert(materialize(typed_view));
       TENZIR_ASSERT(inserted);
+      payload_ += heap_memusage(*it);
     }
   }
 
@@ -85,9 +86,52 @@ private:
     return data{std::move(result)};
   }
 
+  [[nodiscard]] auto save() const -> caf::expected<data> override {
+    auto result = list{};
+    result.reserve(distinct_.size());
+    for (const auto& value : distinct_)
+      result.emplace_back(value);
+    return data{std::move(result)};
+  }
+
+  [[nodiscard]] auto merge(const data& state) -> caf::error override {
+    const auto* other = caf::get_if<list>(&state);
+    if (!other)
+      return make_state_error(state);
+    for (const auto& value : *other) {
+      const auto* typed_value = caf::get_if<type_to_data_t<Type>>(&value);
+      if (!typed_value)
+        return make_state_error(state);
+      if (const auto [it, inserted] = distinct_.insert(*typed_value);
+          inserted) {
+        payload_ += heap_memusage(*it);
+      }
+    }
+    return {};
+  }
+
+  [[nodiscard]] auto merge_instance(const aggregation_function& other)
+    -> caf::error override {
+    const auto* that = dynamic_cast<const distinct_function*>(&other);
+    if (!that)
+      return aggregation_function::merge_instance(other);
+    for (const auto& value : that->distinct_) {
+      if (const auto [it, inserted] = distinct_.insert(value); inserted)
+        payload_ += heap_memusage(*it);
+    }
+    return {};
+  }
+
+  [[nodiscard]] auto memusage() const -> size_t override {
+    return distinct_.bucket_count() * sizeof(type_to_data_t<Type>) + payload_;
+  }
+
   tsl::robin_set<type_to_data_t<Type>, heterogeneous_data_hash<Type>,
                  heterogeneous_data_equal<Type>>
     distinct_ = {};
+
+  /// The heap memory owned by the distinct values.
+  size_t payload_ = {};
 };
 
 class plugin : public virtual aggregation_function_plugin {
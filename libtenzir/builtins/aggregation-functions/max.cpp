@@ -39,6 +39,21 @@ private:
     return data{max_};
   }
 
+  [[nodiscard]] caf::expected<data> save() const override {
+    return data{max_};
+  }
+
+  [[nodiscard]] caf::error merge(const data& state) override {
+    if (caf::holds_alternative<caf::none_t>(state))
+      return {};
+    const auto* other = caf::get_if<type_to_data_t<Type>>(&state);
+    if (!other)
+      return make_state_error(state);
+    if (!max_ || *other > *max_)
+      max_ = *other;
+    return {};
+  }
+
   std::optional<type_to_data_t<Type>> max_ = {};
 };
 
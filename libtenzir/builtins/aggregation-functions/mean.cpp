@@ -64,6 +64,31 @@ private:
     return data{mean_};
   }
 
+  auto save() const -> caf::expected<data> override {
+    return record{
+      {"count", uint64_t{count_}},
+      {"mean", mean_},
+    };
+  }
+
+  auto merge(const data& state) -> caf::error override {
+    const auto* other = caf::get_if<record>(&state);
+    if (not other) {
+      return make_state_error(state);
+    }
+    const auto* count = get_if<uint64_t>(other, "count");
+    const auto* mean = get_if<double>(other, "mean");
+    if (not count or not mean) {
+      return make_state_error(state);
+    }
+    if (*count == 0) {
+      return {};
+    }
+    count_ += *count;
+    mean_ += (*mean - mean_) * static_cast<double>(*count) / count_;
+    return {};
+  }
+
   double mean_ = {};
   size_t count_ = {};
 };
@@ -47,6 +47,16 @@ private:
     return std::move(sample_);
   }
 
+  [[nodiscard]] caf::expected<data> save() const override {
+    return sample_;
+  }
+
+  [[nodiscard]] caf::error merge(const data& state) override {
+    if (caf::holds_alternative<caf::none_t>(sample_))
+      sample_ = state;
+    return {};
+  }
+
   data sample_ = {};
 };
 
@@ -73,6 +73,35 @@ private:
     return data{mode_ == mode::stddev ? std::sqrt(variance) : variance};
   }
 
+  auto save() const -> caf::expected<data> override {
+    return record{
+      {"count", uint64_t{count_}},
+      {"mean", mean_},
+      {"mean_squared", mean_squared_},
+    };
+  }
+
+  auto merge(const data& state) -> caf::error override {
+    const auto* other = caf::get_if<record>(&state);
+    if (not other) {
+      return make_state_error(state);
+    }
+    const auto* count = get_if<uint64_t>(other, "count");
+    const auto* mean = get_if<double>(other, "mean");
+    const auto* mean_squared = get_if<double>(other, "mean_squared");
+    if (not count or not mean or not mean_squared) {
+      return make_state_error(state);
+    }
+    if (*count == 0) {
+      return {};
+    }
+    count_ += *count;
+    const auto fraction = static_cast<double>(*count) / count_;
+    mean_ += (*mean - mean_) * fraction;
+    mean_squared_ += (*mean_squared - mean_squared_) * fraction;
+    return {};
+  }
+
   double mean_ = {};
   double mean_squared_ = {};
   size_t count_ = {};
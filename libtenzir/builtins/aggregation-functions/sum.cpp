@@ -41,6 +41,23 @@ private:
     return data{sum_};
   }
 
+  [[nodiscard]] caf::expected<data> save() const override {
+    return data{sum_};
+  }
+
+  [[nodiscard]] caf::error merge(const data& state) override {
+    if (caf::holds_alternative<caf::none_t>(state))
+      return {};
+    const auto* other = caf::get_if<type_to_data_t<Type>>(&state);
+    if (!other)
+      return make_state_error(state);
+    if (!sum_)
+      sum_ = *other;
+    else
+      sum_ = *sum_ + *other;
+    return {};
+  }
+
   std::optional<type_to_data_t<Type>> sum_ = {};
 };
 
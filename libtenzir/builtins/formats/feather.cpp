@@ -12,6 +12,7 @@
 #include <tenzir/collect.hpp>
 #include <tenzir/concept/convertible/data.hpp>
 #include <tenzir/data.hpp>
+#include <tenzir/detail/base64.hpp>
 #include <tenzir/detail/narrow.hpp>
 #include <tenzir/error.hpp>
 #include <tenzir/fwd.hpp>
@@ -20,17 +21,17 @@
 #include <tenzir/plugin.hpp>
 #include <tenzir/store.hpp>
 #include <tenzir/table_slice.hpp>
+#include <tenzir/zone_map.hpp>
 
 #include <arrow/io/memory.h>
-#include <arrow/ipc/feather.h>
 #include <arrow/ipc/reader.h>
 #include <arrow/ipc/writer.h>
 #include <arrow/record_batch.h>
-#include <arrow/table.h>
-#include <arrow/util/iterator.h>
+#include <arrow/util/compression.h>
 #include <arrow/util/key_value_metadata.h>
 #include <caf/expected.hpp>
 
+#include <charconv>
 #include <queue>
 
 namespace tenzir::plugins::feather {
@@ -56,39 +57,16 @@ unwrap_record_batch(const std::shared_ptr<arrow::RecordBatch>& rb) {
   return event_rb->ReplaceSchemaMetadata(schema_metadata);
 }
 
-/// Create a constant column for the given import time with `rows` rows
-auto make_import_time_col(const time& import_time, int64_t rows) {
-  auto v = import_time.time_since_epoch().count();
-  auto builder = time_type::make_arrow_builder(arrow::default_memory_pool());
-  if (auto status = builder->Reserve(rows); !status.ok()) {
-    die(fmt::format("make time column failed: '{}'", status.ToString()));
-  }
-  for (int i = 0; i < rows; ++i) {
-    auto status = builder->Append(v);
-    TENZIR_ASSERT(status.ok());
-  }
-  return builder->Finish().ValueOrDie();
-}
+/// The key of the per-batch custom metadata that holds the import time.
+constexpr auto import_time_key = std::string_view{"TENZIR:import_time"};
 
-/// Wrap a record batch into an event envelope containing the event data
-/// as a nested struct alongside metadata as separate columns, containing
-/// the `import_time`.
-auto wrap_record_batch(const table_slice& slice)
-  -> std::shared_ptr<arrow::RecordBatch> {
-  auto rb = to_record_batch(slice);
-  auto event_array = rb->ToStructArray().ValueOrDie();
-  auto time_col = make_import_time_col(slice.import_time(), rb->num_rows());
-  auto schema = arrow::schema(
-    {arrow::field("import_time", time_type::to_arrow_type()),
-     arrow::field("event", event_array->type(), rb->schema()->metadata())});
-  auto new_rb
-    = arrow::RecordBatch::Make(schema, rb->num_rows(), {time_col, event_array});
-  return new_rb;
-}
+/// The key of the footer metadata that holds the zone maps of all record
+/// batches as a Base64-encoded, versioned FlatBuffers table.
+constexpr auto zone_maps_key = std::string_view{"TENZIR:zone_maps"};
 
-/// Decode an Arrow IPC stream incrementally.
-auto decode_ipc_stream(chunk_ptr chunk)
-  -> caf::expected<generator<std::shared_ptr<arrow::RecordBatch>>> {
+/// Open an Apache Feather v2 or Arrow IPC file for random access.
+auto open_ipc_file(chunk_ptr chunk, const arrow::ipc::IpcReadOptions& options)
+  -> caf::expected<std::shared_ptr<arrow::ipc::RecordBatchFileReader>> {
   // See arrow::ipc::internal::kArrowMagicBytes in
   // arrow/ipc/metadata_internal.h.
   static constexpr auto arrow_magic_bytes = std::string_view{"ARROW1"};
@@ -99,87 +77,106 @@ auto decode_ipc_stream(chunk_ptr chunk)
     return caf::make_error(ec::format_error, "not an Apache Feather v1 or "
                                              "Arrow IPC file");
   }
-  auto open_reader_result
-    = arrow::ipc::RecordBatchFileReader::Open(as_arrow_file(std::move(chunk)));
+  auto open_reader_result = arrow::ipc::RecordBatchFileReader::Open(
+    as_arrow_file(std::move(chunk)), options);
   if (!open_reader_result.ok()) {
     return caf::make_error(ec::format_error,
                            fmt::format("failed to open reader: {}",
                                        open_reader_result.status().ToString()));
   }
-  auto reader = open_reader_result.MoveValueUnsafe();
-  auto get_generator_result = reader->GetRecordBatchGenerator();
-  if (!get_generator_result.ok()) {
-    return caf::make_error(
-      ec::format_error, fmt::format("failed to get batch generator: {}",
-                                    get_generator_result.status().ToString()));
-  }
-  auto gen = get_generator_result.MoveValueUnsafe();
-  return []([[maybe_unused]] auto reader,
-            auto gen) -> generator<std::shared_ptr<arrow::RecordBatch>> {
-    while (true) {
-      auto next = gen();
-      if (!next.is_finished()) {
-        next.Wait();
-      }
-      TENZIR_ASSERT(next.is_finished());
-      auto result = next.MoveResult().ValueOrDie();
-      if (arrow::IsIterationEnd(result)) {
-        co_return;
-      }
-      co_yield std::move(result);
-    }
-  }(std::move(reader), std::move(gen));
+  return open_reader_result.MoveValueUnsafe();
+}
+
+/// Older stores wrap every record batch in an envelope that holds the import
+/// time in a separate column. Newer stores contain the fields of the events
+/// directly and keep the import time in the custom metadata of the record
+/// batches, which allows for reading only a subset of the fields.
+auto has_flat_layout(const arrow::Schema& schema) -> bool {
+  const auto& metadata = schema.metadata();
+  return metadata and metadata->Contains("TENZIR:name:0");
 }
 
 class passive_feather_store final : public passive_store {
   [[nodiscard]] caf::error load(chunk_ptr chunk) override {
-    auto decode_result = decode_ipc_stream(std::move(chunk));
-    if (!decode_result) {
+    auto reader
+      = open_ipc_file(chunk, arrow::ipc::IpcReadOptions::Defaults());
+    if (!reader) {
       return caf::make_error(ec::format_error,
                              fmt::format("failed to load feather store: {}",
-                                         decode_result.error()));
+                                         reader.error()));
     }
-    remaining_slices_generator_ = std::move(*decode_result);
-    remaining_slices_iterator_ = remaining_slices_generator_.begin();
+    chunk_ = std::move(chunk);
+    reader_ = std::move(*reader);
+    flat_ = has_flat_layout(*reader_->schema());
+    if (flat_) {
+      schema_ = type::from_arrow(*reader_->schema());
+      zone_maps_ = read_zone_maps(*reader_);
+    }
+    cached_slices_.resize(reader_->num_record_batches());
     return {};
   }
 
   [[nodiscard]] generator<table_slice> slices() const override {
     auto offset = id{};
-    auto i = size_t{};
-    while (true) {
-      if (i < cached_slices_.size()) {
-        TENZIR_ASSERT(offset == cached_slices_[i].offset());
-      } else if (remaining_slices_iterator_
-                 != remaining_slices_generator_.end()) {
-        auto batch = std::move(*remaining_slices_iterator_);
-        TENZIR_ASSERT(batch);
-        ++remaining_slices_iterator_;
-        auto import_time_column = batch->GetColumnByName("import_time");
-        auto slice = cached_slices_.empty()
-                       ? table_slice{unwrap_record_batch(batch)}
-                       : table_slice{unwrap_record_batch(batch),
-                                     cached_slices_[0].schema()};
-        slice.offset(offset);
-        slice.import_time(derive_import_time(import_time_column));
-        cached_slices_.push_back(std::move(slice));
-      } else {
-        co_return;
+    for (auto i = 0; i < reader_->num_record_batches(); ++i) {
+      const auto& slice = slice_at(i, offset);
+      co_yield slice;
+      offset += slice.rows();
+    }
+  }
+
+  [[nodiscard]] generator<table_slice>
+  extract(expression expr, ids selection,
+          std::optional<std::vector<std::string>> fields) const override {
+    if (not flat_) {
+      return base_store::extract(std::move(expr), std::move(selection),
+                                 std::move(fields));
+    }
+    // Determine which top-level fields we need to read: the ones we need to
+    // return, and the ones we need for evaluating the expression. If we need
+    // to read all of them anyways, we can just use the cached slices.
+    auto columns = std::vector<offset>{};
+    auto included = std::vector<int>{};
+    if (fields) {
+      columns = project_columns(schema_, *fields);
+    }
+    if (not columns.empty()) {
+      for (const auto& column : columns) {
+        included.push_back(detail::narrow_cast<int>(column[0]));
+      }
+      for (const auto& column : expression_columns(schema_, expr)) {
+        included.push_back(detail::narrow_cast<int>(column[0]));
       }
-      co_yield cached_slices_[i];
-      offset += cached_slices_[i].rows();
-      ++i;
+      std::sort(included.begin(), included.end());
+      included.erase(std::unique(included.begin(), included.end()),
+                     included.end());
+      if (detail::narrow_cast<int>(included.size())
+          == reader_->schema()->num_fields()) {
+        included.clear();
+      }
+    }
+    if (zone_maps_.empty() and included.empty()) {
+      return base_store::extract(std::move(expr), std::move(selection),
+                                 std::move(fields));
     }
+    return extract_flat(std::move(expr), std::move(selection),
+                        std::move(columns), std::move(included));
   }
 
   [[nodiscard]] uint64_t num_events() const override {
     if (cached_num_events_ == 0) {
-      cached_num_events_ = rows(collect(slices()));
+      auto num_rows = reader_->CountRows();
+      cached_num_events_ = num_rows.ok()
+                             ? detail::narrow_cast<uint64_t>(*num_rows)
+                             : rows(collect(slices()));
     }
     return cached_num_events_;
   }
 
   [[nodiscard]] type schema() const override {
+    if (flat_) {
+      return schema_;
+    }
     for (const auto& slice : slices()) {
       return slice.schema();
     }
@@ -187,11 +184,164 @@ class passive_feather_store final : public passive_store {
   }
 
 private:
-  generator<std::shared_ptr<arrow::RecordBatch>> remaining_slices_generator_
-    = {};
-  mutable generator<std::shared_ptr<arrow::RecordBatch>>::iterator
-    remaining_slices_iterator_
-    = {};
+  /// Returns the record batch at the given index as a table slice, reading it
+  /// from the file if it was not read before.
+  auto slice_at(int index, id offset) const -> const table_slice& {
+    auto& slice = cached_slices_[index];
+    if (slice.rows() == 0) {
+      slice = read_slice(*reader_, index);
+      slice.offset(offset);
+    }
+    TENZIR_ASSERT(offset == slice.offset());
+    return slice;
+  }
+
+  /// Reads the record batch at the given index into a table slice.
+  auto read_slice(arrow::ipc::RecordBatchFileReader& reader, int index) const
+    -> table_slice {
+    if (not flat_) {
+      auto batch = reader.ReadRecordBatch(index).ValueOrDie();
+      auto import_time_column = batch->GetColumnByName("import_time");
+      auto slice = cached_slices_[0].rows() == 0
+                     ? table_slice{unwrap_record_batch(batch)}
+                     : table_slice{unwrap_record_batch(batch),
+                                   cached_slices_[0].schema()};
+      slice.import_time(derive_import_time(import_time_column));
+      return slice;
+    }
+    auto batch = reader.ReadRecordBatchWithCustomMetadata(index).ValueOrDie();
+    auto slice = table_slice{batch.batch, schema_};
+    slice.import_time(read_import_time(batch.custom_metadata));
+    return slice;
+  }
+
+  /// Reads the record batch at the given index from a reader that includes
+  /// only a subset of the top-level fields. The resulting table slice has the
+  /// projected schema of the reader.
+  static auto read_projected_slice(arrow::ipc::RecordBatchFileReader& reader,
+                                   int index, const type& projected_schema)
+    -> table_slice {
+    auto batch = reader.ReadRecordBatchWithCustomMetadata(index).ValueOrDie();
+    auto slice = table_slice{batch.batch, projected_schema};
+    slice.import_time(read_import_time(batch.custom_metadata));
+    return slice;
+  }
+
+  /// Reads the import time from the custom metadata of a record batch.
+  static auto
+  read_import_time(const std::shared_ptr<arrow::KeyValueMetadata>& metadata)
+    -> time {
+    if (not metadata) {
+      return {};
+    }
+    auto value = metadata->Get(std::string{import_time_key});
+    if (not value.ok()) {
+      return {};
+    }
+    auto result = int64_t{};
+    const auto* end = value->data() + value->size();
+    if (std::from_chars(value->data(), end, result).ptr != end) {
+      return {};
+    }
+    return time{duration{result}};
+  }
+
+  /// Reads the zone maps from the footer of the file. Returns no zone maps if
+  /// the file does not contain any, if they use an unknown version, or if they
+  /// do not match the file.
+  static auto read_zone_maps(const arrow::ipc::RecordBatchFileReader& reader)
+    -> std::vector<zone_map> {
+    const auto& metadata = reader.metadata();
+    if (not metadata) {
+      return {};
+    }
+    auto value = metadata->Get(std::string{zone_maps_key});
+    if (not value.ok()) {
+      return {};
+    }
+    auto bytes = detail::base64::try_decode(*value);
+    if (not bytes) {
+      TENZIR_WARN("ignoring invalid zone maps in feather store");
+      return {};
+    }
+    auto result = unpack_zone_maps(chunk::make(std::move(*bytes)));
+    if (not result) {
+      TENZIR_WARN("ignoring zone maps in feather store: {}", result.error());
+      return {};
+    }
+    if (detail::narrow_cast<int>(result->size())
+        != reader.num_record_batches()) {
+      TENZIR_WARN("ignoring invalid zone maps in feather store");
+      return {};
+    }
+    return std::move(*result);
+  }
+
+  /// Executes an extract query on a store with the flat layout, skipping all
+  /// record batches that cannot match the expression according to their zone
+  /// maps. If `included` is non-empty, only the included top-level fields are
+  /// read from the file. If `columns` is non-empty, only the given columns are
+  /// returned.
+  auto extract_flat(expression expr, ids selection, std::vector<offset> columns,
+                    std::vector<int> included) const -> generator<table_slice> {
+    auto projected_reader
+      = std::shared_ptr<arrow::ipc::RecordBatchFileReader>{};
+    auto projected_schema = type{};
+    auto projected_expr = expression{};
+    if (not included.empty()) {
+      auto options = arrow::ipc::IpcReadOptions::Defaults();
+      options.included_fields = included;
+      auto reader = open_ipc_file(chunk_, options);
+      TENZIR_ASSERT(reader);
+      projected_reader = std::move(*reader);
+      projected_schema = type::from_arrow(*projected_reader->schema());
+      // The expression and the columns refer to the full schema, but the
+      // projected batches contain only the included top-level fields.
+      projected_expr
+        = project_expression(expr, schema_, projected_schema, included);
+      for (auto& column : columns) {
+        column = project_offset(std::move(column), included);
+      }
+    }
+    const auto& slice_expr = projected_reader ? projected_expr : expr;
+    auto offset = id{};
+    for (auto i = 0; i < reader_->num_record_batches(); ++i) {
+      auto slice = table_slice{};
+      if (zone_maps_.empty()) {
+        slice = projected_reader
+                  ? read_projected_slice(*projected_reader, i, projected_schema)
+                  : slice_at(i, offset);
+      } else {
+        // The zone maps tell us the number of rows in each batch, so we can
+        // skip batches without reading them.
+        const auto& zone_map = zone_maps_[i];
+        if (not zone_map.may_match(expr)) {
+          offset += zone_map.rows;
+          continue;
+        }
+        slice = projected_reader
+                  ? read_projected_slice(*projected_reader, i, projected_schema)
+                  : slice_at(i, offset);
+        TENZIR_ASSERT(slice.rows() == zone_map.rows);
+      }
+      slice.offset(offset);
+      offset += slice.rows();
+      auto filtered_slice = filter(slice, slice_expr, selection);
+      if (not filtered_slice) {
+        continue;
+      }
+      if (not columns.empty()) {
+        *filtered_slice = select_columns(*filtered_slice, columns);
+      }
+      co_yield std::move(*filtered_slice);
+    }
+  }
+
+  chunk_ptr chunk_ = {};
+  std::shared_ptr<arrow::ipc::RecordBatchFileReader> reader_ = {};
+  bool flat_ = {};
+  type schema_ = {};
+  std::vector<zone_map> zone_maps_ = {};
   mutable uint64_t cached_num_events_ = {};
   mutable std::vector<table_slice> cached_slices_ = {};
 };
@@ -230,23 +380,49 @@ public:
     if (num_new_events_ > 0) {
       rebatched_slices_.push_back(concatenate(std::exchange(new_slices_, {})));
     }
-    auto record_batches = arrow::RecordBatchVector{};
-    record_batches.reserve(rebatched_slices_.size());
+    if (rebatched_slices_.empty()) {
+      return caf::make_error(ec::logic_error, "cannot persist empty store");
+    }
+    auto output_stream = arrow::io::BufferOutputStream::Create().ValueOrDie();
+    auto write_options = arrow::ipc::IpcWriteOptions::Defaults();
+    auto codec = arrow::util::Codec::Create(arrow::Compression::ZSTD);
+    if (!codec.ok()) {
+      return caf::make_error(ec::system_error, codec.status().ToString());
+    }
+    write_options.codec = codec.MoveValueUnsafe();
+    // Store a zone map per record batch in the footer, which allows for
+    // skipping batches when reading the store.
+    auto zone_maps = std::vector<zone_map>{};
+    zone_maps.reserve(rebatched_slices_.size());
     for (const auto& slice : rebatched_slices_) {
-      record_batches.push_back(wrap_record_batch(slice));
+      zone_maps.push_back(zone_map::make(slice));
     }
-    const auto table = ::arrow::Table::FromRecordBatches(record_batches);
-    if (!table.ok()) {
-      return caf::make_error(ec::system_error, table.status().ToString());
+    auto packed_zone_maps = pack_zone_maps(zone_maps);
+    if (not packed_zone_maps) {
+      return std::move(packed_zone_maps.error());
     }
-    auto output_stream = arrow::io::BufferOutputStream::Create().ValueOrDie();
-    auto write_properties = arrow::ipc::feather::WriteProperties::Defaults();
-    // TODO: Set write_properties.chunksize to the expected batch size
-    write_properties.compression = arrow::Compression::ZSTD;
-    const auto write_status = ::arrow::ipc::feather::WriteTable(
-      *table.ValueUnsafe(), output_stream.get(), write_properties);
-    if (!write_status.ok()) {
-      return caf::make_error(ec::system_error, write_status.ToString());
+    const auto footer_metadata = arrow::key_value_metadata(
+      {std::string{zone_maps_key}},
+      {detail::base64::encode(as_bytes(*packed_zone_maps))});
+    auto writer = arrow::ipc::MakeFileWriter(
+      output_stream, to_record_batch(rebatched_slices_.front())->schema(),
+      write_options, footer_metadata);
+    if (!writer.ok()) {
+      return caf::make_error(ec::system_error, writer.status().ToString());
+    }
+    for (const auto& slice : rebatched_slices_) {
+      const auto import_time
+        = slice.import_time().time_since_epoch().count();
+      const auto metadata = arrow::key_value_metadata(
+        {std::string{import_time_key}}, {fmt::to_string(import_time)});
+      const auto write_status
+        = (*writer)->WriteRecordBatch(*to_record_batch(slice), metadata);
+      if (!write_status.ok()) {
+        return caf::make_error(ec::system_error, write_status.ToString());
+      }
+    }
+    if (auto close_status = (*writer)->Close(); !close_status.ok()) {
+      return caf::make_error(ec::system_error, close_status.ToString());
     }
     auto buffer = output_stream->Finish();
     if (!buffer.ok()) {
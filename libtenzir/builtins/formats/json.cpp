@@ -19,6 +19,7 @@
 #include <tenzir/detail/padded_buffer.hpp>
 #include <tenzir/detail/string_literal.hpp>
 #include <tenzir/diagnostics.hpp>
+#include <tenzir/error.hpp>
 #include <tenzir/generator.hpp>
 #include <tenzir/modules.hpp>
 #include <tenzir/operator_control_plane.hpp>
@@ -28,11 +29,15 @@
 #include <tenzir/try_simdjson.hpp>
 
 #include <arrow/record_batch.h>
+#include <arrow/util/future.h>
+#include <arrow/util/thread_pool.h>
 #include <caf/detail/is_one_of.hpp>
+#include <caf/detail/scope_guard.hpp>
 #include <caf/typed_event_based_actor.hpp>
 #include <fmt/format.h>
 
 #include <chrono>
+#include <deque>
 #include <simdjson.h>
 
 namespace tenzir::plugins::json {
@@ -218,12 +223,50 @@ struct entry_data {
   std::chrono::steady_clock::time_point flushed;
 };
 
+/// The kind of data that a string was inferred as.
+enum class string_inference { none, time, duration, subnet, ip };
+
+/// Maps field names to the kind of data that the last string value of the
+/// field was inferred as.
+using string_inference_cache
+  = detail::heterogeneous_string_hashmap<string_inference>;
+
+/// The maximum number of field names in the string inference cache before we
+/// clear it, which bounds its memory usage for inputs with dynamic keys.
+constexpr auto max_string_inference_cache_size = size_t{10'000};
+
+/// Returns whether a string may be a time, duration, subnet, or IP address,
+/// judging by its characters only. This must never reject a string that one of
+/// the parsers accepts.
+auto maybe_inferable(std::string_view str) -> bool {
+  if (str.empty()) {
+    return false;
+  }
+  const auto c = str.front();
+  // Numbers, durations, times, and IP addresses begin with one of these. The
+  // letters cover `now`, `in`, `inf`, and `nan`.
+  if ((c >= '0' and c <= '9') or c == '+' or c == '-' or c == '.' or c == '@'
+      or c == ':' or c == 'n' or c == 'N' or c == 'i' or c == 'I') {
+    return true;
+  }
+  // Otherwise, only IPv6 addresses and subnets remain.
+  const auto is_hex_letter
+    = (c >= 'a' and c <= 'f') or (c >= 'A' and c <= 'F');
+  if (not is_hex_letter or str.find(':') == std::string_view::npos) {
+    return false;
+  }
+  return std::ranges::all_of(str, [](char c) {
+    return (c >= '0' and c <= '9') or (c >= 'a' and c <= 'f')
+           or (c >= 'A' and c <= 'F') or c == ':' or c == '.' or c == '/';
+  });
+}
+
 struct parser_state {
-  explicit parser_state(operator_control_plane& ctrl, bool preserve_order)
-    : ctrl_{ctrl}, preserve_order{preserve_order} {
+  explicit parser_state(diagnostic_handler& diag, bool preserve_order)
+    : diag_{diag}, preserve_order{preserve_order} {
   }
 
-  operator_control_plane& ctrl_;
+  diagnostic_handler& diag_;
   /// Maps schema names to indices for the `entries` member.
   detail::heterogeneous_string_hashmap<size_t> entry_map;
   /// If `--precise` is set, we use this map instead of `entry_map`. Obviously,
@@ -241,6 +284,9 @@ struct parser_state {
   /// If this is false, then the JSON parser is allowed to reorder events
   /// between different schemas.
   bool preserve_order = true;
+  /// Remembers what strings of a field were inferred as, so that we can try
+  /// the same parser first for the next string.
+  string_inference_cache string_inferences;
 
   auto get_entry(size_t idx) -> entry_data& {
     TENZIR_ASSERT(idx < entries.size());
@@ -298,18 +344,21 @@ struct parser_state {
 /// Parses simdjson objects into the given `series_builder` handles.
 class doc_parser {
 public:
-  doc_parser(std::string_view parsed_document, operator_control_plane& ctrl,
-             bool no_infer, bool raw)
+  doc_parser(std::string_view parsed_document, diagnostic_handler& diag,
+             string_inference_cache& inferences, bool no_infer, bool raw)
     : parsed_document_{parsed_document},
-      ctrl_{ctrl},
+      diag_{diag},
+      inferences_{inferences},
       no_infer_{no_infer},
       raw_{raw} {
   }
 
-  doc_parser(std::string_view parsed_document, operator_control_plane& ctrl,
-             std::size_t parsed_lines, bool no_infer, bool raw)
+  doc_parser(std::string_view parsed_document, diagnostic_handler& diag,
+             string_inference_cache& inferences, std::size_t parsed_lines,
+             bool no_infer, bool raw)
     : parsed_document_{parsed_document},
-      ctrl_{ctrl},
+      diag_{diag},
+      inferences_{inferences},
       parsed_lines_{parsed_lines},
       no_infer_{no_infer},
       raw_{raw} {
@@ -323,6 +372,7 @@ public:
       report_parse_err(v, "object");
       return false;
     }
+    const auto outer_key = key_;
     for (auto pair : obj) {
       if (pair.error()) {
         report_parse_err(v, "key value pair");
@@ -344,10 +394,12 @@ public:
         // TODO: Consider whether we want to emit a diagnostic here.
         continue;
       }
+      key_ = key;
       if (not parse_impl(val.value_unsafe(), field, depth + 1)) {
         return false;
       }
     }
+    key_ = outer_key;
     return true;
   }
 
@@ -368,12 +420,12 @@ private:
                           std::move(description))
         .note("{} {} ...", note_prefix,
               document_to_truncate.substr(0, character_limit))
-        .emit(ctrl_.diagnostics());
+        .emit(diag_);
     }
     diagnostic::warning("failed to parse {} in the JSON document",
                         std::move(description))
       .note("{} {}", note_prefix, document_to_truncate)
-      .emit(ctrl_.diagnostics());
+      .emit(diag_);
   }
 
   void report_parse_err(auto& v, std::string description) {
@@ -390,14 +442,14 @@ private:
       diagnostic::warning("failed to parse {} in the JSON document",
                           std::move(description))
         .note("line {}", *parsed_lines_)
-        .emit(ctrl_.diagnostics());
+        .emit(diag_);
       return;
     }
     auto column = v.current_location().value_unsafe() - parsed_document_.data();
     diagnostic::warning("failed to parse {} in the JSON document",
                         std::move(description))
       .note("line {} column {}", *parsed_lines_, column)
-      .emit(ctrl_.diagnostics());
+      .emit(diag_);
   }
 
   [[nodiscard]] auto
@@ -454,23 +506,81 @@ private:
       return false;
     }
     auto str = maybe_str.value_unsafe();
-    if (not raw_ and not builder.is_protected()) {
+    if (not raw_ and not builder.is_protected() and maybe_inferable(str)) {
       // Attempt to parse it as data.
-      static constexpr auto parser
-        = parsers::time | parsers::duration | parsers::net | parsers::ip;
-      auto result = std::variant<time, duration, subnet, ip>{};
-      if (parser(str, result)) {
-        return std::visit(
-          [&](auto& value) {
-            return add_value(builder, std::move(value));
-          },
-          result);
+      if (auto added = infer_string(str, builder)) {
+        return *added;
       }
     }
     // If this doesn't work, we fall back to a string.
     return add_value(builder, std::string{str});
   }
 
+  /// Attempts to parse a string as data, and adds it to the builder on
+  /// success. Strings of the same field usually have the same kind, so we
+  /// first try the parser that succeeded for the previous string of the field.
+  [[nodiscard]] auto infer_string(std::string_view str, builder_ref builder)
+    -> std::optional<bool> {
+    const auto add = [&](auto& value) {
+      return add_value(builder, std::move(value));
+    };
+    auto it = inferences_.find(key_);
+    const auto previous
+      = it != inferences_.end() ? it->second : string_inference::none;
+    switch (previous) {
+      case string_inference::none:
+        break;
+      case string_inference::time: {
+        auto value = time{};
+        if (parsers::time(str, value)) {
+          return add(value);
+        }
+        break;
+      }
+      case string_inference::duration: {
+        auto value = duration{};
+        if (parsers::duration(str, value)) {
+          return add(value);
+        }
+        break;
+      }
+      case string_inference::subnet: {
+        auto value = subnet{};
+        if (parsers::net(str, value)) {
+          return add(value);
+        }
+        break;
+      }
+      case string_inference::ip: {
+        auto value = ip{};
+        if (parsers::ip(str, value)) {
+          return add(value);
+        }
+        break;
+      }
+    }
+    static constexpr auto parser
+      = parsers::time | parsers::duration | parsers::net | parsers::ip;
+    auto result = std::variant<time, duration, subnet, ip>{};
+    auto inferred = string_inference::none;
+    if (parser(str, result)) {
+      // The alternatives of the variant are in the order of the enumerators.
+      inferred = static_cast<string_inference>(result.index() + 1);
+    }
+    if (it != inferences_.end()) {
+      it.value() = inferred;
+    } else {
+      if (inferences_.size() >= max_string_inference_cache_size) {
+        inferences_.clear();
+      }
+      inferences_.emplace(std::string{key_}, inferred);
+    }
+    if (inferred == string_inference::none) {
+      return std::nullopt;
+    }
+    return std::visit(add, result);
+  }
+
   [[nodiscard]] auto parse_array(simdjson::ondemand::array arr,
                                  builder_ref builder, size_t depth) -> bool {
     for (auto element : arr) {
@@ -532,14 +642,17 @@ private:
     -> bool {
     auto result = builder.try_data(value);
     if (not result) {
-      diagnostic::warning(result.error()).emit(ctrl_.diagnostics());
+      diagnostic::warning(result.error()).emit(diag_);
       return false;
     }
     return true;
   }
 
   std::string_view parsed_document_;
-  operator_control_plane& ctrl_;
+  diagnostic_handler& diag_;
+  string_inference_cache& inferences_;
+  /// The name of the field whose value we are currently parsing.
+  std::string_view key_;
   std::optional<std::size_t> parsed_lines_;
   bool no_infer_;
   bool raw_;
@@ -732,11 +845,11 @@ auto unflatten_if_needed(std::string_view separator, table_slice slice)
 
 class parser_base {
 public:
-  parser_base(operator_control_plane& ctrl, std::optional<selector> selector,
+  parser_base(diagnostic_handler& diag, std::optional<selector> selector,
               std::optional<type> schema, std::vector<type> schemas,
               bool no_infer, bool preserve_order, bool raw,
               bool arrays_of_objects, bool precise)
-    : ctrl_{ctrl},
+    : diag_{diag},
       selector_{std::move(selector)},
       schema_{std::move(schema)},
       schemas_{std::move(schemas)},
@@ -795,7 +908,7 @@ protected:
     TENZIR_ASSERT(selector_);
     auto maybe_schema_name = get_schema_name(doc_ref, *selector_);
     if (not maybe_schema_name) {
-      diagnostic::warning(maybe_schema_name.error()).emit(ctrl_.diagnostics());
+      diagnostic::warning(maybe_schema_name.error()).emit(diag_);
       if (no_infer_) {
         return {parser_action::skip, std::nullopt};
       }
@@ -817,7 +930,7 @@ protected:
       }
       return {parser_action::parse, std::nullopt};
     }
-    diagnostic::warning(maybe_slice_to_yield.error()).emit(ctrl_.diagnostics());
+    diagnostic::warning(maybe_slice_to_yield.error()).emit(diag_);
     return {parser_action::skip, std::nullopt};
   }
 
@@ -838,7 +951,7 @@ protected:
     return state.get_active_entry().flush();
   }
 
-  operator_control_plane& ctrl_;
+  diagnostic_handler& diag_;
   std::optional<selector> selector_;
   std::optional<type> schema_;
   std::vector<type> schemas_;
@@ -866,7 +979,7 @@ public:
     if (auto err = val.error()) {
       diagnostic::warning("{}", error_message(err))
         .note("skips invalid JSON `{}`", json_line)
-        .emit(this->ctrl_.diagnostics());
+        .emit(this->diag_);
       co_return;
     }
     auto& doc = maybe_doc.value_unsafe();
@@ -876,14 +989,14 @@ public:
         // TODO: Extra info?
         diagnostic::warning("{}", simdjson::error_message(maybe_event.error()))
           .note("at line {}", lines_processed_)
-          .emit(ctrl_.diagnostics());
+          .emit(diag_);
         co_return;
       }
       auto event = std::move(maybe_event).value_unsafe();
       if (not caf::holds_alternative<record>(event)) {
         diagnostic::warning("skipping non-record JSON value: {}", event)
           .note("at line {}", lines_processed_)
-          .emit(ctrl_.diagnostics());
+          .emit(diag_);
         co_return;
       }
       signature_.clear();
@@ -905,7 +1018,7 @@ public:
         diagnostic::warning(
           "encountered more than one JSON object in a single NDJSON line")
           .note("skips remaining objects in line `{}`", json_line)
-          .emit(this->ctrl_.diagnostics());
+          .emit(this->diag_);
       }
     } else {
       auto [action, slices] = this->handle_selector(doc, json_line, state);
@@ -921,9 +1034,11 @@ public:
           }
       }
       auto& builder = state.get_active_entry().builder;
-      auto success
-        = doc_parser{json_line, this->ctrl_, lines_processed_, no_infer_, raw_}
-            .parse_object(val.value_unsafe(), builder.record());
+      auto parser = doc_parser{
+        json_line,        this->diag_, state.string_inferences,
+        lines_processed_, no_infer_,   raw_,
+      };
+      auto success = parser.parse_object(val.value_unsafe(), builder.record());
       // After parsing one JSON object it is expected for the result to be at
       // the end. If it's otherwise then it means that a line contains more than
       // one object in which case we don't add any data and emit a warning.
@@ -935,7 +1050,7 @@ public:
         diagnostic::warning(
           "encountered more than one JSON object in a single NDJSON line")
           .note("skips remaining objects in line `{}`", json_line)
-          .emit(this->ctrl_.diagnostics());
+          .emit(this->diag_);
         success = false;
       }
       if (not success) {
@@ -978,7 +1093,7 @@ public:
       buffer_.reset();
       diagnostic::warning("{}", error_message(err))
         .note("failed to parse")
-        .emit(this->ctrl_.diagnostics());
+        .emit(this->diag_);
       co_return;
     }
     for (auto doc_it = stream_.begin(); doc_it != stream_.end(); ++doc_it) {
@@ -989,7 +1104,7 @@ public:
         state.abort_requested = true;
         diagnostic::error("{}", error_message(err))
           .note("skips invalid JSON '{}'", view)
-          .emit(this->ctrl_.diagnostics());
+          .emit(this->diag_);
         co_return;
       }
       auto [action, slices]
@@ -1012,14 +1127,16 @@ public:
           state.abort_requested = true;
           diagnostic::error("expected an array of objects")
             .note("got: {}", view)
-            .emit(this->ctrl_.diagnostics());
+            .emit(this->diag_);
           co_return;
         }
         for (auto&& elem : arr.value_unsafe()) {
           auto row = builder.record();
-          auto success
-            = doc_parser{doc_it.source(), this->ctrl_, no_infer_, raw_}
-                .parse_object(elem.value_unsafe(), row);
+          auto parser = doc_parser{
+            doc_it.source(), this->diag_, state.string_inferences,
+            no_infer_,       raw_,
+          };
+          auto success = parser.parse_object(elem.value_unsafe(), row);
           if (not success) {
             // We already reported the issue.
             builder.remove_last();
@@ -1028,8 +1145,11 @@ public:
         }
       } else {
         auto row = builder.record();
-        auto success = doc_parser{doc_it.source(), this->ctrl_, no_infer_, raw_}
-                         .parse_object(doc.value_unsafe(), row);
+        auto parser = doc_parser{
+          doc_it.source(), this->diag_, state.string_inferences,
+          no_infer_,       raw_,
+        };
+        auto success = parser.parse_object(doc.value_unsafe(), row);
         if (not success) {
           // We already reported the issue.
           builder.remove_last();
@@ -1048,7 +1168,7 @@ public:
   void finish(parser_state& state) {
     if (not buffer_.view().empty()) {
       diagnostic::error("parser input ended with incomplete object")
-        .emit(ctrl_.diagnostics());
+        .emit(diag_);
       state.abort_requested = true;
     }
   }
@@ -1066,7 +1186,7 @@ private:
       state.abort_requested = true;
       diagnostic::error("detected malformed JSON")
         .note("in input '{}'", buffer_.view())
-        .emit(this->ctrl_.diagnostics());
+        .emit(this->diag_);
       return;
     }
     buffer_.truncate(truncated_bytes);
@@ -1080,10 +1200,10 @@ private:
 
 template <class GeneratorValue>
 auto make_parser(generator<GeneratorValue> json_chunk_generator,
-                 operator_control_plane& ctrl, std::string separator,
+                 diagnostic_handler& diag, std::string separator,
                  std::optional<type> schema, bool preserve_order,
                  auto parser_impl) -> generator<table_slice> {
-  auto state = parser_state{ctrl, preserve_order};
+  auto state = parser_state{diag, preserve_order};
   if (schema) {
     // TODO: What about `infer_types`?
     state.active_entry = state.add_entry(schema->name(), *schema);
@@ -1156,6 +1276,7 @@ struct parser_args {
   bool raw = false;
   bool arrays_of_objects = false;
   bool precise = false;
+  uint64_t parallelism = defaults::json::parallelism;
 
   template <class Inspector>
   friend auto inspect(Inspector& f, parser_args& x) -> bool {
@@ -1169,10 +1290,25 @@ struct parser_args {
               f.field("preserve_order", x.preserve_order),
               f.field("raw", x.raw),
               f.field("arrays_of_objects", x.arrays_of_objects),
-              f.field("precise", x.precise));
+              f.field("precise", x.precise),
+              f.field("parallelism", x.parallelism));
   }
 };
 
+auto read_parallelism_option(const record& global_config, uint64_t& result)
+  -> caf::error {
+  auto parallelism = try_get_or<uint64_t>(
+    global_config, "tenzir.json-parallelism", defaults::json::parallelism);
+  if (not parallelism) {
+    return caf::make_error(ec::invalid_configuration,
+                           fmt::format("failed to parse "
+                                       "`tenzir.json-parallelism` option: {}",
+                                       parallelism.error()));
+  }
+  result = std::max(*parallelism, uint64_t{1});
+  return {};
+}
+
 void add_no_infer_option(argument_parser& parser, parser_args& args) {
   // TODO: Rename this option.
   parser.add("--no-infer", args.no_infer);
@@ -1182,6 +1318,215 @@ void add_raw_option(argument_parser& parser, parser_args& args) {
   parser.add("--raw", args.raw);
 }
 
+/// The events and diagnostics of a block of NDJSON input.
+struct block_result {
+  std::vector<table_slice> slices;
+  std::vector<diagnostic> diagnostics;
+};
+
+auto make_chunk_generator(std::vector<chunk_ptr> chunks)
+  -> generator<chunk_ptr> {
+  for (auto& chunk : chunks) {
+    co_yield std::move(chunk);
+  }
+}
+
+/// Splits off the longest prefix of a block that ends with a newline, so that
+/// no line spans two blocks. Returns nothing if the block has no newline.
+auto split_block(std::vector<chunk_ptr>& block)
+  -> std::optional<std::vector<chunk_ptr>> {
+  for (auto i = block.size(); i-- > 0;) {
+    const auto* begin = reinterpret_cast<const char*>(block[i]->data());
+    const auto size = block[i]->size();
+    const auto text = std::string_view{begin, size};
+    const auto newline = text.rfind('\n');
+    if (newline == std::string_view::npos) {
+      continue;
+    }
+    auto result = std::vector<chunk_ptr>(block.begin(), block.begin() + i);
+    result.push_back(block[i]->slice(0, newline + 1));
+    auto rest = std::vector<chunk_ptr>{};
+    if (newline + 1 < size) {
+      rest.push_back(block[i]->slice(newline + 1));
+    }
+    rest.insert(rest.end(), std::make_move_iterator(block.begin() + i + 1),
+                std::make_move_iterator(block.end()));
+    block = std::move(rest);
+    return result;
+  }
+  return std::nullopt;
+}
+
+/// Parses a block of complete NDJSON lines with its own builders. The parser
+/// only sees a diagnostic handler that collects the diagnostics, which the
+/// operator then emits on its own thread.
+auto parse_block(std::vector<chunk_ptr> block, const parser_args& args,
+                 const std::optional<type>& schema, std::vector<type> schemas)
+  -> block_result {
+  auto diag = collecting_diagnostic_handler{};
+  auto result = block_result{};
+  for (auto&& slice :
+       make_parser(split_at_crlf(make_chunk_generator(std::move(block))), diag,
+                   args.unnest_separator, schema, args.preserve_order,
+                   ndjson_parser{
+                     diag,
+                     args.selector,
+                     schema,
+                     std::move(schemas),
+                     args.no_infer.has_value(),
+                     args.preserve_order,
+                     args.raw,
+                     args.arrays_of_objects,
+                     args.precise,
+                   })) {
+    if (slice.rows() > 0) {
+      result.slices.push_back(std::move(slice));
+    }
+  }
+  result.diagnostics = std::move(diag).collect();
+  return result;
+}
+
+/// Returns the next block whose result may be emitted, or the end of the
+/// pending blocks if there is none yet.
+auto next_ready_block(std::deque<arrow::Future<block_result>>& pending,
+                      bool preserve_order)
+  -> std::deque<arrow::Future<block_result>>::iterator {
+  const auto ready = [](const arrow::Future<block_result>& x) {
+    return x.is_finished();
+  };
+  if (not preserve_order) {
+    return std::ranges::find_if(pending, ready);
+  }
+  if (pending.empty() or not ready(pending.front())) {
+    return pending.end();
+  }
+  return pending.begin();
+}
+
+/// Emits the results of finished blocks, in the order of the blocks if the
+/// order of events must be preserved. Sets *failed* if a block emitted an
+/// error.
+auto emit_ready_blocks(std::deque<arrow::Future<block_result>>& pending,
+                       operator_control_plane& ctrl, const parser_args& args,
+                       bool& failed) -> generator<table_slice> {
+  while (true) {
+    const auto it = next_ready_block(pending, args.preserve_order);
+    if (it == pending.end()) {
+      co_return;
+    }
+    auto result = it->MoveResult();
+    pending.erase(it);
+    if (not result.ok()) {
+      diagnostic::error("{}", result.status().ToString())
+        .note("failed to parse NDJSON in parallel")
+        .emit(ctrl.diagnostics());
+      failed = true;
+      co_return;
+    }
+    for (auto& diag : result->diagnostics) {
+      failed = failed or diag.severity == severity::error;
+      ctrl.diagnostics().emit(std::move(diag));
+    }
+    if (failed) {
+      co_return;
+    }
+    for (auto& slice : result->slices) {
+      co_yield unflatten_if_needed(args.unnest_separator, std::move(slice));
+    }
+  }
+}
+
+/// Parses NDJSON on multiple threads. The input is cut into blocks at newlines,
+/// and every block is parsed on Arrow's CPU thread pool into its own builders.
+auto make_parallel_ndjson_parser(generator<chunk_ptr> input,
+                                 operator_control_plane& ctrl,
+                                 parser_args args, std::optional<type> schema,
+                                 std::vector<type> schemas)
+  -> generator<table_slice> {
+  auto pending = std::deque<arrow::Future<block_result>>{};
+  // The tasks reference the parser arguments and the schema, so we must not
+  // leave before they finished.
+  auto guard = caf::detail::make_scope_guard([&] {
+    for (auto& future : pending) {
+      future.Wait();
+    }
+  });
+  auto block = std::vector<chunk_ptr>{};
+  auto block_size = size_t{0};
+  auto last_launch = std::chrono::steady_clock::now();
+  auto failed = false;
+  // Every finished block resumes the operator, which may be waiting for it.
+  const auto waker = ctrl.make_waker();
+  const auto launch = [&](std::vector<chunk_ptr> chunks) {
+    auto task
+      = [&args, &schema, schemas, chunks = std::move(chunks)]() mutable {
+          return parse_block(std::move(chunks), args, schema,
+                             std::move(schemas));
+        };
+    auto future = arrow::internal::GetCpuThreadPool()->Submit(std::move(task));
+    pending.push_back(future.ok() ? future.MoveValueUnsafe()
+                                  : arrow::Future<block_result>::MakeFinished(
+                                    future.status()));
+    pending.back().AddCallback([waker](const arrow::Result<block_result>&) {
+      waker();
+    });
+    last_launch = std::chrono::steady_clock::now();
+  };
+  for (auto&& chunk : input) {
+    if (chunk and chunk->size() > 0) {
+      block_size += chunk->size();
+      block.push_back(std::move(chunk));
+    }
+    // We hand off a block once it is large enough, or once the input has been
+    // slow for longer than the batch timeout.
+    const auto timed_out = std::chrono::steady_clock::now()
+                           > last_launch + defaults::import::batch_timeout;
+    if (block_size >= defaults::json::block_size
+        or (block_size > 0 and timed_out)) {
+      if (auto chunks = split_block(block)) {
+        launch(std::move(*chunks));
+        block_size = 0;
+        for (const auto& x : block) {
+          block_size += x->size();
+        }
+      }
+    }
+    // At most `parallelism` blocks remain in flight. Instead of blocking the
+    // operator's thread on them, we suspend the operator until the next block
+    // finished.
+    while (true) {
+      for (auto&& slice : emit_ready_blocks(pending, ctrl, args, failed)) {
+        co_yield std::move(slice);
+      }
+      if (failed) {
+        co_return;
+      }
+      if (pending.size() <= args.parallelism) {
+        break;
+      }
+      ctrl.set_waiting(true);
+      co_yield {};
+    }
+    co_yield {};
+  }
+  if (not block.empty()) {
+    launch(std::move(block));
+  }
+  while (not pending.empty()) {
+    for (auto&& slice : emit_ready_blocks(pending, ctrl, args, failed)) {
+      co_yield std::move(slice);
+    }
+    if (failed) {
+      co_return;
+    }
+    if (not pending.empty()) {
+      ctrl.set_waiting(true);
+      co_yield {};
+    }
+  }
+}
+
 class json_parser final : public plugin_parser {
 public:
   json_parser() = default;
@@ -1249,11 +1594,15 @@ public:
         .emit(ctrl.diagnostics());
       return {};
     }
+    if (args_.use_ndjson_mode and args_.parallelism > 1) {
+      return make_parallel_ndjson_parser(std::move(input), ctrl, args_,
+                                         std::move(schema), std::move(schemas));
+    }
     if (args_.use_ndjson_mode) {
-      return make_parser(split_at_crlf(std::move(input)), ctrl,
+      return make_parser(split_at_crlf(std::move(input)), ctrl.diagnostics(),
                          args_.unnest_separator, schema, args_.preserve_order,
                          ndjson_parser{
-                           ctrl,
+                           ctrl.diagnostics(),
                            args_.selector,
                            schema,
                            std::move(schemas),
@@ -1265,10 +1614,11 @@ public:
                          });
     }
     if (args_.use_gelf_mode) {
-      return make_parser(split_at_null(std::move(input), '\0'), ctrl,
-                         args_.unnest_separator, schema, args_.preserve_order,
+      return make_parser(split_at_null(std::move(input), '\0'),
+                         ctrl.diagnostics(), args_.unnest_separator, schema,
+                         args_.preserve_order,
                          ndjson_parser{
-                           ctrl,
+                           ctrl.diagnostics(),
                            args_.selector,
                            schema,
                            std::move(schemas),
@@ -1279,10 +1629,10 @@ public:
                            args_.precise,
                          });
     }
-    return make_parser(std::move(input), ctrl, args_.unnest_separator, schema,
-                       args_.preserve_order,
+    return make_parser(std::move(input), ctrl.diagnostics(),
+                       args_.unnest_separator, schema, args_.preserve_order,
                        default_parser{
-                         ctrl,
+                         ctrl.diagnostics(),
                          args_.selector,
                          schema,
                          std::move(schemas),
@@ -1425,9 +1775,15 @@ public:
     return "json";
   }
 
+  auto initialize([[maybe_unused]] const record& plugin_config,
+                  const record& global_config) -> caf::error override {
+    return read_parallelism_option(global_config, parallelism_);
+  }
+
   auto parse_parser(parser_interface& p) const
     -> std::unique_ptr<plugin_parser> override {
     auto args = parser_args{};
+    args.parallelism = parallelism_;
     auto selector = std::optional<located<std::string>>{};
     auto parser
       = argument_parser{name(), "https://docs.tenzir.com/formats/json"};
@@ -1476,6 +1832,9 @@ public:
     parser.parse(p);
     return std::make_unique<json_printer>(std::move(args));
   }
+
+private:
+  uint64_t parallelism_ = defaults::json::parallelism;
 };
 
 class gelf_parser final : public virtual parser_parser_plugin {
@@ -1505,6 +1864,11 @@ public:
     return std::string{Name.str()};
   }
 
+  auto initialize([[maybe_unused]] const record& plugin_config,
+                  const record& global_config) -> caf::error override {
+    return read_parallelism_option(global_config, parallelism_);
+  }
+
   auto parse_parser(parser_interface& p) const
     -> std::unique_ptr<plugin_parser> override {
     auto parser = argument_parser{
@@ -1515,8 +1879,12 @@ public:
     args.use_ndjson_mode = true;
     args.selector = parse_selector(Selector.str(), location::unknown);
     args.unnest_separator = Separator.str();
+    args.parallelism = parallelism_;
     return std::make_unique<json_parser>(std::move(args));
   }
+
+private:
+  uint64_t parallelism_ = defaults::json::parallelism;
 };
 
 using suricata_parser = selector_parser<"suricata", "event_type:suricata">;
@@ -25,7 +25,9 @@
 #include <fmt/core.h>
 
 #include <algorithm>
+#include <bit>
 #include <cctype>
+#include <cstring>
 #include <iterator>
 
 namespace tenzir::plugins::xsv {
@@ -248,6 +250,129 @@ struct xsv_printer_impl {
   std::string null{};
 };
 
+/// The kind of the previous value of a column. Columns mostly hold values of
+/// the same kind, so we first try the parser for that kind.
+enum class value_kind { unknown, time, duration, subnet, ip, number, boolean };
+
+auto kind_of(const data& x) -> value_kind {
+  return caf::visit(
+    []<class T>(const T&) {
+      if constexpr (std::is_same_v<T, time>) {
+        return value_kind::time;
+      } else if constexpr (std::is_same_v<T, duration>) {
+        return value_kind::duration;
+      } else if constexpr (std::is_same_v<T, subnet>) {
+        return value_kind::subnet;
+      } else if constexpr (std::is_same_v<T, ip>) {
+        return value_kind::ip;
+      } else if constexpr (detail::is_any_v<T, int64_t, uint64_t, double>) {
+        return value_kind::number;
+      } else if constexpr (std::is_same_v<T, bool>) {
+        return value_kind::boolean;
+      } else {
+        return value_kind::unknown;
+      }
+    },
+    x);
+}
+
+/// Parses a value of the given kind, as the corresponding alternative of
+/// `parsers::data` would.
+auto parse_as(value_kind kind, const char*& f, const char* l, data& result)
+  -> bool {
+  const auto parse = [&](const auto& parser, auto value) {
+    if (not parser(f, l, value)) {
+      return false;
+    }
+    result = std::move(value);
+    return true;
+  };
+  switch (kind) {
+    case value_kind::unknown:
+      return false;
+    case value_kind::time:
+      return parse(parsers::time, time{});
+    case value_kind::duration:
+      return parse(parsers::duration, duration{});
+    case value_kind::subnet:
+      return parse(parsers::net, subnet{});
+    case value_kind::ip:
+      return parse(parsers::ip, ip{});
+    case value_kind::number:
+      return parsers::number(f, l, result);
+    case value_kind::boolean:
+      return parse(parsers::boolean, false);
+  }
+  TENZIR_UNREACHABLE();
+}
+
+/// Returns whether `parsers::data` may accept a value that begins with the
+/// given character as something other than a string. This must hold for every
+/// time, duration, subnet, IP address, number, boolean, map, and null.
+auto may_begin_data(char c) -> bool {
+  if ((c >= '0' and c <= '9') or (c >= 'a' and c <= 'f')
+      or (c >= 'A' and c <= 'F')) {
+    return true;
+  }
+  switch (c) {
+    case '+':
+    case '-':
+    case '.':
+    case '@':
+    case ':':
+    case '_':
+    case '{':
+    // `now`, `in`, `nan`, `inf`, `null`, and `true`.
+    case 'n':
+    case 'N':
+    case 'i':
+    case 'I':
+    case 't':
+      return true;
+    default:
+      return false;
+  }
+}
+
+/// Returns whether a separator may occur within a time, duration, subnet, IP
+/// address, number, or boolean. If so, these values may span multiple cells,
+/// and we must not parse them cell by cell.
+auto may_occur_in_data(char c) -> bool {
+  return std::isalnum(static_cast<unsigned char>(c)) != 0
+         or std::isspace(static_cast<unsigned char>(c)) != 0
+         or std::string_view{"+-.:/@_\"{}[]<>"}.find(c)
+              != std::string_view::npos;
+}
+
+/// Returns the position of the first field or list separator, or *end* if
+/// there is none. We compare eight bytes at a time using bitwise arithmetic:
+/// for every byte that equals a separator, the difference sets its high bit.
+/// Bytes after the first match may be false positives, which is fine because
+/// we only need the lowest match.
+auto find_separator(const char* begin, const char* end, char field_sep,
+                    char list_sep) -> const char* {
+  if constexpr (std::endian::native == std::endian::little) {
+    constexpr auto ones = uint64_t{0x0101010101010101};
+    constexpr auto highs = uint64_t{0x8080808080808080};
+    const auto field_seps = ones * static_cast<uint8_t>(field_sep);
+    const auto list_seps = ones * static_cast<uint8_t>(list_sep);
+    while (end - begin >= 8) {
+      auto word = uint64_t{};
+      std::memcpy(&word, begin, sizeof(word));
+      const auto x = word ^ field_seps;
+      const auto y = word ^ list_seps;
+      const auto mask = ((x - ones) & ~x & highs) | ((y - ones) & ~y & highs);
+      if (mask != 0) {
+        return begin + std::countr_zero(mask) / 8;
+      }
+      begin += sizeof(word);
+    }
+  }
+  return std::find_if(begin, end, [&](char c) {
+    return c == field_sep or c == list_sep;
+  });
+}
+
 } // namespace
 
 auto parse_impl(generator<std::optional<std::string_view>> lines,
@@ -313,6 +438,67 @@ auto parse_impl(generator<std::optional<std::string_view>> lines,
       .emit(ctrl.diagnostics());
     co_return;
   }
+  const auto single_value_delimiter
+    = (parsers::eoi | args.list_sep | args.field_sep);
+  const auto single_value_parser
+    = (parsers::lit{args.null_value} >> &single_value_delimiter)
+        .then([](std::string) {
+          return data{};
+        })
+      | (parsers::data >> &single_value_delimiter).with([](const data& d) {
+          return caf::visit(
+            []<class T>(const T&) {
+              return not detail::is_any_v<T, pattern, std::string, list,
+                                          record>;
+            },
+            d);
+        })
+      | (qqstring_value_parser >> &single_value_delimiter
+         | *(parsers::any - single_value_delimiter))
+          .then([](std::string str) {
+            return data{std::move(str)};
+          });
+  // We may only parse values of a known kind cell by cell if they cannot span
+  // multiple cells.
+  const auto parse_known_kinds = not may_occur_in_data(args.field_sep)
+                                 and not may_occur_in_data(args.list_sep);
+  const auto is_separator = [&](const char* f, const char* l) {
+    return f == l or *f == args.field_sep or *f == args.list_sep;
+  };
+  auto kinds = std::vector<value_kind>(fields.size());
+  // Parses the value that begins at `f` and advances `f` to the separator
+  // that follows it. Cells that cannot hold data become strings without
+  // trying any parser, and cells of a column with a known kind first try the
+  // parser for that kind. Everything else goes through the full grammar.
+  auto storage = data{};
+  const auto parse_value = [&](const char*& f, const char* l,
+                               value_kind& kind) -> std::optional<data_view2> {
+    const auto* cell_end = find_separator(f, l, args.field_sep, args.list_sep);
+    const auto cell = std::string_view{f, cell_end};
+    if (cell == args.null_value) {
+      f = cell_end;
+      return caf::none;
+    }
+    if (cell.empty()
+        or (cell.front() != '"' and not may_begin_data(cell.front()))) {
+      f = cell_end;
+      return cell;
+    }
+    if (parse_known_kinds) {
+      auto pos = f;
+      if (parse_as(kind, pos, l, storage) and is_separator(pos, l)) {
+        f = pos;
+        return storage;
+      }
+    }
+    auto pos = f;
+    if (not single_value_parser(pos, l, storage) or not is_separator(pos, l)) {
+      return std::nullopt;
+    }
+    kind = kind_of(storage);
+    f = pos;
+    return storage;
+  };
   auto b = series_builder{};
   for (; it != lines.end(); ++it) {
     auto line = *it;
@@ -338,69 +524,72 @@ auto parse_impl(generator<std::optional<std::string_view>> lines,
     if (args.allow_comments && line->front() == '#') {
       continue;
     }
-    const auto single_value_delimiter
-      = (parsers::eoi | args.list_sep | args.field_sep);
-    const auto single_value_parser
-      = (parsers::lit{args.null_value} >> &single_value_delimiter)
-          .then([](std::string) {
-            return data{};
-          })
-        | (parsers::data >> &single_value_delimiter).with([](const data& d) {
-            return caf::visit(
-              []<class T>(const T&) {
-                return not detail::is_any_v<T, pattern, std::string, list,
-                                            record>;
-              },
-              d);
-          })
-        | (qqstring_value_parser >> &single_value_delimiter
-           | *(parsers::any - single_value_delimiter))
-            .then([](std::string str) {
-              return data{std::move(str)};
-            });
-    const auto value_parser = (single_value_parser % args.list_sep)
-                                .then([](std::vector<data> values) -> data {
-                                  TENZIR_ASSERT(not values.empty());
-                                  if (values.size() == 1) {
-                                    return std::move(values[0]);
-                                  }
-                                  return values;
-                                });
-    auto values_parser = (value_parser % args.field_sep);
-    auto values = std::vector<data>{};
-    if (not values_parser(*line, values)) {
+    auto row = b.record();
+    const auto* f = line->data();
+    const auto* const l = f + line->size();
+    auto index = size_t{0};
+    auto excess = size_t{0};
+    auto generated_field_id = 0;
+    auto elements = list{};
+    auto excess_kind = value_kind::unknown;
+    auto failed = false;
+    while (true) {
+      auto& kind = index < kinds.size() ? kinds[index] : excess_kind;
+      auto value = parse_value(f, l, kind);
+      if (not value) {
+        failed = true;
+        break;
+      }
+      if (f != l and *f == args.list_sep) {
+        elements.push_back(materialize(value->operator data_view()));
+        ++f;
+        continue;
+      }
+      if (not elements.empty()) {
+        elements.push_back(materialize(value->operator data_view()));
+        storage = std::exchange(elements, {});
+        value = storage;
+      }
+      if (index >= fields.size() and args.auto_expand) {
+        while (fields.size() <= index) {
+          auto name = fmt::format("unnamed{}", ++generated_field_id);
+          if (std::find(fields.begin(), fields.end(), name) == fields.end()) {
+            fields.push_back(name);
+          }
+        }
+        kinds.resize(fields.size());
+      }
+      if (index < fields.size()) {
+        auto result = row.field(fields[index]).try_data(std::move(*value));
+        if (not result) {
+          diagnostic::warning(result.error())
+            .note("from `{}` parser", args.name)
+            .emit(ctrl.diagnostics());
+        }
+      } else {
+        ++excess;
+      }
+      ++index;
+      if (f == l) {
+        break;
+      }
+      ++f;
+    }
+    if (failed) {
+      b.remove_last();
       diagnostic::warning("skips unparseable line")
         .note("from `{}` parser", args.name)
         .emit(ctrl.diagnostics());
       continue;
     }
-    auto generated_field_id = 0;
-    if (args.auto_expand) {
-      while (fields.size() < values.size()) {
-        auto name = fmt::format("unnamed{}", ++generated_field_id);
-        if (std::find(fields.begin(), fields.end(), name) == fields.end()) {
-          fields.push_back(name);
-        }
-      }
-    } else if (fields.size() < values.size()) {
-      diagnostic::warning("skips {} excess values in line",
-                          values.size() - fields.size())
+    if (excess > 0) {
+      diagnostic::warning("skips {} excess values in line", excess)
         .hint("use `--auto-expand` to add fields for excess values")
         .note("from `{}` parser", args.name)
         .emit(ctrl.diagnostics());
     }
-    auto row = b.record();
-    for (size_t i = 0; i < fields.size(); ++i) {
-      if (i >= values.size()) {
-        row.field(fields[i]).null();
-        continue;
-      }
-      auto result = row.field(fields[i]).try_data(values[i]);
-      if (not result) {
-        diagnostic::warning(result.error())
-          .note("from `{}` parser", args.name)
-          .emit(ctrl.diagnostics());
-      }
+    for (; index < fields.size(); ++index) {
+      row.field(fields[index]).null();
     }
   }
   if (b.length() > 0) {
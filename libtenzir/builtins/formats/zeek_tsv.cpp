@@ -15,6 +15,7 @@
 #include "tenzir/concept/printable/tenzir/json.hpp"
 #include "tenzir/concept/printable/to_string.hpp"
 #include "tenzir/data.hpp"
+#include "tenzir/detail/narrow.hpp"
 #include "tenzir/detail/string.hpp"
 #include "tenzir/detail/string_literal.hpp"
 #include "tenzir/detail/to_xsv_sep.hpp"
@@ -28,6 +29,7 @@
 #include "tenzir/type.hpp"
 #include "tenzir/view.hpp"
 
+#include <arrow/memory_pool.h>
 #include <arrow/record_batch.h>
 #include <caf/error.hpp>
 #include <caf/expected.hpp>
@@ -40,113 +42,105 @@
 #include <iterator>
 #include <string>
 #include <string_view>
+#include <unordered_map>
+#include <utility>
 
 namespace tenzir::plugins::zeek_tsv {
 
 namespace {
 
-template <concrete_type Type>
-struct zeek_parser {
-  auto operator()(const Type&, char, const std::string&) const
-    -> rule<std::string_view::const_iterator, type_to_data_t<Type>> {
-    die("unexpected type");
-  }
-};
-
-template <>
-struct zeek_parser<bool_type> {
-  auto operator()(const bool_type&, char, const std::string&) const {
-    return parsers::tf;
-  }
-};
-
-template <>
-struct zeek_parser<int64_type> {
-  auto operator()(const int64_type&, char, const std::string&) const {
-    return parsers::i64;
-  }
-};
-
-template <>
-struct zeek_parser<uint64_type> {
-  auto operator()(const uint64_type&, char, const std::string&) const {
-    return parsers::u64;
-  }
-};
-
-template <>
-struct zeek_parser<double_type> {
-  auto operator()(const double_type&, char, const std::string&) const {
-    return parsers::real.then([](double x) {
-      return x;
-    });
-  }
-};
-
-template <>
-struct zeek_parser<duration_type> {
-  auto operator()(const duration_type&, char, const std::string&) const {
-    return parsers::real.then([](double x) {
-      return std::chrono::duration_cast<duration>(double_seconds(x));
-    });
-  }
-};
-
-template <>
-struct zeek_parser<time_type> {
-  auto operator()(const time_type&, char, const std::string&) const {
-    return parsers::real.then([](double x) {
-      return time{} + std::chrono::duration_cast<duration>(double_seconds(x));
-    });
-  }
-};
+/// Applies a parser to a string in place.
+/// @returns Whether the parser succeeded and consumed the entire input.
+template <class Parser, class Attribute>
+auto parse_entirely(const Parser& parser, std::string_view input,
+                    Attribute& x) -> bool {
+  const auto* f = input.data();
+  const auto* const l = input.data() + input.size();
+  return parser(f, l, x) and f == l;
+}
 
-template <>
-struct zeek_parser<string_type> {
-  auto operator()(const string_type&, char separator,
-                  const std::string& set_separator) const
-    -> rule<std::string_view::const_iterator, std::string> {
-    if (set_separator.empty()) {
-      return (+(parsers::any - separator)).then([](std::string x) {
-        return detail::byte_unescape(x);
-      });
+/// Parses a single Zeek value and appends it to a builder. The value must
+/// span the entire input, which makes it possible to parse numbers in place
+/// and to append strings without escape sequences directly from the line.
+/// @returns Whether the input is a valid value of the given type.
+template <concrete_type Type>
+auto append_zeek_value(const Type& type,
+                       type_to_arrow_builder_t<Type>& builder,
+                       std::string_view value, std::string_view set_separator)
+  -> bool {
+  if constexpr (std::is_same_v<Type, bool_type>) {
+    auto x = false;
+    return parse_entirely(parsers::tf, value, x) and builder.Append(x).ok();
+  } else if constexpr (std::is_same_v<Type, int64_type>) {
+    auto x = int64_t{};
+    return parse_entirely(parsers::i64, value, x) and builder.Append(x).ok();
+  } else if constexpr (std::is_same_v<Type, uint64_type>) {
+    auto x = uint64_t{};
+    return parse_entirely(parsers::u64, value, x) and builder.Append(x).ok();
+  } else if constexpr (std::is_same_v<Type, double_type>) {
+    auto x = double{};
+    return parse_entirely(parsers::real, value, x) and builder.Append(x).ok();
+  } else if constexpr (std::is_same_v<Type, duration_type>
+                       or std::is_same_v<Type, time_type>) {
+    auto x = double{};
+    if (not parse_entirely(parsers::real, value, x)) {
+      return false;
     }
-    return (+(parsers::any - separator - set_separator)).then([](std::string x) {
-      return detail::byte_unescape(x);
-    });
-  }
-};
-
-template <>
-struct zeek_parser<ip_type> {
-  auto operator()(const ip_type&, char, const std::string&) const {
-    return parsers::ip;
-  }
-};
-
-template <>
-struct zeek_parser<subnet_type> {
-  auto operator()(const subnet_type&, char, const std::string&) const {
-    return parsers::net;
-  }
-};
-
-template <>
-struct zeek_parser<list_type> {
-  auto operator()(const list_type& lt, char separator,
-                  const std::string& set_separator) const {
-    auto f
-      = [&]<concrete_type Type>(
-          const Type& type) -> rule<std::string_view::const_iterator, list> {
-      return (zeek_parser<Type>{}(type, separator, set_separator)
-                .then([](type_to_data_t<Type> value) {
-                  return data{value};
-                })
-              % set_separator);
+    auto result = std::chrono::duration_cast<duration>(double_seconds(x));
+    if constexpr (std::is_same_v<Type, time_type>) {
+      return append_builder(type, builder, time{} + result).ok();
+    } else {
+      return append_builder(type, builder, result).ok();
+    }
+  } else if constexpr (std::is_same_v<Type, string_type>) {
+    // TODO: A zeek `string` is not necessarily valid UTF-8, but our
+    // `string_type` requires it. We must use `blob` here instead of the string
+    // turns out to contain invalid UTF-8.
+    if (value.empty()) {
+      return false;
+    }
+    if (value.find('\\') == std::string_view::npos) {
+      return builder.Append(value).ok();
+    }
+    return builder.Append(detail::byte_unescape(value)).ok();
+  } else if constexpr (std::is_same_v<Type, ip_type>) {
+    auto x = ip{};
+    return parse_entirely(parsers::ip, value, x)
+           and append_builder(type, builder, x).ok();
+  } else if constexpr (std::is_same_v<Type, subnet_type>) {
+    auto x = subnet{};
+    return parse_entirely(parsers::net, value, x)
+           and append_builder(type, builder, x).ok();
+  } else if constexpr (std::is_same_v<Type, list_type>) {
+    // The elements of a list are delimited by the set separator, so we only
+    // need to find the offsets of the separators and append the elements
+    // in between to the value builder.
+    if (not builder.Append().ok()) {
+      return false;
+    }
+    auto append_values
+      = [&]<concrete_type ValueType>(const ValueType& value_type) {
+      auto& value_builder = caf::get<type_to_arrow_builder_t<ValueType>>(
+        *builder.value_builder());
+      while (true) {
+        const auto end = set_separator.empty()
+                           ? std::string_view::npos
+                           : value.find(set_separator);
+        if (not append_zeek_value(value_type, value_builder,
+                                  value.substr(0, end), set_separator)) {
+          return false;
+        }
+        if (end == std::string_view::npos) {
+          return true;
+        }
+        value.remove_prefix(end + set_separator.size());
+      }
     };
-    return caf::visit(f, lt.value_type());
+    return caf::visit(append_values, type.value_type());
+  } else {
+    die("unexpected type");
   }
-};
+}
 
 // Creates a Tenzir type from an ASCII Zeek type in a log header.
 auto parse_type(std::string_view zeek_type) -> caf::expected<type> {
@@ -470,6 +464,21 @@ struct zeek_printer {
   bool disable_timestamp_tags{false};
 };
 
+/// The schema of a Zeek document together with the builders for its columns.
+/// Layouts depend only on the #path, #fields, and #types headers, so we reuse
+/// them across documents with the same headers.
+struct zeek_layout {
+  type schema = {};
+  std::shared_ptr<arrow::Schema> arrow_schema = {};
+  type target_schema = {};
+  std::vector<type> types = {};
+  std::vector<std::shared_ptr<arrow::ArrayBuilder>> builders = {};
+  int64_t rows = {};
+};
+
+/// The maximum number of distinct layouts that we keep around.
+constexpr auto max_cached_layouts = size_t{1'024};
+
 struct zeek_document {
   /// Optional metadata.
   char separator = '\t';
@@ -482,32 +491,64 @@ struct zeek_document {
   std::vector<std::string> fields = {};
   std::vector<std::string> types = {};
 
-  /// A builder generated from the above metadata.
-  std::optional<table_slice_builder> builder = {};
-  std::vector<rule<std::string_view::const_iterator, bool>> parsers = {};
-  type target_schema = {};
+  /// The layout generated from the above metadata.
+  zeek_layout* layout = {};
 };
 
+/// Returns the key of the layout cache for the headers of a document.
+auto make_layout_key(const zeek_document& document) -> std::string {
+  // We prefix every string with its length to make the key unambiguous.
+  auto result = std::string{};
+  auto out = std::back_inserter(result);
+  out = fmt::format_to(out, "{}:{}", document.path.size(), document.path);
+  for (const auto& field : document.fields) {
+    out = fmt::format_to(out, "{}:{}", field.size(), field);
+  }
+  for (const auto& zeek_type : document.types) {
+    out = fmt::format_to(out, "{}:{}", zeek_type.size(), zeek_type);
+  }
+  return result;
+}
+
 auto parser_impl(generator<std::optional<std::string_view>> lines,
                  operator_control_plane& ctrl) -> generator<table_slice> {
   auto document = zeek_document{};
+  auto layouts = std::unordered_map<std::string, zeek_layout>{};
   auto last_finish = std::chrono::steady_clock::now();
   auto line_nr = size_t{0};
   // Helper for finishing and casting.
   auto finish = [&] {
-    auto slice = unflatten(document.builder->finish(), ".");
-    if (document.target_schema
-        and can_cast(slice.schema(), document.target_schema)) {
-      return cast(std::move(slice), document.target_schema);
+    auto& layout = *document.layout;
+    auto arrays = arrow::ArrayVector{};
+    arrays.reserve(layout.builders.size());
+    for (const auto& builder : layout.builders) {
+      arrays.push_back(builder->Finish().ValueOrDie());
+    }
+    auto batch = arrow::RecordBatch::Make(
+      layout.arrow_schema, std::exchange(layout.rows, 0), std::move(arrays));
+    auto slice = unflatten(table_slice{batch, layout.schema}, ".");
+    if (layout.target_schema
+        and can_cast(slice.schema(), layout.target_schema)) {
+      return cast(std::move(slice), layout.target_schema);
     } else {
       return slice;
     }
   };
+  // Helper for dropping the rows of the current layout, including the values
+  // of a partially parsed row, so that all builders have the same length.
+  auto discard = [&] {
+    auto& layout = *document.layout;
+    for (const auto& builder : layout.builders) {
+      builder->Reset();
+    }
+    layout.rows = 0;
+  };
   for (auto&& line : lines) {
     const auto now = std::chrono::steady_clock::now();
     // Yield at chunk boundaries.
-    if (document.builder
-        and (document.builder->rows() >= defaults::import::table_slice_size
+    if (document.layout and document.layout->rows > 0
+        and (detail::narrow<size_t>(document.layout->rows)
+               >= defaults::import::table_slice_size
              or last_finish + defaults::import::batch_timeout < now)) {
       last_finish = now;
       co_yield finish();
@@ -541,7 +582,7 @@ auto parser_impl(generator<std::optional<std::string_view>> lines,
             (void)close;
           });
       if (close_parser(header, unused)) {
-        if (document.builder) {
+        if (document.layout) {
           last_finish = now;
           co_yield finish();
           document = {};
@@ -549,10 +590,10 @@ auto parser_impl(generator<std::optional<std::string_view>> lines,
         continue;
       }
       // For all header other than #close, we should not have an existing
-      // builder anymore. If that's the case then we have a bug in the data,
+      // layout anymore. If that's the case then we have a bug in the data,
       // but we can just handle that gracefully and tell the user that they
       // were missing a closing tag.
-      if (document.builder) {
+      if (document.layout) {
         last_finish = now;
         co_yield finish();
         document = {};
@@ -618,11 +659,8 @@ auto parser_impl(generator<std::optional<std::string_view>> lines,
       }
       continue;
     }
-    // If we don't have a builder yet, then we create one lazily.
-    if (not document.builder) {
-      // We parse the header into three things:
-      // 1. A schema that we create the builder with.
-      // 2. A rule that parses lines according to the schema.
+    // If we don't have a layout yet, then we look it up or create one lazily.
+    if (not document.layout) {
       if (document.path.empty()) {
         diagnostic::error("failed to parse Zeek document: missing #path")
           .note("line {}", line_nr)
@@ -644,116 +682,123 @@ auto parser_impl(generator<std::optional<std::string_view>> lines,
           .emit(ctrl.diagnostics());
         co_return;
       }
-      // Now we create the schema and the parser rule.
-      document.parsers.reserve(document.fields.size());
-      auto record_fields = std::vector<record_type::field_view>{};
-      record_fields.reserve(document.fields.size());
-      for (const auto& [field, zeek_type] :
-           detail::zip(document.fields, document.types)) {
-        auto parsed_type = parse_type(zeek_type);
-        if (not parsed_type) {
-          diagnostic::warning("failed to parse Zeek type `{}`", zeek_type)
-            .note("line {}", line_nr)
-            .note("falling back to `string", line_nr)
-            .emit(ctrl.diagnostics());
-          parsed_type = type{string_type{}};
+      auto key = make_layout_key(document);
+      if (auto it = layouts.find(key); it != layouts.end()) {
+        document.layout = &it->second;
+      } else {
+        // All layouts are empty outside of a document, so we can safely
+        // start over when there are too many of them.
+        if (layouts.size() >= max_cached_layouts) {
+          layouts.clear();
         }
-        const auto make_unset_parser = [&]() {
-          return ignore(parsers::str{document.unset_field}
-                        >> &(parsers::chr{document.separator} | parsers::eoi))
-            .then([&]() {
-              return document.builder->add(caf::none);
-            });
-        };
-        const auto make_empty_parser
-          = [&]<concrete_type Type>(const Type& type) {
-              return ignore(parsers::str{document.empty_field} >> &(
-                              parsers::chr{document.separator} | parsers::eoi))
-                .then([&]() {
-                  return document.builder->add(type.construct());
-                });
-            };
-        auto make_field_parser =
-          [&]<concrete_type Type>(
-            const Type& type) -> rule<std::string_view::const_iterator, bool> {
-          return make_unset_parser() | make_empty_parser(type)
-                 | zeek_parser<Type>{}(type, document.separator,
-                                       std::is_same_v<Type, list_type>
-                                         ? document.set_separator
-                                         : std::string{})
-                     .then([&](type_to_data_t<Type> value) {
-                       // TODO: A zeek `string` is not necessarily valid UTF-8,
-                       // but our `string_type` requires it. We must use `blob`
-                       // here instead of the string turns out to contain
-                       // invalid UTF-8.
-                       return document.builder->add(value);
-                     });
-        };
-        document.parsers.push_back(caf::visit(make_field_parser, *parsed_type));
-        record_fields.push_back({field, std::move(*parsed_type)});
-      }
-      const auto schema_name = fmt::format("zeek.{}", document.path);
-      auto schema = type{schema_name, record_type{record_fields}};
-      document.builder = table_slice_builder{std::move(schema)};
-      // If there is a schema with the exact matching name, then we set it as a
-      // target schema and use that for casting.
-      auto target_schema
-        = std::find_if(modules::schemas().begin(), modules::schemas().end(),
-                       [&](const auto& schema) {
-                         for (const auto& name : schema.names()) {
-                           if (name == schema_name) {
-                             return true;
+        auto layout = zeek_layout{};
+        layout.types.reserve(document.fields.size());
+        layout.builders.reserve(document.fields.size());
+        auto record_fields = std::vector<record_type::field_view>{};
+        record_fields.reserve(document.fields.size());
+        for (const auto& [field, zeek_type] :
+             detail::zip(document.fields, document.types)) {
+          auto parsed_type = parse_type(zeek_type);
+          if (not parsed_type) {
+            diagnostic::warning("failed to parse Zeek type `{}`", zeek_type)
+              .note("line {}", line_nr)
+              .note("falling back to `string", line_nr)
+              .emit(ctrl.diagnostics());
+            parsed_type = type{string_type{}};
+          }
+          layout.builders.push_back(
+            parsed_type->make_arrow_builder(arrow::default_memory_pool()));
+          layout.types.push_back(*parsed_type);
+          record_fields.push_back({field, std::move(*parsed_type)});
+        }
+        const auto schema_name = fmt::format("zeek.{}", document.path);
+        layout.schema = type{schema_name, record_type{record_fields}};
+        layout.arrow_schema = layout.schema.to_arrow_schema();
+        // If there is a schema with the exact matching name, then we set it as
+        // a target schema and use that for casting.
+        auto target_schema
+          = std::find_if(modules::schemas().begin(), modules::schemas().end(),
+                         [&](const auto& schema) {
+                           for (const auto& name : schema.names()) {
+                             if (name == schema_name) {
+                               return true;
+                             }
                            }
-                         }
-                         return false;
-                       });
-      document.target_schema
-        = target_schema == modules::schemas().end() ? type{} : *target_schema;
-      // We intentionally fall through here; we create the builder lazily
+                           return false;
+                         });
+        layout.target_schema
+          = target_schema == modules::schemas().end() ? type{} : *target_schema;
+        document.layout
+          = &layouts.emplace(std::move(key), std::move(layout)).first->second;
+      }
+      // We intentionally fall through here; we create the layout lazily
       // when we encounter the first event, but that we still need to parse
       // now.
     }
-    // Lastly, we can apply our rules and parse the builder.
-    auto f = line->begin();
-    const auto l = line->end();
-    auto add_ok = false;
-    const auto separator = ignore(parsers::chr{document.separator});
-    for (size_t i = 0; i < document.parsers.size() - 1; ++i) {
-      const auto parse_ok = document.parsers[i](f, l, add_ok);
-      if (not parse_ok) [[unlikely]] {
+    // Lastly, we split the line at the separators and append the values
+    // directly to the builders of their columns.
+    auto& layout = *document.layout;
+    auto remainder = *line;
+    for (auto i = size_t{0}; i < layout.builders.size(); ++i) {
+      const auto end = remainder.find(document.separator);
+      const auto value = remainder.substr(0, end);
+      auto& builder = *layout.builders[i];
+      auto append_ok = false;
+      if (value.empty()) [[unlikely]] {
+        // Zeek writes the empty field marker for empty values, so no type
+        // accepts a value without characters.
+        append_ok = false;
+      } else if (value == document.unset_field) {
+        append_ok = builder.AppendNull().ok();
+      } else if (value == document.empty_field) {
+        append_ok = caf::visit(
+          [&]<concrete_type Type>(const Type& type) {
+            const auto empty = type.construct();
+            return append_builder(
+                     type, caf::get<type_to_arrow_builder_t<Type>>(builder),
+                     make_view(empty))
+              .ok();
+          },
+          layout.types[i]);
+      } else {
+        append_ok = caf::visit(
+          [&]<concrete_type Type>(const Type& type) {
+            return append_zeek_value(
+              type, caf::get<type_to_arrow_builder_t<Type>>(builder), value,
+              document.set_separator);
+          },
+          layout.types[i]);
+      }
+      if (not append_ok) [[unlikely]] {
         diagnostic::error("failed to parse Zeek value at index {} in `{}`", i,
                           *line)
           .note("line {}", line_nr)
           .emit(ctrl.diagnostics());
+        discard();
         co_return;
       }
-      TENZIR_ASSERT_EXPENSIVE(add_ok);
-      const auto separator_ok = separator(f, l, unused);
-      if (not separator_ok) [[unlikely]] {
+      if (i + 1 == layout.builders.size()) {
+        if (end != std::string_view::npos) [[unlikely]] {
+          diagnostic::warning("unparsed values at end of Zeek line: `{}`",
+                              remainder.substr(end))
+            .note("line {}", line_nr)
+            .emit(ctrl.diagnostics());
+        }
+        break;
+      }
+      if (end == std::string_view::npos) [[unlikely]] {
         diagnostic::error("failed to parse Zeek separator at index {} in `{}`",
                           i, *line)
           .note("line {}", line_nr)
           .emit(ctrl.diagnostics());
+        discard();
         co_return;
       }
+      remainder.remove_prefix(end + 1);
     }
-    const auto parse_ok = document.parsers.back()(f, l, add_ok);
-    if (not parse_ok) [[unlikely]] {
-      diagnostic::error("failed to parse Zeek value at index {} in `{}`",
-                        document.parsers.size() - 1, *line)
-        .note("line {}", line_nr)
-        .emit(ctrl.diagnostics());
-      co_return;
-    }
-    const auto eoi_ok = parsers::eoi(f, l, unused);
-    if (not eoi_ok) [[unlikely]] {
-      diagnostic::warning("unparsed values at end of Zeek line: `{}`",
-                          std::string_view{f, l})
-        .note("line {}", line_nr)
-        .emit(ctrl.diagnostics());
-    }
+    ++layout.rows;
   }
-  if (document.builder and document.builder->rows() > 0) {
+  if (document.layout and document.layout->rows > 0) {
     co_yield finish();
   }
 }
@@ -104,6 +104,12 @@ public:
       filter, order, std::make_unique<batch_operator>(limit_, timeout_, order)};
   }
 
+  auto
+  optimize_projection(const std::optional<std::vector<std::string>>& fields)
+    const -> projection_result override {
+    return projection_result::passthrough(*this, fields);
+  }
+
   auto name() const -> std::string override {
     return "batch";
   }
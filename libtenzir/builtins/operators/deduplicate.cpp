@@ -10,97 +10,206 @@
 #include <tenzir/arrow_table_slice.hpp>
 #include <tenzir/collect.hpp>
 #include <tenzir/concept/parseable/tenzir/pipeline.hpp>
+#include <tenzir/defaults.hpp>
+#include <tenzir/detail/narrow.hpp>
+#include <tenzir/hash/hash.hpp>
+#include <tenzir/hash/xxhash.hpp>
 #include <tenzir/plugin.hpp>
 #include <tenzir/tql/parser.hpp>
 
+#include <tsl/robin_map.h>
+
+#include <algorithm>
+#include <bit>
+#include <concepts>
+#include <limits>
+#include <numeric>
 #include <ranges>
 
 namespace tenzir::plugins::deduplicate {
 namespace {
 
-/// Returns `true` if
-///  - `rec` is a flat record (depth of 0 or 1), and
-///  - the keys of `rec` are sorted.
-/// Requires `d` to be a record.
-auto is_sorted_and_flattened(const record& rec) -> bool {
-  if (depth(rec) > 1) {
-    return false;
+using std::chrono::steady_clock;
+
+/// A 128-bit fingerprint of the deduplication key of a row. We store and
+/// compare fingerprints instead of the keys themselves, which makes the size of
+/// a match independent of its key, at a negligible probability of collisions.
+struct fingerprint {
+  uint64_t lo = {};
+  uint64_t hi = {};
+
+  friend auto operator==(const fingerprint&, const fingerprint&) -> bool
+    = default;
+};
+
+struct fingerprint_hash {
+  auto operator()(const fingerprint& x) const noexcept -> size_t {
+    // The fingerprint is a hash digest already.
+    return x.lo;
   }
-  return std::ranges::is_sorted(rec | std::views::keys);
+};
+
+/// Mixes a hash digest into a fingerprint. Both halves are mixed with a
+/// bijection, so fingerprints only collide if the digests collide.
+void mix(fingerprint& x, const XXH128_hash_t& digest) {
+  x.lo = std::rotl(x.lo ^ digest.low64, 29) * 0x9e3779b97f4a7c15;
+  x.hi = std::rotl(x.hi ^ digest.high64, 31) * 0xc2b2ae3d27d4eb4f;
 }
 
-/// Flattens `rec`, and sorts it keys.
-/// Postcondition: `is_sorted_and_flattened(rec)` is `true`.
-void make_sorted_and_flattened(record& rec) {
-  if (depth(rec) > 1) {
-    rec = flatten(rec);
+/// Computes the fingerprints of all rows of a flat record batch. We hash one
+/// column at a time, and mix the columns in order of their names, so that the
+/// fingerprints do not depend on the order of the fields.
+auto make_fingerprints(const type& schema, const arrow::RecordBatch& batch)
+  -> std::vector<fingerprint> {
+  const auto& layout = caf::get<record_type>(schema);
+  auto order = std::vector<size_t>(layout.num_fields());
+  std::iota(order.begin(), order.end(), size_t{0});
+  std::ranges::sort(order, std::ranges::less{}, [&](size_t i) {
+    return layout.field(i).name;
+  });
+  auto result
+    = std::vector<fingerprint>(detail::narrow<size_t>(batch.num_rows()));
+  for (auto i : order) {
+    const auto field = layout.field(i);
+    // The name of a column is part of the key, and so is its type unless the
+    // value is null. This way, a null value equals a missing field, whose
+    // type is null after the projection.
+    const auto null_header = hash<xxh3_128>(field.name);
+    const auto header = hash<xxh3_128>(field.name, field.type.type_index());
+    const auto& array = *batch.column(detail::narrow<int>(i));
+    auto f = [&]<concrete_type Type>(const Type& ty) {
+      auto row = size_t{0};
+      for (auto&& value :
+           values(ty, caf::get<type_to_arrow_array_t<Type>>(array))) {
+        auto& x = result[row++];
+        if (value) {
+          mix(x, header);
+          mix(x, hash<xxh3_128>(*value));
+        } else {
+          mix(x, null_header);
+        }
+      }
+    };
+    caf::visit(f, field.type);
   }
-  std::ranges::sort(rec, std::ranges::less{}, &record::value_type::first);
+  return result;
 }
 
-/// A wrapper for `record`,
-/// where `is_sorted_and_flattened(get())` is always `true`.
-///
-/// Used as the key in the `matches` hashmap in `deduplicate`,
-/// to allow for transparent comparison irrespective of field ordering.
-class sorted_flat_record {
+/// The matches of all keys that were not evicted yet, ordered by their last
+/// occurrence. The matches live in a slab and form an intrusive doubly-linked
+/// list, so that a match moves to the back whenever it occurs again, and
+/// expired or excess matches are evicted from the front without scanning.
+class match_table {
+  static constexpr auto npos = std::numeric_limits<uint32_t>::max();
+
 public:
-  sorted_flat_record() = default;
+  struct match {
+    int64_t count{0};
+    int64_t last_row_number{0};
+    steady_clock::time_point last_time{};
+  };
 
-  sorted_flat_record(const record& x) : inner_(construct(x)) {
+  /// Creates an empty table.
+  /// @param capacity The maximum number of matches before the table evicts
+  /// the least recently occurred ones, or 0 for no limit.
+  explicit match_table(size_t capacity)
+    : capacity_{capacity == 0 ? size_t{npos}
+                              : std::min(capacity, size_t{npos})} {
+    // nop
   }
 
-  sorted_flat_record(record&& x) : inner_(construct(std::move(x))) {
+  /// Returns the match for a key, which is created if it does not exist, and
+  /// marks it as the most recently occurred one.
+  auto touch(const fingerprint& key, int64_t row_number,
+             steady_clock::time_point now) -> match& {
+    if (auto it = index_.find(key); it != index_.end()) {
+      const auto i = it->second;
+      unlink(i);
+      link_back(i);
+      return nodes_[i].value;
+    }
+    if (index_.size() >= capacity_) {
+      erase(head_);
+      ++num_forced_evictions_;
+    }
+    auto i = uint32_t{};
+    if (free_.empty()) {
+      i = detail::narrow<uint32_t>(nodes_.size());
+      nodes_.emplace_back();
+    } else {
+      i = free_.back();
+      free_.pop_back();
+    }
+    nodes_[i].key = key;
+    nodes_[i].value = match{
+      .count = 0,
+      .last_row_number = row_number,
+      .last_time = now,
+    };
+    index_.emplace(key, i);
+    link_back(i);
+    return nodes_[i].value;
   }
 
-  auto get() -> record& {
-    return inner_;
-  }
-  auto get() const -> const record& {
-    return inner_;
+  /// Returns the number of matches that were evicted before they expired
+  /// because the table reached its capacity.
+  auto num_forced_evictions() const -> size_t {
+    return num_forced_evictions_;
   }
 
-  auto operator==(const sorted_flat_record& other) const -> bool {
-    return inner_ == other.inner_;
+  /// Evicts matches from the front for as long as they are expired.
+  void evict(std::predicate<const match&> auto expired) {
+    while (head_ != npos and expired(nodes_[head_].value)) {
+      erase(head_);
+    }
   }
 
 private:
-  static auto construct(const record& x) -> record {
-    if (is_sorted_and_flattened(x)) {
-      return x;
-    }
-    auto y = x;
-    make_sorted_and_flattened(y);
-    return y;
-  }
+  struct node {
+    fingerprint key = {};
+    match value = {};
+    uint32_t prev = npos;
+    uint32_t next = npos;
+  };
+
+public:
+  /// An estimate of the memory that a single match uses, including its slot
+  /// in the index at the maximum load factor.
+  static constexpr auto bytes_per_match
+    = sizeof(node) + 2 * sizeof(std::pair<fingerprint, uint32_t>);
 
-  static auto construct(record&& x) -> record {
-    if (not is_sorted_and_flattened(x)) {
-      make_sorted_and_flattened(x);
+private:
+  void link_back(uint32_t i) {
+    nodes_[i].prev = tail_;
+    nodes_[i].next = npos;
+    if (tail_ != npos) {
+      nodes_[tail_].next = i;
+    } else {
+      head_ = i;
     }
-    return x;
+    tail_ = i;
   }
 
-  record inner_{};
-};
-} // namespace
-} // namespace tenzir::plugins::deduplicate
-
-namespace std {
-template <>
-struct hash<tenzir::plugins::deduplicate::sorted_flat_record> {
-  auto
-  operator()(const tenzir::plugins::deduplicate::sorted_flat_record& x) const
-    -> size_t {
-    return tenzir::hash(x.get());
+  void unlink(uint32_t i) {
+    const auto& x = nodes_[i];
+    (x.prev != npos ? nodes_[x.prev].next : head_) = x.next;
+    (x.next != npos ? nodes_[x.next].prev : tail_) = x.prev;
   }
-};
-} // namespace std
 
-namespace tenzir::plugins::deduplicate {
-namespace {
+  void erase(uint32_t i) {
+    unlink(i);
+    index_.erase(nodes_[i].key);
+    free_.push_back(i);
+  }
 
-using std::chrono::steady_clock;
+  size_t capacity_ = {};
+  size_t num_forced_evictions_ = {};
+  std::vector<node> nodes_ = {};
+  std::vector<uint32_t> free_ = {};
+  uint32_t head_ = npos;
+  uint32_t tail_ = npos;
+  tsl::robin_map<fingerprint, uint32_t, fingerprint_hash> index_ = {};
+};
 
 struct configuration {
   friend auto inspect(auto& f, configuration& x) -> bool {
@@ -108,7 +217,8 @@ struct configuration {
                               f.field("limit", x.limit),
                               f.field("distance", x.distance),
                               f.field("timeout", x.timeout),
-                              f.field("project_only", x.project_only));
+                              f.field("project_only", x.project_only),
+                              f.field("memory_budget", x.memory_budget));
   }
 
   std::vector<std::string> fields{};
@@ -116,6 +226,7 @@ struct configuration {
   int64_t distance{};
   steady_clock::duration timeout{};
   bool project_only{false};
+  uint64_t memory_budget{defaults::deduplicate::memory_budget};
 };
 
 class deduplicate_operator final : public crtp_operator<deduplicate_operator> {
@@ -129,10 +240,15 @@ public:
   operator()(generator<table_slice> input, operator_control_plane& ctrl) const
     -> generator<table_slice> {
     projection_cache cached_projections{};
-    match_store matches{};
+    // A memory budget of 0 means that we remember all keys.
+    auto matches = match_table{
+      cfg_.memory_budget == 0
+        ? size_t{0}
+        : std::max(detail::narrow_cast<size_t>(cfg_.memory_budget
+                                               / match_table::bytes_per_match),
+                   size_t{1})};
     int64_t row_number{0};
-    int64_t last_cleanup_row{0};
-    auto last_cleanup_time = steady_clock::now();
+    auto warned_about_budget = false;
     for (auto&& slice : input) {
       if (slice.rows() == 0) {
         co_yield {};
@@ -154,28 +270,40 @@ public:
         co_yield table_slice{projected_batch, projected_type};
         continue;
       }
-      auto elements = projected_batch->ToStructArray().ValueOrDie();
-      TENZIR_ASSERT(elements);
+      // Evict the matches that expired since the last slice. As the matches
+      // are ordered by their last occurrence, we only need to look at the
+      // expired ones.
+      const auto now = steady_clock::now();
+      matches.evict([&](const match_table::match& match) {
+        return row_number - match.last_row_number > cfg_.distance
+               || now - match.last_time > cfg_.timeout;
+      });
+      const auto fingerprints
+        = make_fingerprints(projected_type, *projected_batch);
       for (auto&& new_slice :
-           deduplicate(matches, row_number, slice, projected_type, *elements)) {
+           deduplicate(matches, row_number, now, slice, fingerprints)) {
         if (new_slice.rows() > 0) {
           co_yield std::move(new_slice);
         }
       }
-      // Clean up `matches` and `cached_indices` every so often:
-      //  - we haven't cleaned up in a while (half the --timeout)
-      //  - we haven't cleaned up in N rows (where N = --distance)
-      //  - the projection cache has grown to over 256 elements
-      //    (there's probably no need to ever cache more than 256 projections,
-      //     but this number isn't based on any objective measurement)
-      if (const auto now = steady_clock::now();
-          now - last_cleanup_time > cfg_.timeout / 2
-          || row_number - last_cleanup_row > cfg_.distance
-          || cached_projections.size() > 256) {
-        cleanup_matches(matches, row_number);
+      // Forgetting keys before they expire silently changes the result, so we
+      // tell the user about it once.
+      if (not warned_about_budget and matches.num_forced_evictions() > 0) {
+        diagnostic::warning("deduplicate exceeded its memory budget of {} "
+                            "bytes",
+                            cfg_.memory_budget)
+          .note("the operator forgets the least recently seen keys, so their "
+                "next occurrence is no longer considered a duplicate")
+          .hint("increase `tenzir.deduplicate-memory-budget`, or set it to 0 "
+                "to remember all keys")
+          .emit(ctrl.diagnostics());
+        warned_about_budget = true;
+      }
+      // Clean up `cached_projections` when it has grown to over 256 elements
+      // (there's probably no need to ever cache more than 256 projections,
+      // but this number isn't based on any objective measurement).
+      if (cached_projections.size() > 256) {
         cleanup_projection_cache(cached_projections);
-        last_cleanup_time = now;
-        last_cleanup_row = row_number;
         co_yield {};
       }
     }
@@ -235,13 +363,6 @@ private:
   };
   using projection_cache = std::unordered_map<type, cached_projection>;
 
-  struct match_type {
-    int64_t count{0};
-    int64_t last_row_number{0};
-    steady_clock::time_point last_time{steady_clock::now()};
-  };
-  using match_store = std::unordered_map<sorted_flat_record, match_type>;
-
   /// Project `slice` based on the configuration,
   /// and return the projected table slice.
   /// On error, returns `pair{null_type, nullptr}`.
@@ -265,25 +386,15 @@ private:
     return projection.apply(flattened_slice);
   }
 
-  auto deduplicate(match_store& matches, int64_t& row_number,
-                   const table_slice& slice, const type& projected_type,
-                   const arrow::Array& projected_elements) const
+  auto deduplicate(match_table& matches, int64_t& row_number,
+                   steady_clock::time_point now, const table_slice& slice,
+                   std::span<const fingerprint> fingerprints) const
     -> generator<table_slice> {
+    TENZIR_ASSERT(fingerprints.size() == slice.rows());
     size_t begin{};
-    const auto now = steady_clock::now();
     // Logic adapted from the `unique` operator
     for (size_t row = 0; row < slice.rows(); ++row) {
-      auto projected_value_view = value_at(projected_type, projected_elements,
-                                           static_cast<int64_t>(row));
-      auto projected_value = materialize(projected_value_view);
-      TENZIR_ASSERT(caf::holds_alternative<record>(projected_value));
-      auto& projected_record = caf::get<record>(projected_value);
-      auto match_it = matches.find(projected_record);
-      if (match_it == matches.end()) {
-        std::tie(match_it, std::ignore)
-          = matches.emplace(std::move(projected_record), match_type{});
-      }
-      auto& match = match_it->second;
+      auto& match = matches.touch(fingerprints[row], row_number, now);
       // This value hasn't been matched within the timeout,
       // reset match count to zero
       if (now - match.last_time > cfg_.timeout) {
@@ -307,25 +418,6 @@ private:
     co_yield subslice(slice, begin, slice.rows());
   }
 
-  auto cleanup_matches(match_store& matches, int64_t row_number) const -> void {
-    if (cfg_.distance == std::numeric_limits<int64_t>::max()
-        && cfg_.limit == std::numeric_limits<int64_t>::max()) {
-      return;
-    }
-    const auto now = steady_clock::now();
-    // Erase stale matches
-    std::erase_if(matches, [&](const auto& elem) -> bool {
-      auto& match = elem.second;
-      if (row_number - match.last_row_number > cfg_.distance) {
-        return true;
-      }
-      if (now - match.last_time > cfg_.timeout) {
-        return true;
-      }
-      return false;
-    });
-  }
-
   static auto cleanup_projection_cache(projection_cache& cache) -> void {
     // Not cleaning up cache if we're caching less than 128 items
     if (cache.size() < 128) {
@@ -497,6 +589,22 @@ auto deduplicate_operator::cached_projection::apply(
 
 class plugin final : public virtual operator_plugin<deduplicate_operator> {
 public:
+  auto initialize([[maybe_unused]] const record& plugin_config,
+                  const record& global_config) -> caf::error override {
+    auto memory_budget
+      = try_get_or<uint64_t>(global_config, "tenzir.deduplicate-memory-budget",
+                             defaults::deduplicate::memory_budget);
+    if (not memory_budget) {
+      return caf::make_error(ec::invalid_configuration,
+                             fmt::format("failed to parse "
+                                         "`tenzir.deduplicate-memory-budget` "
+                                         "option: {}",
+                                         memory_budget.error()));
+    }
+    memory_budget_ = *memory_budget;
+    return {};
+  }
+
   auto signature() const -> operator_signature override {
     return {.transformation = true};
   }
@@ -577,12 +685,16 @@ public:
       .timeout = timeout.value_or(
         steady_clock::duration{std::numeric_limits<int64_t>::max()}),
       .project_only = project_only,
+      .memory_budget = memory_budget_,
     });
     return {
       std::string_view{op_end, l},
       std::move(op),
     };
   }
+
+private:
+  uint64_t memory_budget_ = defaults::deduplicate::memory_budget;
 };
 
 } // namespace
@@ -12,17 +12,23 @@
 #include <tenzir/catalog.hpp>
 #include <tenzir/concept/parseable/string/char_class.hpp>
 #include <tenzir/concept/parseable/tenzir/pipeline.hpp>
+#include <tenzir/defaults.hpp>
+#include <tenzir/detail/prefetch_queue.hpp>
 #include <tenzir/error.hpp>
+#include <tenzir/evaluate.hpp>
+#include <tenzir/instrumentation.hpp>
 #include <tenzir/logger.hpp>
 #include <tenzir/node_control.hpp>
 #include <tenzir/passive_partition.hpp>
 #include <tenzir/pipeline.hpp>
 #include <tenzir/plugin.hpp>
 #include <tenzir/query_context.hpp>
+#include <tenzir/report.hpp>
 #include <tenzir/table_slice.hpp>
 #include <tenzir/uuid.hpp>
 
 #include <arrow/type.h>
+#include <caf/detail/scope_guard.hpp>
 #include <caf/event_based_actor.hpp>
 #include <caf/scheduled_actor.hpp>
 #include <caf/scoped_actor.hpp>
@@ -30,6 +36,8 @@
 #include <caf/timespan.hpp>
 #include <caf/typed_event_based_actor.hpp>
 
+#include <deque>
+#include <map>
 #include <queue>
 
 namespace tenzir::plugins::export_ {
@@ -38,12 +46,12 @@ struct bridge_state {
   std::queue<table_slice> buffer = {};
   size_t num_buffered = {};
   caf::typed_response_promise<table_slice> rp = {};
-  expression expr = {};
+  evaluation_program_cache programs = {};
 };
 
 caf::behavior make_bridge(caf::stateful_actor<bridge_state>* self,
                           importer_actor importer, expression expr) {
-  self->state.expr = std::move(expr);
+  self->state.programs = evaluation_program_cache{std::move(expr)};
   self
     ->request(importer, caf::infinite, atom::subscribe_v,
               caf::actor_cast<receiver_actor<table_slice>>(self))
@@ -53,7 +61,10 @@ caf::behavior make_bridge(caf::stateful_actor<bridge_state>* self,
           });
   return {
     [self](table_slice slice) {
-      auto filtered = filter(std::move(slice), self->state.expr);
+      const auto* program = self->state.programs.get(slice.schema());
+      if (not program)
+        return;
+      auto filtered = filter(slice, *program, ids{});
       if (not filtered)
         return;
       if (self->state.rp.pending()) {
@@ -84,12 +95,60 @@ caf::behavior make_bridge(caf::stateful_actor<bridge_state>* self,
   };
 };
 
+/// A partition that the export operator needs to evaluate.
+struct partition_scan {
+  tenzir::uuid uuid = {};
+  time max_import_time = {};
+  expression expr = {};
+};
+
+/// The results of a partition that the export operator did not yet emit.
+struct partition_scan_result {
+  std::vector<table_slice> slices = {};
+  bool done = {};
+};
+
+/// Evaluates a query against a single passive partition and forwards the
+/// results to the export operator, tagged with a sequence number. Routing both
+/// the events and the completion through this actor guarantees that the
+/// completion never overtakes the events of the partition.
+caf::behavior make_partition_scanner(caf::event_based_actor* self, uint64_t seq,
+                                     caf::actor sink, partition_actor partition,
+                                     query_context query_context) {
+  caf::get<extract_query_context>(query_context.cmd).sink
+    = caf::actor_cast<receiver_actor<table_slice>>(self);
+  self
+    ->request(partition, caf::infinite, atom::query_v,
+              std::move(query_context))
+    .then(
+      [self, seq, sink](uint64_t) {
+        self->send(sink, atom::done_v, seq);
+        self->quit();
+      },
+      [self, seq, sink](caf::error& err) {
+        self->send(sink, seq, std::move(err));
+        self->quit();
+      });
+  return {
+    [self, seq, sink](table_slice& slice) {
+      self->send(sink, seq, std::move(slice));
+    },
+  };
+}
+
 class export_operator final : public crtp_operator<export_operator> {
 public:
   export_operator() = default;
 
-  explicit export_operator(expression expr, bool live)
-    : expr_{std::move(expr)}, live_{live} {
+  export_operator(expression expr, bool live, uint64_t parallel,
+                  uint64_t prefetch, bool ordered,
+                  std::optional<std::vector<std::string>> fields)
+    : expr_{std::move(expr)},
+      live_{live},
+      parallel_{parallel},
+      prefetch_{prefetch},
+      ordered_{ordered},
+      fields_{std::move(fields)} {
   }
 
   auto run_live(operator_control_plane& ctrl) const -> generator<table_slice> {
@@ -146,10 +205,10 @@ public:
     }
     co_yield {};
     auto [catalog, accountant, fs] = std::move(*components);
-    auto current_slice = std::optional<table_slice>{};
     auto query_context
       = tenzir::query_context::make_extract("export", blocking_self, expr_);
     query_context.id = uuid::random();
+    caf::get<extract_query_context>(query_context.cmd).fields = fields_;
     TENZIR_DEBUG("export operator starts catalog lookup with id {} and "
                  "expression {}",
                  query_context.id, expr_);
@@ -166,46 +225,176 @@ public:
             .emit(ctrl.diagnostics());
         });
     co_yield {};
+    // Flatten the candidates into a single queue of scans. When we need to
+    // emit events in order, we scan the partitions from oldest to newest.
+    auto queued = std::deque<partition_scan>{};
     for (const auto& [type, info] : current_result.candidate_infos) {
       auto bound_expr = tailor(info.exp, type);
       if (not bound_expr) {
         // failing to bind is not an error.
         continue;
       }
-      query_context.expr = std::move(*bound_expr);
       for (const auto& partition_info : info.partition_infos) {
-        const auto& uuid = partition_info.uuid;
+        queued.push_back(partition_scan{
+          .uuid = partition_info.uuid,
+          .max_import_time = partition_info.max_import_time,
+          .expr = *bound_expr,
+        });
+      }
+    }
+    if (ordered_) {
+      std::stable_sort(queued.begin(), queued.end(),
+                       [](const auto& lhs, const auto& rhs) {
+                         return lhs.max_import_time < rhs.max_import_time;
+                       });
+    }
+    // We keep up to `parallel_` partitions evaluating at the same time, and
+    // additionally spawn up to `prefetch_` partitions ahead of time so that
+    // they can already load their state from disk while we wait for the
+    // running ones. Every running scan is tagged with a sequence number that
+    // we use to reassemble the results per partition in ordered mode.
+    using prefetched_scan = std::pair<partition_scan, partition_actor>;
+    auto scans = detail::prefetch_queue<partition_scan, prefetched_scan>{
+      parallel_, prefetch_};
+    for (auto& scan : queued) {
+      scans.push(std::move(scan));
+    }
+    auto running = std::unordered_map<uint64_t, std::pair<caf::actor, //
+                                                          partition_actor>>{};
+    auto pending = std::map<uint64_t, partition_scan_result>{};
+    auto ready = std::vector<table_slice>{};
+    auto next_seq = uint64_t{0};
+    auto next_emit = uint64_t{0};
+    auto on_exit = caf::detail::make_scope_guard([&] {
+      for (const auto& [_, scan] : running) {
+        blocking_self->send_exit(scan.first, caf::exit_reason::user_shutdown);
+        blocking_self->send_exit(scan.second, caf::exit_reason::user_shutdown);
+      }
+      for (const auto& [_, partition] : scans.prefetched()) {
+        blocking_self->send_exit(partition, caf::exit_reason::user_shutdown);
+      }
+    });
+    const auto schedule = [&] {
+      // In ordered mode, finished partitions stay buffered until all earlier
+      // partitions were emitted. We stop starting new partitions while
+      // `prefetch_` of them are buffered, so that a slow early partition
+      // cannot make the buffer grow without bounds.
+      if (ordered_ and pending.size() - running.size() >= prefetch_) {
+        return;
+      }
+      const auto prefetch = [&](partition_scan scan) {
         auto partition = blocking_self->spawn(
-          passive_partition, uuid, accountant, fs,
-          std::filesystem::path{"index"} / fmt::format("{:l}", uuid));
-        auto recieving_slices = true;
-        auto current_error = caf::error{};
-        blocking_self->send(partition, atom::query_v, query_context);
-        while (recieving_slices) {
-          blocking_self->receive(
-            [&current_slice](table_slice slice) {
-              current_slice = std::move(slice);
-            },
-            [&recieving_slices](uint64_t) {
-              recieving_slices = false;
-            },
-            [&recieving_slices, &current_error](caf::error e) {
-              recieving_slices = false;
-              current_error = std::move(e);
-            });
-          if (current_error) {
-            diagnostic::warning(current_error).emit(ctrl.diagnostics());
-            co_yield {};
-            continue;
-          }
-          if (current_slice) {
-            co_yield *current_slice;
-            current_slice.reset();
-          } else {
-            co_yield {};
+          passive_partition, scan.uuid, accountant, fs,
+          std::filesystem::path{"index"} / fmt::format("{:l}", scan.uuid));
+        return prefetched_scan{std::move(scan), std::move(partition)};
+      };
+      const auto start = [&](prefetched_scan prefetched) {
+        auto& [scan, partition] = prefetched;
+        auto scan_query_context = query_context;
+        scan_query_context.expr = std::move(scan.expr);
+        const auto seq = next_seq++;
+        auto scanner = blocking_self->spawn(
+          make_partition_scanner, seq,
+          caf::actor_cast<caf::actor>(blocking_self), partition,
+          std::move(scan_query_context));
+        running.emplace(seq, std::pair{std::move(scanner), //
+                                       std::move(partition)});
+        pending.emplace(seq, partition_scan_result{});
+      };
+      scans.schedule(prefetch, start);
+    };
+    // Moves all results that may be emitted from the pending partitions into
+    // the ready buffer. In unordered mode, this is every result; in ordered
+    // mode, we only move the results of the oldest running partition, and
+    // advance to the next partition once it is done.
+    const auto drain = [&] {
+      auto it = pending.begin();
+      while (it != pending.end()) {
+        if (ordered_ and it->first != next_emit) {
+          break;
+        }
+        std::move(it->second.slices.begin(), it->second.slices.end(),
+                  std::back_inserter(ready));
+        it->second.slices.clear();
+        if (not it->second.done) {
+          if (ordered_) {
+            break;
           }
+          ++it;
+          continue;
         }
+        if (ordered_) {
+          ++next_emit;
+        }
+        it = pending.erase(it);
+      }
+    };
+    auto throughput = measurement{};
+    auto last_report = stopwatch::now();
+    auto num_events = uint64_t{0};
+    const auto send_report = [&] {
+      if (not accountant) {
+        return;
       }
+      const auto now = stopwatch::now();
+      throughput += {now - std::exchange(last_report, now),
+                     std::exchange(num_events, 0)};
+      if (throughput.duration < defaults::telemetry_rate
+          and not running.empty()) {
+        return;
+      }
+      const auto metadata = metrics_metadata{
+        {"query", fmt::to_string(query_context.id)},
+        {"issuer", query_context.issuer},
+      };
+      blocking_self->send(
+        accountant, atom::metrics_v,
+        report{
+          .data = {
+            {"export.partitions.queued",
+             scans.num_queued() + scans.num_prefetched()},
+            {"export.partitions.running", running.size()},
+            {"export.partitions.buffered", pending.size()},
+          },
+          .metadata = metadata,
+        });
+      blocking_self->send(accountant, atom::metrics_v,
+                          performance_report{
+                            .data = {{"export", std::exchange(throughput, {})}},
+                            .metadata = metadata,
+                          });
+    };
+    schedule();
+    while (not running.empty()) {
+      blocking_self->receive(
+        [&](uint64_t seq, table_slice& slice) {
+          num_events += slice.rows();
+          pending[seq].slices.push_back(std::move(slice));
+        },
+        [&](atom::done, uint64_t seq) {
+          running.erase(seq);
+          scans.finish();
+          pending[seq].done = true;
+        },
+        [&](uint64_t seq, caf::error& err) {
+          running.erase(seq);
+          scans.finish();
+          pending[seq].done = true;
+          diagnostic::warning(err).emit(ctrl.diagnostics());
+        });
+      // Draining first frees the buffer slots of emitted partitions before we
+      // schedule new ones.
+      drain();
+      schedule();
+      send_report();
+      if (ready.empty()) {
+        co_yield {};
+        continue;
+      }
+      for (auto& slice : ready) {
+        co_yield std::move(slice);
+      }
+      ready.clear();
     }
   }
 
@@ -230,7 +419,6 @@ public:
 
   auto optimize(expression const& filter, event_order order) const
     -> optimize_result override {
-    (void)order;
     if (live_)
       return do_not_optimize(*this);
     auto clauses = std::vector<expression>{};
@@ -242,19 +430,46 @@ public:
     }
     auto expr = clauses.empty() ? trivially_true_expression()
                                 : expression{conjunction{std::move(clauses)}};
-    return optimize_result{trivially_true_expression(), event_order::ordered,
-                           std::make_unique<export_operator>(std::move(expr),
-                                                             live_)};
+    // If the downstream operators do not care about the order of events, we
+    // can emit them as soon as any of the concurrently evaluated partitions
+    // yields them.
+    return optimize_result{
+      trivially_true_expression(), event_order::ordered,
+      std::make_unique<export_operator>(std::move(expr), live_, parallel_,
+                                        prefetch_,
+                                        order == event_order::ordered,
+                                        fields_)};
+  }
+
+  auto
+  optimize_projection(const std::optional<std::vector<std::string>>& fields)
+    const -> projection_result override {
+    // The stores only read the fields that the downstream operators access,
+    // and the ones required for evaluating the expression.
+    if (live_) {
+      return projection_result{std::nullopt, copy()};
+    }
+    return projection_result{
+      std::nullopt,
+      std::make_unique<export_operator>(expr_, live_, parallel_, prefetch_,
+                                        ordered_, fields),
+    };
   }
 
   friend auto inspect(auto& f, export_operator& x) -> bool {
-    return f.object(x).fields(f.field("expression", x.expr_),
-                              f.field("live", x.live_));
+    return f.object(x).fields(
+      f.field("expression", x.expr_), f.field("live", x.live_),
+      f.field("parallel", x.parallel_), f.field("prefetch", x.prefetch_),
+      f.field("ordered", x.ordered_), f.field("fields", x.fields_));
   }
 
 private:
   expression expr_;
   bool live_;
+  uint64_t parallel_ = defaults::export_::parallel;
+  uint64_t prefetch_ = defaults::export_::prefetch;
+  bool ordered_ = true;
+  std::optional<std::vector<std::string>> fields_ = {};
 };
 
 class plugin final : public virtual operator_plugin<export_operator> {
@@ -269,10 +484,21 @@ public:
     bool live = false;
     auto internal = false;
     auto low_priority = false;
+    auto parallel
+      = located<uint64_t>{defaults::export_::parallel, location::unknown};
+    auto prefetch
+      = located<uint64_t>{defaults::export_::prefetch, location::unknown};
     parser.add("--live", live);
     parser.add("--low-priority", low_priority);
     parser.add("--internal", internal);
+    parser.add("--parallel", parallel, "<level>");
+    parser.add("--prefetch", prefetch, "<count>");
     parser.parse(p);
+    if (parallel.inner == 0) {
+      diagnostic::error("parallel level must not be zero")
+        .primary(parallel.source)
+        .throw_();
+    }
     // The --low-priority option is currently a no-op, and will be brought back
     // alongside the database plugin.
     (void)low_priority;
@@ -284,7 +510,7 @@ public:
           data{internal},
         },
       },
-      live);
+      live, parallel.inner, prefetch.inner, true, std::nullopt);
   }
 };
 
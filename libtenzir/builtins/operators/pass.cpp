@@ -30,6 +30,12 @@ public:
     return optimize_result{filter, order, nullptr};
   }
 
+  auto
+  optimize_projection(const std::optional<std::vector<std::string>>& fields)
+    const -> projection_result override {
+    return projection_result::passthrough(*this, fields);
+  }
+
   friend auto inspect(auto& f, pass_operator& x) -> bool {
     return f.object(x).fields();
   }
@@ -83,6 +83,13 @@ public:
     return optimize_result::order_invariant(*this, order);
   }
 
+  auto
+  optimize_projection(const std::optional<std::vector<std::string>>& fields)
+    const -> projection_result override {
+    (void)fields;
+    return projection_result{config_.fields, copy()};
+  }
+
   friend auto inspect(auto& f, select_operator& x) -> bool {
     return f.apply(x.config_);
   }
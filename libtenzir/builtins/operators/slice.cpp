@@ -328,6 +328,20 @@ public:
     };
   }
 
+  auto
+  optimize_projection(const std::optional<std::vector<std::string>>& fields)
+    const -> projection_result override {
+    return projection_result::passthrough(*this, fields);
+  }
+
+  auto event_limit() const -> std::optional<uint64_t> override {
+    if (begin_.value_or(0) != 0 or not end_ or *end_ < 0
+        or stride_.value_or(1) != 1) {
+      return std::nullopt;
+    }
+    return static_cast<uint64_t>(*end_);
+  }
+
   friend auto inspect(auto& f, slice_operator& x) -> bool {
     return f.object(x)
       .pretty_name("tenzir.plugin.slice.slice_operator")
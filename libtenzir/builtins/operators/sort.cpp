@@ -9,214 +9,855 @@
 #include <tenzir/arrow_table_slice.hpp>
 #include <tenzir/concept/parseable/numeric/integral.hpp>
 #include <tenzir/concept/parseable/tenzir/pipeline.hpp>
+#include <tenzir/defaults.hpp>
+#include <tenzir/detail/narrow.hpp>
 #include <tenzir/error.hpp>
 #include <tenzir/logger.hpp>
+#include <tenzir/normalized_keys.hpp>
 #include <tenzir/pipeline.hpp>
 #include <tenzir/plugin.hpp>
 #include <tenzir/table_slice.hpp>
+#include <tenzir/uuid.hpp>
 
+#include <arrow/builder.h>
 #include <arrow/compute/api_vector.h>
+#include <arrow/io/file.h>
+#include <arrow/ipc/reader.h>
+#include <arrow/ipc/writer.h>
 #include <arrow/record_batch.h>
+#include <arrow/table.h>
+#include <arrow/util/byte_size.h>
 
-#include <ranges>
+#include <algorithm>
+#include <deque>
+#include <filesystem>
+#include <numeric>
+#include <queue>
+#include <span>
 
 namespace tenzir::plugins::sort {
 
 namespace {
 
+/// Options for spilling sorted runs to disk.
+struct spill_options {
+  /// The maximum number of bytes to buffer in memory before spilling, or 0 to
+  /// never spill.
+  uint64_t memory_budget = defaults::sort::memory_budget;
+
+  /// The directory below which to create temporary files.
+  std::string directory = {};
+
+  /// The maximum number of runs to merge at once.
+  uint64_t merge_fan_in = defaults::sort::merge_fan_in;
+
+  friend auto inspect(auto& f, spill_options& x) -> bool {
+    return f.object(x).fields(f.field("memory_budget", x.memory_budget),
+                              f.field("directory", x.directory),
+                              f.field("merge_fan_in", x.merge_fan_in));
+  }
+};
+
+/// Throws an error diagnostic if an Arrow operation failed.
+void check(const arrow::Status& status, std::string_view note) {
+  if (not status.ok()) {
+    diagnostic::error("{}", status.ToString()).note("{}", note).throw_();
+  }
+}
+
+/// A field to sort by.
+struct sort_key {
+  /// The field or concept, as passed to the operator.
+  std::string field = {};
+
+  /// Whether to sort in descending order.
+  bool descending = {};
+
+  /// Whether to put null values first.
+  bool nulls_first = {};
+
+  friend auto inspect(auto& f, sort_key& x) -> bool {
+    return f.object(x).fields(f.field("field", x.field),
+                              f.field("descending", x.descending),
+                              f.field("nulls_first", x.nulls_first));
+  }
+};
+
+/// Collects rows of table slices of the same schema, and materializes them
+/// into a new table slice with Arrow's Take kernel.
+class gatherer {
+public:
+  /// Adds a table slice to gather rows from.
+  /// @returns A handle to the slice for use with `add_row`.
+  auto add_source(const table_slice& slice) -> size_t {
+    if (batches_.empty()) {
+      schema_ = slice.schema();
+    }
+    TENZIR_ASSERT(slice.schema() == schema_);
+    batches_.push_back(to_record_batch(slice));
+    return batches_.size() - 1;
+  }
+
+  /// Adds a row of a previously added table slice to the output.
+  void add_row(size_t source, int64_t row) {
+    rows_.emplace_back(source, row);
+  }
+
+  /// Returns the number of rows added since the last call to `finish`.
+  auto num_rows() const -> size_t {
+    return rows_.size();
+  }
+
+  /// Returns the schema of the table slices.
+  auto schema() const -> const type& {
+    return schema_;
+  }
+
+  /// Materializes the added rows. The table slices to gather rows from remain
+  /// available for subsequent calls.
+  /// @pre `num_rows() > 0`
+  auto finish() -> table_slice {
+    TENZIR_ASSERT(not rows_.empty());
+    // Taking from a table of all sources would make Arrow concatenate them
+    // first, copying every source for every output batch. Instead, we take
+    // the rows from every source separately, and then restore the order of
+    // the rows with a second take over the much smaller intermediate results.
+    auto order = std::vector<size_t>(rows_.size());
+    std::iota(order.begin(), order.end(), size_t{0});
+    std::stable_sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) {
+      return rows_[lhs].first < rows_[rhs].first;
+    });
+    auto parts = std::vector<std::shared_ptr<arrow::RecordBatch>>{};
+    auto positions = std::vector<int64_t>(rows_.size());
+    auto offset = int64_t{0};
+    for (auto first = order.begin(); first != order.end();) {
+      const auto source = rows_[*first].first;
+      const auto last = std::find_if(first, order.end(), [&](size_t i) {
+        return rows_[i].first != source;
+      });
+      auto builder = arrow::Int64Builder{};
+      check(builder.Reserve(last - first), "failed to prepare sorted events");
+      for (auto it = first; it != last; ++it) {
+        builder.UnsafeAppend(rows_[*it].second);
+        positions[*it] = offset++;
+      }
+      auto indices = builder.Finish();
+      check(indices.status(), "failed to prepare sorted events");
+      auto result = arrow::compute::Take(batches_[source], *indices);
+      check(result.status(), "failed to gather sorted events");
+      TENZIR_ASSERT(result->kind() == arrow::Datum::Kind::RECORD_BATCH);
+      parts.push_back(result->record_batch());
+      first = last;
+    }
+    const auto in_order = std::is_sorted(order.begin(), order.end());
+    rows_.clear();
+    if (parts.size() == 1) {
+      return table_slice{std::move(parts.front()), schema_};
+    }
+    auto table = arrow::Table::FromRecordBatches(parts.front()->schema(),
+                                                 std::move(parts));
+    check(table.status(), "failed to gather sorted events");
+    auto gathered = table.MoveValueUnsafe();
+    if (not in_order) {
+      auto builder = arrow::Int64Builder{};
+      check(builder.AppendValues(positions), "failed to prepare sorted events");
+      auto indices = builder.Finish();
+      check(indices.status(), "failed to prepare sorted events");
+      auto result = arrow::compute::Take(gathered, *indices);
+      check(result.status(), "failed to gather sorted events");
+      TENZIR_ASSERT(result->kind() == arrow::Datum::Kind::TABLE);
+      gathered = result->table();
+    }
+    auto batch = gathered->CombineChunksToBatch();
+    check(batch.status(), "failed to gather sorted events");
+    return table_slice{batch.MoveValueUnsafe(), schema_};
+  }
+
+  /// Removes all table slices and rows.
+  void clear() {
+    batches_.clear();
+    rows_.clear();
+  }
+
+private:
+  type schema_ = {};
+  std::vector<std::shared_ptr<arrow::RecordBatch>> batches_ = {};
+  std::vector<std::pair<size_t, int64_t>> rows_ = {};
+};
+
+/// A file containing a sorted run of events of a single schema.
+struct spill_file {
+  /// The path to the file.
+  std::filesystem::path path = {};
+
+  /// The schema of the events in the file.
+  type schema = {};
+
+  /// The index of the run that the file belongs to.
+  size_t run = {};
+
+  /// The position of the first event of each record batch within its run,
+  /// which allows for keeping the merge stable.
+  std::vector<uint64_t> batch_positions = {};
+};
+
+/// Gathers rows of table slices in the given order, and returns them in
+/// batches of up to the default table slice size. Every batch contains events
+/// of a single schema.
+/// @param slices The table slices to gather rows from.
+/// @param rows The rows to gather, each with a `slice` index and a `row`.
+template <class Rows>
+auto gather(std::span<const table_slice> slices, const Rows& rows)
+  -> generator<table_slice> {
+  auto gatherers = std::unordered_map<type, gatherer>{};
+  auto sources = std::vector<std::pair<gatherer*, size_t>>{};
+  sources.reserve(slices.size());
+  for (const auto& slice : slices) {
+    auto& target = gatherers[slice.schema()];
+    sources.emplace_back(&target, target.add_source(slice));
+  }
+  auto* current = static_cast<gatherer*>(nullptr);
+  for (const auto& x : rows) {
+    auto [target, source] = sources[x.slice];
+    if (current
+        and (current != target
+             or current->num_rows() >= defaults::import::table_slice_size)) {
+      co_yield current->finish();
+    }
+    current = target;
+    current->add_row(source, x.row);
+  }
+  if (current) {
+    co_yield current->finish();
+  }
+}
+
+/// Resolves the sort keys per schema, and encodes them into normalized keys.
+class key_encoder {
+public:
+  explicit key_encoder(const std::vector<sort_key>& keys) : keys_{keys} {
+    key_types_.resize(keys_.size());
+  }
+
+  /// Encodes the sort keys for all rows of a table slice.
+  /// @returns The keys, or `std::nullopt` if the events of the schema cannot
+  /// be sorted, in which case a warning is emitted once per schema.
+  auto encode(const table_slice& slice, operator_control_plane& ctrl)
+    -> std::optional<normalized_keys> {
+    const auto& paths = find_or_create_paths(slice.schema(), ctrl);
+    if (not paths) {
+      return std::nullopt;
+    }
+    return encode(*paths, *to_record_batch(slice));
+  }
+
+  /// Encodes the sort keys for all rows of a record batch of a schema that
+  /// was previously encoded successfully.
+  auto encode(const type& schema, const arrow::RecordBatch& batch) const
+    -> normalized_keys {
+    const auto& paths = key_paths_.at(schema);
+    TENZIR_ASSERT(paths);
+    return encode(*paths, batch);
+  }
+
+private:
+  auto encode(const std::vector<offset>& paths,
+              const arrow::RecordBatch& batch) const -> normalized_keys {
+    TENZIR_ASSERT(paths.size() == keys_.size());
+    auto columns = std::vector<normalized_key_column>{};
+    columns.reserve(keys_.size());
+    for (auto i = size_t{0}; i < keys_.size(); ++i) {
+      TENZIR_ASSERT(key_types_[i]);
+      columns.push_back({
+        .type = *key_types_[i],
+        .array = paths[i].get(batch),
+        .descending = keys_[i].descending,
+        .nulls_first = keys_[i].nulls_first,
+      });
+    }
+    return normalized_keys::make(columns, batch.num_rows());
+  }
+
+  auto find_or_create_paths(const type& schema, operator_control_plane& ctrl)
+    -> const std::optional<std::vector<offset>>& {
+    auto it = key_paths_.find(schema);
+    if (it != key_paths_.end()) {
+      return it->second;
+    }
+    // Set up the sorting and emit warnings at most once per schema.
+    it = key_paths_.emplace_hint(key_paths_.end(), schema, std::nullopt);
+    auto paths = std::vector<offset>{};
+    auto types = std::vector<type>{};
+    for (const auto& key : keys_) {
+      auto path = schema.resolve_key_or_concept_once(key.field);
+      if (not path) {
+        diagnostic::warning("sort key `{}` does not apply to schema `{}`",
+                            key.field, schema)
+          .note("events of this schema will be discarded")
+          .note("from `sort`")
+          .emit(ctrl.diagnostics());
+        return it->second;
+      }
+      auto key_type = caf::get<record_type>(schema).field(*path).type.prune();
+      if (not normalized_keys::is_supported(key_type)) {
+        diagnostic::warning("sort key `{}` resolves to unsupported type `{}` "
+                            "for schema `{}`",
+                            key.field, key_type, schema)
+          .note("events of this schema will be discarded")
+          .note("from `sort`")
+          .emit(ctrl.diagnostics());
+        return it->second;
+      }
+      paths.push_back(std::move(*path));
+      types.push_back(std::move(key_type));
+    }
+    for (auto i = size_t{0}; i < keys_.size(); ++i) {
+      if (key_types_[i] and *key_types_[i] != types[i]) {
+        diagnostic::warning("sort key `{}` resolves to type `{}` "
+                            "for schema `{}`, but to `{}` for a previous schema",
+                            keys_[i].field, types[i], schema, *key_types_[i])
+          .note("events of this schema will be discarded")
+          .note("from `sort`")
+          .emit(ctrl.diagnostics());
+        return it->second;
+      }
+    }
+    for (auto i = size_t{0}; i < keys_.size(); ++i) {
+      key_types_[i] = std::move(types[i]);
+    }
+    it->second = std::move(paths);
+    return it->second;
+  }
+
+  /// The sort keys, as passed to the operator.
+  const std::vector<sort_key>& keys_;
+
+  /// The cached field paths for the sort keys per schema. A nullopt value
+  /// indicates that sorting is not possible for this schema.
+  std::unordered_map<type, std::optional<std::vector<offset>>> key_paths_ = {};
+
+  /// The types of the sort keys.
+  std::vector<std::optional<type>> key_types_ = {};
+};
+
 class sort_state {
 public:
-  sort_state(const std::string& key,
-             const arrow::compute::ArraySortOptions& sort_options)
-    : key_{key}, sort_options_{sort_options} {
+  sort_state(const std::vector<sort_key>& keys, bool stable,
+             const spill_options& spill)
+    : encoder_{keys}, stable_{stable}, spill_options_{spill} {
+  }
+
+  sort_state(const sort_state&) = delete;
+  auto operator=(const sort_state&) -> sort_state& = delete;
+  sort_state(sort_state&&) = delete;
+  auto operator=(sort_state&&) -> sort_state& = delete;
+
+  ~sort_state() noexcept {
+    if (not spill_directory_.empty()) {
+      auto ec = std::error_code{};
+      std::filesystem::remove_all(spill_directory_, ec);
+      if (ec) {
+        TENZIR_WARN("sort failed to remove temporary directory {}: {}",
+                    spill_directory_.string(), ec.message());
+      }
+    }
   }
 
   auto try_add(table_slice slice, operator_control_plane& ctrl) -> table_slice {
     if (slice.rows() == 0) {
       return slice;
     }
-    const auto& path = find_or_create_path(slice.schema(), ctrl);
-    if (not path) {
+    auto keys = encoder_.encode(slice, ctrl);
+    if (not keys) {
       return {};
     }
-    auto batch = to_record_batch(slice);
-    TENZIR_ASSERT(batch);
-    auto array = path->get(*batch);
-    // TODO: Sorting in Arrow using arrow::compute::SortIndices is not
-    // supported for extension types, so eventually we'll have to roll our
-    // own implementation. In the meantime, we sort the underlying storage
-    // array, which at least sorts in some stable way.
-    if (auto ext_array
-        = std::dynamic_pointer_cast<arrow::ExtensionArray>(array)) {
-      sort_keys_.push_back(ext_array->storage());
-    } else {
-      sort_keys_.push_back(std::move(array));
-    }
-    offset_table_.push_back(offset_table_.back()
-                            + detail::narrow_cast<int64_t>(slice.rows()));
+    cached_bytes_ += detail::narrow_cast<uint64_t>(
+      arrow::util::ReferencedBufferSize(*to_record_batch(slice)).ValueOr(0));
+    cached_bytes_ += keys->memusage();
     cache_.push_back(std::move(slice));
+    cache_keys_.push_back(std::move(*keys));
+    if (spill_options_.memory_budget > 0
+        and cached_bytes_ > spill_options_.memory_budget) {
+      spill();
+    }
     return {};
   }
 
   auto sorted() && -> generator<table_slice> {
+    // If nothing was spilled, then we can sort entirely in memory.
+    if (spill_files_.empty()) {
+      for (auto&& slice : sort_cache()) {
+        co_yield std::move(slice);
+      }
+      co_return;
+    }
+    // Otherwise, we spill the remaining events as well and merge all runs.
+    // With too many runs, we first merge them into fewer, larger runs, so
+    // that the number of open files stays bounded.
+    spill();
+    while (num_runs_ > spill_options_.merge_fan_in) {
+      merge_pass();
+    }
+    for (auto&& slice : merge(spill_files_)) {
+      co_yield std::move(slice);
+    }
+  }
+
+private:
+  /// Sorts the cached slices, and returns the sorted events in batches of up
+  /// to the default table slice size.
+  auto sort_cache() -> generator<table_slice> {
     // If there is nothing to sort, then we can just return early.
     if (cache_.empty()) {
       co_return;
     }
-    // Arrow's sort function returns us an Int64Array of indices, which are
-    // guaranteed not to be null. We map these in a two-step process onto our
-    // cached table slices, and yield slices of size 1 for each returned row.
-    // The algorithm below uses an offset table that has an additional 0 value
-    // at the start, and uses std::upper_bound to find the entry in the cache
-    // using the offset table.
-    const auto chunked_key
-      = arrow::ChunkedArray::Make(std::move(sort_keys_)).ValueOrDie();
-    const auto indices
-      = arrow::compute::SortIndices(*chunked_key, sort_options_);
-    if (not indices.ok()) {
-      diagnostic::error("{}", indices.status().ToString())
-        .note("failed to sort `{}`", key_)
-        .throw_();
-    }
-    auto result_buffer = std::vector<table_slice>{};
-    for (const auto& index :
-         static_cast<const arrow::Int64Array&>(*indices.ValueUnsafe())) {
-      TENZIR_ASSERT(index.has_value());
-      const auto offset = std::prev(
-        std::upper_bound(offset_table_.begin(), offset_table_.end(), *index));
-      const auto cache_index = std::distance(offset_table_.begin(), offset);
-      const auto row = *index - *offset;
-      const auto& slice = cache_[cache_index];
-      auto result = subslice(slice, row, row + 1);
-      TENZIR_ASSERT(result.rows() == 1);
-      co_yield std::move(result);
+    // We sort references to all cached rows by their normalized keys, which
+    // boils down to a memcmp per comparison, and then gather the rows into
+    // batches per schema.
+    struct entry {
+      std::string_view key;
+      size_t slice;
+      int64_t row;
+    };
+    auto entries = std::vector<entry>{};
+    for (auto i = size_t{0}; i < cache_.size(); ++i) {
+      const auto& keys = cache_keys_[i];
+      for (auto row = size_t{0}; row < keys.size(); ++row) {
+        entries.push_back({keys[row], i, detail::narrow_cast<int64_t>(row)});
+      }
+    }
+    const auto less = [](const entry& lhs, const entry& rhs) {
+      return lhs.key < rhs.key;
+    };
+    if (stable_) {
+      std::stable_sort(entries.begin(), entries.end(), less);
+    } else {
+      std::sort(entries.begin(), entries.end(), less);
+    }
+    for (auto&& slice : gather(cache_, entries)) {
+      co_yield std::move(slice);
     }
   }
 
-private:
-  auto find_or_create_path(const type& schema, operator_control_plane& ctrl)
-    -> const std::optional<offset>& {
-    auto key_path = key_field_path_.find(schema);
-    if (key_path != key_field_path_.end()) {
-      return key_path->second;
+  /// Sorts the cached slices, and writes them to temporary files as a new run.
+  void spill() {
+    if (cache_.empty()) {
+      return;
     }
-    // Set up the sorting and emit warnings at most once per schema.
-    key_path = key_field_path_.emplace_hint(
-      key_field_path_.end(), schema, schema.resolve_key_or_concept_once(key_));
-    if (not key_path->second.has_value()) {
-      diagnostic::warning("sort key `{}` does not apply to schema `{}`", key_,
-                          schema)
-        .note("events of this schema will be discarded")
-        .note("from `sort`")
-        .emit(ctrl.diagnostics());
-      return key_path->second;
-    }
-    auto current_key_type
-      = caf::get<record_type>(schema).field(*key_path->second).type.prune();
-    if (caf::holds_alternative<subnet_type>(current_key_type)) {
-      // TODO: Sorting in Arrow using arrow::compute::SortIndices is not
-      // supported for extension types. We can fall back to the storage array
-      // for all types but subnet, which has a nested extension type.
-      diagnostic::warning("sort key `{}` resolves to unsupported type `subnet` "
-                          "for schema `{}`",
-                          key_, schema)
-        .note("events of this schema will be discarded")
-        .note("from `sort`")
-        .emit(ctrl.diagnostics());
-      key_path->second = std::nullopt;
-      return key_path->second;
-    }
-    if (not key_type_) {
-      key_type_ = current_key_type;
-    } else if (key_type_ != current_key_type) {
-      diagnostic::warning("sort key `{}` resolves to type `{}` "
-                          "for schema `{}`, but to `{}` for a previous schema",
-                          key_, current_key_type, schema, *key_type_)
-        .note("events of this schema will be discarded")
-        .note("from `sort`")
-        .emit(ctrl.diagnostics());
-      key_path->second = std::nullopt;
-    }
-    return key_path->second;
-  }
-
-  /// The sort field key, as passed to the operator.
-  const std::string& key_;
-
-  /// The sort options, as passed to the operator.
-  const arrow::compute::ArraySortOptions& sort_options_;
+    if (spill_directory_.empty()) {
+      auto directory = spill_options_.directory.empty()
+                         ? std::filesystem::temp_directory_path()
+                         : std::filesystem::path{spill_options_.directory};
+      spill_directory_ = directory / fmt::format("sort-{}", uuid::random());
+      auto ec = std::error_code{};
+      std::filesystem::create_directories(spill_directory_, ec);
+      if (ec) {
+        diagnostic::error("{}", ec.message())
+          .note("failed to create temporary directory `{}`",
+                spill_directory_.string())
+          .throw_();
+      }
+    }
+    write_run(sort_cache());
+    cache_.clear();
+    cache_keys_.clear();
+    cached_bytes_ = 0;
+  }
+
+  /// Writes sorted events to temporary files as a new run, with one file per
+  /// schema.
+  void write_run(generator<table_slice> sorted) {
+    const auto run = num_runs_++;
+    auto writers = std::unordered_map<
+      type, std::pair<size_t, std::shared_ptr<arrow::ipc::RecordBatchWriter>>>{};
+    auto position = uint64_t{0};
+    for (auto&& slice : sorted) {
+      auto batch = to_record_batch(slice);
+      auto writer = writers.find(slice.schema());
+      if (writer == writers.end()) {
+        auto path = spill_directory_
+                    / fmt::format("{}-{}.feather", run, num_files_++);
+        auto stream = arrow::io::FileOutputStream::Open(path.string());
+        check(stream.status(), "failed to spill sorted events to disk");
+        auto file_writer = arrow::ipc::MakeFileWriter(*stream, batch->schema());
+        check(file_writer.status(), "failed to spill sorted events to disk");
+        spill_files_.push_back(spill_file{
+          .path = std::move(path),
+          .schema = slice.schema(),
+          .run = run,
+        });
+        writer = writers
+                   .emplace(slice.schema(),
+                            std::pair{spill_files_.size() - 1,
+                                      file_writer.MoveValueUnsafe()})
+                   .first;
+      }
+      auto& [file_index, file_writer] = writer->second;
+      spill_files_[file_index].batch_positions.push_back(position);
+      position += slice.rows();
+      check(file_writer->WriteRecordBatch(*batch),
+            "failed to spill sorted events to disk");
+    }
+    for (auto& [_, writer] : writers) {
+      check(writer.second->Close(), "failed to spill sorted events to disk");
+    }
+  }
+
+  /// Merges groups of up to `merge_fan_in` consecutive runs into new runs, and
+  /// removes the merged files. Since the groups keep the order of the runs,
+  /// the merge remains stable.
+  void merge_pass() {
+    const auto inputs = std::exchange(spill_files_, {});
+    const auto runs = std::exchange(num_runs_, 0);
+    auto first = inputs.begin();
+    for (auto run = size_t{0}; run < runs; run += spill_options_.merge_fan_in) {
+      const auto last = std::find_if(first, inputs.end(), [&](const auto& x) {
+        return x.run >= run + spill_options_.merge_fan_in;
+      });
+      write_run(merge(std::span{first, last}));
+      for (const auto& file : std::span{first, last}) {
+        auto ec = std::error_code{};
+        std::filesystem::remove(file.path, ec);
+        if (ec) {
+          TENZIR_WARN("sort failed to remove temporary file {}: {}",
+                      file.path.string(), ec.message());
+        }
+      }
+      first = last;
+    }
+  }
+
+  /// Merges the sorted runs from the given temporary files, and returns the
+  /// sorted events in batches of up to the default table slice size.
+  auto merge(std::span<const spill_file> files) -> generator<table_slice> {
+    struct cursor {
+      const spill_file* file = {};
+      std::shared_ptr<arrow::ipc::RecordBatchFileReader> reader = {};
+      int batch = -1;
+      table_slice slice = {};
+      normalized_keys keys = {};
+      int64_t row = {};
+      std::optional<size_t> source = {};
+    };
+    // Advances a cursor to its next record batch, returning false if the
+    // cursor is exhausted.
+    const auto next_batch = [&](cursor& cursor) -> bool {
+      cursor.batch += 1;
+      if (cursor.batch >= cursor.reader->num_record_batches()) {
+        return false;
+      }
+      auto batch = cursor.reader->ReadRecordBatch(cursor.batch);
+      check(batch.status(), "failed to read spilled events from disk");
+      cursor.keys = encoder_.encode(cursor.file->schema, **batch);
+      cursor.slice = table_slice{batch.MoveValueUnsafe(), cursor.file->schema};
+      cursor.row = 0;
+      cursor.source = std::nullopt;
+      return true;
+    };
+    auto cursors = std::vector<cursor>{};
+    cursors.reserve(files.size());
+    for (const auto& file : files) {
+      auto input = arrow::io::ReadableFile::Open(file.path.string());
+      check(input.status(), "failed to read spilled events from disk");
+      auto reader = arrow::ipc::RecordBatchFileReader::Open(*input);
+      check(reader.status(), "failed to read spilled events from disk");
+      cursors.push_back(cursor{
+        .file = &file,
+        .reader = reader.MoveValueUnsafe(),
+      });
+    }
+    // Returns whether the current row of the cursor at the rhs index sorts
+    // before the current row of the cursor at the lhs index. Ties are broken
+    // by the position of the rows within the runs, which keeps the order
+    // stable.
+    const auto greater = [&](size_t lhs, size_t rhs) {
+      const auto& l = cursors[lhs];
+      const auto& r = cursors[rhs];
+      const auto result = l.keys[l.row].compare(r.keys[r.row]);
+      if (result != 0) {
+        return result > 0;
+      }
+      if (l.file->run != r.file->run) {
+        return l.file->run > r.file->run;
+      }
+      return l.file->batch_positions[l.batch] + l.row
+             > r.file->batch_positions[r.batch] + r.row;
+    };
+    auto heap = std::priority_queue<size_t, std::vector<size_t>,
+                                    decltype(greater)>{greater};
+    for (auto i = size_t{0}; i < cursors.size(); ++i) {
+      if (next_batch(cursors[i])) {
+        heap.push(i);
+      }
+    }
+    auto output = gatherer{};
+    while (not heap.empty()) {
+      const auto i = heap.top();
+      heap.pop();
+      auto& cursor = cursors[i];
+      if (output.num_rows() > 0
+          and (output.schema() != cursor.file->schema
+               or output.num_rows() >= defaults::import::table_slice_size)) {
+        co_yield output.finish();
+        output.clear();
+        for (auto& x : cursors) {
+          x.source = std::nullopt;
+        }
+      }
+      if (not cursor.source) {
+        cursor.source = output.add_source(cursor.slice);
+      }
+      output.add_row(*cursor.source, cursor.row);
+      cursor.row += 1;
+      if (cursor.row < detail::narrow_cast<int64_t>(cursor.slice.rows())
+          or next_batch(cursor)) {
+        heap.push(i);
+      }
+    }
+    if (output.num_rows() > 0) {
+      co_yield output.finish();
+    }
+  }
+
+  /// The encoder for the sort keys.
+  key_encoder encoder_;
+
+  /// Whether rows with equal keys must keep their relative order.
+  const bool stable_;
+
+  /// The spill options, as passed to the operator.
+  const spill_options& spill_options_;
 
   /// The slices that we want to sort.
   std::vector<table_slice> cache_ = {};
 
-  /// An offset table into the cached slices. The first entry of this is always
-  /// zero, and for every slice we append to the cache we append the total
-  /// number of rows in the cache to this table. This allows for using
-  /// std::upper_bound to identify the index of the cache entry quickly.
-  std::vector<int64_t> offset_table_ = {0};
+  /// The normalized sort keys of the cached slices.
+  std::vector<normalized_keys> cache_keys_ = {};
 
-  /// The arrays that we sort by, in the same order as the offset table.
-  std::vector<std::shared_ptr<arrow::Array>> sort_keys_ = {};
+  /// The approximate number of bytes referenced by the cached slices and their
+  /// sort keys.
+  uint64_t cached_bytes_ = {};
 
-  /// The cached field paths for the sorted-by field per schema. A nullopt value
-  /// indicates that sorting is not possible for this schema.
-  std::unordered_map<type, std::optional<offset>> key_field_path_ = {};
+  /// The temporary directory for spilled runs, created on first use.
+  std::filesystem::path spill_directory_ = {};
+
+  /// The number of spilled runs.
+  size_t num_runs_ = {};
+
+  /// The number of temporary files written so far, which keeps their names
+  /// unique across merge passes.
+  size_t num_files_ = {};
+
+  /// The files of all spilled runs.
+  std::vector<spill_file> spill_files_ = {};
+};
+
+/// Keeps the first events of the sorted input, without sorting the entire
+/// input. The state holds the candidates in a bounded max-heap, so every input
+/// row needs just a single comparison against the worst candidate, and it
+/// periodically compacts the retained table slices down to the candidates.
+class top_k_state {
+public:
+  top_k_state(const std::vector<sort_key>& keys, uint64_t limit)
+    : encoder_{keys}, limit_{limit} {
+  }
+
+  void add(table_slice slice, operator_control_plane& ctrl) {
+    if (slice.rows() == 0 or limit_ == 0) {
+      return;
+    }
+    auto keys = encoder_.encode(slice, ctrl);
+    if (not keys) {
+      return;
+    }
+    // The keys must not move after taking views into them, so we add them to
+    // the state before checking the rows.
+    const auto index = slices_.size();
+    const auto& stored_keys = keys_.emplace_back(std::move(*keys));
+    auto admitted = false;
+    for (auto row = size_t{0}; row < stored_keys.size(); ++row) {
+      auto x = candidate{
+        .key = stored_keys[row],
+        .sequence = sequence_++,
+        .slice = index,
+        .row = detail::narrow_cast<int64_t>(row),
+      };
+      if (heap_.size() < limit_) {
+        heap_.push_back(x);
+        std::push_heap(heap_.begin(), heap_.end(), less);
+      } else if (less(x, heap_.front())) {
+        std::pop_heap(heap_.begin(), heap_.end(), less);
+        heap_.back() = x;
+        std::push_heap(heap_.begin(), heap_.end(), less);
+      } else {
+        continue;
+      }
+      admitted = true;
+    }
+    if (not admitted) {
+      keys_.pop_back();
+      return;
+    }
+    num_rows_ += slice.rows();
+    slices_.push_back(std::move(slice));
+    if (num_rows_ > std::max(2 * limit_, defaults::import::table_slice_size)) {
+      compact();
+    }
+  }
+
+  auto finish() && -> generator<table_slice> {
+    std::sort(heap_.begin(), heap_.end(), less);
+    for (auto&& slice : gather(slices_, heap_)) {
+      co_yield std::move(slice);
+    }
+  }
+
+private:
+  struct candidate {
+    std::string_view key;
+    uint64_t sequence;
+    size_t slice;
+    int64_t row;
+  };
+
+  /// Orders candidates by their keys, and candidates with equal keys by their
+  /// arrival, which makes the result match that of a stable sort.
+  static auto less(const candidate& lhs, const candidate& rhs) -> bool {
+    if (const auto cmp = lhs.key.compare(rhs.key); cmp != 0) {
+      return cmp < 0;
+    }
+    return lhs.sequence < rhs.sequence;
+  }
+
+  /// Replaces the retained table slices with new ones that contain only the
+  /// candidates.
+  void compact() {
+    std::sort(heap_.begin(), heap_.end(), less);
+    auto compacted = std::vector<table_slice>{};
+    for (auto&& slice : gather(slices_, heap_)) {
+      compacted.push_back(std::move(slice));
+    }
+    auto sequences = std::vector<uint64_t>{};
+    sequences.reserve(heap_.size());
+    for (const auto& x : heap_) {
+      sequences.push_back(x.sequence);
+    }
+    slices_ = std::move(compacted);
+    keys_.clear();
+    heap_.clear();
+    num_rows_ = 0;
+    auto next = sequences.begin();
+    for (auto i = size_t{0}; i < slices_.size(); ++i) {
+      const auto& keys = keys_.emplace_back(
+        encoder_.encode(slices_[i].schema(), *to_record_batch(slices_[i])));
+      for (auto row = size_t{0}; row < keys.size(); ++row) {
+        heap_.push_back({
+          .key = keys[row],
+          .sequence = *next++,
+          .slice = i,
+          .row = detail::narrow_cast<int64_t>(row),
+        });
+      }
+      num_rows_ += slices_[i].rows();
+    }
+    // The candidates are now in ascending order, but the heap needs the
+    // largest candidate first.
+    std::make_heap(heap_.begin(), heap_.end(), less);
+  }
+
+  /// The encoder for the sort keys.
+  key_encoder encoder_;
+
+  /// The number of events to keep.
+  const uint64_t limit_;
+
+  /// The table slices that contain at least one candidate.
+  std::vector<table_slice> slices_ = {};
+
+  /// The normalized sort keys of the retained slices. We use a deque because
+  /// the candidates point into the keys.
+  std::deque<normalized_keys> keys_ = {};
+
+  /// The number of rows of the retained slices.
+  uint64_t num_rows_ = {};
 
-  /// The type of the sorted-by field.
-  std::optional<type> key_type_ = {};
+  /// The candidates, ordered as a max-heap such that the first element is the
+  /// candidate that would be evicted first.
+  std::vector<candidate> heap_ = {};
+
+  /// The number of rows seen so far.
+  uint64_t sequence_ = {};
+};
+
+/// The fused form of `sort | head`, which keeps only the first events of the
+/// sorted input in memory.
+class top_k_operator final : public crtp_operator<top_k_operator> {
+public:
+  top_k_operator() = default;
+
+  top_k_operator(std::vector<sort_key> keys, bool stable, uint64_t limit)
+    : keys_{std::move(keys)}, stable_{stable}, limit_{limit} {
+  }
+
+  auto
+  operator()(generator<table_slice> input, operator_control_plane& ctrl) const
+    -> generator<table_slice> {
+    auto state = top_k_state{keys_, limit_};
+    for (auto&& slice : input) {
+      state.add(std::move(slice), ctrl);
+      co_yield {};
+    }
+    for (auto&& slice : std::move(state).finish()) {
+      co_yield std::move(slice);
+    }
+  }
+
+  auto name() const -> std::string override {
+    return "internal-sort-top-k";
+  }
+
+  auto optimize(expression const& filter, event_order order) const
+    -> optimize_result override {
+    (void)filter;
+    (void)order;
+    // Unlike for `sort`, filters cannot be moved past this operator, as that
+    // would change which events are kept.
+    return optimize_result{std::nullopt,
+                           stable_ ? event_order::ordered
+                                   : event_order::unordered,
+                           copy()};
+  }
+
+  friend auto inspect(auto& f, top_k_operator& x) -> bool {
+    return f.object(x).fields(f.field("keys", x.keys_),
+                              f.field("stable", x.stable_),
+                              f.field("limit", x.limit_));
+  }
+
+private:
+  std::vector<sort_key> keys_ = {};
+  bool stable_ = {};
+  uint64_t limit_ = {};
 };
 
 class sort_operator final : public crtp_operator<sort_operator> {
 public:
   sort_operator() = default;
 
-  sort_operator(std::string key, bool stable, bool descending, bool nulls_first)
-    : key_{std::move(key)},
-      stable_{stable},
-      descending_{descending},
-      nulls_first_{nulls_first} {
+  sort_operator(std::vector<sort_key> keys, bool stable, spill_options spill)
+    : keys_{std::move(keys)}, stable_{stable}, spill_options_{std::move(spill)} {
   }
 
   auto
   operator()(generator<table_slice> input, operator_control_plane& ctrl) const
     -> generator<table_slice> {
-    auto options = arrow::compute::ArraySortOptions::Defaults();
-    options.order = descending_ ? arrow::compute::SortOrder::Descending
-                                : arrow::compute::SortOrder::Ascending;
-    options.null_placement = nulls_first_
-                               ? arrow::compute::NullPlacement::AtStart
-                               : arrow::compute::NullPlacement::AtEnd;
-    auto state = sort_state{key_, options};
+    auto state = sort_state{keys_, stable_, spill_options_};
     co_yield {};
     for (auto&& slice : input) {
       co_yield state.try_add(std::move(slice), ctrl);
     }
-    // The sorted slices are very like to have size 1 each, so we rebatch them
-    // first to avoid inefficiencies in downstream operators.
-    auto buffer = std::vector<table_slice>{};
-    auto num_buffered = uint64_t{0};
     for (auto&& slice : std::move(state).sorted()) {
-      if (not buffer.empty() and buffer.back().schema() != slice.schema()) {
-        while (not buffer.empty()) {
-          auto [lhs, rhs] = split(buffer, defaults::import::table_slice_size);
-          auto result = concatenate(std::move(lhs));
-          num_buffered -= result.rows();
-          co_yield std::move(result);
-          buffer = std::move(rhs);
-        }
-      }
-      num_buffered += slice.rows();
-      buffer.push_back(std::move(slice));
-      while (num_buffered >= defaults::import::table_slice_size) {
-        auto [lhs, rhs] = split(buffer, defaults::import::table_slice_size);
-        auto result = concatenate(std::move(lhs));
-        num_buffered -= result.rows();
-        co_yield std::move(result);
-        buffer = std::move(rhs);
-      }
-    }
-    if (not buffer.empty()) {
-      co_yield concatenate(std::move(buffer));
+      co_yield std::move(slice);
     }
   }
 
@@ -230,22 +871,69 @@ public:
                            copy()};
   }
 
+  auto with_event_limit(uint64_t limit) const -> operator_ptr override {
+    // For large limits, the spilling of the regular sort is preferable.
+    if (limit > defaults::sort::max_top_k) {
+      return nullptr;
+    }
+    return std::make_unique<top_k_operator>(keys_, stable_, limit);
+  }
+
   friend auto inspect(auto& f, sort_operator& x) -> bool {
-    return f.object(x).fields(f.field("key", x.key_),
+    return f.object(x).fields(f.field("keys", x.keys_),
                               f.field("stable", x.stable_),
-                              f.field("descending", x.descending_),
-                              f.field("nulls_first", x.nulls_first_));
+                              f.field("spill_options", x.spill_options_));
   }
 
 private:
-  std::string key_ = {};
+  std::vector<sort_key> keys_ = {};
   bool stable_ = {};
-  bool descending_ = {};
-  bool nulls_first_ = {};
+  spill_options spill_options_ = {};
 };
 
 class plugin final : public virtual operator_plugin<sort_operator> {
 public:
+  auto initialize([[maybe_unused]] const record& plugin_config,
+                  const record& global_config) -> caf::error override {
+    auto memory_budget
+      = try_get_or<uint64_t>(global_config, "tenzir.sort-memory-budget",
+                             defaults::sort::memory_budget);
+    if (not memory_budget) {
+      return caf::make_error(ec::invalid_configuration,
+                             fmt::format("failed to parse "
+                                         "`tenzir.sort-memory-budget` "
+                                         "option: {}",
+                                         memory_budget.error()));
+    }
+    spill_options_.memory_budget = *memory_budget;
+    auto merge_fan_in
+      = try_get_or<uint64_t>(global_config, "tenzir.sort-merge-fan-in",
+                             defaults::sort::merge_fan_in);
+    if (not merge_fan_in) {
+      return caf::make_error(ec::invalid_configuration,
+                             fmt::format("failed to parse "
+                                         "`tenzir.sort-merge-fan-in` "
+                                         "option: {}",
+                                         merge_fan_in.error()));
+    }
+    if (*merge_fan_in < 2) {
+      return caf::make_error(ec::invalid_configuration,
+                             fmt::format("`tenzir.sort-merge-fan-in` must be "
+                                         "at least 2, but is {}",
+                                         *merge_fan_in));
+    }
+    spill_options_.merge_fan_in = *merge_fan_in;
+    if (const auto* cache_dir
+        = get_if<std::string>(&global_config, "tenzir.cache-directory")) {
+      spill_options_.directory
+        = (std::filesystem::path{*cache_dir} / "sort").string();
+    } else {
+      spill_options_.directory
+        = (std::filesystem::temp_directory_path() / "tenzir" / "sort").string();
+    }
+    return {};
+  }
+
   auto signature() const -> operator_signature override {
     return {.transformation = true};
   }
@@ -297,21 +985,32 @@ public:
     if (sort_args.size() > 1) {
       stable = true;
     }
-    auto result = std::make_unique<tenzir::pipeline>();
-    for (auto& [key, descending, nulls_first] :
-         sort_args | std::ranges::views::reverse) {
-      result->append(std::make_unique<sort_operator>(std::move(key), stable,
-                                                     descending, nulls_first));
+    auto keys = std::vector<sort_key>{};
+    keys.reserve(sort_args.size());
+    for (auto& [field, descending, nulls_first] : sort_args) {
+      keys.push_back({
+        .field = std::move(field),
+        .descending = descending,
+        .nulls_first = nulls_first,
+      });
     }
+    auto result = std::make_unique<sort_operator>(std::move(keys), stable,
+                                                  spill_options_);
     return {
       std::string_view{f, l},
       std::move(result),
     };
   }
+
+private:
+  spill_options spill_options_ = {};
 };
 
+using top_k_plugin = operator_inspection_plugin<top_k_operator>;
+
 } // namespace
 
 } // namespace tenzir::plugins::sort
 
 TENZIR_REGISTER_PLUGIN(tenzir::plugins::sort::plugin)
+TENZIR_REGISTER_PLUGIN(tenzir::plugins::sort::top_k_plugin)
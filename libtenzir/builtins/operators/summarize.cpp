@@ -8,28 +8,48 @@
 
 #include <tenzir/aggregation_function.hpp>
 #include <tenzir/arrow_table_slice.hpp>
+#include <tenzir/as_bytes.hpp>
 #include <tenzir/concept/convertible/data.hpp>
 #include <tenzir/concept/convertible/to.hpp>
 #include <tenzir/concept/parseable/core.hpp>
 #include <tenzir/concept/parseable/tenzir/pipeline.hpp>
 #include <tenzir/concept/parseable/tenzir/time.hpp>
+#include <tenzir/defaults.hpp>
+#include <tenzir/detail/narrow.hpp>
 #include <tenzir/detail/zip_iterator.hpp>
 #include <tenzir/error.hpp>
 #include <tenzir/hash/hash_append.hpp>
+#include <tenzir/hash/xxhash.hpp>
+#include <tenzir/logger.hpp>
+#include <tenzir/normalized_keys.hpp>
 #include <tenzir/operator_control_plane.hpp>
 #include <tenzir/parser_interface.hpp>
 #include <tenzir/plugin.hpp>
 #include <tenzir/series_builder.hpp>
 #include <tenzir/table_slice_builder.hpp>
 #include <tenzir/type.hpp>
+#include <tenzir/uuid.hpp>
 
+#include <arrow/builder.h>
 #include <arrow/compute/api_scalar.h>
+#include <arrow/io/file.h>
+#include <arrow/ipc/reader.h>
+#include <arrow/ipc/writer.h>
 #include <arrow/record_batch.h>
 #include <arrow/type.h>
+#include <arrow/util/future.h>
+#include <arrow/util/thread_pool.h>
+#include <caf/binary_deserializer.hpp>
+#include <caf/binary_serializer.hpp>
+#include <caf/detail/scope_guard.hpp>
 #include <caf/expected.hpp>
 #include <tsl/robin_map.h>
 
 #include <algorithm>
+#include <filesystem>
+#include <map>
+#include <numeric>
+#include <span>
 #include <utility>
 
 namespace tenzir::plugins::summarize {
@@ -108,6 +128,19 @@ struct configuration {
     /// Unresolved input extractor.
     std::string input;
 
+    /// The constant argument of the aggregation function, if any.
+    data argument = {};
+
+    /// Instantiates the aggregation function for an input type.
+    auto make_function(const type& input_type) const
+      -> caf::expected<std::unique_ptr<aggregation_function>> {
+      if (caf::holds_alternative<caf::none_t>(argument)) {
+        return function->make_aggregation_function(input_type);
+      }
+      return function->make_aggregation_function_with_argument(input_type,
+                                                               argument);
+    }
+
     friend auto inspect(auto& f, aggregation& x) -> bool {
       auto get = [&]() {
         return x.function->name();
@@ -118,7 +151,8 @@ struct configuration {
       };
       return f.object(x).fields(f.field("output", x.output),
                                 f.field("function", get, set),
-                                f.field("input", x.input));
+                                f.field("input", x.input),
+                                f.field("argument", x.argument));
     }
   };
 
@@ -133,16 +167,56 @@ struct configuration {
   std::optional<duration> created_timeout = {};
   std::optional<duration> update_timeout = {};
 
+  /// The configuration of windowed aggregation.
+  struct window_options {
+    /// Unresolved extractor of the event time that assigns rows to windows.
+    std::string field;
+
+    /// The length of a window.
+    duration size;
+
+    /// The distance between the starts of consecutive windows, which equals
+    /// the size for tumbling windows.
+    duration slide;
+
+    /// How far the watermark trails behind the largest observed event time.
+    duration lateness;
+
+    friend auto inspect(auto& f, window_options& x) -> bool {
+      return f.object(x).fields(f.field("field", x.field),
+                                f.field("size", x.size),
+                                f.field("slide", x.slide),
+                                f.field("lateness", x.lateness));
+    }
+  };
+
   /// Configuration for aggregation columns.
   std::vector<aggregation> aggregations = {};
 
+  /// Aggregate per window of event time instead of over the entire input.
+  std::optional<window_options> window = {};
+
+  /// The number of batches to pre-aggregate in parallel.
+  uint64_t parallelism = defaults::summarize::parallelism;
+
+  /// The number of bytes that the groups may use before their partial
+  /// aggregations are spilled to disk, or 0 to never spill.
+  uint64_t memory_budget = defaults::summarize::memory_budget;
+
+  /// The directory below which to create temporary files.
+  std::string spill_directory = {};
+
   friend auto inspect(auto& f, configuration& x) -> bool {
     return f.object(x).fields(f.field("group_by_extractors",
                                       x.group_by_extractors),
                               f.field("time_resolution", x.time_resolution),
                               f.field("created_timeout", x.created_timeout),
                               f.field("update_timeout", x.update_timeout),
-                              f.field("aggregations", x.aggregations));
+                              f.field("aggregations", x.aggregations),
+                              f.field("window", x.window),
+                              f.field("parallelism", x.parallelism),
+                              f.field("memory_budget", x.memory_budget),
+                              f.field("spill_directory", x.spill_directory));
   }
 };
 
@@ -217,6 +291,24 @@ struct group_by_key_equal {
   }
 };
 
+/// The hash functor for the normalized group-by keys of a schema, which
+/// supports lookups with string views and precalculated hashes.
+struct normalized_key_hash {
+  using is_transparent = void;
+
+  size_t operator()(std::string_view x) const noexcept {
+    return xxh3_64::make(as_bytes(x.data(), x.size()));
+  }
+};
+
+template <class T, class... Ts>
+auto zip_equal(T& x, Ts&... xs) -> detail::zip<T, Ts...> {
+  auto size = x.size();
+  auto match = ((xs.size() == size) && ...);
+  TENZIR_ASSERT(match);
+  return detail::zip{x, xs...};
+}
+
 struct column {
   struct offset offset;
   class type type;
@@ -272,7 +364,7 @@ struct binding {
         // ahead of time. We only use this to emit a warning. We do not set the
         // column to `std::nullopt`, because we will have to differentiate the
         // error and the missing case later on.
-        auto instantiation = aggr.function->make_aggregation_function(type);
+        auto instantiation = aggr.make_function(type);
         if (!instantiation) {
           diagnostic::warning(
             "cannot instantiate `{}` with `{}` for schema `{}`: {}",
@@ -316,6 +408,28 @@ struct binding {
     return result;
   };
 
+  /// Encodes the group-by values of all rows as normalized keys. Returns
+  /// `std::nullopt` if a group-by column has a type that normalized keys do
+  /// not support. Missing group-by columns are null for every row and thus do
+  /// not contribute to the keys.
+  auto make_group_by_keys(
+    const std::vector<std::optional<std::shared_ptr<arrow::Array>>>& arrays,
+    int64_t rows) const -> std::optional<normalized_keys> {
+    auto columns = std::vector<normalized_key_column>{};
+    columns.reserve(group_by_columns.size());
+    for (auto [column, array] : zip_equal(group_by_columns, arrays)) {
+      if (not column) {
+        continue;
+      }
+      if (not normalized_keys::is_supported(column->type)) {
+        return std::nullopt;
+      }
+      TENZIR_ASSERT(array);
+      columns.push_back({column->type, *array});
+    }
+    return normalized_keys::make(columns, rows);
+  }
+
   /// Read the input arrays for the configured aggregation columns.
   auto make_aggregation_arrays(const arrow::RecordBatch& batch) const
     -> std::vector<std::optional<std::shared_ptr<arrow::Array>>> {
@@ -345,37 +459,292 @@ struct binding {
   };
 };
 
-template <class T, class... Ts>
-auto zip_equal(T& x, Ts&... xs) -> detail::zip<T, Ts...> {
-  auto size = x.size();
-  auto match = ((xs.size() == size) && ...);
-  TENZIR_ASSERT(match);
-  return detail::zip{x, xs...};
+/// Throws an error diagnostic if an Arrow operation failed.
+void check(const arrow::Status& status, std::string_view note) {
+  if (not status.ok()) {
+    diagnostic::error("{}", status.ToString()).note("{}", note).throw_();
+  }
+}
+
+/// The group-by values and types of a group, as spilled to disk.
+struct partial_group {
+  /// The group-by values.
+  std::vector<data> key = {};
+
+  /// The types of the group-by values, where `std::nullopt` denotes a type
+  /// conflict and a null type denotes a missing column.
+  std::vector<std::optional<type>> types = {};
+
+  friend auto inspect(auto& f, partial_group& x) -> bool {
+    return f.object(x).fields(f.field("key", x.key),
+                              f.field("types", x.types));
+  }
+};
+
+/// The partial state of an aggregation function of a group, as spilled to
+/// disk.
+struct partial_aggregation {
+  /// Whether there was a type conflict, which makes the result null.
+  bool dead = false;
+
+  /// The input type of the function, or a null type if the input column was
+  /// missing so far.
+  type input_type = {};
+
+  /// The partial state of the function.
+  data state = {};
+
+  friend auto inspect(auto& f, partial_aggregation& x) -> bool {
+    return f.object(x).fields(f.field("dead", x.dead),
+                              f.field("input_type", x.input_type),
+                              f.field("state", x.state));
+  }
+};
+
+/// The temporary files that hold the spilled partial aggregations, with one
+/// file per partition of the group-by keys. Every spill appends one batch to
+/// the file of every partition that had groups.
+class spill_files {
+public:
+  explicit spill_files(const std::filesystem::path& directory) {
+    auto parent = directory.empty() ? std::filesystem::temp_directory_path()
+                                    : directory;
+    directory_ = parent / fmt::format("summarize-{}", uuid::random());
+    auto ec = std::error_code{};
+    std::filesystem::create_directories(directory_, ec);
+    if (ec) {
+      diagnostic::error("{}", ec.message())
+        .note("failed to create temporary directory `{}`",
+              directory_.string())
+        .throw_();
+    }
+    writers_.resize(defaults::summarize::spill_partitions);
+    memusage_.resize(writers_.size());
+    rows_.resize(writers_.size());
+  }
+
+  spill_files(const spill_files&) = delete;
+  auto operator=(const spill_files&) -> spill_files& = delete;
+  spill_files(spill_files&&) = delete;
+  auto operator=(spill_files&&) -> spill_files& = delete;
+
+  ~spill_files() noexcept {
+    auto ec = std::error_code{};
+    std::filesystem::remove_all(directory_, ec);
+    if (ec) {
+      TENZIR_WARN("summarize failed to remove temporary directory {}: {}",
+                  directory_.string(), ec.message());
+    }
+  }
+
+  /// Returns the temporary directory that holds the files.
+  auto directory() const -> const std::filesystem::path& {
+    return directory_;
+  }
+
+  /// Returns the number of partitions.
+  auto partitions() const -> size_t {
+    return writers_.size();
+  }
+
+  /// Returns an estimate of the memory that the groups of a partition used
+  /// before they were spilled.
+  auto memusage(size_t partition) const -> size_t {
+    return memusage_[partition];
+  }
+
+  /// Returns the number of groups written to a partition.
+  auto rows(size_t partition) const -> size_t {
+    return rows_[partition];
+  }
+
+  /// Appends a batch of partial aggregations to the file of a partition.
+  /// @param memusage An estimate of the memory that the groups in the batch
+  /// used before they were spilled.
+  void write(size_t partition, const arrow::RecordBatch& batch,
+             size_t memusage) {
+    auto& writer = writers_[partition];
+    if (not writer) {
+      auto stream = arrow::io::FileOutputStream::Open(path(partition).string());
+      check(stream.status(), "failed to spill partial aggregations to disk");
+      auto file_writer = arrow::ipc::MakeFileWriter(*stream, batch.schema());
+      check(file_writer.status(),
+            "failed to spill partial aggregations to disk");
+      writer = file_writer.MoveValueUnsafe();
+    }
+    check(writer->WriteRecordBatch(batch),
+          "failed to spill partial aggregations to disk");
+    memusage_[partition] += memusage;
+    rows_[partition] += detail::narrow<size_t>(batch.num_rows());
+  }
+
+  /// Closes the file of a partition, and reads back its batches in the order
+  /// in which they were written. The file is removed afterwards.
+  auto read(size_t partition)
+    -> generator<std::shared_ptr<arrow::RecordBatch>> {
+    auto& writer = writers_[partition];
+    if (not writer) {
+      co_return;
+    }
+    check(writer->Close(), "failed to spill partial aggregations to disk");
+    writer = nullptr;
+    auto input = arrow::io::ReadableFile::Open(path(partition).string());
+    check(input.status(), "failed to read partial aggregations from disk");
+    auto reader = arrow::ipc::RecordBatchFileReader::Open(*input);
+    check(reader.status(), "failed to read partial aggregations from disk");
+    for (auto i = 0; i < (*reader)->num_record_batches(); ++i) {
+      auto batch = (*reader)->ReadRecordBatch(i);
+      check(batch.status(), "failed to read partial aggregations from disk");
+      co_yield batch.MoveValueUnsafe();
+    }
+    check((*input)->Close(), "failed to read partial aggregations from disk");
+    auto ec = std::error_code{};
+    std::filesystem::remove(path(partition), ec);
+  }
+
+private:
+  auto path(size_t partition) const -> std::filesystem::path {
+    return directory_ / fmt::format("{}.feather", partition);
+  }
+
+  std::filesystem::path directory_ = {};
+  std::vector<std::shared_ptr<arrow::ipc::RecordBatchWriter>> writers_ = {};
+  std::vector<size_t> memusage_ = {};
+  std::vector<size_t> rows_ = {};
+};
+
+/// Builds record batches of serialized partial aggregations, with a column
+/// for the groups and one column per aggregation function.
+class spill_batch_builder {
+public:
+  explicit spill_batch_builder(const configuration& config) {
+    auto fields = arrow::FieldVector{};
+    fields.push_back(arrow::field("group", arrow::binary()));
+    for (const auto& aggr : config.aggregations) {
+      fields.push_back(arrow::field(aggr.output, arrow::binary()));
+    }
+    schema_ = arrow::schema(std::move(fields));
+    for (auto i = size_t{0}; i <= config.aggregations.size(); ++i) {
+      builders_.push_back(std::make_unique<arrow::BinaryBuilder>());
+    }
+  }
+
+  /// Appends a serialized value to a column.
+  void append(size_t column, std::string_view bytes) {
+    check(builders_[column]->Append(
+            reinterpret_cast<const uint8_t*>(bytes.data()),
+            detail::narrow<int32_t>(bytes.size())),
+          "failed to spill partial aggregations to disk");
+  }
+
+  /// Serializes a value and appends it to a column.
+  void serialize(size_t column, auto& x) {
+    buffer_.clear();
+    auto f = caf::binary_serializer{nullptr, buffer_};
+    if (not f.apply(x)) {
+      diagnostic::error("{}", f.get_error())
+        .note("failed to spill partial aggregations to disk")
+        .throw_();
+    }
+    append(column, std::string_view{reinterpret_cast<const char*>(
+                                      buffer_.data()),
+                                    buffer_.size()});
+  }
+
+  /// Returns the number of complete rows.
+  auto rows() const -> int64_t {
+    return builders_[0]->length();
+  }
+
+  /// Returns the record batch of all appended rows, and resets the builder.
+  auto finish() -> std::shared_ptr<arrow::RecordBatch> {
+    const auto rows = this->rows();
+    auto arrays = arrow::ArrayVector{};
+    arrays.reserve(builders_.size());
+    for (auto& builder : builders_) {
+      auto array = builder->Finish();
+      check(array.status(), "failed to spill partial aggregations to disk");
+      arrays.push_back(array.MoveValueUnsafe());
+    }
+    return arrow::RecordBatch::Make(schema_, rows, std::move(arrays));
+  }
+
+private:
+  std::shared_ptr<arrow::Schema> schema_ = {};
+  std::vector<std::unique_ptr<arrow::BinaryBuilder>> builders_ = {};
+  caf::byte_buffer buffer_ = {};
+};
+
+/// Returns the spill partition of a group-by key. Every level of recursive
+/// partitioning seeds the hash differently, so that the groups of a single
+/// partition spread across all partitions of the next level.
+auto spill_partition(const group_by_key& key, size_t level) -> size_t {
+  auto hasher = xxh64{level};
+  for (const auto& value : key) {
+    hash_append(hasher, make_view(value));
+  }
+  return hasher.finish() % defaults::summarize::spill_partitions;
+}
+
+/// Deserializes a spilled partial aggregation.
+auto deserialize_partial(std::string_view bytes, auto& x) -> bool {
+  auto f = caf::binary_deserializer{nullptr, bytes.data(), bytes.size()};
+  return f.apply(x);
+}
+
+/// Returns an estimate of the memory that a group-by key uses, including the
+/// normalized key that caches its lookup.
+auto estimate_memusage(const group_by_key& key) -> size_t {
+  auto result = key.size() * sizeof(data);
+  for (const auto& value : key) {
+    if (const auto* str = caf::get_if<std::string>(&value)) {
+      result += str->size();
+    } else if (const auto* bytes = caf::get_if<blob>(&value)) {
+      result += bytes->size();
+    }
+  }
+  return 2 * result;
 }
 
 /// An instantiation of the inter-schematic aggregation process.
 class implementation {
 public:
+  /// Resolves the aggregation and group-by columns for a schema.
+  /// @note The returned reference is valid until the next call with a schema
+  /// that was not resolved before.
+  auto bind(const type& schema, const configuration& config,
+            diagnostic_handler& diag) -> const binding& {
+    auto it = bindings.find(schema);
+    if (it == bindings.end()) {
+      it = bindings.try_emplace(it, schema,
+                                binding::make(schema, config, diag));
+    }
+    return it->second;
+  }
+
   /// Divides the input into groups and feeds it to the aggregation function.
   void add(const table_slice& slice, const configuration& config,
            diagnostic_handler& diag) {
     // Step 1: Resolve extractor names (if possible).
-    auto it = bindings.find(slice.schema());
-    if (it == bindings.end()) {
-      it = bindings.try_emplace(it, slice.schema(),
-                                binding::make(slice.schema(), config, diag));
-    }
-    auto const& bound = it->second;
+    add(slice, bind(slice.schema(), config, diag), config, diag);
+  }
+
+  /// Divides the input into groups and feeds it to the aggregation function,
+  /// using columns that were resolved for the schema of the input already.
+  void add(const table_slice& slice, const binding& bound,
+           const configuration& config, diagnostic_handler& diag) {
     // Step 2: Collect the aggregation columns and group-by columns into arrays.
     auto batch = to_record_batch(slice);
     auto group_by_arrays = bound.make_group_by_arrays(*batch, config);
     auto aggregation_arrays = bound.make_aggregation_arrays(*batch);
+    const auto rows = detail::narrow<int64_t>(slice.rows());
+    TENZIR_ASSERT(rows > 0);
+    num_batches += 1;
     // A key view used to determine the bucket for a single row.
     auto reusable_key_view = group_by_key_view{};
     reusable_key_view.resize(bound.group_by_columns.size(), {});
-    // Returns the group that the given row belongs to, creating new groups
-    // whenever necessary.
-    auto find_or_create_bucket = [&](int64_t row) -> bucket* {
+    // Returns the group-by values of the given row.
+    auto key_view_at = [&](int64_t row) -> const group_by_key_view& {
       for (size_t col = 0; col < bound.group_by_columns.size(); ++col) {
         if (bound.group_by_columns[col]) {
           TENZIR_ASSERT(group_by_arrays[col].has_value());
@@ -386,84 +755,95 @@ public:
           reusable_key_view[col] = caf::none;
         }
       }
-      if (auto it = buckets.find(reusable_key_view); it != buckets.end()) {
-        auto&& bucket = *it->second;
-        // Check that the group-by values also have matching types.
-        for (auto [existing, other] :
-             zip_equal(bucket.group_by_types, bound.group_by_columns)) {
-          if (!other) {
-            // If this group-by column does not exist in the input schema, we
-            // already warned and can ignore it.
-            continue;
-          }
-          if (existing.is_dead()) {
-            continue;
-          }
-          if (existing.is_empty()) {
-            // If the group-by column did not have a type before (because the
-            // column was missing when the group was created), we can set it here.
-            existing.set_active(other->type);
-            continue;
-          }
-          auto existing_type = existing.get_active();
-          if (other->type == existing_type) {
-            // No conflict, nothing to do.
-            continue;
-          }
-          // Otherwise, there is a type mismatch for the same data. This can
-          // only happen with `null` or metadata mismatches.
-          auto pruned = existing_type.prune();
-          if (other->type.prune() == pruned) {
-            // If the type mismatch is only caused by metadata, we remove
-            // it. This for example can unify `:port` and `:uint64` into
-            // `:uint64`, which we consider an acceptable conversion.
-            existing.set_active(std::move(pruned));
-          } else {
-            // Otherwise, we have a bucket (and thus matching data) where
-            // the types are conflicting. This can only happen if the
-            // conflicting group columns both have `null` values.
-            diagnostic::warning("summarize found matching group for key `{}`, "
-                                "but the existing type `{}` clashes with `{}`",
-                                reusable_key_view, existing_type, other->type)
-              .emit(diag);
-            existing.set_dead();
-          }
+      return reusable_key_view;
+    };
+    // Checks that the types of the group-by and aggregation columns of this
+    // schema match the types of an existing bucket that the given row belongs
+    // to. The checks only depend on the schema, so we run them only once per
+    // bucket and batch.
+    auto check_bucket = [&](bucket& bucket, int64_t row) {
+      // Check that the group-by values also have matching types.
+      for (auto [existing, other] :
+           zip_equal(bucket.group_by_types, bound.group_by_columns)) {
+        if (!other) {
+          // If this group-by column does not exist in the input schema, we
+          // already warned and can ignore it.
+          continue;
         }
-        // Check that the aggregation extractors have the same type.
-        for (auto&& [aggr, column, cfg] :
-             zip_equal(bucket.aggregations, bound.aggregation_columns,
-                       config.aggregations)) {
-          if (aggr.is_dead()) {
-            continue;
-          }
-          if (!column) {
-            // We already warned that this column does not exist. Since we
-            // assume `null` values for it, and also assume that `nulls` don't
-            // change the function value, we ignore it.
-            continue;
-          }
-          if (aggr.is_empty()) {
-            // We can now instantiate the missing function because we have a type.
-            if (auto instance
-                = cfg.function->make_aggregation_function(column->type)) {
-              aggr.set_active(std::move(*instance));
-            } else {
-              // We already noticed this and emitted a warning previously.
-              aggr.set_dead();
-            }
-            continue;
-          }
-          auto& func = aggr.get_active();
-          TENZIR_ASSERT(func);
-          if (func->input_type() != column->type) {
-            diagnostic::warning("summarize aggregation function for group `{}` "
-                                "expected type `{}`, but got `{}`",
-                                reusable_key_view, func->input_type(),
-                                column->type)
-              .emit(diag);
+        if (existing.is_dead()) {
+          continue;
+        }
+        if (existing.is_empty()) {
+          // If the group-by column did not have a type before (because the
+          // column was missing when the group was created), we can set it here.
+          existing.set_active(other->type);
+          continue;
+        }
+        auto existing_type = existing.get_active();
+        if (other->type == existing_type) {
+          // No conflict, nothing to do.
+          continue;
+        }
+        // Otherwise, there is a type mismatch for the same data. This can
+        // only happen with `null` or metadata mismatches.
+        auto pruned = existing_type.prune();
+        if (other->type.prune() == pruned) {
+          // If the type mismatch is only caused by metadata, we remove
+          // it. This for example can unify `:port` and `:uint64` into
+          // `:uint64`, which we consider an acceptable conversion.
+          existing.set_active(std::move(pruned));
+        } else {
+          // Otherwise, we have a bucket (and thus matching data) where
+          // the types are conflicting. This can only happen if the
+          // conflicting group columns both have `null` values.
+          diagnostic::warning("summarize found matching group for key `{}`, "
+                              "but the existing type `{}` clashes with `{}`",
+                              key_view_at(row), existing_type, other->type)
+            .emit(diag);
+          existing.set_dead();
+        }
+      }
+      // Check that the aggregation extractors have the same type.
+      for (auto&& [aggr, column, cfg] :
+           zip_equal(bucket.aggregations, bound.aggregation_columns,
+                     config.aggregations)) {
+        if (aggr.is_dead()) {
+          continue;
+        }
+        if (!column) {
+          // We already warned that this column does not exist. Since we
+          // assume `null` values for it, and also assume that `nulls` don't
+          // change the function value, we ignore it.
+          continue;
+        }
+        if (aggr.is_empty()) {
+          // We can now instantiate the missing function because we have a type.
+          if (auto instance
+              = cfg.make_function(column->type)) {
+            aggr.set_active(std::move(*instance));
+          } else {
+            // We already noticed this and emitted a warning previously.
             aggr.set_dead();
           }
+          continue;
+        }
+        auto& func = aggr.get_active();
+        TENZIR_ASSERT(func);
+        if (func->input_type() != column->type) {
+          diagnostic::warning("summarize aggregation function for group `{}` "
+                              "expected type `{}`, but got `{}`",
+                              key_view_at(row), func->input_type(),
+                              column->type)
+            .emit(diag);
+          aggr.set_dead();
         }
+      }
+    };
+    // Returns the group that the given row belongs to, creating new groups
+    // whenever necessary.
+    auto find_or_create_bucket = [&](int64_t row) -> bucket* {
+      const auto& key_view = key_view_at(row);
+      if (auto it = buckets.find(key_view); it != buckets.end()) {
         return it->second.get();
       }
       // Did not find existing bucket, create a new one.
@@ -487,8 +867,7 @@ public:
         if (bound.aggregation_columns[col].has_value()) {
           auto input_type = bound.aggregation_columns[col]->type;
           if (auto instance
-              = config.aggregations[col].function->make_aggregation_function(
-                input_type)) {
+              = config.aggregations[col].make_function(input_type)) {
             new_bucket->aggregations.push_back(
               aggregation::make_active(std::move(*instance)));
           } else {
@@ -501,15 +880,73 @@ public:
           new_bucket->aggregations.emplace_back(aggregation::make_empty());
         }
       }
-      auto [it, inserted] = buckets.emplace(materialize(reusable_key_view),
-                                            std::move(new_bucket));
+      auto [it, inserted]
+        = buckets.emplace(materialize(key_view), std::move(new_bucket));
       TENZIR_ASSERT(inserted);
+      it.value()->key_memusage = estimate_memusage(it->first);
       return it.value().get();
     };
-    // This lambda is called for consecutive rows that belong to the same group
-    // and updates its aggregation functions.
-    auto update_bucket = [&](bucket& bucket, int64_t offset, int64_t length) {
-      bucket.updated_at = std::chrono::steady_clock::now();
+    // Step 3: Determine the bucket of every row, and number the distinct
+    // buckets of this batch in order of their first occurrence.
+    auto groups = std::vector<bucket*>{};
+    auto row_groups = std::vector<size_t>(rows);
+    auto assign_bucket = [&](bucket& bucket, int64_t row) {
+      if (bucket.batch != num_batches) {
+        check_bucket(bucket, row);
+        bucket.batch = num_batches;
+        bucket.batch_group = groups.size();
+        groups.push_back(&bucket);
+      }
+      row_groups[row] = bucket.batch_group;
+    };
+    if (auto keys = bound.make_group_by_keys(group_by_arrays, rows)) {
+      // All group-by columns have fixed types for a schema, so equal
+      // normalized keys imply equal group-by values. This lets us find the
+      // buckets of all rows whose group we have seen before for this schema
+      // with a single probe of a byte string, without materializing the
+      // group-by values. We hash all keys up front before probing.
+      auto& index = bucket_indices[slice.schema()];
+      auto hashes = std::vector<size_t>(rows);
+      const auto hasher = normalized_key_hash{};
+      for (auto row = int64_t{0}; row < rows; ++row) {
+        hashes[row] = hasher((*keys)[row]);
+      }
+      for (auto row = int64_t{0}; row < rows; ++row) {
+        const auto key = (*keys)[row];
+        if (auto it = index.find(key, hashes[row]); it != index.end()) {
+          assign_bucket(*it->second, row);
+          continue;
+        }
+        auto* bucket = find_or_create_bucket(row);
+        index.emplace(std::string{key}, bucket);
+        assign_bucket(*bucket, row);
+      }
+    } else {
+      for (auto row = int64_t{0}; row < rows; ++row) {
+        assign_bucket(*find_or_create_bucket(row), row);
+      }
+    }
+    // Step 4: Compute a selection vector that lists the rows of every bucket
+    // in order, and update the aggregation functions one column and bucket at
+    // a time.
+    auto group_offsets = std::vector<size_t>(groups.size() + 1, 0);
+    for (auto group : row_groups) {
+      group_offsets[group + 1] += 1;
+    }
+    std::partial_sum(group_offsets.begin(), group_offsets.end(),
+                     group_offsets.begin());
+    auto selection = std::vector<int64_t>(rows);
+    auto cursors
+      = std::vector<size_t>(group_offsets.begin(), group_offsets.end() - 1);
+    for (auto row = int64_t{0}; row < rows; ++row) {
+      selection[cursors[row_groups[row]]++] = row;
+    }
+    const auto now = std::chrono::steady_clock::now();
+    for (auto group = size_t{0}; group < groups.size(); ++group) {
+      auto& bucket = *groups[group];
+      bucket.updated_at = now;
+      const auto group_rows = std::span<const int64_t>{selection}.subspan(
+        group_offsets[group], group_offsets[group + 1] - group_offsets[group]);
       for (auto [aggr, input] :
            zip_equal(bucket.aggregations, aggregation_arrays)) {
         if (!input) {
@@ -523,29 +960,82 @@ public:
           // remaining case to handle is where it is a function.
           continue;
         }
-        aggr.get_active()->add(*(*input)->Slice(offset, length));
+        aggr.get_active()->add(**input, group_rows);
       }
-    };
-    // Step 3: Iterate over all rows of the batch, and determine a sliding
-    // window of rows belonging to the same batch that is as large as possible,
-    // then update the corresponding bucket.
-    auto first_row = int64_t{0};
-    auto* first_bucket = find_or_create_bucket(first_row);
-    TENZIR_ASSERT(slice.rows() > 0);
-    for (auto row = int64_t{1}; row < detail::narrow<int64_t>(slice.rows());
-         ++row) {
-      auto* bucket = find_or_create_bucket(row);
-      if (bucket == first_bucket)
+      account(bucket);
+    }
+  }
+
+  /// Merges the groups of another aggregation over different input. The
+  /// groups of the other aggregation count as if their input came after the
+  /// input of this aggregation.
+  void merge(implementation&& other, const configuration& config,
+             diagnostic_handler& diag) {
+    for (auto it = other.buckets.begin(); it != other.buckets.end(); ++it) {
+      auto& other_bucket = it.value();
+      auto existing = buckets.find(it->first);
+      if (existing == buckets.end()) {
+        // The bucket does not belong to a batch of this aggregation.
+        other_bucket->batch = 0;
+        other_bucket->memusage = 0;
+        account(*other_bucket);
+        buckets.emplace(it->first, std::move(other_bucket));
         continue;
-      update_bucket(*first_bucket, first_row, row - first_row);
-      first_row = row;
-      first_bucket = bucket;
+      }
+      merge_bucket(*existing->second, *other_bucket, it->first, config, diag);
+      account(*existing->second);
+    }
+    other.buckets.clear();
+    other.bucket_indices.clear();
+    other.memusage_ = 0;
+  }
+
+  /// Returns an estimate of the memory that all groups use.
+  auto memusage() const -> size_t {
+    return memusage_;
+  }
+
+  /// Writes the partial aggregations of all groups to disk, partitioned by
+  /// the hash of their group-by key, and frees their memory.
+  void spill(const configuration& config, diagnostic_handler& diag) {
+    if (buckets.empty()) {
+      return;
+    }
+    if (not spill_) {
+      spill_ = std::make_unique<spill_files>(config.spill_directory);
     }
-    update_bucket(*first_bucket, first_row,
-                  detail::narrow<int64_t>(slice.rows()) - first_row);
+    // The normalized key indices point into the buckets that we free below.
+    bucket_indices.clear();
+    for (const auto& [key, bucket] : buckets) {
+      bucket->partition = spill_partition(key, 0);
+    }
+    // We write one partition at a time and free its groups right away, so
+    // that the serialized form of at most one partition exists in memory
+    // alongside the groups.
+    auto builder = spill_batch_builder{config};
+    for (auto partition = size_t{0}; partition < spill_->partitions();
+         ++partition) {
+      auto bytes = size_t{0};
+      for (auto it = buckets.begin(); it != buckets.end();) {
+        auto& bucket = *it->second;
+        if (bucket.partition != partition) {
+          ++it;
+          continue;
+        }
+        spill_bucket(builder, it->first, bucket, config, diag);
+        bytes += bucket.memusage;
+        memusage_ -= bucket.memusage;
+        it = buckets.erase(it);
+      }
+      if (builder.rows() > 0) {
+        spill_->write(partition, *builder.finish(), bytes);
+      }
+    }
+    TENZIR_ASSERT(buckets.empty());
+    memusage_ = 0;
   }
 
-  auto check_timeouts(const configuration& config)
+  auto check_timeouts(const configuration& config, diagnostic_handler& diag)
     -> generator<caf::expected<table_slice>> {
     if (not config.created_timeout and not config.update_timeout) {
       co_return;
@@ -572,18 +1062,39 @@ public:
     if (copy.buckets.empty()) {
       co_return;
     }
-    for (const auto& [key, _] : copy.buckets) {
+    for (const auto& [key, bucket] : copy.buckets) {
+      memusage_ -= bucket->memusage;
       const auto num_erased = buckets.erase(key);
       TENZIR_ASSERT(num_erased == 1);
     }
-    for (auto&& result : std::move(copy).finish(config)) {
+    bucket_indices.clear();
+    for (auto&& result : std::move(copy).finish(config, diag)) {
       co_yield std::move(result);
     }
   }
 
   /// Returns the summarization results after the input is done.
-  auto finish(
-    const configuration& config) && -> generator<caf::expected<table_slice>> {
+  /// @param window The bounds of the window that the results belong to, which
+  /// are prepended as `window_start` and `window_end` fields.
+  auto finish(const configuration& config, diagnostic_handler& diag,
+              std::optional<std::pair<time, time>> window = {}) &&
+    -> generator<caf::expected<table_slice>> {
+    if (spill_) {
+      auto remaining = std::vector<implementation>(spill_->partitions());
+      for (const auto& [key, bucket] : buckets) {
+        auto& target = remaining[spill_partition(key, 0)];
+        target.memusage_ += bucket->memusage;
+        target.buckets.emplace(key, bucket);
+      }
+      buckets.clear();
+      bucket_indices.clear();
+      memusage_ = 0;
+      for (auto&& result :
+           restore(*spill_, std::move(remaining), 0, config, diag, window)) {
+        co_yield std::move(result);
+      }
+      co_return;
+    }
     if (config.group_by_extractors.empty() && buckets.empty()) {
       // This `summarize` has no `by` clause. In the case where the operator
       // did not receive any input, the user still expects a result. For
@@ -607,8 +1118,12 @@ public:
       const auto& bucket = it->second;
       TENZIR_ASSERT(config.aggregations.size() == bucket->aggregations.size());
       auto fields = std::vector<record_type::field_view>{};
-      fields.reserve(config.group_by_extractors.size()
+      fields.reserve(2 + config.group_by_extractors.size()
                      + config.aggregations.size());
+      if (window) {
+        fields.emplace_back("window_start", type{time_type{}});
+        fields.emplace_back("window_end", type{time_type{}});
+      }
       for (auto&& [extractor, group] :
            zip_equal(config.group_by_extractors, bucket->group_by_types)) {
         fields.emplace_back(extractor, group.is_active() ? group.get_active()
@@ -625,6 +1140,7 @@ public:
       // This creates a new entry if it does not exist yet.
       output_schemas[std::move(output_schema)].push_back(it);
     }
+    const auto num_window_fields = window ? size_t{2} : size_t{0};
     for (const auto& [output_schema, groups] : output_schemas) {
       auto builder = caf::get<record_type>(output_schema)
                        .make_arrow_builder(arrow::default_memory_pool());
@@ -639,10 +1155,28 @@ public:
                                                status.ToString()));
           co_return;
         }
+        // Assign the window bounds.
+        if (window) {
+          for (auto i = 0; i < 2; ++i) {
+            status = append_builder(
+              time_type{},
+              static_cast<type_to_arrow_builder_t<time_type>&>(
+                *builder->field_builder(i)),
+              i == 0 ? window->first : window->second);
+            if (not status.ok()) {
+              co_yield caf::make_error(
+                ec::system_error, fmt::format("failed to append window: {}",
+                                              status.ToString()));
+              co_return;
+            }
+          }
+        }
         // Assign data of group-by fields.
         for (auto i = size_t{0}; i < group.size(); ++i) {
-          auto col = detail::narrow<int>(i);
-          auto ty = caf::get<record_type>(output_schema).field(i).type;
+          auto col = detail::narrow<int>(num_window_fields + i);
+          auto ty = caf::get<record_type>(output_schema)
+                      .field(num_window_fields + i)
+                      .type;
           status = append_builder(ty, *builder->field_builder(col),
                                   make_data_view(group[i]));
           if (!status.ok()) {
@@ -654,7 +1188,7 @@ public:
         }
         // Assign data of aggregations.
         for (auto i = size_t{0}; i < bucket->aggregations.size(); ++i) {
-          auto col = detail::narrow<int>(group.size() + i);
+          auto col = detail::narrow<int>(num_window_fields + group.size() + i);
           if (bucket->aggregations[i].is_active()) {
             auto& func = bucket->aggregations[i].get_active();
             auto output_type = func->output_type();
@@ -694,6 +1228,317 @@ public:
   }
 
 private:
+  struct bucket;
+
+  /// Updates the memory estimate after a bucket changed.
+  void account(bucket& bucket) {
+    auto result = sizeof(bucket) + bucket.key_memusage
+                  + bucket.group_by_types.size() * sizeof(group_type)
+                  + bucket.aggregations.size() * sizeof(aggregation);
+    for (auto& aggr : bucket.aggregations) {
+      if (aggr.is_active()) {
+        // We do not know the size of the function object itself, so we
+        // assume a small constant.
+        result += 64 + aggr.get_active()->memusage();
+      }
+    }
+    memusage_ = memusage_ - bucket.memusage + result;
+    bucket.memusage = result;
+  }
+
+  /// Serializes the group-by values and partial aggregations of a group into
+  /// a spill batch.
+  static void spill_bucket(spill_batch_builder& builder,
+                           const group_by_key& key, bucket& bucket,
+                           const configuration& config,
+                           diagnostic_handler& diag) {
+    auto group = partial_group{};
+    group.key.assign(key.begin(), key.end());
+    for (auto& x : bucket.group_by_types) {
+      if (x.is_dead()) {
+        group.types.emplace_back(std::nullopt);
+      } else if (x.is_empty()) {
+        group.types.emplace_back(type{});
+      } else {
+        group.types.emplace_back(x.get_active());
+      }
+    }
+    builder.serialize(0, group);
+    for (auto i = size_t{0}; i < bucket.aggregations.size(); ++i) {
+      auto& aggr = bucket.aggregations[i];
+      auto partial = partial_aggregation{};
+      if (aggr.is_dead()) {
+        partial.dead = true;
+      } else if (aggr.is_active()) {
+        auto& func = aggr.get_active();
+        partial.input_type = func->input_type();
+        if (auto state = func->save()) {
+          partial.state = std::move(*state);
+        } else {
+          diagnostic::warning(state.error())
+            .note(fmt::format("failed to spill `{}` for group `{}`",
+                              config.aggregations[i].function->name(), key))
+            .emit(diag);
+          partial.dead = true;
+        }
+      }
+      builder.serialize(i + 1, partial);
+    }
+  }
+
+  /// Restores the spilled partial aggregations one partition at a time,
+  /// followed by the groups of that partition that are still in memory, so
+  /// that only a single partition needs to fit into memory. A partition that
+  /// exceeds the memory budget on its own is split again with the hash of the
+  /// next level.
+  static auto restore(spill_files& files, std::vector<implementation> remaining,
+                      size_t level, const configuration& config,
+                      diagnostic_handler& diag,
+                      std::optional<std::pair<time, time>> window)
+    -> generator<caf::expected<table_slice>> {
+    for (auto partition = size_t{0}; partition < remaining.size();
+         ++partition) {
+      auto& in_memory = remaining[partition];
+      if (files.memusage(partition) + in_memory.memusage_
+            > config.memory_budget
+          and files.rows(partition) > 1
+          and level < defaults::summarize::max_spill_depth) {
+        auto children = spill_files{files.directory()};
+        auto split = std::vector<implementation>(children.partitions());
+        for (const auto& [key, bucket] : in_memory.buckets) {
+          auto& target = split[spill_partition(key, level + 1)];
+          target.memusage_ += bucket->memusage;
+          target.buckets.emplace(key, bucket);
+        }
+        in_memory = implementation{};
+        if (auto err
+            = repartition(files, partition, children, level + 1, config)) {
+          co_yield std::move(err);
+          co_return;
+        }
+        for (auto&& result : restore(children, std::move(split), level + 1,
+                                     config, diag, window)) {
+          co_yield std::move(result);
+        }
+        continue;
+      }
+      auto restored = implementation{};
+      for (auto&& batch : files.read(partition)) {
+        const auto& groups
+          = static_cast<const arrow::BinaryArray&>(*batch->column(0));
+        for (auto row = int64_t{0}; row < batch->num_rows(); ++row) {
+          auto group = partial_group{};
+          auto aggregations
+            = std::vector<partial_aggregation>(config.aggregations.size());
+          auto success = deserialize_partial(groups.GetView(row), group);
+          for (auto i = size_t{0}; i < aggregations.size(); ++i) {
+            const auto& column = static_cast<const arrow::BinaryArray&>(
+              *batch->column(detail::narrow<int>(i + 1)));
+            success = success
+                      and deserialize_partial(column.GetView(row),
+                                              aggregations[i]);
+          }
+          if (not success) {
+            co_yield caf::make_error(ec::serialization_error,
+                                     "failed to read partial aggregations "
+                                     "from disk");
+            co_return;
+          }
+          restored.merge_partial(std::move(group), std::move(aggregations),
+                                 config, diag);
+        }
+      }
+      restored.merge(std::move(in_memory), config, diag);
+      if (restored.buckets.empty()) {
+        continue;
+      }
+      for (auto&& result : std::move(restored).finish(config, diag, window)) {
+        co_yield std::move(result);
+      }
+    }
+  }
+
+  /// Distributes the spilled partial aggregations of a partition across the
+  /// partitions of the next level. This only deserializes the group-by values
+  /// and copies the serialized partial states as they are.
+  static auto repartition(spill_files& files, size_t partition,
+                          spill_files& children, size_t level,
+                          const configuration& config) -> caf::error {
+    // We no longer know the memory usage of the individual groups, so we
+    // assume that all groups of the partition use the same amount.
+    const auto memusage_per_group
+      = files.memusage(partition) / std::max(files.rows(partition), size_t{1});
+    auto builders = std::vector<spill_batch_builder>{};
+    builders.reserve(children.partitions());
+    for (auto child = size_t{0}; child < children.partitions(); ++child) {
+      builders.emplace_back(config);
+    }
+    for (auto&& batch : files.read(partition)) {
+      const auto& groups
+        = static_cast<const arrow::BinaryArray&>(*batch->column(0));
+      for (auto row = int64_t{0}; row < batch->num_rows(); ++row) {
+        auto group = partial_group{};
+        if (not deserialize_partial(groups.GetView(row), group)) {
+          return caf::make_error(ec::serialization_error,
+                                 "failed to read partial aggregations from "
+                                 "disk");
+        }
+        auto key = group_by_key{};
+        key.assign(std::make_move_iterator(group.key.begin()),
+                   std::make_move_iterator(group.key.end()));
+        auto& builder = builders[spill_partition(key, level)];
+        for (auto column = 0; column < batch->num_columns(); ++column) {
+          builder.append(
+            column,
+            static_cast<const arrow::BinaryArray&>(*batch->column(column))
+              .GetView(row));
+        }
+      }
+      // Writing after every input batch bounds the memory usage of the
+      // builders by the size of a single batch.
+      for (auto child = size_t{0}; child < builders.size(); ++child) {
+        const auto rows = detail::narrow<size_t>(builders[child].rows());
+        if (rows > 0) {
+          children.write(child, *builders[child].finish(),
+                         rows * memusage_per_group);
+        }
+      }
+    }
+    return {};
+  }
+
+  /// Restores a spilled partial aggregation, and merges it into its group.
+  void merge_partial(partial_group group,
+                     std::vector<partial_aggregation> aggregations,
+                     const configuration& config, diagnostic_handler& diag) {
+    auto key = group_by_key{};
+    key.assign(std::make_move_iterator(group.key.begin()),
+               std::make_move_iterator(group.key.end()));
+    auto restored = std::make_shared<bucket>();
+    restored->group_by_types.reserve(group.types.size());
+    for (auto& x : group.types) {
+      if (not x) {
+        restored->group_by_types.push_back(group_type::make_dead());
+      } else if (not *x) {
+        restored->group_by_types.push_back(group_type::make_empty());
+      } else {
+        restored->group_by_types.push_back(
+          group_type::make_active(std::move(*x)));
+      }
+    }
+    restored->aggregations.reserve(aggregations.size());
+    for (auto&& [partial, cfg] : zip_equal(aggregations, config.aggregations)) {
+      if (partial.dead) {
+        restored->aggregations.push_back(aggregation::make_dead());
+        continue;
+      }
+      if (not partial.input_type) {
+        restored->aggregations.push_back(aggregation::make_empty());
+        continue;
+      }
+      auto instance = cfg.make_function(partial.input_type);
+      auto err = instance ? (*instance)->merge(partial.state)
+                          : instance.error();
+      if (err) {
+        diagnostic::warning(std::move(err))
+          .note(fmt::format("failed to restore `{}` for group `{}`",
+                            cfg.function->name(), key))
+          .emit(diag);
+        restored->aggregations.push_back(aggregation::make_dead());
+        continue;
+      }
+      restored->aggregations.push_back(
+        aggregation::make_active(std::move(*instance)));
+    }
+    if (auto existing = buckets.find(key); existing != buckets.end()) {
+      merge_bucket(*existing->second, *restored, key, config, diag);
+      account(*existing->second);
+      return;
+    }
+    restored->key_memusage = estimate_memusage(key);
+    account(*restored);
+    buckets.emplace(std::move(key), std::move(restored));
+  }
+
+  /// Merges the partial aggregation of a group into an existing bucket for the
+  /// same group.
+  void merge_bucket(bucket& existing, bucket& other, const group_by_key& key,
+                    const configuration& config, diagnostic_handler& diag) {
+    existing.created_at = std::min(existing.created_at, other.created_at);
+    existing.updated_at = std::max(existing.updated_at, other.updated_at);
+    // Merge the group-by types like for a new batch of input.
+    for (auto [mine, theirs] :
+         zip_equal(existing.group_by_types, other.group_by_types)) {
+      if (mine.is_dead()) {
+        continue;
+      }
+      if (theirs.is_dead()) {
+        mine.set_dead();
+        continue;
+      }
+      if (theirs.is_empty()) {
+        continue;
+      }
+      if (mine.is_empty()) {
+        mine.set_active(theirs.get_active());
+        continue;
+      }
+      auto existing_type = mine.get_active();
+      const auto& other_type = theirs.get_active();
+      if (other_type == existing_type) {
+        continue;
+      }
+      auto pruned = existing_type.prune();
+      if (other_type.prune() == pruned) {
+        mine.set_active(std::move(pruned));
+      } else {
+        diagnostic::warning("summarize found matching group for key `{}`, "
+                            "but the existing type `{}` clashes with `{}`",
+                            key, existing_type, other_type)
+          .emit(diag);
+        mine.set_dead();
+      }
+    }
+    // Merge the partial states of the aggregation functions.
+    for (auto&& [mine, theirs, cfg] :
+         zip_equal(existing.aggregations, other.aggregations,
+                   config.aggregations)) {
+      if (mine.is_dead()) {
+        continue;
+      }
+      if (theirs.is_dead()) {
+        mine.set_dead();
+        continue;
+      }
+      if (theirs.is_empty()) {
+        continue;
+      }
+      if (mine.is_empty()) {
+        mine.set_active(std::move(theirs.get_active()));
+        continue;
+      }
+      auto& func = mine.get_active();
+      auto& other_func = theirs.get_active();
+      if (func->input_type() != other_func->input_type()) {
+        diagnostic::warning("summarize aggregation function for group `{}` "
+                            "expected type `{}`, but got `{}`",
+                            key, func->input_type(), other_func->input_type())
+          .emit(diag);
+        mine.set_dead();
+        continue;
+      }
+      // Both functions live in this process, so we merge them directly
+      // instead of round-tripping through a partial state like for spilling.
+      if (auto err = func->merge(*other_func)) {
+        diagnostic::warning(std::move(err))
+          .note(fmt::format("failed to merge `{}` for group `{}`",
+                            cfg.function->name(), key))
+          .emit(diag);
+        mine.set_dead();
+      }
+    }
+  }
+
   /// This class takes a `T` that is contextually convertible to `bool`. It
   /// exposes three states: The state is `empty` if the underlying value is
   /// false. This class does not allow access to the value in that case. Other
@@ -790,8 +1635,26 @@ private:
       = std::chrono::steady_clock::now();
     std::chrono::steady_clock::time_point updated_at
       = std::chrono::steady_clock::now();
+
+    /// The number of the last batch that contained this bucket, and the index
+    /// of this bucket among the buckets of that batch.
+    uint64_t batch = 0;
+    size_t batch_group = 0;
+
+    /// The spill partition of this bucket, as determined by the last spill.
+    size_t partition = 0;
+
+    /// Estimates of the memory that the group-by key and the entire bucket
+    /// use, respectively.
+    size_t key_memusage = 0;
+    size_t memusage = 0;
   };
 
+  /// Maps the normalized group-by keys of a schema to their buckets.
+  using bucket_index
+    = tsl::robin_map<std::string, bucket*, normalized_key_hash, std::equal_to<>,
+                     std::allocator<std::pair<std::string, bucket*>>, true>;
+
   /// We cache the offsets and types of the resolved columns for each schema.
   tsl::robin_map<type, binding> bindings = {};
 
@@ -799,6 +1662,181 @@ private:
   tsl::robin_map<group_by_key, std::shared_ptr<bucket>, group_by_key_hash,
                  group_by_key_equal>
     buckets = {};
+
+  /// Caches the buckets for the normalized group-by keys of every schema. The
+  /// buckets themselves remain the source of truth.
+  tsl::robin_map<type, bucket_index> bucket_indices = {};
+
+  /// The number of batches added so far.
+  uint64_t num_batches = 0;
+
+  /// An estimate of the memory that all buckets use.
+  size_t memusage_ = 0;
+
+  /// The spilled partial aggregations, created on the first spill.
+  std::unique_ptr<spill_files> spill_ = {};
+};
+
+/// Rounds a time down to a multiple of a duration since the epoch.
+auto floor_to(time x, duration resolution) -> time {
+  auto count = x.time_since_epoch().count() / resolution.count();
+  if (x.time_since_epoch().count() % resolution.count() < 0) {
+    count -= 1;
+  }
+  return time{count * resolution};
+}
+
+/// Aggregates the input per window of event time. Every window has its own
+/// groups, which are emitted and freed as soon as the watermark, i.e., the
+/// largest observed event time minus the allowed lateness, passes the end of
+/// the window.
+class window_aggregation {
+public:
+  /// Assigns the rows of a slice to their windows, and aggregates them there.
+  /// Rows that only belong to windows that were emitted already are dropped.
+  void add(const table_slice& slice, const configuration& config,
+           diagnostic_handler& diag) {
+    TENZIR_ASSERT(config.window);
+    const auto& options = *config.window;
+    const auto& column = resolve(slice.schema(), options, diag);
+    if (not column) {
+      return;
+    }
+    auto batch = to_record_batch(slice);
+    auto array = column->get(*batch);
+    const auto& times = static_cast<const arrow::TimestampArray&>(*array);
+    // We collect the runs of consecutive rows per window, so that we can add
+    // them as subslices without copying. For input that arrives in order of
+    // its event time, every window gets a single run.
+    auto runs = std::map<time, std::vector<std::pair<size_t, size_t>>>{};
+    auto max_time = max_time_;
+    auto num_late = size_t{0};
+    for (auto row = int64_t{0}; row < times.length(); ++row) {
+      if (times.IsNull(row)) {
+        continue;
+      }
+      const auto t = time{duration{times.Value(row)}};
+      max_time = max_time ? std::max(*max_time, t) : t;
+      const auto index = detail::narrow<size_t>(row);
+      auto assigned = false;
+      for (auto start = floor_to(t, options.slide); start + options.size > t;
+           start -= options.slide) {
+        if (watermark_ and start + options.size <= *watermark_) {
+          // This window and all earlier ones were emitted already.
+          break;
+        }
+        auto& xs = runs[start];
+        if (not xs.empty() and xs.back().second == index) {
+          xs.back().second += 1;
+        } else {
+          xs.emplace_back(index, index + 1);
+        }
+        assigned = true;
+      }
+      num_late += assigned ? 0 : 1;
+    }
+    // The windows share the resolved columns, so that we warn about missing
+    // columns only once per schema rather than once per window.
+    const auto& bound = bind(slice.schema(), config, diag);
+    for (const auto& [start, xs] : runs) {
+      auto& impl = windows_[start];
+      for (const auto& [begin, end] : xs) {
+        impl.add(subslice(slice, begin, end), bound, config, diag);
+      }
+    }
+    if (num_late > 0 and not warned_late_) {
+      diagnostic::warning("dropped {} events that arrived after their windows "
+                          "were closed",
+                          num_late)
+        .note("consider increasing the allowed `lateness`")
+        .emit(diag);
+      warned_late_ = true;
+    }
+    if (max_time) {
+      max_time_ = max_time;
+      watermark_ = *max_time - options.lateness;
+    }
+  }
+
+  /// Emits the windows that the watermark passed, or all windows if the input
+  /// is done.
+  auto flush(const configuration& config, diagnostic_handler& diag, bool done)
+    -> generator<caf::expected<table_slice>> {
+    TENZIR_ASSERT(config.window);
+    // All windows have the same size, so they end in the order of their start.
+    while (not windows_.empty()) {
+      auto it = windows_.begin();
+      const auto start = it->first;
+      const auto end = start + config.window->size;
+      if (not done and (not watermark_ or end > *watermark_)) {
+        break;
+      }
+      auto impl = std::move(it->second);
+      windows_.erase(it);
+      for (auto&& result :
+           std::move(impl).finish(config, diag, std::pair{start, end})) {
+        co_yield std::move(result);
+      }
+    }
+  }
+
+private:
+  /// Resolves the event-time column for a schema, warning once per schema if
+  /// it is missing or not of type `time`.
+  auto resolve(const type& schema, const configuration::window_options& options,
+               diagnostic_handler& diag) -> const std::optional<offset>& {
+    auto it = columns_.find(schema);
+    if (it != columns_.end()) {
+      return it->second;
+    }
+    auto result = std::optional<offset>{};
+    if (auto index = schema.resolve_key_or_concept_once(options.field)) {
+      const auto& field_type = caf::get<record_type>(schema).field(*index).type;
+      if (caf::holds_alternative<time_type>(field_type)) {
+        result = std::move(*index);
+      } else {
+        diagnostic::warning("window field `{}` has type `{}` instead of `time` "
+                            "for schema `{}`",
+                            options.field, field_type, schema.name())
+          .emit(diag);
+      }
+    } else {
+      diagnostic::warning("window field `{}` does not exist for schema `{}`",
+                          options.field, schema.name())
+        .emit(diag);
+    }
+    return columns_.try_emplace(schema, std::move(result)).first->second;
+  }
+
+  /// Resolves the aggregation and group-by columns for a schema once for all
+  /// windows.
+  auto bind(const type& schema, const configuration& config,
+            diagnostic_handler& diag) -> const binding& {
+    auto it = bindings_.find(schema);
+    if (it == bindings_.end()) {
+      it = bindings_.try_emplace(it, schema,
+                                 binding::make(schema, config, diag));
+    }
+    return it->second;
+  }
+
+  /// The resolved event-time column per schema.
+  tsl::robin_map<type, std::optional<offset>> columns_ = {};
+
+  /// The resolved aggregation and group-by columns per schema.
+  tsl::robin_map<type, binding> bindings_ = {};
+
+  /// The groups of the windows that are still open, keyed by their start.
+  std::map<time, implementation> windows_ = {};
+
+  /// The largest observed event time.
+  std::optional<time> max_time_ = {};
+
+  /// Windows that end at or before the watermark are closed.
+  std::optional<time> watermark_ = {};
+
+  /// Whether we warned about dropped late events already.
+  bool warned_late_ = false;
 };
 
 /// The summarize pipeline operator implementation.
@@ -817,10 +1855,138 @@ public:
   operator()(generator<table_slice> input, operator_control_plane& ctrl) const
     -> generator<table_slice> {
     co_yield {};
+    if (config_.window) {
+      auto windows = window_aggregation{};
+      for (auto&& slice : input) {
+        if (slice.rows() == 0) {
+          co_yield {};
+          continue;
+        }
+        windows.add(slice, config_, ctrl.diagnostics());
+        for (auto&& result :
+             windows.flush(config_, ctrl.diagnostics(), false)) {
+          if (not result) {
+            diagnostic::error(result.error()).emit(ctrl.diagnostics());
+            co_return;
+          }
+          co_yield std::move(*result);
+        }
+      }
+      for (auto&& result : windows.flush(config_, ctrl.diagnostics(), true)) {
+        if (not result) {
+          diagnostic::error(result.error()).emit(ctrl.diagnostics());
+          co_return;
+        }
+        co_yield std::move(*result);
+      }
+      co_return;
+    }
     auto impl = implementation{};
+    // Without timeouts, we pre-aggregate batches of the input in parallel into
+    // partial aggregations, and then merge them in order of their input.
+    // Timeouts require all groups in one place, so we aggregate sequentially.
+    const auto parallelism
+      = config_.created_timeout or config_.update_timeout
+          ? uint64_t{1}
+          : std::max(config_.parallelism, uint64_t{1});
+    // When the groups exceed the memory budget, we spill their partial
+    // aggregations to disk. Timeouts require all groups in memory.
+    const auto memory_budget
+      = config_.created_timeout or config_.update_timeout
+          ? uint64_t{0}
+          : config_.memory_budget;
+    auto pending = std::vector<table_slice>{};
+    auto partials = std::vector<implementation>{};
+    auto diagnostics = std::vector<collecting_diagnostic_handler>{};
+    // Starts the partial aggregations of the pending batches on Arrow's CPU
+    // thread pool, which is bounded and shared across operators, so that we do
+    // not start a thread per batch.
+    auto start = [&]() -> arrow::Future<> {
+      // Resolve the columns upfront, so that the partial aggregations share
+      // them and we only warn once. The references remain valid once all
+      // schemas are resolved.
+      for (const auto& slice : pending) {
+        (void)impl.bind(slice.schema(), config_, ctrl.diagnostics());
+      }
+      partials = std::vector<implementation>(pending.size());
+      diagnostics = std::vector<collecting_diagnostic_handler>(pending.size());
+      auto futures = std::vector<arrow::Future<>>{};
+      futures.reserve(pending.size());
+      for (auto i = size_t{0}; i < pending.size(); ++i) {
+        const auto& bound
+          = impl.bind(pending[i].schema(), config_, ctrl.diagnostics());
+        auto task = [&, i, &columns = bound] {
+          // Diagnostics must not escape the thread pool, so we hand them to
+          // the operator like all others.
+          try {
+            partials[i].add(pending[i], columns, config_, diagnostics[i]);
+          } catch (diagnostic& diag) {
+            diagnostics[i].emit(std::move(diag));
+          }
+        };
+        auto future = arrow::internal::GetCpuThreadPool()->Submit(task);
+        if (not future.ok()) {
+          // The thread pool only rejects tasks when it shuts down, in which
+          // case we aggregate the batch on our own thread.
+          task();
+          continue;
+        }
+        futures.push_back(future.MoveValueUnsafe());
+      }
+      return arrow::AllComplete(futures);
+    };
+    // Aggregates the pending batches, and spills the groups to disk when they
+    // exceed the memory budget. While the partial aggregations run, we
+    // suspend the operator instead of blocking its thread.
+    auto aggregate = [&]() -> generator<table_slice> {
+      if (pending.size() == 1) {
+        impl.add(pending.front(), config_, ctrl.diagnostics());
+      } else {
+        auto done = start();
+        // The tasks reference the state of the operator, so we must not
+        // leave before they finished.
+        auto guard = caf::detail::make_scope_guard([&] {
+          done.Wait();
+        });
+        if (not done.is_finished()) {
+          done.AddCallback([waker = ctrl.make_waker()](const arrow::Status&) {
+            waker();
+          });
+        }
+        while (not done.is_finished()) {
+          ctrl.set_waiting(true);
+          co_yield {};
+        }
+        if (not done.status().ok()) {
+          diagnostic::error("{}", done.status().ToString())
+            .note("failed to aggregate batches in parallel")
+            .emit(ctrl.diagnostics());
+          co_return;
+        }
+        // We merge the partial aggregations in order of their input, which
+        // keeps order-sensitive functions deterministic.
+        for (auto i = size_t{0}; i < pending.size(); ++i) {
+          for (auto& diagnostic : std::move(diagnostics[i]).collect()) {
+            ctrl.diagnostics().emit(std::move(diagnostic));
+          }
+          impl.merge(std::move(partials[i]), config_, ctrl.diagnostics());
+        }
+        partials.clear();
+        diagnostics.clear();
+      }
+      pending.clear();
+      if (memory_budget > 0 and impl.memusage() > memory_budget) {
+        impl.spill(config_, ctrl.diagnostics());
+      }
+    };
     for (auto&& slice : input) {
       if (slice.rows() == 0) {
-        for (auto&& result : impl.check_timeouts(config_)) {
+        if (not pending.empty()) {
+          for (auto&& output : aggregate()) {
+            co_yield std::move(output);
+          }
+        }
+        for (auto&& result : impl.check_timeouts(config_, ctrl.diagnostics())) {
           if (not result) {
             diagnostic::error(result.error()).emit(ctrl.diagnostics());
             co_return;
@@ -830,9 +1996,20 @@ public:
         co_yield {};
         continue;
       }
-      impl.add(slice, config_, ctrl.diagnostics());
+      pending.push_back(std::move(slice));
+      if (pending.size() >= parallelism) {
+        for (auto&& output : aggregate()) {
+          co_yield std::move(output);
+        }
+      }
+    }
+    if (not pending.empty()) {
+      for (auto&& output : aggregate()) {
+        co_yield std::move(output);
+      }
     }
-    for (auto&& result : std::move(impl).finish(config_)) {
+    for (auto&& result :
+         std::move(impl).finish(config_, ctrl.diagnostics())) {
       if (not result) {
         diagnostic::error(result.error()).emit(ctrl.diagnostics());
         co_return;
@@ -855,8 +2032,13 @@ public:
   auto optimize(expression const& filter, event_order order) const
     -> optimize_result override {
     // Note: The `unordered` relies on commutativity of the aggregation functions.
+    // Windowed aggregation advances its watermark in order of arrival, so it
+    // must see the input in order to not drop events as late.
     (void)filter, (void)order;
-    return optimize_result{std::nullopt, event_order::unordered, copy()};
+    return optimize_result{std::nullopt,
+                           config_.window ? event_order::ordered
+                                          : event_order::unordered,
+                           copy()};
   }
 
   friend auto inspect(auto& f, summarize_operator& x) -> bool {
@@ -871,6 +2053,42 @@ private:
 /// The summarize pipeline operator plugin.
 class plugin final : public virtual operator_plugin<summarize_operator> {
 public:
+  auto initialize([[maybe_unused]] const record& plugin_config,
+                  const record& global_config) -> caf::error override {
+    auto parallelism
+      = try_get_or<uint64_t>(global_config, "tenzir.summarize-parallelism",
+                             defaults::summarize::parallelism);
+    if (not parallelism) {
+      return caf::make_error(ec::invalid_configuration,
+                             fmt::format("failed to parse "
+                                         "`tenzir.summarize-parallelism` "
+                                         "option: {}",
+                                         parallelism.error()));
+    }
+    parallelism_ = *parallelism;
+    auto memory_budget
+      = try_get_or<uint64_t>(global_config, "tenzir.summarize-memory-budget",
+                             defaults::summarize::memory_budget);
+    if (not memory_budget) {
+      return caf::make_error(ec::invalid_configuration,
+                             fmt::format("failed to parse "
+                                         "`tenzir.summarize-memory-budget` "
+                                         "option: {}",
+                                         memory_budget.error()));
+    }
+    memory_budget_ = *memory_budget;
+    if (const auto* cache_dir
+        = get_if<std::string>(&global_config, "tenzir.cache-directory")) {
+      spill_directory_
+        = (std::filesystem::path{*cache_dir} / "summarize").string();
+    } else {
+      spill_directory_
+        = (std::filesystem::temp_directory_path() / "tenzir" / "summarize")
+            .string();
+    }
+    return {};
+  }
+
   auto signature() const -> operator_signature override {
     return {.transformation = true};
   }
@@ -879,7 +2097,8 @@ public:
     -> std::pair<std::string_view, caf::expected<operator_ptr>> override {
     using parsers::end_of_pipeline_operator, parsers::required_ws_or_comment,
       parsers::optional_ws_or_comment, parsers::duration,
-      parsers::extractor_list, parsers::aggregation_function_list;
+      parsers::extractor, parsers::extractor_list,
+      parsers::aggregation_function_list;
     const auto* f = pipeline.begin();
     const auto* const l = pipeline.end();
     const auto p = required_ws_or_comment >> aggregation_function_list
@@ -890,10 +2109,9 @@ public:
                    >> -(required_ws_or_comment >> "timeout"
                         >> required_ws_or_comment >> duration)
                    >> -(required_ws_or_comment >> "update-timeout"
-                        >> required_ws_or_comment >> duration)
-                   >> optional_ws_or_comment >> end_of_pipeline_operator;
+                        >> required_ws_or_comment >> duration);
     std::tuple<std::vector<std::tuple<caf::optional<std::string>, std::string,
-                                      std::string>>,
+                                      std::string, caf::optional<data>>>,
                std::vector<std::string>, std::optional<tenzir::duration>,
                std::optional<tenzir::duration>, std::optional<tenzir::duration>>
       parsed_aggregations{};
@@ -907,7 +2125,54 @@ public:
       };
     }
     auto config = configuration{};
-    for (const auto& [output, function_name, argument] :
+    auto window_size = tenzir::duration{};
+    if ((required_ws_or_comment >> "window" >> required_ws_or_comment
+         >> duration)(f, l, window_size)) {
+      auto window = configuration::window_options{};
+      window.size = window_size;
+      // Without a `slide`, the windows are tumbling, i.e., they do not
+      // overlap.
+      window.slide = window_size;
+      auto slide = tenzir::duration{};
+      if ((required_ws_or_comment >> "slide" >> required_ws_or_comment
+           >> duration)(f, l, slide)) {
+        window.slide = slide;
+      }
+      if (not(required_ws_or_comment >> "on" >> required_ws_or_comment
+              >> extractor)(f, l, window.field)) {
+        return {
+          std::string_view{f, l},
+          caf::make_error(ec::syntax_error, "found `window` specifier without "
+                                            "`on` clause"),
+        };
+      }
+      (void)(required_ws_or_comment >> "lateness" >> required_ws_or_comment
+             >> duration)(f, l, window.lateness);
+      if (window.size <= tenzir::duration::zero()
+          or window.slide <= tenzir::duration::zero()
+          or window.slide > window.size
+          or window.lateness < tenzir::duration::zero()) {
+        return {
+          std::string_view{f, l},
+          caf::make_error(ec::syntax_error,
+                          "`window` and `slide` must be positive, `slide` "
+                          "must not exceed `window`, and `lateness` must not "
+                          "be negative"),
+        };
+      }
+      config.window = std::move(window);
+    }
+    if (not(optional_ws_or_comment >> end_of_pipeline_operator)(f, l,
+                                                                 unused)) {
+      return {
+        std::string_view{f, l},
+        caf::make_error(ec::syntax_error, fmt::format("failed to parse "
+                                                      "summarize "
+                                                      "operator: '{}'",
+                                                      pipeline)),
+      };
+    }
+    for (const auto& [output, function_name, argument, constant] :
          std::get<0>(parsed_aggregations)) {
       if (argument == ".") {
         if (function_name != "count") {
@@ -934,8 +2199,14 @@ public:
       auto new_aggregation = configuration::aggregation{};
       new_aggregation.function = function;
       new_aggregation.input = argument;
+      if (constant) {
+        new_aggregation.argument = *constant;
+      }
       new_aggregation.output
-        = (output) ? *output : fmt::format("{}({})", function_name, argument);
+        = (output)     ? *output
+          : (constant) ? fmt::format("{}({}, {})", function_name, argument,
+                                     *constant)
+                       : fmt::format("{}({})", function_name, argument);
       config.aggregations.push_back(std::move(new_aggregation));
     }
     config.group_by_extractors = std::move(std::get<1>(parsed_aggregations));
@@ -949,11 +2220,26 @@ public:
                                           "without `by` clause"),
       };
     }
+    if (config.window and (config.created_timeout or config.update_timeout)) {
+      return {
+        std::string_view{f, l},
+        caf::make_error(ec::syntax_error, "`window` cannot be combined with "
+                                          "`timeout` or `update-timeout`"),
+      };
+    }
+    config.parallelism = parallelism_;
+    config.memory_budget = memory_budget_;
+    config.spill_directory = spill_directory_;
     return {
       std::string_view{f, l},
       std::make_unique<summarize_operator>(std::move(config)),
     };
   }
+
+private:
+  uint64_t parallelism_ = defaults::summarize::parallelism;
+  uint64_t memory_budget_ = defaults::summarize::memory_budget;
+  std::string spill_directory_ = {};
 };
 
 } // namespace
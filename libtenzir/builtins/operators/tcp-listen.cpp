@@ -91,6 +91,10 @@ public:
     TENZIR_UNIMPLEMENTED();
   }
 
+  auto make_waker() noexcept -> std::function<void()> override {
+    TENZIR_UNIMPLEMENTED();
+  }
+
 private:
   shared_diagnostic_handler diagnostics_;
   bool has_terminal_;
@@ -16,6 +16,7 @@
 #include <tenzir/detail/debug_writer.hpp>
 #include <tenzir/diagnostics.hpp>
 #include <tenzir/error.hpp>
+#include <tenzir/evaluate.hpp>
 #include <tenzir/expression.hpp>
 #include <tenzir/logger.hpp>
 #include <tenzir/modules.hpp>
@@ -53,7 +54,8 @@ struct configuration {
 
 // Selects matching rows from the input.
 class where_operator final
-  : public schematic_operator<where_operator, std::optional<expression>> {
+  : public schematic_operator<where_operator,
+                              std::optional<evaluation_program>> {
 public:
   where_operator() = default;
 
@@ -87,16 +89,14 @@ public:
       //   .emit(ctrl.diagnostics());
       return std::nullopt;
     }
-    return std::move(*tailored_expr);
+    return evaluation_program::make(*tailored_expr, schema);
   }
 
-  auto process(table_slice slice, state_type& expr) const
+  auto process(table_slice slice, state_type& program) const
     -> output_type override {
     // TODO: Adjust filter function return type.
-    // TODO: Replace this with an Arrow-native filter function as soon as we
-    // are able to directly evaluate expressions on a record batch.
-    if (expr) {
-      return filter(slice, *expr).value_or(table_slice{});
+    if (program) {
+      return filter(slice, *program, ids{}).value_or(table_slice{});
     }
     return {};
   }
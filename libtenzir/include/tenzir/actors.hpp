@@ -215,6 +215,13 @@ using catalog_actor = typed_actor_fwd<
   // Conform to the procotol of the STATUS CLIENT actor.
   ::extend_with<status_client_actor>::unwrap;
 
+/// The interface of a CATALOG SNAPSHOT WRITER actor.
+using catalog_snapshot_writer_actor = typed_actor_fwd<
+  // Packs a snapshot of the given partition synopses with the given generation
+  // and writes it to disk.
+  auto(atom::write, int64_t, std::vector<partition_synopsis_pair>)
+    ->caf::result<atom::ok>>::unwrap;
+
 /// The interface of an IMPORTER actor.
 using importer_actor = typed_actor_fwd<
   // Add a new sink.
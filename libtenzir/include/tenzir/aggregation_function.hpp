@@ -15,6 +15,8 @@
 
 #include <caf/expected.hpp>
 
+#include <span>
+
 namespace tenzir {
 
 /// An aggregation function; used by the *summarize* pipeline operator to
@@ -40,9 +42,41 @@ public:
   /// elements of the *array*.
   virtual void add(const arrow::Array& array);
 
+  /// Bulk-add selected rows of an array to the aggregation function.
+  /// @param array The array to add rows of.
+  /// @param selection The indices of the rows to add in ascending order.
+  /// @pre *array* matches the input type.
+  /// @note The default implementation for this calls *add* for consecutive
+  /// runs of selected rows, and for single rows in between.
+  virtual void add(const arrow::Array& array,
+                   std::span<const int64_t> selection);
+
   /// Finish the aggregation into a single materialized value.
   [[nodiscard]] virtual caf::expected<data> finish() && = 0;
 
+  /// Return the partial state of the aggregation. Another instance of the same
+  /// function with the same input type can merge the state, which allows for
+  /// aggregating parts of the input independently.
+  /// @note The default implementation for this returns an error.
+  [[nodiscard]] virtual caf::expected<data> save() const;
+
+  /// Merge a partial state into the aggregation.
+  /// @param state The partial state as returned by *save*.
+  /// @note The default implementation for this returns an error.
+  [[nodiscard]] virtual caf::error merge(const data& state);
+
+  /// Merge another instance of the same function with the same input type
+  /// into the aggregation. Unlike merging a partial state, this does not
+  /// serialize the state of *other*.
+  /// @param other The other instance, which remains unchanged.
+  [[nodiscard]] caf::error merge(const aggregation_function& other);
+
+  /// Return an estimate of the memory that the state of the function uses in
+  /// addition to the function object itself.
+  /// @note The default implementation for this returns 0, which is correct
+  /// for functions with a state of constant size.
+  [[nodiscard]] virtual size_t memusage() const;
+
   /// Return the input type of the function.
   [[nodiscard]] const type& input_type() const noexcept;
 
@@ -52,9 +86,54 @@ protected:
   /// @param input_type The input type from the aggregation function plugin.
   explicit aggregation_function(type input_type) noexcept;
 
+  /// Creates the error for a partial state that does not match the function.
+  /// @param state The partial state passed to *merge*.
+  [[nodiscard]] caf::error make_state_error(const data& state) const;
+
+  /// Merge another instance of the function; called by *merge*.
+  /// @param other The other instance with the same input type.
+  /// @note The default implementation for this round-trips the state of
+  /// *other* through *save*.
+  [[nodiscard]] virtual caf::error
+  merge_instance(const aggregation_function& other);
+
 private:
   /// The input type of the function.
   type input_type_ = {};
 };
 
+/// Estimates the heap memory that a value owns beyond its own size. Functions
+/// that retain their input values account for this in `memusage()`, as the
+/// payloads of strings, blobs, and nested values often dominate.
+auto heap_memusage(const data& x) -> size_t;
+
+/// @copydoc heap_memusage(const data&)
+template <class T>
+  requires(not std::is_same_v<T, data>)
+auto heap_memusage(const T& x) -> size_t {
+  if constexpr (std::is_same_v<T, std::string> or std::is_same_v<T, blob>) {
+    return x.size();
+  } else if constexpr (std::is_same_v<T, list>) {
+    auto result = x.capacity() * sizeof(data);
+    for (const auto& element : x) {
+      result += heap_memusage(element);
+    }
+    return result;
+  } else if constexpr (std::is_same_v<T, map>) {
+    auto result = x.size() * 2 * sizeof(data);
+    for (const auto& [key, value] : x) {
+      result += heap_memusage(key) + heap_memusage(value);
+    }
+    return result;
+  } else if constexpr (std::is_same_v<T, record>) {
+    auto result = x.size() * (sizeof(std::string) + sizeof(data));
+    for (const auto& [key, value] : x) {
+      result += heap_memusage(key) + heap_memusage(value);
+    }
+    return result;
+  } else {
+    return 0;
+  }
+}
+
 } // namespace tenzir
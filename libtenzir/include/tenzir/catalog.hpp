@@ -15,13 +15,16 @@
 #include "tenzir/detail/heterogeneous_string_hash.hpp"
 #include "tenzir/detail/inspection_common.hpp"
 #include "tenzir/expression.hpp"
+#include "tenzir/interval_index.hpp"
 #include "tenzir/partition_synopsis.hpp"
+#include "tenzir/qualified_record_field.hpp"
 #include "tenzir/taxonomies.hpp"
 #include "tenzir/uuid.hpp"
 
 #include <caf/settings.hpp>
 #include <caf/typed_event_based_actor.hpp>
 
+#include <variant>
 #include <vector>
 
 namespace tenzir {
@@ -68,6 +71,51 @@ struct catalog_lookup_result {
   }
 };
 
+/// Indexes over the partition synopses of a single schema, which allow for
+/// answering range predicates without visiting every partition synopsis.
+/// @note The index covers the import time and all fields whose synopses track
+/// a minimum and a maximum, i.e., fields of type `int64`, `uint64`, `double`,
+/// `duration`, and `time`.
+struct catalog_schema_index {
+  /// The value ranges of a single field across partitions.
+  struct field_index {
+    /// The value ranges of partitions with a min-max synopsis for the field,
+    /// or `std::monostate` if the field has a type that we do not index, in
+    /// which case lookups must fall back to the synopses.
+    std::variant<std::monostate, basic_interval_index<int64_t>,
+                 basic_interval_index<uint64_t>, basic_interval_index<double>,
+                 basic_interval_index<duration>, basic_interval_index<time>>
+      intervals = {};
+
+    /// The sorted IDs of partitions without a min-max synopsis for the field,
+    /// which can never be ruled out.
+    std::vector<uuid> unindexed = {};
+  };
+
+  /// Adds a partition, replacing a previously added partition with the same
+  /// ID.
+  void add(const uuid& id, const partition_synopsis& synopsis);
+
+  /// Adds many partitions at once, replacing previously added partitions with
+  /// the same IDs. The intervals are sorted once per batch rather than once
+  /// per partition, which keeps loading a large catalog at O(n log n).
+  /// @pre The partition IDs are unique.
+  void add(
+    const std::vector<std::pair<uuid, const partition_synopsis*>>& partitions);
+
+  /// Removes a partition.
+  void erase(const uuid& id);
+
+  /// @returns A best-effort estimate of the memory usage in bytes.
+  auto memusage() const -> size_t;
+
+  /// The import time ranges of all partitions.
+  interval_index import_time = {};
+
+  /// The value ranges per field.
+  std::unordered_map<qualified_record_field, field_index> fields = {};
+};
+
 /// The state of the CATALOG actor.
 struct catalog_state {
 public:
@@ -92,8 +140,14 @@ public:
   /// @returns A lookup result of candidate partitions categorized by type.
   auto lookup(expression expr) const -> caf::expected<catalog_lookup_result>;
 
-  auto lookup_impl(const expression& expr, const type& schema) const
-    -> catalog_lookup_result::candidate_info;
+  /// Retrieves the candidate partitions of a single schema.
+  /// @param expr The expression to lookup.
+  /// @param schema The schema of the partitions to consider.
+  /// @param candidates If set, restricts the lookup to the given partitions,
+  /// which must be sorted.
+  auto lookup_impl(const expression& expr, const type& schema,
+                   const std::vector<partition_info>* candidates
+                   = nullptr) const -> catalog_lookup_result::candidate_info;
 
   /// @returns A best-effort estimate of the amount of memory used for this
   /// catalog (in bytes).
@@ -121,6 +175,9 @@ public:
                      detail::flat_map<uuid, partition_synopsis_ptr>>
     synopses_per_type = {};
 
+  /// For each type, the indexes over the partition synopses.
+  std::unordered_map<tenzir::type, catalog_schema_index> indexes_per_type = {};
+
   /// The set of fields that should not be touched by the pruner.
   detail::heterogeneous_string_hashset unprunable_fields;
 
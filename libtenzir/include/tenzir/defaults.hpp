@@ -81,6 +81,14 @@ inline constexpr size_t max_events = 0;
 /// Path for writing query results or `-` for writing to STDOUT.
 inline constexpr std::string_view write = "-";
 
+/// Maximum number of partitions that the `export` operator evaluates
+/// concurrently.
+inline constexpr uint64_t parallel = 4;
+
+/// Number of partitions that the `export` operator starts loading ahead of
+/// evaluating them.
+inline constexpr uint64_t prefetch = 2;
+
 /// Contains settings for the csv subcommand.
 struct csv {
   static constexpr char separator = ',';
@@ -105,6 +113,70 @@ struct infer {
   static constexpr size_t buffer_size = 8'192;
 };
 
+// -- constants for the summarize operator -------------------------------------
+
+namespace summarize {
+
+/// The number of input batches that the summarize operator pre-aggregates in
+/// parallel before merging them.
+inline constexpr uint64_t parallelism = 1;
+
+/// The number of bytes that the groups of the summarize operator may use
+/// before it spills their partial aggregations to disk.
+inline constexpr uint64_t memory_budget = 1'073'741'824; // 1 Gi
+
+/// The number of partitions into which the summarize operator divides its
+/// groups when spilling them to disk.
+inline constexpr size_t spill_partitions = 16;
+
+/// The maximum number of times that the summarize operator splits a spilled
+/// partition again when it does not fit into the memory budget on its own.
+inline constexpr size_t max_spill_depth = 4;
+
+} // namespace summarize
+
+// -- constants for the sort operator ------------------------------------------
+
+namespace sort {
+
+/// The number of bytes that the sort operator buffers in memory before it
+/// writes sorted runs to disk.
+inline constexpr uint64_t memory_budget = 1'073'741'824; // 1 Gi
+
+/// The maximum number of sorted runs that the sort operator merges at once.
+/// With more runs, it first merges them into fewer, larger runs.
+inline constexpr uint64_t merge_fan_in = 64;
+
+/// The maximum number of events for which `sort | head` keeps only the first
+/// events in memory instead of sorting the entire input.
+inline constexpr uint64_t max_top_k = 1'048'576; // 1 Mi
+
+} // namespace sort
+
+// -- constants for the deduplicate operator -----------------------------------
+
+namespace deduplicate {
+
+/// The number of bytes that the matches of the deduplicate operator may use
+/// before it evicts the least recently seen ones, or 0 for no limit. A match
+/// uses about 96 bytes.
+inline constexpr uint64_t memory_budget = 0;
+
+} // namespace deduplicate
+
+// -- constants for the JSON parser --------------------------------------------
+
+namespace json {
+
+/// The number of blocks of NDJSON input that the JSON parser parses at once.
+inline constexpr uint64_t parallelism = 1;
+
+/// The number of bytes of NDJSON input that the JSON parser parses as one
+/// block when parsing in parallel.
+inline constexpr size_t block_size = 1'048'576; // 1 Mi
+
+} // namespace json
+
 // -- constants for the index --------------------------------------------------
 
 /// Contains constants for value index parameterization.
@@ -214,6 +286,9 @@ inline constexpr caf::timespan aging_frequency = std::chrono::hours{24};
 inline constexpr std::chrono::seconds disk_scan_interval
   = std::chrono::minutes{1};
 
+/// Number of workers that execute blocking filesystem operations.
+inline constexpr size_t filesystem_workers = 4;
+
 /// Number of partitions to remove before re-checking disk size.
 inline constexpr size_t disk_monitor_step_size = 1;
 
@@ -224,6 +299,17 @@ inline constexpr size_t max_partition_size = 4'194'304; // 4 Mi
 inline constexpr caf::timespan active_partition_timeout
   = std::chrono::seconds{30};
 
+/// Number of active partitions per schema that events are spread over.
+inline constexpr size_t ingest_shards = 1;
+
+/// Interval between two snapshots of the catalog.
+inline constexpr caf::timespan catalog_snapshot_interval
+  = std::chrono::minutes{5};
+
+/// Size in bytes after which the catalog snapshot starts a new segment. Each
+/// segment is a separate FlatBuffers table, which must stay below 2 GiB.
+inline constexpr size_t catalog_snapshot_segment_size = 256 * 1024 * 1024;
+
 /// Timeout after which a new automatic rebuild is triggered.
 inline constexpr caf::timespan rebuild_interval = std::chrono::minutes{120};
 
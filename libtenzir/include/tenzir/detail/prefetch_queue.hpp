@@ -0,0 +1,92 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2024 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include "tenzir/detail/assert.hpp"
+
+#include <concepts>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <utility>
+
+namespace tenzir::detail {
+
+/// A work queue that loads items ahead of time. Items are first *queued*, then
+/// *prefetched*, e.g., spawned so that they can load their state from disk,
+/// and finally *running*. At most `parallel` items run at the same time, and
+/// at most `parallel + prefetch` items are prefetched or running in total.
+template <class Queued, class Prefetched>
+class prefetch_queue {
+public:
+  prefetch_queue(size_t parallel, size_t prefetch)
+    : parallel_{parallel}, prefetch_{prefetch} {
+    // nop
+  }
+
+  /// Appends an item to the queue.
+  void push(Queued item) {
+    queued_.push_back(std::move(item));
+  }
+
+  /// Prefetches queued items and starts prefetched items until the limits
+  /// are reached.
+  /// @param prefetch Turns a queued item into a prefetched item.
+  /// @param start Starts a prefetched item.
+  void schedule(std::invocable<Queued> auto&& prefetch,
+                std::invocable<Prefetched> auto&& start) {
+    while (running_ + prefetched_.size() < parallel_ + prefetch_
+           and not queued_.empty()) {
+      auto item = std::move(queued_.front());
+      queued_.pop_front();
+      prefetched_.push_back(std::invoke(prefetch, std::move(item)));
+    }
+    while (running_ < parallel_ and not prefetched_.empty()) {
+      auto item = std::move(prefetched_.front());
+      prefetched_.pop_front();
+      ++running_;
+      std::invoke(start, std::move(item));
+    }
+  }
+
+  /// Marks a running item as finished.
+  void finish() {
+    TENZIR_ASSERT(running_ > 0);
+    --running_;
+  }
+
+  /// Returns the prefetched items that have not started yet.
+  auto prefetched() const -> const std::deque<Prefetched>& {
+    return prefetched_;
+  }
+
+  /// Returns the number of items that were not prefetched yet.
+  auto num_queued() const -> size_t {
+    return queued_.size();
+  }
+
+  /// Returns the number of prefetched items that have not started yet.
+  auto num_prefetched() const -> size_t {
+    return prefetched_.size();
+  }
+
+  /// Returns the number of running items.
+  auto num_running() const -> size_t {
+    return running_;
+  }
+
+private:
+  size_t parallel_ = {};
+  size_t prefetch_ = {};
+  std::deque<Queued> queued_ = {};
+  std::deque<Prefetched> prefetched_ = {};
+  size_t running_ = {};
+};
+
+} // namespace tenzir::detail
@@ -0,0 +1,110 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2024 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include "tenzir/fwd.hpp"
+
+#include "tenzir/expression.hpp"
+#include "tenzir/ids.hpp"
+#include "tenzir/type.hpp"
+
+#include <functional>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace tenzir {
+
+/// An expression compiled for a single schema. Compilation resolves all
+/// columns and binds the constants to type-specialized evaluators up front,
+/// folds predicates that can be decided from the schema alone, and orders
+/// the operands of connectives such that cheap predicates run first. This
+/// makes evaluating the program for a table slice considerably cheaper than
+/// walking the expression for every slice.
+class evaluation_program {
+public:
+  /// Constructs a program that matches no events.
+  evaluation_program() = default;
+
+  /// Compiles an expression for a schema.
+  /// @param expr The expression to compile.
+  /// @param schema The schema of the table slices to evaluate the program for.
+  /// @pre *expr* must be tailored to *schema*.
+  static auto make(const expression& expr, const type& schema)
+    -> evaluation_program;
+
+  /// Evaluates the program for a table slice.
+  /// @param slice The table slice to evaluate the program for.
+  /// @param hints An optional pre-selection of rows to look at.
+  /// @returns The set of row IDs in *slice* for which the program yields true.
+  /// @pre `slice.schema() == schema()`
+  auto evaluate(const table_slice& slice, const ids& hints) const -> ids;
+
+  /// Returns whether the program can never match, in which case there is no
+  /// need to evaluate it at all.
+  auto matches_nothing() const -> bool;
+
+  /// Returns the schema the program was compiled for.
+  auto schema() const -> const type&;
+
+private:
+  /// A single node of the program. Connectives refer to their operands by
+  /// their position in the program.
+  struct node {
+    enum class opcode {
+      constant,
+      conjunction,
+      disjunction,
+      negation,
+      predicate,
+    };
+
+    /// The kind of the node.
+    opcode op = opcode::constant;
+
+    /// The result of a constant node.
+    bool value = false;
+
+    /// The range of operands of a connective.
+    size_t first = 0;
+    size_t last = 0;
+
+    /// The bound evaluator of a predicate, which takes the table slice, its
+    /// offset, and the selection.
+    std::function<ids(const table_slice&, id, const ids&)> predicate = {};
+  };
+
+  /// Evaluates the node at the given position for a selection.
+  auto evaluate(size_t index, const table_slice& slice, id offset,
+                ids selection) const -> ids;
+
+  type schema_ = {};
+  std::vector<node> nodes_ = {};
+};
+
+/// Lazily compiles an expression into evaluation programs, one per schema.
+class evaluation_program_cache {
+public:
+  evaluation_program_cache() = default;
+
+  /// Constructs a cache for an expression.
+  explicit evaluation_program_cache(expression expr);
+
+  /// Returns the program for a schema, tailoring and compiling the expression
+  /// on first use.
+  /// @returns A pointer to the program, or `nullptr` if the expression cannot
+  /// be tailored to the schema.
+  auto get(const type& schema) -> const evaluation_program*;
+
+private:
+  expression expr_ = {};
+  std::unordered_map<type, std::optional<evaluation_program>> programs_ = {};
+};
+
+} // namespace tenzir
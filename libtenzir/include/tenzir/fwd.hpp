@@ -155,6 +155,7 @@ class diagnostic_handler;
 class double_type;
 class duration_type;
 class enumeration_type;
+class evaluation_program;
 class ewah_bitmap;
 class expression;
 class http_request_description;
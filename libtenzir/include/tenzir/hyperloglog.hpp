@@ -0,0 +1,94 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2024 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include "tenzir/fwd.hpp"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace tenzir {
+
+/// A mergeable sketch for approximate distinct counts, following the
+/// HyperLogLog algorithm by Flajolet et al. It stores one small register per
+/// bucket of hash values, and estimates the count with the improved estimator
+/// by Ertl, which is accurate for small and large counts alike without
+/// empirical bias correction. The relative standard error is roughly
+/// `1.04 / sqrt(2^precision)`.
+///
+/// A sketch starts out with a sparse representation that stores only the
+/// non-zero registers, using four bytes per register. It switches to the dense
+/// representation of one byte per register once that is smaller. Both
+/// representations yield the same estimate.
+class hyperloglog {
+public:
+  /// The smallest supported precision.
+  static constexpr auto min_precision = uint8_t{4};
+
+  /// The largest supported precision.
+  static constexpr auto max_precision = uint8_t{18};
+
+  /// Constructs an empty sketch.
+  /// @param precision The base-2 logarithm of the number of registers.
+  /// @pre `min_precision <= precision <= max_precision`
+  explicit hyperloglog(uint8_t precision = 14);
+
+  /// Adds a value by its 64-bit hash digest.
+  auto add(uint64_t digest) -> void;
+
+  /// Adds all values of another sketch.
+  /// @pre Both sketches have the same precision.
+  auto merge(const hyperloglog& other) -> void;
+
+  /// Adds all values of another sketch, given by its registers.
+  /// @pre `registers.size() == num_registers()`
+  auto merge(std::span<const uint8_t> registers) -> void;
+
+  /// Adds all values of another sketch, given by its sparse entries.
+  /// @pre Every entry refers to a register index below `num_registers()`.
+  auto merge_sparse(std::span<const uint32_t> entries) -> void;
+
+  /// Returns the approximate number of distinct added values.
+  auto estimate() const -> double;
+
+  /// Returns the base-2 logarithm of the number of registers.
+  auto precision() const -> uint8_t;
+
+  /// Returns the number of registers.
+  auto num_registers() const -> size_t;
+
+  /// Returns the registers, which identify the sketch for a given precision.
+  /// Materializes the dense representation for sparse sketches.
+  auto registers() const -> std::vector<uint8_t>;
+
+  /// Returns whether the sketch uses the sparse representation.
+  auto sparse() const -> bool;
+
+  /// Returns the entries of a sparse sketch, sorted by register index. Every
+  /// entry holds the index of a non-zero register in its upper 24 bits and the
+  /// value of the register in its lower 8 bits.
+  auto sparse_entries() const -> std::span<const uint32_t>;
+
+  /// Returns the number of bytes allocated by the sketch.
+  auto memusage() const -> size_t;
+
+private:
+  /// Raises the register at the given index to at least the given value.
+  auto update(size_t index, uint8_t value) -> void;
+
+  /// Switches to the dense representation.
+  auto densify() -> void;
+
+  uint8_t precision_ = {};
+  std::vector<uint32_t> sparse_ = {};
+  std::vector<uint8_t> registers_ = {};
+};
+
+} // namespace tenzir
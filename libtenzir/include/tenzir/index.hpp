@@ -13,9 +13,13 @@
 #include "tenzir/active_partition.hpp"
 #include "tenzir/actors.hpp"
 #include "tenzir/catalog.hpp"
+#include "tenzir/defaults.hpp"
 #include "tenzir/detail/lru_cache.hpp"
 #include "tenzir/detail/stable_set.hpp"
+#include "tenzir/fbs/catalog_snapshot.hpp"
 #include "tenzir/fbs/index.hpp"
+#include "tenzir/flatbuffer.hpp"
+#include "tenzir/hash/hash.hpp"
 #include "tenzir/importer.hpp"
 #include "tenzir/plugin.hpp"
 #include "tenzir/query_context.hpp"
@@ -28,6 +32,7 @@
 #include <caf/event_based_actor.hpp>
 #include <caf/typed_response_promise.hpp>
 
+#include <map>
 #include <queue>
 #include <unordered_map>
 #include <vector>
@@ -81,6 +86,32 @@ extract_partition_synopsis(const std::filesystem::path& partition_path,
 caf::expected<flatbuffers::Offset<fbs::Index>>
 pack(flatbuffers::FlatBufferBuilder& builder, const index_state& state);
 
+/// A snapshot of all partition synopses in the catalog.
+using catalog_snapshot
+  = flatbuffer<fbs::CatalogSnapshot, fbs::CatalogSnapshotIdentifier>;
+
+/// Packs the partition synopses of the catalog into a catalog snapshot. The
+/// snapshot is a segmented file whose segments are catalog snapshot tables
+/// that each hold a subset of the partitions.
+/// @param generation The time at which the catalog state was captured, in
+/// nanoseconds since the epoch of the filesystem clock.
+/// @param synopses The partition synopses to include.
+/// @param segment_size The size in bytes after which to start a new segment.
+caf::expected<chunk_ptr>
+pack_catalog_snapshot(int64_t generation,
+                      const std::vector<partition_synopsis_pair>& synopses,
+                      size_t segment_size
+                      = defaults::catalog_snapshot_segment_size);
+
+/// Returns the segments of a catalog snapshot written by
+/// `pack_catalog_snapshot`.
+caf::expected<std::vector<catalog_snapshot>>
+unpack_catalog_snapshot(chunk_ptr chunk);
+
+/// Restores a partition synopsis from its entry in a catalog snapshot.
+caf::expected<partition_synopsis_ptr>
+unpack_catalog_snapshot_entry(const fbs::catalog_snapshot::Partition& entry);
+
 /// The state of the active partition.
 struct active_partition_info {
   /// The partition actor.
@@ -104,6 +135,27 @@ struct active_partition_info {
   }
 };
 
+/// Identifies an active partition. The events of a schema are spread over one
+/// active partition per ingest shard.
+struct active_partition_key {
+  /// The schema of the partition.
+  type schema = {};
+
+  /// The ingest shard of the partition.
+  size_t shard = {};
+
+  friend bool operator==(const active_partition_key& lhs,
+                         const active_partition_key& rhs) noexcept
+    = default;
+
+  template <class Inspector>
+  friend auto inspect(Inspector& f, active_partition_key& x) {
+    return f.object(x)
+      .pretty_name("active_partition_key")
+      .fields(f.field("schema", x.schema), f.field("shard", x.shard));
+  }
+};
+
 /// Loads partitions from disk by UUID.
 class partition_factory {
 public:
@@ -185,10 +237,24 @@ struct index_state {
   [[nodiscard]] std::string
   transformer_partition_synopsis_path_template() const;
 
+  /// The path to the snapshot of all partition synopses in the catalog.
+  [[nodiscard]] std::filesystem::path catalog_snapshot_path() const;
+
+  /// Loads the synopsis of a partition from its synopsis file, creating the
+  /// synopsis file first if it does not exist yet. Safe to call concurrently.
+  [[nodiscard]] caf::expected<partition_synopsis_ptr> load_partition_synopsis(
+    const uuid& id,
+    const std::map<uuid, std::filesystem::path>& store_map) const;
+
   caf::error load_from_disk();
 
   void flush_to_disk();
 
+  /// Writes a snapshot of all partition synopses in the catalog, which allows
+  /// for reading them from a single file on the next startup. Does nothing if
+  /// the catalog did not change since the last snapshot.
+  void write_catalog_snapshot();
+
   // -- flush handling ---------------------------------------------------------
 
   /// Adds a new flush listener.
@@ -203,20 +269,29 @@ struct index_state {
   tenzir::uuid create_query_id();
 
   /// Creates a new active partition.
-  /// @param schema The schema of the new partition. All events routed to the
-  /// partition are assumed to have the exact same schema.
+  /// @param key The schema and ingest shard of the new partition. All events
+  /// routed to the partition are assumed to have the exact same schema.
   /// @returns An iterator to the new active partition.
   [[nodiscard]] caf::expected<
-    std::unordered_map<type, active_partition_info>::iterator>
-  create_active_partition(const type& schema);
+    std::unordered_map<active_partition_key, active_partition_info>::iterator>
+  create_active_partition(const active_partition_key& key);
 
   /// Decommissions the active partition.
-  /// @param schema The schema of the active partition to decommission.
+  /// @param key The schema and ingest shard of the active partition to
+  /// decommission.
   /// @param completion The completion handler; called in the actor context of
   /// the index when the partition was decommissioned.
   /// @note This invalidates iterators to the *active_partitions* map.
   void decommission_active_partition(
-    const type& schema, std::function<void(const caf::error&)> completion);
+    const active_partition_key& key,
+    std::function<void(const caf::error&)> completion);
+
+  /// Splits a table slice into the parts for the individual ingest shards.
+  /// Without an ingest shard key, the slice is assigned to the shards in a
+  /// round-robin fashion. Otherwise, the rows are grouped by the hash of the
+  /// key's value, yielding at most one part per shard.
+  [[nodiscard]] caf::expected<std::vector<std::pair<size_t, table_slice>>>
+  split_into_shards(table_slice slice);
 
   /// Adds a new partition creation listener.
   void
@@ -247,8 +322,23 @@ struct index_state {
   /// The streaming stage.
   index_stream_stage_ptr stage;
 
-  /// One active (read/write) partition per schema.
-  std::unordered_map<type, active_partition_info> active_partitions = {};
+  /// One active (read/write) partition per schema and ingest shard.
+  std::unordered_map<active_partition_key, active_partition_info>
+    active_partitions = {};
+
+  /// The number of active partitions per schema that events are spread over.
+  size_t ingest_shards = 1;
+
+  /// The field whose value determines the ingest shard of an event. Events are
+  /// assigned to shards in a round-robin fashion if this is empty.
+  std::string ingest_shard_key = {};
+
+  /// The ingest shard that currently receives the events of a schema in
+  /// round-robin mode, and the number of events it received since it took
+  /// over. The next shard takes over after a full batch of events, so that
+  /// active partitions fill up with large table slices.
+  std::unordered_map<type, std::pair<size_t, uint64_t>> round_robin_shards
+    = {};
 
   /// Partitions that are currently in the process of persisting.
   // TODO: An alternative to keeping an explicit set of unpersisted partitions
@@ -266,6 +356,12 @@ struct index_state {
   /// The set of partitions that exist on disk.
   std::unordered_set<uuid> persisted_partitions = {};
 
+  /// Whether the catalog changed since the catalog snapshot was last written.
+  bool catalog_snapshot_dirty = {};
+
+  /// Packs and writes catalog snapshots on a dedicated thread.
+  catalog_snapshot_writer_actor catalog_snapshot_writer = {};
+
   /// This set to true after the index finished reading the catalog state
   /// from disk.
   bool accept_queries = {};
@@ -371,6 +467,11 @@ struct index_state {
 /// @param partition_capacity The maximum number of events per partition.
 /// @param active_partition_timeout Timeout after which an active partition is
 /// forcibly flushed.
+/// @param catalog_snapshot_interval The interval between two snapshots of the
+/// catalog; a zero interval disables snapshots.
+/// @param ingest_shards The number of active partitions per schema.
+/// @param ingest_shard_key The field that determines the ingest shard of an
+/// event; events are distributed round-robin if empty.
 /// @param max_inmem_partitions The maximum number of passive partitions loaded
 /// into memory.
 /// @param taste_partitions How many lookup partitions to schedule immediately.
@@ -386,8 +487,21 @@ index(index_actor::stateful_pointer<index_state> self,
       accountant_actor accountant, filesystem_actor filesystem,
       catalog_actor catalog, const std::filesystem::path& dir,
       std::string store_backend, size_t partition_capacity,
-      duration active_partition_timeout, size_t max_inmem_partitions,
+      duration active_partition_timeout, duration catalog_snapshot_interval,
+      size_t ingest_shards, std::string ingest_shard_key,
+      size_t max_inmem_partitions,
       size_t taste_partitions, size_t max_concurrent_partition_lookups,
       const std::filesystem::path& catalog_dir, index_config);
 
 } // namespace tenzir
+
+namespace std {
+
+template <>
+struct hash<tenzir::active_partition_key> {
+  size_t operator()(const tenzir::active_partition_key& x) const noexcept {
+    return tenzir::hash(std::hash<tenzir::type>{}(x.schema), x.shard);
+  }
+};
+
+} // namespace std
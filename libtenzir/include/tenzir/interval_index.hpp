@@ -0,0 +1,92 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2024 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include "tenzir/fwd.hpp"
+
+#include "tenzir/operator.hpp"
+#include "tenzir/time.hpp"
+#include "tenzir/uuid.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace tenzir {
+
+/// An index over the closed value intervals of a set of partitions. The index
+/// keeps the intervals sorted by their lower and upper bounds, which allows
+/// for finding all partitions that may contain a value satisfying a
+/// relational predicate with a binary search.
+/// @tparam T The type of the values, which must be totally ordered for all
+/// values that the index contains.
+template <class T>
+class basic_interval_index {
+public:
+  /// The closed interval [min, max] of a single partition.
+  struct interval {
+    T min = {};
+    T max = {};
+    uuid id = {};
+  };
+
+  /// Adds the interval [min, max] for a partition, replacing a previously
+  /// added interval for the same partition.
+  void insert(const uuid& id, T min, T max);
+
+  /// Adds many intervals at once, replacing previously added intervals for
+  /// the same partitions. Unlike repeated single insertions, this sorts the
+  /// new intervals only once and merges them into the index.
+  /// @pre The partition IDs in *xs* are unique.
+  void insert(std::vector<interval> xs);
+
+  /// Removes the interval of a partition.
+  /// @returns Whether the index contained an interval for the partition.
+  auto erase(const uuid& id) -> bool;
+
+  /// Finds all partitions whose interval may contain a value `v` such that
+  /// `v op x` holds.
+  /// @returns The partition IDs in ascending order, or `std::nullopt` if the
+  /// operator is not supported.
+  auto lookup(relational_operator op, T x) const
+    -> std::optional<std::vector<uuid>>;
+
+  /// @returns The number of intervals in the index.
+  auto size() const -> size_t;
+
+  /// @returns Whether the index is empty.
+  auto empty() const -> bool;
+
+  /// @returns A best-effort estimate of the memory usage in bytes.
+  auto memusage() const -> size_t;
+
+private:
+  /// The interval per partition, which allows for locating the entries of a
+  /// partition in the sorted sequences with a binary search.
+  std::unordered_map<uuid, std::pair<T, T>> ranges_ = {};
+
+  /// The intervals sorted by their lower bounds.
+  std::vector<interval> by_min_ = {};
+
+  /// The intervals sorted by their upper bounds.
+  std::vector<interval> by_max_ = {};
+};
+
+extern template class basic_interval_index<int64_t>;
+extern template class basic_interval_index<uint64_t>;
+extern template class basic_interval_index<double>;
+extern template class basic_interval_index<duration>;
+extern template class basic_interval_index<time>;
+
+/// An index over the time intervals of a set of partitions.
+using interval_index = basic_interval_index<time>;
+
+} // namespace tenzir
@@ -0,0 +1,89 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2024 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include "tenzir/fwd.hpp"
+
+#include "tenzir/type.hpp"
+
+#include <arrow/type_fwd.h>
+
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace tenzir {
+
+/// A column that contributes to a normalized key.
+struct normalized_key_column {
+  /// The type of the column.
+  tenzir::type type = {};
+
+  /// The values of the column.
+  std::shared_ptr<arrow::Array> array = {};
+
+  /// Whether larger values order first.
+  bool descending = false;
+
+  /// Whether null values order before all other values.
+  bool nulls_first = false;
+};
+
+/// Byte strings that order like the rows of a set of columns. The columns are
+/// encoded one after another into a single byte-comparable buffer per row, so
+/// comparing two keys lexicographically as unsigned bytes yields the same
+/// result as comparing the rows column by column, respecting the sort order
+/// and the null placement of every column.
+///
+/// The encoding per column is a null marker byte followed by the value:
+/// - `bool`, `int64`, `uint64`, `double`, `duration`, and `time` values use a
+///   fixed-width big-endian encoding with the sign bit adjusted.
+/// - `ip` values use their 16 bytes in network byte order, which orders IPv4
+///   addresses by their IPv4-mapped IPv6 representation.
+/// - `subnet` values use the network address followed by the prefix length.
+/// - `string` and `blob` values, and the names of `enumeration` values, escape
+///   zero bytes and end with a terminator, such that a prefix of a value orders
+///   before the value itself.
+/// For descending columns, all value bytes are inverted.
+class normalized_keys {
+public:
+  normalized_keys() = default;
+
+  /// Encodes the keys for a set of columns.
+  /// @param columns The columns to encode, in order of precedence.
+  /// @param rows The number of rows.
+  /// @pre All arrays have *rows* rows, and all types are supported.
+  static auto make(std::span<const normalized_key_column> columns,
+                   int64_t rows) -> normalized_keys;
+
+  /// Returns whether a type can be part of a normalized key.
+  static auto is_supported(const type& type) -> bool;
+
+  /// Returns the key of a row.
+  auto operator[](size_t row) const -> std::string_view {
+    return std::string_view{bytes_}.substr(offsets_[row],
+                                           offsets_[row + 1] - offsets_[row]);
+  }
+
+  /// Returns the number of rows.
+  auto size() const -> size_t {
+    return offsets_.empty() ? 0 : offsets_.size() - 1;
+  }
+
+  /// Returns an estimate of the memory used by the keys.
+  auto memusage() const -> size_t;
+
+private:
+  std::string bytes_ = {};
+  std::vector<size_t> offsets_ = {};
+};
+
+} // namespace tenzir
@@ -16,6 +16,8 @@
 
 #include <caf/typed_actor.hpp>
 
+#include <functional>
+
 namespace tenzir {
 
 /// The operator control plane is the bridge between an operator and an
@@ -44,6 +46,12 @@ struct operator_control_plane {
   /// get resumed after it yielded to the executor.
   virtual auto set_waiting(bool value) noexcept -> void = 0;
 
+  /// Returns a function that resumes the operator's runloop after it was
+  /// suspended with `set_waiting(true)`. Unlike `set_waiting(false)`, the
+  /// function may be called from any thread, e.g., from the callback of a
+  /// future that the operator waits for.
+  virtual auto make_waker() noexcept -> std::function<void()> = 0;
+
   /// Return a version of the diagnostic handler that may be passed to other
   /// threads. NOTE: Unlike for the regular diagnostic handler, emitting an
   /// erorr via the shared diagnostic handler does not shut down the operator
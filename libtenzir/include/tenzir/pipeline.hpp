@@ -159,6 +159,7 @@ auto inspect(auto& f, event_order& x) -> bool {
 }
 
 struct optimize_result;
+struct projection_result;
 
 struct operator_measurement {
   std::string unit = std::string{operator_type_name<void>()};
@@ -321,6 +322,39 @@ public:
     -> optimize_result
     = 0;
 
+  /// Optimizes the operator for the set of fields that the downstream
+  /// operators access, where `std::nullopt` stands for all fields.
+  ///
+  /// The returned fields must contain every field of the input events that
+  /// the operator accesses to produce the given fields of its output. Fields
+  /// are resolved against a schema like the fields of the `select` operator.
+  /// Operators that have no input events must return `std::nullopt`. The
+  /// default implementation returns `std::nullopt` and the operator itself,
+  /// which is always valid but acts as a barrier for the projection.
+  ///
+  /// Unlike `optimize`, this must not change the number or order of events.
+  /// Operators may use the fields to avoid producing columns that no
+  /// downstream operator accesses.
+  virtual auto
+  optimize_projection(const std::optional<std::vector<std::string>>& fields)
+    const -> projection_result;
+
+  /// Returns the number of events that the operator forwards, if it forwards
+  /// just a prefix of its input events unchanged and drops the rest.
+  virtual auto event_limit() const -> std::optional<uint64_t> {
+    return std::nullopt;
+  }
+
+  /// Returns a replacement for the operator that is equivalent to it if only
+  /// the first *limit* events of its output are used, or `nullptr` if there is
+  /// none. `pipeline::optimize` calls this for operators that are directly
+  /// followed by an operator with an event limit, which stays in place. For
+  /// example, `sort` uses this to keep only the first events in memory.
+  virtual auto with_event_limit(uint64_t limit) const -> operator_ptr {
+    (void)limit;
+    return nullptr;
+  }
+
   /// Returns the location of the operator.
   virtual auto location() const -> operator_location {
     return operator_location::anywhere;
@@ -423,6 +457,31 @@ struct optimize_result {
 /// Returns something that is valid for `op`, but probably not optimal.
 auto do_not_optimize(const operator_base& op) -> optimize_result;
 
+/// The result of calling `operator_base::optimize_projection(...)`.
+///
+/// @see operator_base::optimize_projection
+struct projection_result {
+  /// The fields of the input events that the operator accesses, or
+  /// `std::nullopt` if it may access all of them.
+  std::optional<std::vector<std::string>> fields;
+
+  /// The operator that replaces the optimized operator. Must not be null.
+  operator_ptr replacement;
+
+  projection_result(std::optional<std::vector<std::string>> fields,
+                    operator_ptr replacement)
+    : fields{std::move(fields)}, replacement{std::move(replacement)} {
+  }
+
+  /// Always valid if the operator produces every field of its output from the
+  /// same field of its input, and does not access any other fields.
+  static auto passthrough(const operator_base& op,
+                          std::optional<std::vector<std::string>> fields)
+    -> projection_result {
+    return projection_result{std::move(fields), op.copy()};
+  }
+};
+
 /// A pipeline is a sequence of pipeline operators.
 class pipeline final : public operator_base {
 public:
@@ -477,6 +536,10 @@ public:
   auto optimize(expression const& filter, event_order order) const
     -> optimize_result override;
 
+  auto
+  optimize_projection(const std::optional<std::vector<std::string>>& fields)
+    const -> projection_result override;
+
   /// Returns whether this is a well-formed `void -> void` pipeline.
   auto is_closed() const -> bool;
 
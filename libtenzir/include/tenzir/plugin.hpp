@@ -537,6 +537,16 @@ public:
   [[nodiscard]] virtual caf::expected<std::unique_ptr<aggregation_function>>
   make_aggregation_function(const type& input_type) const = 0;
 
+  /// Creates a new aggregation function that additionally takes a constant
+  /// argument, e.g., the quantile in `approximate_quantile(x, 0.9)`.
+  /// @param input_type The input type for which to create the aggregation
+  /// function.
+  /// @param argument The constant argument.
+  /// @note The default implementation rejects all arguments.
+  [[nodiscard]] virtual caf::expected<std::unique_ptr<aggregation_function>>
+  make_aggregation_function_with_argument(const type& input_type,
+                                          const data& argument) const;
+
   /// Return the value that should be used if there is no input.
   virtual auto aggregation_default() const -> data = 0;
 };
@@ -11,20 +11,58 @@
 #include "tenzir/fwd.hpp"
 
 #include "tenzir/actors.hpp"
+#include "tenzir/defaults.hpp"
 #include "tenzir/detail/weak_handle.hpp"
 #include "tenzir/filesystem_statistics.hpp"
 
 #include <caf/typed_event_based_actor.hpp>
 
 #include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 namespace tenzir {
 
+/// Statistics about filesystem operations that are shared between the POSIX
+/// filesystem and its workers.
+struct shared_filesystem_statistics {
+  /// Updates the statistics while holding a lock.
+  template <class Function>
+  void update(Function&& function) {
+    auto lock = std::lock_guard{mutex};
+    std::invoke(std::forward<Function>(function), stats);
+  }
+
+  /// Returns a copy of the statistics.
+  auto get() -> filesystem_statistics {
+    auto lock = std::lock_guard{mutex};
+    return stats;
+  }
+
+  std::mutex mutex = {};
+  filesystem_statistics stats = {};
+};
+
+/// The state for a worker of the POSIX filesystem.
+/// @relates posix_filesystem_worker
+struct posix_filesystem_worker_state {
+  /// Statistics about filesystem operations.
+  std::shared_ptr<shared_filesystem_statistics> stats = {};
+
+  /// The filesystem root.
+  std::filesystem::path root = {};
+
+  /// The actor name.
+  static inline const char* name = "posix-filesystem-worker";
+};
+
 /// The state for the POSIX filesystem.
 /// @relates posix_filesystem
 struct posix_filesystem_state {
   /// Statistics about filesystem operations.
-  filesystem_statistics stats = {};
+  std::shared_ptr<shared_filesystem_statistics> stats = {};
 
   /// The filesystem root.
   std::filesystem::path root = {};
@@ -32,22 +70,45 @@ struct posix_filesystem_state {
   /// A handle to the ACCOUNTANT actor.
   detail::weak_handle<accountant_actor> accountant = {};
 
+  /// The workers that execute the blocking filesystem operations.
+  std::vector<filesystem_actor> workers = {};
+
   /// The actor name.
   static inline const char* name = "posix-filesystem";
 
-  // Rename a file and update statistics.
-  caf::expected<atom::done> rename_single_file(const std::filesystem::path&,
-                                               const std::filesystem::path&);
+  /// Returns the worker responsible for a path. All reads, writes, mmaps, and
+  /// erases of the same path are handled by the same worker, which preserves
+  /// their order. Moves are not routed to a worker; the filesystem executes
+  /// them itself, so callers must wait for pending operations on the involved
+  /// paths before moving them.
+  auto worker_for(const std::filesystem::path& path) const
+    -> const filesystem_actor&;
 };
 
-/// A filesystem implemented with POSIX system calls.
+/// A worker of the POSIX filesystem that executes blocking filesystem
+/// operations.
+/// @param self The actor handle.
+/// @param root The filesystem root.
+/// @param stats The statistics shared with the POSIX filesystem.
+/// @returns The actor behavior.
+filesystem_actor::behavior_type posix_filesystem_worker(
+  filesystem_actor::stateful_pointer<posix_filesystem_worker_state> self,
+  std::filesystem::path root,
+  std::shared_ptr<shared_filesystem_statistics> stats);
+
+/// A filesystem implemented with POSIX system calls. The blocking system calls
+/// run in a pool of detached workers, so that operations on different files
+/// do not wait for each other.
 /// @param self The actor handle.
 /// @param root The filesystem root. The actor prepends this path to all
 ///             operations that include a path parameter.
 /// @param accountant A handle to the ACCOUNTANT actor.
+/// @param num_workers The number of workers. If zero, the filesystem executes
+///                    all operations itself.
 /// @returns The actor behavior.
 filesystem_actor::behavior_type posix_filesystem(
   filesystem_actor::stateful_pointer<posix_filesystem_state> self,
-  std::filesystem::path root, const accountant_actor& accountant);
+  std::filesystem::path root, const accountant_actor& accountant,
+  size_t num_workers = defaults::filesystem_workers);
 
 } // namespace tenzir
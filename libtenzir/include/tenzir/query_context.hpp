@@ -16,22 +16,30 @@
 
 #include <caf/typed_actor_view.hpp>
 
+#include <optional>
+#include <string>
+#include <vector>
+
 namespace tenzir {
 
 /// An extract query to retrieve the events that match the expression.
 struct extract_query_context {
   receiver_actor<table_slice> sink;
 
+  /// The fields that the receiver accesses, or `std::nullopt` for all fields.
+  /// Stores may omit all other top-level fields from the results.
+  std::optional<std::vector<std::string>> fields = {};
+
   friend bool operator==(const extract_query_context& lhs,
                          const extract_query_context& rhs) {
-    return lhs.sink == rhs.sink;
+    return lhs.sink == rhs.sink && lhs.fields == rhs.fields;
   }
 
   template <class Inspector>
   friend auto inspect(Inspector& f, extract_query_context& x) {
     return f.object(x)
       .pretty_name("tenzir.query.extract")
-      .fields(f.field("sink", x.sink));
+      .fields(f.field("sink", x.sink), f.field("fields", x.fields));
   }
 };
 
@@ -12,13 +12,17 @@
 
 #include "tenzir/actors.hpp"
 #include "tenzir/generator.hpp"
+#include "tenzir/offset.hpp"
 #include "tenzir/resource.hpp"
 #include "tenzir/table_slice.hpp"
 #include "tenzir/uuid.hpp"
 
 #include <caf/typed_event_based_actor.hpp>
 
+#include <optional>
+#include <string>
 #include <variant>
+#include <vector>
 
 namespace tenzir {
 
@@ -50,11 +54,42 @@ public:
   /// Execute an extract query against the store.
   /// @param expr The expression to filter events.
   /// @param selection Pre-filtered ids to consider.
+  /// @param fields The fields that the results must contain, or `std::nullopt`
+  /// for all fields. Stores may omit all top-level fields of the results that
+  /// do not contain any of them.
   /// @return The results of applying the extract query to each table slice.
   [[nodiscard]] virtual generator<table_slice>
-  extract(expression expr, ids selection) const;
+  extract(expression expr, ids selection,
+          std::optional<std::vector<std::string>> fields) const;
 };
 
+/// Returns the top-level fields of a schema that contain any of the given
+/// fields, sorted and without duplicates. The fields are resolved like for
+/// the `select` operator.
+auto project_columns(const type& schema, const std::vector<std::string>& fields)
+  -> std::vector<offset>;
+
+/// Returns the top-level fields of a schema that an expression tailored to the
+/// schema accesses, sorted and without duplicates.
+auto expression_columns(const type& schema, const expression& expr)
+  -> std::vector<offset>;
+
+/// Maps an offset into a schema to the corresponding offset into a projection
+/// of the schema that contains only the given top-level fields.
+/// @param included The sorted indices of the top-level fields that the
+/// projection contains.
+/// @pre The projection contains the top-level field of the offset.
+auto project_offset(offset index, const std::vector<int>& included) -> offset;
+
+/// Rewrites an expression tailored to a schema so that it applies to a
+/// projection of the schema that contains only the given top-level fields.
+/// @param included The sorted indices of the top-level fields that the
+/// projection contains.
+/// @pre The projection contains all fields that the expression accesses.
+auto project_expression(const expression& expr, const type& schema,
+                        const type& projected_schema,
+                        const std::vector<int>& included) -> expression;
+
 /// A base class for passive stores used by the store plugin.
 class passive_store : public base_store {
 public:
@@ -286,6 +286,8 @@ private:
 
 /// Concatenates all slices in the given range.
 /// @param slices The input table slices.
+/// @throws diagnostic if Arrow fails to concatenate a column, e.g., because
+/// the result exceeds the offset range of a variable-width column.
 table_slice concatenate(std::vector<table_slice> slices);
 
 /// Selects all rows in `slice` with event IDs in `selection`. Cuts `slice`
@@ -296,6 +298,16 @@ table_slice concatenate(std::vector<table_slice> slices);
 generator<table_slice>
 select(const table_slice& slice, expression expr, const ids& hints);
 
+/// Selects all rows in `slice` with event IDs in `selection` that match an
+/// evaluation program. Cuts `slice` into multiple slices if `selection`
+/// produces gaps.
+/// @param slice The input table slice.
+/// @param program The evaluation program compiled for the schema of `slice`.
+/// @param hints ID set for selecting events from `slice`.
+generator<table_slice> select(const table_slice& slice,
+                              const evaluation_program& program,
+                              const ids& hints);
+
 /// Produces a new table slice consisting only of events addressed in `hints`
 /// that match the given expression. Does not preserve ids; use `select`
 /// instead if the id mapping must be maintained.
@@ -307,6 +319,17 @@ select(const table_slice& slice, expression expr, const ids& hints);
 std::optional<table_slice>
 filter(const table_slice& slice, expression expr, const ids& hints);
 
+/// Produces a new table slice consisting only of events addressed in `hints`
+/// that match an evaluation program. Does not preserve ids; use `select`
+/// instead if the id mapping must be maintained.
+/// @param slice The input table slice.
+/// @param program The evaluation program compiled for the schema of `slice`.
+/// @param hints An ID set for pruning the events that need to be considered.
+/// @returns a new table slice consisting only of events matching the program.
+std::optional<table_slice> filter(const table_slice& slice,
+                                  const evaluation_program& program,
+                                  const ids& hints);
+
 /// Counts the rows that match an expression.
 /// @param slice The input table slice.
 /// @param expr The expression to evaluate.
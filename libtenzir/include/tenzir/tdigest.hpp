@@ -0,0 +1,83 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2024 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include "tenzir/fwd.hpp"
+
+#include <limits>
+#include <span>
+#include <vector>
+
+namespace tenzir {
+
+/// A mergeable sketch for approximate quantiles, following the merging
+/// t-digest by Dunning and Ertl. Added values are buffered and periodically
+/// merged into a sorted list of centroids. The scale function limits the
+/// weight of centroids near the extreme quantiles, so the sketch is most
+/// accurate there, while the number of centroids stays proportional to the
+/// compression.
+class tdigest {
+public:
+  /// A cluster of values, represented by their mean and their number.
+  struct centroid {
+    double mean = {};
+    double weight = {};
+  };
+
+  /// Constructs an empty digest.
+  /// @param compression The maximum number of centroids is roughly
+  /// proportional to this value.
+  explicit tdigest(double compression = 100.0);
+
+  /// Adds a value.
+  /// @pre *x* is not NaN and *weight* is positive.
+  auto add(double x, double weight = 1.0) -> void;
+
+  /// Adds all values of another digest.
+  auto merge(const tdigest& other) -> void;
+
+  /// Adds the centroids of another digest.
+  /// @param centroids The centroids of the other digest.
+  /// @param min The smallest value of the other digest.
+  /// @param max The largest value of the other digest.
+  auto merge(std::span<const centroid> centroids, double min, double max)
+    -> void;
+
+  /// Returns the approximate value at a quantile.
+  /// @pre `not empty()` and `0.0 <= q <= 1.0`
+  auto quantile(double q) -> double;
+
+  /// Returns whether no values were added.
+  auto empty() const -> bool;
+
+  /// Returns the total weight of all added values.
+  auto count() const -> double;
+
+  /// Returns the smallest added value.
+  auto min() const -> double;
+
+  /// Returns the largest added value.
+  auto max() const -> double;
+
+  /// Returns the centroids after merging all buffered values.
+  auto centroids() -> std::span<const centroid>;
+
+private:
+  /// Merges the buffered values into the centroids.
+  auto compress() -> void;
+
+  double compression_ = {};
+  std::vector<centroid> centroids_ = {};
+  std::vector<centroid> buffer_ = {};
+  double count_ = {};
+  double min_ = std::numeric_limits<double>::infinity();
+  double max_ = -std::numeric_limits<double>::infinity();
+};
+
+} // namespace tenzir
@@ -0,0 +1,89 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2024 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include "tenzir/fwd.hpp"
+
+#include "tenzir/chunk.hpp"
+#include "tenzir/data.hpp"
+#include "tenzir/expression.hpp"
+#include "tenzir/time.hpp"
+
+#include <caf/expected.hpp>
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace tenzir {
+
+/// Statistics about a single leaf column of a batch of events.
+struct column_statistics {
+  /// The smallest non-null value, or `caf::none` if unknown.
+  data min = {};
+
+  /// The largest non-null value, or `caf::none` if unknown.
+  data max = {};
+
+  /// The number of null values, or `std::nullopt` if unknown.
+  std::optional<uint64_t> null_count = {};
+
+  friend auto inspect(auto& f, column_statistics& x) -> bool {
+    return f.object(x)
+      .pretty_name("tenzir.column_statistics")
+      .fields(f.field("min", x.min), f.field("max", x.max),
+              f.field("null_count", x.null_count));
+  }
+};
+
+/// A zone map summarizes a batch of events with per-column statistics, which
+/// allows for skipping the batch for expressions that cannot match any of its
+/// events without decoding it.
+struct zone_map {
+  /// Computes the zone map for a table slice. Minimum and maximum values are
+  /// only tracked for columns of type `int64`, `uint64`, `double`, `duration`,
+  /// and `time`.
+  static auto make(const table_slice& slice) -> zone_map;
+
+  /// Checks whether an expression may match any of the events in the batch.
+  /// @param expr An expression tailored to the schema of the batch.
+  /// @returns false if no event in the batch can match the expression.
+  auto may_match(const expression& expr) const -> bool;
+
+  /// The number of events in the batch.
+  uint64_t rows = {};
+
+  /// The import time of the batch.
+  time import_time = {};
+
+  /// The statistics per leaf column, indexed by the flat column index.
+  std::vector<column_statistics> columns = {};
+
+  friend auto inspect(auto& f, zone_map& x) -> bool {
+    return f.object(x)
+      .pretty_name("tenzir.zone_map")
+      .fields(f.field("rows", x.rows), f.field("import_time", x.import_time),
+              f.field("columns", x.columns));
+  }
+
+private:
+  auto may_match(const predicate& pred) const -> std::optional<bool>;
+};
+
+/// Packs the zone maps of all batches of a file into a versioned FlatBuffers
+/// table that is independent of the in-memory layout of `zone_map`.
+auto pack_zone_maps(const std::vector<zone_map>& zone_maps)
+  -> caf::expected<chunk_ptr>;
+
+/// Unpacks zone maps that were packed with `pack_zone_maps`.
+/// @returns an error if the chunk is not a valid zone maps table, or if it
+/// uses a version that is not known to this build.
+auto unpack_zone_maps(chunk_ptr chunk) -> caf::expected<std::vector<zone_map>>;
+
+} // namespace tenzir
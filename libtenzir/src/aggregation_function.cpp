@@ -9,6 +9,9 @@
 #include "tenzir/aggregation_function.hpp"
 
 #include "tenzir/arrow_table_slice.hpp"
+#include "tenzir/error.hpp"
+
+#include <iterator>
 
 namespace tenzir {
 
@@ -17,6 +20,47 @@ void aggregation_function::add(const arrow::Array& array) {
     add(value);
 }
 
+void aggregation_function::add(const arrow::Array& array,
+                               std::span<const int64_t> selection) {
+  auto begin = selection.begin();
+  while (begin != selection.end()) {
+    auto end = std::next(begin);
+    while (end != selection.end() and *end == *std::prev(end) + 1) {
+      ++end;
+    }
+    const auto length = std::distance(begin, end);
+    if (length == 1) {
+      add(value_at(input_type_, array, *begin));
+    } else {
+      add(*array.Slice(*begin, length));
+    }
+    begin = end;
+  }
+}
+
+caf::expected<data> aggregation_function::save() const {
+  return caf::make_error(ec::unimplemented,
+                         fmt::format("aggregation function for `{}` does not "
+                                     "support partial states",
+                                     input_type_));
+}
+
+caf::error aggregation_function::merge(const data& state) {
+  (void)state;
+  return caf::make_error(ec::unimplemented,
+                         fmt::format("aggregation function for `{}` does not "
+                                     "support partial states",
+                                     input_type_));
+}
+
+caf::error aggregation_function::merge(const aggregation_function& other) {
+  return merge_instance(other);
+}
+
+size_t aggregation_function::memusage() const {
+  return 0;
+}
+
 aggregation_function::aggregation_function(type input_type) noexcept
   : input_type_{std::move(input_type)} {
   // nop
@@ -26,4 +70,27 @@ const type& aggregation_function::input_type() const noexcept {
   return input_type_;
 }
 
+caf::error aggregation_function::make_state_error(const data& state) const {
+  return caf::make_error(ec::type_clash,
+                         fmt::format("cannot merge partial state `{}` into "
+                                     "aggregation function for `{}`",
+                                     state, input_type_));
+}
+
+caf::error
+aggregation_function::merge_instance(const aggregation_function& other) {
+  auto state = other.save();
+  if (not state)
+    return std::move(state.error());
+  return merge(*state);
+}
+
+auto heap_memusage(const data& x) -> size_t {
+  return caf::visit(
+    [](const auto& value) {
+      return heap_memusage(value);
+    },
+    x);
+}
+
 } // namespace tenzir
@@ -93,9 +93,24 @@ void add_root_opts(command& cmd) {
   cmd.options.add<int64_t>("?tenzir", "max-partition-size",
                            "maximum number of events in a "
                            "partition");
+  cmd.options.add<std::string>("?tenzir", "store-backend",
+                               "store backend for new partitions, e.g., "
+                               "feather or parquet (default: feather)");
   cmd.options.add<duration>("?tenzir", "active-partition-timeout",
                             "timespan after which an active partition is "
                             "forcibly flushed (default: 30s)");
+  cmd.options.add<int64_t>("?tenzir", "ingest-shards",
+                           "number of active partitions per schema that "
+                           "events are spread over (default: 1)");
+  cmd.options.add<std::string>("?tenzir", "ingest-shard-key",
+                               "field whose value determines the active "
+                               "partition of an event (default: round-robin)");
+  cmd.options.add<duration>("?tenzir", "catalog-snapshot-interval",
+                            "timespan between two snapshots of the catalog "
+                            "(default: 5min)");
+  cmd.options.add<int64_t>("?tenzir", "filesystem-workers",
+                           "number of threads that execute blocking "
+                           "filesystem operations (default: 4)");
   cmd.options.add<int64_t>("?tenzir", "max-resident-partitions",
                            "maximum number of in-memory "
                            "partitions (default: 1)");
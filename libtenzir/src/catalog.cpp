@@ -11,6 +11,7 @@
 #include "tenzir/actors.hpp"
 #include "tenzir/data.hpp"
 #include "tenzir/defaults.hpp"
+#include "tenzir/detail/narrow.hpp"
 #include "tenzir/detail/overload.hpp"
 #include "tenzir/detail/set_operations.hpp"
 #include "tenzir/detail/tracepoint.hpp"
@@ -21,6 +22,7 @@
 #include "tenzir/io/read.hpp"
 #include "tenzir/io/save.hpp"
 #include "tenzir/logger.hpp"
+#include "tenzir/min_max_synopsis.hpp"
 #include "tenzir/modules.hpp"
 #include "tenzir/partition_synopsis.hpp"
 #include "tenzir/pipeline.hpp"
@@ -36,8 +38,73 @@
 #include <caf/detail/set_thread_name.hpp>
 #include <caf/expected.hpp>
 
+#include <cmath>
+#include <variant>
+
 namespace tenzir {
 
+namespace {
+
+/// Checks whether the catalog can answer a lookup for an expression from its
+/// indexes without checking the synopses of all partitions.
+auto is_indexed(const expression& expr) -> bool {
+  const auto* pred = caf::get_if<predicate>(&expr);
+  if (not pred) {
+    return false;
+  }
+  if (const auto* lhs = caf::get_if<meta_extractor>(&pred->lhs)) {
+    return lhs->kind == meta_extractor::import_time;
+  }
+  const auto* rhs = caf::get_if<data>(&pred->rhs);
+  return rhs
+         and (caf::holds_alternative<int64_t>(*rhs)
+              or caf::holds_alternative<uint64_t>(*rhs)
+              or caf::holds_alternative<double>(*rhs)
+              or caf::holds_alternative<duration>(*rhs)
+              or caf::holds_alternative<tenzir::time>(*rhs));
+}
+
+using field_intervals = decltype(catalog_schema_index::field_index::intervals);
+
+/// Creates an empty index for the value ranges of a field, which is only
+/// possible for fields whose synopses track a minimum and a maximum.
+auto make_field_intervals(const type& field_type) -> field_intervals {
+  auto f = detail::overload{
+    [](const int64_type&) -> field_intervals {
+      return basic_interval_index<int64_t>{};
+    },
+    [](const uint64_type&) -> field_intervals {
+      return basic_interval_index<uint64_t>{};
+    },
+    [](const double_type&) -> field_intervals {
+      return basic_interval_index<double>{};
+    },
+    [](const duration_type&) -> field_intervals {
+      return basic_interval_index<duration>{};
+    },
+    [](const time_type&) -> field_intervals {
+      return basic_interval_index<tenzir::time>{};
+    },
+    [](const auto&) -> field_intervals {
+      return std::monostate{};
+    },
+  };
+  return caf::visit(f, field_type);
+}
+
+/// The intervals of a batch of partitions for a single field, which we insert
+/// into the field's index at once.
+template <class T>
+using staged_intervals
+  = std::vector<typename basic_interval_index<T>::interval>;
+
+using any_staged_intervals
+  = std::variant<staged_intervals<int64_t>, staged_intervals<uint64_t>,
+                 staged_intervals<double>, staged_intervals<duration>,
+                 staged_intervals<tenzir::time>>;
+
+} // namespace
+
 auto catalog_lookup_result::size() const noexcept -> size_t {
   return std::accumulate(candidate_infos.begin(), candidate_infos.end(),
                          size_t{0}, [](auto i, const auto& cat_result) {
@@ -50,6 +117,120 @@ auto catalog_lookup_result::empty() const noexcept -> bool {
   return candidate_infos.empty();
 }
 
+void catalog_schema_index::add(const uuid& id,
+                               const partition_synopsis& synopsis) {
+  add({{id, &synopsis}});
+}
+
+void catalog_schema_index::add(
+  const std::vector<std::pair<uuid, const partition_synopsis*>>& partitions) {
+  auto import_times = std::vector<interval_index::interval>{};
+  import_times.reserve(partitions.size());
+  auto intervals
+    = std::unordered_map<qualified_record_field, any_staged_intervals>{};
+  auto unindexed
+    = std::unordered_map<qualified_record_field, std::vector<uuid>>{};
+  for (const auto& [id, synopsis] : partitions) {
+    erase(id);
+    import_times.push_back(
+      {synopsis->min_import_time, synopsis->max_import_time, id});
+    for (const auto& [field, field_synopsis] : synopsis->field_synopses_) {
+      auto [it, inserted] = fields.try_emplace(field);
+      auto& index = it->second;
+      if (inserted) {
+        index.intervals = make_field_intervals(field.type());
+      }
+      // Fields without a dedicated synopsis fall back to the synopsis for
+      // their type, just like for lookups in the catalog.
+      const auto* ptr = field_synopsis.get();
+      if (not ptr) {
+        auto prune = [&]<concrete_type T>(const T& x) {
+          return type{x};
+        };
+        const auto type_synopsis
+          = synopsis->type_synopses_.find(caf::visit(prune, field.type()));
+        if (type_synopsis != synopsis->type_synopses_.end()) {
+          ptr = type_synopsis->second.get();
+        }
+      }
+      auto stage = detail::overload{
+        [](const std::monostate&) {
+          // We do not index fields of this type.
+        },
+        [&]<class T>(const basic_interval_index<T>&) {
+          const auto* mm = dynamic_cast<const min_max_synopsis<T>*>(ptr);
+          if (not mm) {
+            unindexed[field].push_back(id);
+            return;
+          }
+          auto [staged, _]
+            = intervals.try_emplace(field, staged_intervals<T>{});
+          std::get<staged_intervals<T>>(staged->second)
+            .push_back({mm->min(), mm->max(), id});
+        },
+      };
+      std::visit(stage, index.intervals);
+    }
+  }
+  import_time.insert(std::move(import_times));
+  for (auto& [field, xs] : intervals) {
+    auto insert = [&]<class T>(staged_intervals<T>& xs) {
+      std::get<basic_interval_index<T>>(fields[field].intervals)
+        .insert(std::move(xs));
+    };
+    std::visit(insert, xs);
+  }
+  for (auto& [field, ids] : unindexed) {
+    auto& xs = fields[field].unindexed;
+    const auto mid = xs.size();
+    std::sort(ids.begin(), ids.end());
+    xs.insert(xs.end(), ids.begin(), ids.end());
+    std::inplace_merge(xs.begin(), xs.begin() + detail::narrow<ptrdiff_t>(mid),
+                       xs.end());
+  }
+}
+
+void catalog_schema_index::erase(const uuid& id) {
+  if (not import_time.erase(id)) {
+    return;
+  }
+  for (auto& [_, index] : fields) {
+    auto erase_interval = detail::overload{
+      [](std::monostate&) {
+        return false;
+      },
+      [&]<class T>(basic_interval_index<T>& intervals) {
+        return intervals.erase(id);
+      },
+    };
+    if (std::visit(erase_interval, index.intervals)) {
+      continue;
+    }
+    auto it
+      = std::lower_bound(index.unindexed.begin(), index.unindexed.end(), id);
+    if (it != index.unindexed.end() and *it == id) {
+      index.unindexed.erase(it);
+    }
+  }
+}
+
+auto catalog_schema_index::memusage() const -> size_t {
+  auto result = import_time.memusage();
+  for (const auto& [_, index] : fields) {
+    auto intervals_memusage = detail::overload{
+      [](const std::monostate&) {
+        return size_t{0};
+      },
+      []<class T>(const basic_interval_index<T>& intervals) {
+        return intervals.memusage();
+      },
+    };
+    result += std::visit(intervals_memusage, index.intervals)
+              + index.unindexed.capacity() * sizeof(uuid);
+  }
+  return result;
+}
+
 auto catalog_state::initialize(
   std::shared_ptr<std::unordered_map<uuid, partition_synopsis_ptr>> ps)
   -> caf::result<atom::ok> {
@@ -87,6 +268,13 @@ auto catalog_state::initialize(
                  const std::pair<uuid, partition_synopsis_ptr>& rhs) {
                 return lhs.first < rhs.first;
               });
+    auto partitions
+      = std::vector<std::pair<uuid, const partition_synopsis*>>{};
+    partitions.reserve(flat_data.size());
+    for (const auto& [id, synopsis] : flat_data) {
+      partitions.emplace_back(id, synopsis.get());
+    }
+    indexes_per_type[type].add(partitions);
     synopses_per_type[type]
       = decltype(synopses_per_type)::value_type::second_type::make_unsafe(
         std::move(flat_data));
@@ -96,6 +284,14 @@ auto catalog_state::initialize(
 
 auto catalog_state::merge(std::vector<partition_synopsis_pair> partitions)
   -> caf::result<atom::ok> {
+  auto partitions_per_type = std::unordered_map<
+    tenzir::type, std::vector<std::pair<uuid, const partition_synopsis*>>>{};
+  for (const auto& [id, synopsis] : partitions) {
+    partitions_per_type[synopsis->schema].emplace_back(id, synopsis.get());
+  }
+  for (const auto& [type, xs] : partitions_per_type) {
+    indexes_per_type[type].add(xs);
+  }
   for (auto& [id, synopsis] : partitions) {
     update_unprunable_fields(*synopsis);
     auto& entry = synopses_per_type[synopsis->schema][id];
@@ -109,7 +305,10 @@ void catalog_state::erase(const uuid& partition) {
     const auto num_erased = uuid_synopsis_map.erase(partition);
     if (num_erased > 0) {
       if (uuid_synopsis_map.empty()) {
+        indexes_per_type.erase(type);
         synopses_per_type.erase(type);
+      } else {
+        indexes_per_type[type].erase(partition);
       }
       return;
     }
@@ -168,45 +367,89 @@ auto catalog_state::lookup(expression expr) const
   return total_candidates;
 }
 
-auto catalog_state::lookup_impl(const expression& expr,
-                                const type& schema) const
+auto catalog_state::lookup_impl(
+  const expression& expr, const type& schema,
+  const std::vector<partition_info>* candidates) const
   -> catalog_lookup_result::candidate_info {
   TENZIR_ASSERT(!caf::holds_alternative<caf::none_t>(expr));
   auto synopsis_map_per_type_it = synopses_per_type.find(schema);
   TENZIR_ASSERT(synopsis_map_per_type_it != synopses_per_type.end());
   const auto& partition_synopses = synopsis_map_per_type_it->second;
+  auto index_it = indexes_per_type.find(schema);
+  TENZIR_ASSERT(index_it != indexes_per_type.end());
+  const auto& index = index_it->second;
   // The partition UUIDs must be sorted, otherwise the invariants of the
   // inplace union and intersection algorithms are violated, leading to
   // wrong results. So all places where we return an assembled set must
   // ensure the post-condition of returning a sorted list. We currently
   // rely on `flat_map` already traversing them in the correct order, so
   // no separate sorting step is required.
+  // Calls `f` for all partitions considered for this lookup in the order of
+  // their IDs: either all partitions of the schema, or only the candidates
+  // remaining from previous operands of a conjunction.
+  auto for_each_partition = [&](auto&& f) {
+    if (not candidates) {
+      for (const auto& [partition_id, synopsis] : partition_synopses) {
+        f(partition_id, synopsis);
+      }
+      return;
+    }
+    for (const auto& candidate : *candidates) {
+      const auto it = partition_synopses.find(candidate.uuid);
+      TENZIR_ASSERT(it != partition_synopses.end());
+      f(it->first, it->second);
+    }
+  };
+  // Turns the sorted partition IDs from an index lookup into a result.
+  auto from_ids = [&](const std::vector<uuid>& ids) {
+    auto result = catalog_lookup_result::candidate_info{};
+    result.partition_infos.reserve(ids.size());
+    for (const auto& id : ids) {
+      const auto it = partition_synopses.find(id);
+      TENZIR_ASSERT(it != partition_synopses.end());
+      result.partition_infos.emplace_back(id, *it->second);
+    }
+    return result;
+  };
   auto memoized_partitions = catalog_lookup_result::candidate_info{};
   auto all_partitions = [&] {
     if (!memoized_partitions.partition_infos.empty()
         || partition_synopses.empty())
       return memoized_partitions;
-    for (const auto& [partition_id, synopsis] : partition_synopses) {
+    for_each_partition([&](const uuid& partition_id,
+                           const partition_synopsis_ptr& synopsis) {
       memoized_partitions.partition_infos.emplace_back(partition_id, *synopsis);
-    }
+    });
     return memoized_partitions;
   };
   auto f = detail::overload{
     [&](const conjunction& x) -> catalog_lookup_result::candidate_info {
       TENZIR_ASSERT(!x.empty());
-      auto i = x.begin();
-      auto result = lookup_impl(*i, schema);
+      // We first evaluate the operands that the indexes can answer, and then
+      // restrict the lookups for the remaining operands to the candidates,
+      // which spares us checking the synopses of all other partitions.
+      auto operands = std::vector<const expression*>{};
+      operands.reserve(x.size());
+      for (const auto& operand : x) {
+        operands.push_back(&operand);
+      }
+      std::stable_partition(operands.begin(), operands.end(),
+                            [](const expression* operand) {
+                              return is_indexed(*operand);
+                            });
+      auto i = operands.begin();
+      auto result = lookup_impl(**i, schema, candidates);
       if (!result.partition_infos.empty())
-        for (++i; i != x.end(); ++i) {
-          // TODO: A conjunction means that we can restrict the lookup to the
-          // remaining candidates. This could be achived by passing the `result`
-          // set to `lookup` along with the child expression.
-          auto xs = lookup_impl(*i, schema);
+        for (++i; i != operands.end(); ++i) {
+          auto xs = lookup_impl(**i, schema, &result.partition_infos);
           if (xs.partition_infos.empty())
             return xs; // short-circuit
-          detail::inplace_intersect(result.partition_infos, xs.partition_infos);
-          TENZIR_ASSERT_EXPENSIVE(std::is_sorted(result.partition_infos.begin(),
-                                                 result.partition_infos.end()));
+          // The lookup was restricted to the current candidates, so the
+          // result is already the intersection.
+          TENZIR_ASSERT_EXPENSIVE(std::includes(
+            result.partition_infos.begin(), result.partition_infos.end(),
+            xs.partition_infos.begin(), xs.partition_infos.end()));
+          result.partition_infos = std::move(xs.partition_infos);
         }
       return result;
     },
@@ -215,8 +458,9 @@ auto catalog_state::lookup_impl(const expression& expr,
       for (const auto& op : x) {
         // TODO: A disjunction means that we can restrict the lookup to the
         // set of partitions that are outside of the current result set.
-        auto xs = lookup_impl(op, schema);
-        if (xs.partition_infos.size() == partition_synopses.size())
+        auto xs = lookup_impl(op, schema, candidates);
+        if (xs.partition_infos.size()
+            == (candidates ? candidates->size() : partition_synopses.size()))
           return xs; // short-circuit
         TENZIR_ASSERT_EXPENSIVE(
           std::is_sorted(xs.partition_infos.begin(), xs.partition_infos.end()));
@@ -239,14 +483,59 @@ auto catalog_state::lookup_impl(const expression& expr,
       // data from the predicate of the expression. The match function
       // uses a qualified_record_field to determine whether the synopsis
       // should be queried.
+      // Answers the lookup from the indexes for ordered fields without
+      // checking the synopses of all partitions. Returns `std::nullopt` if
+      // the indexes cannot answer the lookup.
+      auto search_index = [&](auto& match, const data& rhs)
+        -> std::optional<std::vector<uuid>> {
+        auto result = std::vector<uuid>{};
+        for (const auto& [field, field_index] : index.fields) {
+          if (not match(field)) {
+            continue;
+          }
+          auto lookup = detail::overload{
+            [](const std::monostate&) -> std::optional<std::vector<uuid>> {
+              return std::nullopt;
+            },
+            [&]<class T>(const basic_interval_index<T>& intervals)
+              -> std::optional<std::vector<uuid>> {
+              // Like the synopses, the index cannot rule out partitions for
+              // values of a different type. NaN is not ordered, so the index
+              // cannot handle it either.
+              const auto* value = caf::get_if<T>(&rhs);
+              if (not value) {
+                return std::nullopt;
+              }
+              if constexpr (std::is_same_v<T, double>) {
+                if (std::isnan(*value)) {
+                  return std::nullopt;
+                }
+              }
+              return intervals.lookup(x.op, *value);
+            },
+          };
+          auto ids = std::visit(lookup, field_index.intervals);
+          if (not ids) {
+            return std::nullopt;
+          }
+          detail::inplace_unify(result, std::move(*ids));
+          detail::inplace_unify(result, field_index.unindexed);
+        }
+        return result;
+      };
       auto search = [&](auto match) {
         TENZIR_ASSERT(caf::holds_alternative<data>(x.rhs));
         const auto& rhs = caf::get<data>(x.rhs);
+        // For restricted lookups, the number of candidates is usually small
+        // enough that checking their synopses is cheaper.
+        if (not candidates) {
+          if (auto ids = search_index(match, rhs)) {
+            return from_ids(*ids);
+          }
+        }
         catalog_lookup_result::candidate_info result;
-        // dont iterate through all synopses, rewrite lookup_impl to use a
-        // singular type all synopses loops -> relevant anymore? Use type as
-        // synopses key
-        for (const auto& [part_id, part_syn] : partition_synopses) {
+        for_each_partition([&](const uuid& part_id,
+                               const partition_synopsis_ptr& part_syn) {
           for (const auto& [field, syn] : part_syn->field_synopses_) {
             if (match(field)) {
               // We need to prune the type's metadata here by converting it to
@@ -285,7 +574,7 @@ auto catalog_state::lookup_impl(const expression& expr,
               }
             }
           }
-        }
+        });
         TENZIR_DEBUG("{} checked {} partitions for predicate {} and got {} "
                      "results",
                      detail::pretty_type_name(this), synopses_per_type.size(),
@@ -303,7 +592,8 @@ auto catalog_state::lookup_impl(const expression& expr,
               // We don't have to look into the synopses for type queries, just
               // at the schema names.
               catalog_lookup_result::candidate_info result;
-              for (const auto& [part_id, part_syn] : partition_synopses) {
+              for_each_partition([&](const uuid& part_id,
+                                     const partition_synopsis_ptr& part_syn) {
                 for (const auto& [fqf, _] : part_syn->field_synopses_) {
                   // TODO: provide an overload for view of evaluate() so that
                   // we can use string_view here. Fortunately type names are
@@ -314,7 +604,7 @@ auto catalog_state::lookup_impl(const expression& expr,
                     break;
                   }
                 }
-              }
+              });
               TENZIR_ASSERT_EXPENSIVE(std::is_sorted(
                 result.partition_infos.begin(), result.partition_infos.end()));
               return result;
@@ -325,17 +615,22 @@ auto catalog_state::lookup_impl(const expression& expr,
                 TENZIR_ASSERT_EXPENSIVE(part_syn->schema == schema);
               }
               if (evaluate(schema.make_fingerprint(), x.op, d)) {
-                for (const auto& [part_id, part_syn] : partition_synopses) {
-                  result.partition_infos.emplace_back(part_id, *part_syn);
-                }
+                result = all_partitions();
               }
               TENZIR_ASSERT_EXPENSIVE(std::is_sorted(
                 result.partition_infos.begin(), result.partition_infos.end()));
               return result;
             }
             case meta_extractor::import_time: {
+              if (not candidates) {
+                if (auto ids = index.import_time.lookup(
+                      x.op, caf::get<tenzir::time>(d))) {
+                  return from_ids(*ids);
+                }
+              }
               catalog_lookup_result::candidate_info result;
-              for (const auto& [part_id, part_syn] : partition_synopses) {
+              for_each_partition([&](const uuid& part_id,
+                                     const partition_synopsis_ptr& part_syn) {
                 TENZIR_ASSERT(
                   part_syn->min_import_time <= part_syn->max_import_time,
                   "encountered empty or moved-from partition synopsis");
@@ -347,14 +642,15 @@ auto catalog_state::lookup_impl(const expression& expr,
                 if (!add || *add) {
                   result.partition_infos.emplace_back(part_id, *part_syn);
                 }
-              }
+              });
               TENZIR_ASSERT_EXPENSIVE(std::is_sorted(
                 result.partition_infos.begin(), result.partition_infos.end()));
               return result;
             }
             case meta_extractor::internal: {
               auto result = catalog_lookup_result::candidate_info{};
-              for (const auto& [part_id, part_syn] : partition_synopses) {
+              for_each_partition([&](const uuid& part_id,
+                                     const partition_synopsis_ptr& part_syn) {
                 auto internal = false;
                 if (part_syn->schema) {
                   internal = part_syn->schema.attribute("internal").has_value();
@@ -362,7 +658,7 @@ auto catalog_state::lookup_impl(const expression& expr,
                 if (evaluate(internal, x.op, d)) {
                   result.partition_infos.emplace_back(part_id, *part_syn);
                 }
-              };
+              });
               TENZIR_ASSERT_EXPENSIVE(std::is_sorted(
                 result.partition_infos.begin(), result.partition_infos.end()));
               return result;
@@ -450,6 +746,9 @@ auto catalog_state::memusage() const -> size_t {
       result += synopsis->memusage();
     }
   }
+  for (const auto& [type, index] : indexes_per_type) {
+    result += index.memusage();
+  }
   return result;
 }
 
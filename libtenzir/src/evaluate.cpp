@@ -6,6 +6,8 @@
 // SPDX-FileCopyrightText: (c) 2022 The Tenzir Contributors
 // SPDX-License-Identifier: BSD-3-Clause
 
+#include "tenzir/evaluate.hpp"
+
 #include "tenzir/arrow_table_slice.hpp"
 #include "tenzir/bitmap_algorithms.hpp"
 #include "tenzir/detail/assert.hpp"
@@ -18,8 +20,11 @@
 #include "tenzir/type.hpp"
 
 #include <arrow/record_batch.h>
+#include <arrow/util/bitmap_ops.h>
 
+#include <algorithm>
 #include <cstddef>
+#include <cstring>
 #include <regex>
 #include <span>
 
@@ -214,12 +219,165 @@ struct cell_evaluator<relational_operator::not_ni> {
   }
 };
 
+// Copies the bits [first, first + n) of an Arrow bitmap into a single block.
+ids::block_type
+copy_block(const uint8_t* bitmap, int64_t offset, int64_t first, int64_t n) {
+  TENZIR_ASSERT(n <= ids::word_type::width);
+  auto result = ids::block_type{0};
+  arrow::internal::CopyBitmap(bitmap, offset + first, n,
+                              reinterpret_cast<uint8_t*>(&result), 0);
+  return result;
+}
+
+// Returns the validity of the rows [first, first + n) of an array as a block.
+ids::block_type
+validity_block(const arrow::Array& array, int64_t first, int64_t n) {
+  // Arrays without a validity bitmap are either entirely valid, or entirely
+  // null as is the case for null arrays.
+  if (array.null_bitmap_data() == nullptr)
+    return array.null_count() == 0 ? ids::word_type::all
+                                   : ids::word_type::none;
+  return copy_block(array.null_bitmap_data(), array.offset(), first, n);
+}
+
+// Builds a bitmap for all rows of an array block by block, where each block
+// holds the results for 64 rows. The function `f` takes the first row and the
+// number of rows of a block and returns the block. The result is masked with
+// the selection afterwards, which is cheap because it operates on words.
+template <class F>
+ids make_blockwise(id offset, const arrow::Array& array, const ids& selection,
+                   F f) {
+  constexpr auto width = int64_t{ids::word_type::width};
+  auto result = ids{};
+  result.append(false, offset);
+  const auto length = array.length();
+  for (auto first = int64_t{0}; first < length; first += width) {
+    const auto n = std::min(width, length - first);
+    result.append_block(f(first, n), n);
+  }
+  return result & selection;
+}
+
+// Evaluates a predicate for the rows [first, first + n) into a block. The
+// loop has no branches so that the compiler can vectorize it for cheap
+// predicates.
+template <class Predicate>
+ids::block_type compare_block(int64_t first, int64_t n, Predicate pred) {
+  auto result = ids::block_type{0};
+  for (auto i = int64_t{0}; i < n; ++i)
+    result |= static_cast<ids::block_type>(pred(first + i)) << i;
+  return result;
+}
+
+// Whether the column evaluator for a given combination of relational operator,
+// lhs type, and rhs uses a kernel that compares the Arrow array with the
+// constant block by block rather than dispatching to the cell evaluator for
+// every selected row. We limit this to cheap predicates, as the kernels
+// evaluate the predicate for all rows regardless of the selection.
+template <relational_operator Op, concrete_type LhsType, class Rhs>
+inline constexpr auto has_blockwise_kernel
+  = (detail::is_any_v<LhsType, bool_type, int64_type, uint64_type,
+                      double_type, duration_type, time_type, string_type,
+                      ip_type>
+     && (Op == relational_operator::equal
+         || Op == relational_operator::not_equal
+         || Op == relational_operator::less
+         || Op == relational_operator::less_equal
+         || Op == relational_operator::greater
+         || Op == relational_operator::greater_equal)
+     && !detail::is_any_v<Rhs, pattern, list>)
+    || (std::is_same_v<LhsType, ip_type> && std::is_same_v<Rhs, subnet>
+        && (Op == relational_operator::in
+            || Op == relational_operator::not_in));
+
+template <relational_operator Op, concrete_type LhsType, class Rhs>
+ids evaluate_blockwise([[maybe_unused]] LhsType type, id offset,
+                       const arrow::Array& array, const Rhs& rhs,
+                       const ids& selection) noexcept {
+  const auto& typed_array = caf::get<type_to_arrow_array_t<LhsType>>(array);
+  auto make = [&](auto pred) {
+    return make_blockwise(offset, array, selection,
+                          [&](int64_t first, int64_t n) {
+                            return compare_block(first, n, pred)
+                                   & validity_block(array, first, n);
+                          });
+  };
+  if constexpr (std::is_same_v<LhsType, bool_type>) {
+    if constexpr (std::is_same_v<Rhs, bool>
+                  && (Op == relational_operator::equal
+                      || Op == relational_operator::not_equal)) {
+      // Booleans are bit-packed in Arrow already, so we can copy them
+      // block-wise and flip them as needed.
+      const auto flip = rhs != (Op == relational_operator::equal);
+      const auto* values = typed_array.values()->data();
+      return make_blockwise(
+        offset, array, selection, [&](int64_t first, int64_t n) {
+          auto block = copy_block(values, typed_array.offset(), first, n);
+          if (flip)
+            block = ~block;
+          return block & validity_block(array, first, n);
+        });
+    } else {
+      return make([&](int64_t row) {
+        return cell_evaluator<Op>::evaluate(typed_array.Value(row), rhs);
+      });
+    }
+  } else if constexpr (detail::is_any_v<LhsType, int64_type, uint64_type,
+                                        double_type, duration_type,
+                                        time_type>) {
+    const auto* values = typed_array.raw_values();
+    return make([&](int64_t row) {
+      if constexpr (std::is_same_v<LhsType, time_type>)
+        return cell_evaluator<Op>::evaluate(time{} + duration{values[row]},
+                                            rhs);
+      else if constexpr (std::is_same_v<LhsType, duration_type>)
+        return cell_evaluator<Op>::evaluate(duration{values[row]}, rhs);
+      else
+        return cell_evaluator<Op>::evaluate(values[row], rhs);
+    });
+  } else if constexpr (std::is_same_v<LhsType, string_type>) {
+    return make([&](int64_t row) {
+      const auto str = typed_array.GetView(row);
+      return cell_evaluator<Op>::evaluate(
+        std::string_view{str.data(), str.size()}, rhs);
+    });
+  } else if constexpr (std::is_same_v<LhsType, ip_type>) {
+    // We read the raw bytes of the addresses rather than going through
+    // `value_at`, which must not be called for null values.
+    const auto* values = typed_array.storage()->raw_values();
+    if constexpr (std::is_same_v<Rhs, ip>
+                  && (Op == relational_operator::equal
+                      || Op == relational_operator::not_equal)) {
+      // Comparing the raw bytes avoids constructing an address per row.
+      const auto bytes = as_bytes(rhs);
+      return make([&](int64_t row) {
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        const auto equal = std::memcmp(values + (row * 16), bytes.data(), 16)
+                           == 0;
+        return equal == (Op == relational_operator::equal);
+      });
+    } else {
+      return make([&](int64_t row) {
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        const auto* bytes = values + (row * 16);
+        return cell_evaluator<Op>::evaluate(
+          ip::v6(std::span<const uint8_t, 16>{bytes, 16}), rhs);
+      });
+    }
+  } else {
+    static_assert(detail::always_false_v<LhsType>, "unhandled type");
+  }
+}
+
 // The default implementation for the column evaluator that dispatches to the
-// cell evaluator for every relevant row.
+// cell evaluator for every relevant row, unless there exists a block-wise
+// kernel for the combination of operator and types.
 template <relational_operator Op, concrete_type LhsType, class Rhs>
 struct column_evaluator {
   static ids evaluate(LhsType type, id offset, const arrow::Array& array,
                       const Rhs& rhs, const ids& selection) noexcept {
+    if constexpr (has_blockwise_kernel<Op, LhsType, Rhs>)
+      return evaluate_blockwise<Op>(type, offset, array, rhs, selection);
     ids result{};
     for (auto id : select(selection)) {
       TENZIR_ASSERT(id >= offset);
@@ -243,20 +401,10 @@ struct column_evaluator<relational_operator::equal, LhsType, caf::none_t> {
   static ids
   evaluate([[maybe_unused]] LhsType type, id offset, const arrow::Array& array,
            [[maybe_unused]] caf::none_t rhs, const ids& selection) noexcept {
-    // TODO: This entire loop semantically is just selection &
-    // ~array.null_bitmap, but we cannot do bitwise operations with Arrow's
-    // bitmaps yet.
-    ids result{};
-    for (auto id : select(selection)) {
-      TENZIR_ASSERT(id >= offset);
-      const auto row = detail::narrow_cast<int64_t>(id - offset);
-      if (!array.IsNull(row))
-        continue;
-      result.append(false, id - result.size());
-      result.append(true, 1u);
-    }
-    result.append(false, offset + array.length() - result.size());
-    return result;
+    return make_blockwise(offset, array, selection,
+                          [&](int64_t first, int64_t n) {
+                            return ~validity_block(array, first, n);
+                          });
   }
 };
 
@@ -266,20 +414,10 @@ struct column_evaluator<relational_operator::not_equal, LhsType, caf::none_t> {
   static ids
   evaluate([[maybe_unused]] LhsType type, id offset, const arrow::Array& array,
            [[maybe_unused]] caf::none_t rhs, const ids& selection) noexcept {
-    // TODO: This entire loop semantically is just selection &
-    // array.null_bitmap, but we cannot do bitwise operations with Arrow's
-    // bitmaps yet.
-    ids result{};
-    for (auto id : select(selection)) {
-      TENZIR_ASSERT(id >= offset);
-      const auto row = detail::narrow_cast<int64_t>(id - offset);
-      if (array.IsNull(row))
-        continue;
-      result.append(false, id - result.size());
-      result.append(true, 1u);
-    }
-    result.append(false, offset + array.length() - result.size());
-    return result;
+    return make_blockwise(offset, array, selection,
+                          [&](int64_t first, int64_t n) {
+                            return validity_block(array, first, n);
+                          });
   }
 };
 
@@ -312,167 +450,127 @@ struct column_evaluator<Op, enumeration_type, std::string> {
   }
 };
 
-// A utility function for evaluating meta extractors in predicates. This is
-// always a yes or no question per batch, so the function does not have to deal
-// with bitmaps at all.
-bool evaluate_meta_extractor(const table_slice& slice,
-                             const meta_extractor& lhs, relational_operator op,
-                             const data& rhs) {
-  switch (lhs.kind) {
-    case meta_extractor::kind::schema: {
-      switch (op) {
+// Evaluates a relational operator for a single value and a constant.
+template <class Lhs>
+bool evaluate_cell(const Lhs& lhs, relational_operator op, const data& rhs) {
+  switch (op) {
 #define TENZIR_EVAL_DISPATCH(op)                                               \
   case relational_operator::op: {                                              \
     auto f = [&](const auto& rhs) noexcept {                                   \
-      return cell_evaluator<relational_operator::op>::evaluate(                \
-        slice.schema().name(), rhs);                                           \
+      return cell_evaluator<relational_operator::op>::evaluate(lhs, rhs);      \
     };                                                                         \
     return caf::visit(f, rhs);                                                 \
   }
-        TENZIR_EVAL_DISPATCH(equal);
-        TENZIR_EVAL_DISPATCH(not_equal);
-        TENZIR_EVAL_DISPATCH(in);
-        TENZIR_EVAL_DISPATCH(less);
-        TENZIR_EVAL_DISPATCH(not_in);
-        TENZIR_EVAL_DISPATCH(greater);
-        TENZIR_EVAL_DISPATCH(greater_equal);
-        TENZIR_EVAL_DISPATCH(less_equal);
-        TENZIR_EVAL_DISPATCH(ni);
-        TENZIR_EVAL_DISPATCH(not_ni);
+    TENZIR_EVAL_DISPATCH(equal);
+    TENZIR_EVAL_DISPATCH(not_equal);
+    TENZIR_EVAL_DISPATCH(in);
+    TENZIR_EVAL_DISPATCH(less);
+    TENZIR_EVAL_DISPATCH(not_in);
+    TENZIR_EVAL_DISPATCH(greater);
+    TENZIR_EVAL_DISPATCH(greater_equal);
+    TENZIR_EVAL_DISPATCH(less_equal);
+    TENZIR_EVAL_DISPATCH(ni);
+    TENZIR_EVAL_DISPATCH(not_ni);
 #undef TENZIR_EVAL_DISPATCH
-      }
-      TENZIR_UNREACHABLE();
-    }
-    case meta_extractor::kind::schema_id: {
-      switch (op) {
-#define TENZIR_EVAL_DISPATCH(op)                                               \
-  case relational_operator::op: {                                              \
-    auto f = [&](const auto& rhs) noexcept {                                   \
-      return cell_evaluator<relational_operator::op>::evaluate(                \
-        slice.schema().make_fingerprint(), rhs);                               \
-    };                                                                         \
-    return caf::visit(f, rhs);                                                 \
   }
-        TENZIR_EVAL_DISPATCH(equal);
-        TENZIR_EVAL_DISPATCH(not_equal);
-        TENZIR_EVAL_DISPATCH(in);
-        TENZIR_EVAL_DISPATCH(less);
-        TENZIR_EVAL_DISPATCH(not_in);
-        TENZIR_EVAL_DISPATCH(greater);
-        TENZIR_EVAL_DISPATCH(greater_equal);
-        TENZIR_EVAL_DISPATCH(less_equal);
-        TENZIR_EVAL_DISPATCH(ni);
-        TENZIR_EVAL_DISPATCH(not_ni);
-#undef TENZIR_EVAL_DISPATCH
-      }
-      TENZIR_UNREACHABLE();
-    }
-    case meta_extractor::kind::import_time: {
-      switch (op) {
-#define TENZIR_EVAL_DISPATCH(op)                                               \
-  case relational_operator::op: {                                              \
-    auto f = [&](const auto& rhs) noexcept {                                   \
-      return cell_evaluator<relational_operator::op>::evaluate(                \
-        slice.import_time(), rhs);                                             \
-    };                                                                         \
-    return caf::visit(f, rhs);                                                 \
-  }
-        TENZIR_EVAL_DISPATCH(equal);
-        TENZIR_EVAL_DISPATCH(not_equal);
-        TENZIR_EVAL_DISPATCH(in);
-        TENZIR_EVAL_DISPATCH(less);
-        TENZIR_EVAL_DISPATCH(not_in);
-        TENZIR_EVAL_DISPATCH(greater);
-        TENZIR_EVAL_DISPATCH(greater_equal);
-        TENZIR_EVAL_DISPATCH(less_equal);
-        TENZIR_EVAL_DISPATCH(ni);
-        TENZIR_EVAL_DISPATCH(not_ni);
-#undef TENZIR_EVAL_DISPATCH
-      }
-      TENZIR_UNREACHABLE();
-    }
-    case meta_extractor::kind::internal: {
-      switch (op) {
-#define TENZIR_EVAL_DISPATCH(op)                                               \
-  case relational_operator::op: {                                              \
-    auto f = [&](const auto& rhs) noexcept {                                   \
-      return cell_evaluator<relational_operator::op>::evaluate(                \
-        slice.schema().attribute("internal").has_value(), rhs);                \
-    };                                                                         \
-    return caf::visit(f, rhs);                                                 \
-  }
-        TENZIR_EVAL_DISPATCH(equal);
-        TENZIR_EVAL_DISPATCH(not_equal);
-        TENZIR_EVAL_DISPATCH(in);
-        TENZIR_EVAL_DISPATCH(less);
-        TENZIR_EVAL_DISPATCH(not_in);
-        TENZIR_EVAL_DISPATCH(greater);
-        TENZIR_EVAL_DISPATCH(greater_equal);
-        TENZIR_EVAL_DISPATCH(less_equal);
-        TENZIR_EVAL_DISPATCH(ni);
-        TENZIR_EVAL_DISPATCH(not_ni);
-#undef TENZIR_EVAL_DISPATCH
-      }
-      TENZIR_UNREACHABLE();
-    }
-  }
-  __builtin_unreachable();
+  TENZIR_UNREACHABLE();
+}
+
+// A utility function for evaluating meta extractors that depend only on the
+// schema in predicates. This is always a yes or no question per schema, so
+// the function does not have to deal with bitmaps at all.
+bool evaluate_meta_extractor(const type& schema, const meta_extractor& lhs,
+                             relational_operator op, const data& rhs) {
+  switch (lhs.kind) {
+    case meta_extractor::kind::schema:
+      return evaluate_cell(schema.name(), op, rhs);
+    case meta_extractor::kind::schema_id:
+      return evaluate_cell(schema.make_fingerprint(), op, rhs);
+    case meta_extractor::kind::internal:
+      return evaluate_cell(schema.attribute("internal").has_value(), op, rhs);
+    case meta_extractor::kind::import_time:
+      break;
+  }
+  TENZIR_UNREACHABLE();
 }
 
 } // namespace
 
-// Expression evaluation takes place in multiple resolution steps:
-// 1. Normalize the selection bitmap from the dense index result to the length
-//    of the batch + offset.
-// 2. Determine whether the expression is empty, a connective of some sort, or
-//    a predicate. For connectives, resolve them recursively and combine the
-//    resulting bitmaps accordingly.
-// 3. Evaluate predicates:
-//    a) If it's a meta extractor, operate on the batch metadata. In case of a
-//       match, the selection bitmap is the very result.
-//    b) If it's a data predicate, access the desired array, and lift the
-//       resolved types for both sides of the predicate into a compile-time
-//       context for the column evaluator.
-// 4. The column evaluator has specialization based on the three-tuple of lhs
-//    type, relational operator, and rhs view. The generic fall back case
-//    iterates over all fields per the selection bitmap to do the evaluation
-//    using the cell evaluator, which can be specialized per relational
-//    operator.
-ids evaluate(const expression& expr, const table_slice& slice,
-             const ids& hints) {
-  const auto offset = slice.offset() == invalid_id ? 0 : slice.offset();
-  const auto num_rows = slice.rows();
-  const auto evaluate_predicate = detail::overload{
-    [](const auto&, relational_operator, const auto&, const ids&) -> ids {
+// Compiling an expression into a program takes place in multiple steps:
+// 1. Compile the expression into a tree, recursively:
+//    a) Meta extractors that only depend on the schema are evaluated once and
+//       folded into constants, which then short-circuit the connectives they
+//       are part of.
+//    b) Data predicates resolve their column once, and lift the resolved
+//       types for both sides of the predicate into a compile-time context for
+//       the column evaluator, which is bound to the node.
+//    c) Nested connectives of the same kind are flattened, and their operands
+//       are ordered by their estimated cost, so that cheap predicates narrow
+//       down the selection for more expensive ones.
+// 2. Lay out the tree in a vector, such that the operands of each connective
+//    are adjacent.
+//
+// The column evaluator has specialization based on the three-tuple of lhs type,
+// relational operator, and rhs view. The generic fall back case iterates over
+// all fields per the selection bitmap to do the evaluation using the cell
+// evaluator, which can be specialized per relational operator.
+auto evaluation_program::make(const expression& expr, const type& schema)
+  -> evaluation_program {
+  struct tree {
+    node root = {};
+    size_t cost = 0;
+    std::vector<tree> operands = {};
+  };
+  const auto& layout = caf::get<record_type>(schema);
+  const auto constant = [](bool value) {
+    auto result = tree{};
+    result.root.value = value;
+    return result;
+  };
+  const auto compile_predicate = detail::overload{
+    [](const auto&, relational_operator, const auto&) -> tree {
       die("predicates must be normalized and bound for evaluation");
     },
-    [&](const meta_extractor& lhs, relational_operator op, const data& rhs,
-        ids selection) -> ids {
-      // If no bit in the selection is set we have no results, but we can avoid
-      // an allocation by simply returning the already empty selection.
-      if (!any(selection))
-        return selection;
-      if (evaluate_meta_extractor(slice, lhs, op, rhs))
-        return selection;
-      return ids{offset + num_rows, false};
+    [&](const meta_extractor& lhs, relational_operator op,
+        const data& rhs) -> tree {
+      if (lhs.kind != meta_extractor::kind::import_time)
+        return constant(evaluate_meta_extractor(schema, lhs, op, rhs));
+      auto result = tree{};
+      result.root.op = node::opcode::predicate;
+      result.root.predicate = [op, rhs](const table_slice& slice, id offset,
+                                        const ids& selection) -> ids {
+        if (evaluate_cell(slice.import_time(), op, rhs))
+          return selection;
+        return ids{offset + slice.rows(), false};
+      };
+      return result;
     },
-    [&](const data_extractor& lhs, relational_operator op, const data& rhs,
-        const ids& selection) -> ids {
-      if (!any(selection))
-        return ids{offset + num_rows, false};
-      const auto index
-        = caf::get<record_type>(slice.schema()).resolve_flat_index(lhs.column);
-      const auto type_and_array = index.get(slice);
-      TENZIR_ASSERT(type_and_array.second);
+    [&](const data_extractor& lhs, relational_operator op,
+        const data& rhs) -> tree {
+      const auto index = layout.resolve_flat_index(lhs.column);
+      const auto lhs_type = layout.field(index).type;
+      auto result = tree{};
+      result.root.op = node::opcode::predicate;
       switch (op) {
 #define TENZIR_EVAL_DISPATCH(op)                                               \
   case relational_operator::op: {                                              \
-    auto f = [&]<concrete_type Type, class Rhs>(                               \
-               Type type, const Rhs& rhs) noexcept -> ids {                    \
-      return column_evaluator<relational_operator::op, Type, Rhs>::evaluate(   \
-        type, offset, *type_and_array.second, rhs, selection);                 \
+    auto f = [&]<concrete_type Type, class Rhs>(const Type& type,              \
+                                                const Rhs& rhs) {              \
+      constexpr auto cheap                                                     \
+        = has_blockwise_kernel<relational_operator::op, Type, Rhs>             \
+          || std::is_same_v<Rhs, caf::none_t>;                                 \
+      result.cost = cheap ? 1 : 2;                                             \
+      result.root.predicate = [index, type, rhs](const table_slice& slice,     \
+                                                 id offset,                    \
+                                                 const ids& selection) {       \
+        const auto array = index.get(*to_record_batch(slice));                 \
+        TENZIR_ASSERT(array);                                                  \
+        return column_evaluator<relational_operator::op, Type, Rhs>::evaluate( \
+          type, offset, *array, rhs, selection);                               \
+      };                                                                       \
     };                                                                         \
-    return caf::visit(f, type_and_array.first, rhs);                           \
+    caf::visit(f, lhs_type, rhs);                                              \
+    return result;                                                             \
   }
         TENZIR_EVAL_DISPATCH(equal);
         TENZIR_EVAL_DISPATCH(not_equal);
@@ -489,46 +587,102 @@ ids evaluate(const expression& expr, const table_slice& slice,
       TENZIR_UNREACHABLE();
     },
   };
-  const auto evaluate_expression
-    = [&](const auto& self, const expression& expr, ids selection) -> ids {
-    const auto evaluate_expression_impl = detail::overload{
-      [&](const caf::none_t&, const ids&) {
-        return ids{offset + num_rows, false};
+  const auto compile_connective
+    = [&]<class Connective>(const auto& compile,
+                            const Connective& connective) -> tree {
+    constexpr auto is_conjunction = std::is_same_v<Connective, conjunction>;
+    auto result = tree{};
+    result.root.op = is_conjunction ? node::opcode::conjunction
+                                    : node::opcode::disjunction;
+    // Adds the operands of the connective, and returns true if one of them
+    // decides the connective, i.e., a constant false for a conjunction or a
+    // constant true for a disjunction.
+    const auto add = [&](const auto& add, const Connective& xs) -> bool {
+      for (const auto& x : xs) {
+        if (const auto* nested = caf::get_if<Connective>(&x)) {
+          if (add(add, *nested))
+            return true;
+          continue;
+        }
+        auto operand = compile(compile, x);
+        if (operand.root.op == node::opcode::constant) {
+          if (operand.root.value != is_conjunction)
+            return true;
+          continue;
+        }
+        result.cost += operand.cost;
+        result.operands.push_back(std::move(operand));
+      }
+      return false;
+    };
+    if (add(add, connective))
+      return constant(not is_conjunction);
+    if (result.operands.empty())
+      return constant(is_conjunction);
+    if (result.operands.size() == 1)
+      return std::move(result.operands[0]);
+    std::stable_sort(result.operands.begin(), result.operands.end(),
+                     [](const tree& lhs, const tree& rhs) {
+                       return lhs.cost < rhs.cost;
+                     });
+    return result;
+  };
+  const auto compile = [&](const auto& compile, const expression& x) -> tree {
+    const auto compile_impl = detail::overload{
+      [&](const caf::none_t&) {
+        return constant(false);
       },
-      [&](const negation& negation, const ids& selection) {
-        // For negations we want to return a bitmap that has 1s in places where
-        // the selection had 1s and the nested expression evaluation returned
-        // 0s. The opposite case where the selection has 0s and the nested
-        // expression evaluation returns 1s cannot exist (this is a precondition
-        // violation), so we can simply XOR the bitmaps to do the negation.
-        return selection ^ self(self, negation.expr(), selection);
+      [&](const negation& negation) {
+        auto operand = compile(compile, negation.expr());
+        if (operand.root.op == node::opcode::constant)
+          return constant(not operand.root.value);
+        auto result = tree{};
+        result.root.op = node::opcode::negation;
+        result.cost = operand.cost;
+        result.operands.push_back(std::move(operand));
+        return result;
       },
-      [&](const conjunction& conjunction, ids selection) {
-        for (const auto& connective : conjunction) {
-          if (!any(selection))
-            return selection;
-          selection = self(self, connective, std::move(selection));
-        }
-        return selection;
+      [&](const conjunction& conjunction) {
+        return compile_connective(compile, conjunction);
       },
-      [&](const disjunction& disjunction, const ids& selection) {
-        auto mask = selection;
-        for (const auto& connective : disjunction) {
-          if (!any(mask))
-            return selection;
-          mask &= ~self(self, connective, mask);
-        }
-        return selection & ~mask;
+      [&](const disjunction& disjunction) {
+        return compile_connective(compile, disjunction);
       },
-      [&](const predicate& predicate, const ids& selection) -> ids {
-        return caf::visit(evaluate_predicate, predicate.lhs,
-                          detail::passthrough(predicate.op), predicate.rhs,
-                          detail::passthrough(selection));
+      [&](const predicate& predicate) {
+        return caf::visit(compile_predicate, predicate.lhs,
+                          detail::passthrough(predicate.op), predicate.rhs);
       },
     };
-    return caf::visit(evaluate_expression_impl, expr,
-                      detail::passthrough(selection));
+    return caf::visit(compile_impl, x);
+  };
+  auto root = compile(compile, expr);
+  auto result = evaluation_program{};
+  result.schema_ = schema;
+  result.nodes_.emplace_back();
+  const auto emit = [&](const auto& emit, tree& x, size_t index) -> void {
+    result.nodes_[index] = std::move(x.root);
+    if (x.operands.empty())
+      return;
+    const auto first = result.nodes_.size();
+    result.nodes_.resize(first + x.operands.size());
+    result.nodes_[index].first = first;
+    result.nodes_[index].last = result.nodes_.size();
+    for (auto i = size_t{0}; i < x.operands.size(); ++i)
+      emit(emit, x.operands[i], first + i);
   };
+  emit(emit, root, 0);
+  return result;
+}
+
+auto evaluation_program::evaluate(const table_slice& slice,
+                                  const ids& hints) const -> ids {
+  TENZIR_ASSERT_EXPENSIVE(nodes_.empty() || slice.schema() == schema_);
+  const auto offset = slice.offset() == invalid_id ? 0 : slice.offset();
+  const auto num_rows = slice.rows();
+  if (matches_nothing())
+    return ids{offset + num_rows, false};
+  // Normalize the selection bitmap from the dense index result to the length
+  // of the batch + offset.
   auto selection = ids{};
   selection.append(false, offset);
   if (hints.empty()) {
@@ -545,10 +699,90 @@ ids evaluate(const expression& expr, const table_slice& slice,
     selection.append(false, offset + num_rows - selection.size());
   }
   TENZIR_ASSERT(selection.size() == offset + num_rows);
-  auto result
-    = evaluate_expression(evaluate_expression, expr, std::move(selection));
+  auto result = evaluate(0, slice, offset, std::move(selection));
   TENZIR_ASSERT(result.size() == offset + num_rows);
   return result;
 }
 
+auto evaluation_program::evaluate(size_t index, const table_slice& slice,
+                                  id offset, ids selection) const -> ids {
+  const auto& x = nodes_[index];
+  switch (x.op) {
+    case node::opcode::constant: {
+      if (x.value)
+        return selection;
+      return ids{offset + slice.rows(), false};
+    }
+    case node::opcode::conjunction: {
+      for (auto i = x.first; i < x.last; ++i) {
+        if (!any(selection))
+          return selection;
+        selection = evaluate(i, slice, offset, std::move(selection));
+      }
+      return selection;
+    }
+    case node::opcode::disjunction: {
+      auto mask = selection;
+      for (auto i = x.first; i < x.last; ++i) {
+        if (!any(mask))
+          return selection;
+        mask &= ~evaluate(i, slice, offset, mask);
+      }
+      return selection & ~mask;
+    }
+    case node::opcode::negation: {
+      // For negations we want to return a bitmap that has 1s in places where
+      // the selection had 1s and the nested expression evaluation returned
+      // 0s. The opposite case where the selection has 0s and the nested
+      // expression evaluation returns 1s cannot exist (this is a precondition
+      // violation), so we can simply XOR the bitmaps to do the negation.
+      return selection ^ evaluate(x.first, slice, offset, selection);
+    }
+    case node::opcode::predicate: {
+      // If no bit in the selection is set we have no results, but we can avoid
+      // an allocation by simply returning the already empty selection.
+      if (!any(selection))
+        return selection;
+      return x.predicate(slice, offset, selection);
+    }
+  }
+  TENZIR_UNREACHABLE();
+}
+
+auto evaluation_program::matches_nothing() const -> bool {
+  return nodes_.empty()
+         || (nodes_[0].op == node::opcode::constant && not nodes_[0].value);
+}
+
+auto evaluation_program::schema() const -> const type& {
+  return schema_;
+}
+
+evaluation_program_cache::evaluation_program_cache(expression expr)
+  : expr_{std::move(expr)} {
+  // nop
+}
+
+auto evaluation_program_cache::get(const type& schema)
+  -> const evaluation_program* {
+  auto it = programs_.find(schema);
+  if (it == programs_.end()) {
+    auto program = std::optional<evaluation_program>{};
+    if (caf::holds_alternative<caf::none_t>(expr_)) {
+      // An empty expression selects all events, which is what an empty
+      // conjunction compiles to.
+      program = evaluation_program::make(conjunction{}, schema);
+    } else if (auto tailored_expr = tailor(expr_, schema)) {
+      program = evaluation_program::make(*tailored_expr, schema);
+    }
+    it = programs_.emplace(schema, std::move(program)).first;
+  }
+  return it->second ? &*it->second : nullptr;
+}
+
+ids evaluate(const expression& expr, const table_slice& slice,
+             const ids& hints) {
+  return evaluation_program::make(expr, slice.schema()).evaluate(slice, hints);
+}
+
 } // namespace tenzir
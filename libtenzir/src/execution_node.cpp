@@ -179,6 +179,25 @@ public:
     }
   }
 
+  auto make_waker() noexcept -> std::function<void()> override {
+    // The waker may run on any thread, so instead of touching the state
+    // directly it schedules an action that runs in the context of the actor,
+    // unless the actor is already gone.
+    return [&system = state_.self->home_system(),
+            weak_self = caf::weak_actor_ptr{state_.self->ctrl()},
+            &state = state_] {
+      auto& clock = system.clock();
+      clock.schedule(clock.now(),
+                     caf::make_action(
+                       [&state] {
+                         state.waiting = false;
+                         state.schedule_run(false);
+                       },
+                       caf::action::state::waiting),
+                     weak_self);
+    };
+  }
+
 private:
   exec_node_state<Input, Output>& state_;
   std::unique_ptr<exec_node_diagnostic_handler<Input, Output>> diagnostic_handler_
@@ -0,0 +1,178 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2024 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "tenzir/hyperloglog.hpp"
+
+#include "tenzir/detail/assert.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <numbers>
+
+namespace tenzir {
+
+hyperloglog::hyperloglog(uint8_t precision) : precision_{precision} {
+  TENZIR_ASSERT(precision_ >= min_precision and precision_ <= max_precision);
+}
+
+auto hyperloglog::add(uint64_t digest) -> void {
+  // The leading bits of the digest select the register, and the register
+  // stores the largest position of the first set bit among the remaining
+  // bits, capped at one past the number of remaining bits.
+  const auto index = digest >> (64 - precision_);
+  const auto rest = digest << precision_;
+  const auto rank
+    = rest == 0 ? 64 - precision_ + 1 : std::countl_zero(rest) + 1;
+  update(index, static_cast<uint8_t>(rank));
+}
+
+auto hyperloglog::merge(const hyperloglog& other) -> void {
+  TENZIR_ASSERT(precision_ == other.precision_);
+  if (other.sparse()) {
+    merge_sparse(other.sparse_);
+  } else {
+    merge(std::span<const uint8_t>{other.registers_});
+  }
+}
+
+auto hyperloglog::merge(std::span<const uint8_t> registers) -> void {
+  TENZIR_ASSERT(registers.size() == num_registers());
+  if (sparse()) {
+    densify();
+  }
+  for (auto i = size_t{0}; i < registers_.size(); ++i) {
+    registers_[i] = std::max(registers_[i], registers[i]);
+  }
+}
+
+auto hyperloglog::merge_sparse(std::span<const uint32_t> entries) -> void {
+  for (auto entry : entries) {
+    update(entry >> 8, static_cast<uint8_t>(entry & 0xff));
+  }
+}
+
+auto hyperloglog::estimate() const -> double {
+  // See Otmar Ertl, "New cardinality estimation algorithms for HyperLogLog
+  // sketches", 2017, Algorithm 6.
+  const auto q = 64 - precision_;
+  const auto m = static_cast<double>(num_registers());
+  auto histogram = std::array<uint64_t, 64 + 2>{};
+  if (sparse()) {
+    histogram[0] = num_registers() - sparse_.size();
+    for (auto entry : sparse_) {
+      histogram[entry & 0xff] += 1;
+    }
+  } else {
+    for (auto x : registers_) {
+      histogram[x] += 1;
+    }
+  }
+  // Corrects the contribution of registers that are zero.
+  const auto sigma = [](double x) {
+    if (x == 1.0) {
+      return std::numeric_limits<double>::infinity();
+    }
+    auto y = 1.0;
+    auto z = x;
+    auto previous = 0.0;
+    do {
+      x *= x;
+      previous = z;
+      z += x * y;
+      y += y;
+    } while (z != previous);
+    return z;
+  };
+  // Corrects the contribution of registers that are saturated.
+  const auto tau = [](double x) {
+    if (x == 0.0 or x == 1.0) {
+      return 0.0;
+    }
+    auto y = 1.0;
+    auto z = 1.0 - x;
+    auto previous = 0.0;
+    do {
+      x = std::sqrt(x);
+      previous = z;
+      y *= 0.5;
+      z -= (1.0 - x) * (1.0 - x) * y;
+    } while (z != previous);
+    return z / 3.0;
+  };
+  auto z = m * tau(1.0 - static_cast<double>(histogram[q + 1]) / m);
+  for (auto k = q; k >= 1; --k) {
+    z = 0.5 * (z + static_cast<double>(histogram[k]));
+  }
+  z += m * sigma(static_cast<double>(histogram[0]) / m);
+  const auto alpha = 1.0 / (2.0 * std::numbers::ln2);
+  return alpha * m * m / z;
+}
+
+auto hyperloglog::precision() const -> uint8_t {
+  return precision_;
+}
+
+auto hyperloglog::num_registers() const -> size_t {
+  return size_t{1} << precision_;
+}
+
+auto hyperloglog::registers() const -> std::vector<uint8_t> {
+  if (not sparse()) {
+    return registers_;
+  }
+  auto result = std::vector<uint8_t>(num_registers());
+  for (auto entry : sparse_) {
+    result[entry >> 8] = static_cast<uint8_t>(entry & 0xff);
+  }
+  return result;
+}
+
+auto hyperloglog::sparse() const -> bool {
+  return registers_.empty();
+}
+
+auto hyperloglog::sparse_entries() const -> std::span<const uint32_t> {
+  return sparse_;
+}
+
+auto hyperloglog::memusage() const -> size_t {
+  return sparse_.capacity() * sizeof(uint32_t) + registers_.capacity();
+}
+
+auto hyperloglog::update(size_t index, uint8_t value) -> void {
+  TENZIR_ASSERT(index < num_registers());
+  if (not sparse()) {
+    auto& x = registers_[index];
+    x = std::max(x, value);
+    return;
+  }
+  const auto entry = static_cast<uint32_t>(index << 8 | value);
+  const auto it = std::lower_bound(sparse_.begin(), sparse_.end(),
+                                   static_cast<uint32_t>(index << 8));
+  if (it != sparse_.end() and (*it >> 8) == index) {
+    *it = std::max(*it, entry);
+    return;
+  }
+  if (value == 0) {
+    return;
+  }
+  sparse_.insert(it, entry);
+  if (sparse_.size() * sizeof(uint32_t) >= num_registers()) {
+    densify();
+  }
+}
+
+auto hyperloglog::densify() -> void {
+  registers_ = registers();
+  sparse_ = {};
+}
+
+} // namespace tenzir
@@ -11,6 +11,7 @@
 #include "tenzir/fwd.hpp"
 
 #include "tenzir/active_partition.hpp"
+#include "tenzir/arrow_table_slice.hpp"
 #include "tenzir/catalog.hpp"
 #include "tenzir/chunk.hpp"
 #include "tenzir/concept/parseable/tenzir/uuid.hpp"
@@ -30,6 +31,7 @@
 #include "tenzir/detail/notifying_stream_manager.hpp"
 #include "tenzir/detail/weak_run_delayed.hpp"
 #include "tenzir/error.hpp"
+#include "tenzir/fbs/flatbuffer_container.hpp"
 #include "tenzir/fbs/index.hpp"
 #include "tenzir/fbs/partition.hpp"
 #include "tenzir/fbs/partition_transform.hpp"
@@ -45,11 +47,16 @@
 #include "tenzir/partition_transformer.hpp"
 #include "tenzir/passive_partition.hpp"
 #include "tenzir/report.hpp"
+#include "tenzir/resource.hpp"
 #include "tenzir/shutdown.hpp"
 #include "tenzir/status.hpp"
 #include "tenzir/table_slice.hpp"
 #include "tenzir/uuid.hpp"
+#include "tenzir/view.hpp"
 
+#include <arrow/builder.h>
+#include <arrow/compute/api.h>
+#include <arrow/record_batch.h>
 #include <caf/attach_stream_source.hpp>
 #include <caf/error.hpp>
 #include <caf/make_copy_on_write.hpp>
@@ -59,6 +66,7 @@
 #include <flatbuffers/flatbuffers.h>
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <ctime>
 #include <deque>
@@ -66,6 +74,7 @@
 #include <memory>
 #include <numeric>
 #include <span>
+#include <thread>
 #include <unistd.h>
 
 // clang-format off
@@ -280,6 +289,118 @@ tenzir::chunk_ptr create_marker(const std::vector<tenzir::uuid>& in,
   return tenzir::chunk::make(builder.Release());
 }
 
+namespace {
+
+auto pack_resource(flatbuffers::FlatBufferBuilder& builder, const resource& x)
+  -> flatbuffers::Offset<fbs::catalog_snapshot::Resource> {
+  return fbs::catalog_snapshot::CreateResourceDirect(builder, x.url.c_str(),
+                                                     x.size);
+}
+
+auto unpack_resource(const fbs::catalog_snapshot::Resource* x) -> resource {
+  if (not x)
+    return {};
+  return {
+    .url = x->url() ? x->url()->str() : std::string{},
+    .size = x->size(),
+  };
+}
+
+} // namespace
+
+caf::expected<chunk_ptr>
+pack_catalog_snapshot(int64_t generation,
+                      const std::vector<partition_synopsis_pair>& synopses,
+                      size_t segment_size) {
+  // A single FlatBuffers table cannot exceed 2 GiB, so we split the snapshot
+  // into segments of roughly `segment_size` bytes each.
+  auto container_builder = fbs::flatbuffer_container_builder{segment_size};
+  auto builder = flatbuffers::FlatBufferBuilder{};
+  auto partition_offsets
+    = std::vector<flatbuffers::Offset<fbs::catalog_snapshot::Partition>>{};
+  auto num_segments = size_t{0};
+  const auto finish_segment = [&] {
+    const auto partitions_offset = builder.CreateVector(partition_offsets);
+    const auto v0_offset = fbs::catalog_snapshot::Createv0(
+      builder, generation, partitions_offset);
+    const auto snapshot_offset = fbs::CreateCatalogSnapshot(
+      builder, fbs::catalog_snapshot::CatalogSnapshot::v0, v0_offset.Union());
+    fbs::FinishCatalogSnapshotBuffer(builder, snapshot_offset);
+    container_builder.add(as_bytes(fbs::release(builder)));
+    builder.Clear();
+    partition_offsets.clear();
+    ++num_segments;
+  };
+  for (const auto& [id, ps] : synopses) {
+    auto ps_offset = pack(builder, *ps);
+    if (!ps_offset)
+      return ps_offset.error();
+    const auto synopsis_offset = fbs::CreatePartitionSynopsis(
+      builder, fbs::partition_synopsis::PartitionSynopsis::legacy,
+      ps_offset->Union());
+    const auto indexes_file_offset = pack_resource(builder, ps->indexes_file);
+    const auto sketches_file_offset = pack_resource(builder, ps->sketches_file);
+    const auto store_file_offset = pack_resource(builder, ps->store_file);
+    auto id_fb = fbs::UUID{};
+    ::memcpy(id_fb.mutable_data()->Data(), id.begin(), uuid::num_bytes);
+    partition_offsets.push_back(fbs::catalog_snapshot::CreatePartition(
+      builder, &id_fb, synopsis_offset, indexes_file_offset,
+      sketches_file_offset, store_file_offset));
+    if (builder.GetSize() >= segment_size)
+      finish_segment();
+  }
+  if (num_segments == 0 or not partition_offsets.empty())
+    finish_segment();
+  auto container
+    = std::move(container_builder).finish(fbs::CatalogSnapshotIdentifier());
+  return std::move(container).dissolve();
+}
+
+caf::expected<std::vector<catalog_snapshot>>
+unpack_catalog_snapshot(chunk_ptr chunk) {
+  if (!chunk
+      or chunk->size() < sizeof(flatbuffers::uoffset_t)
+                           + flatbuffers::kFileIdentifierLength
+      or not flatbuffers::BufferHasIdentifier(
+        chunk->data(), fbs::SegmentedFileHeaderIdentifier()))
+    return caf::make_error(ec::format_error, "catalog snapshot is not a "
+                                             "segmented file");
+  auto container = fbs::flatbuffer_container{std::move(chunk)};
+  if (!container)
+    return caf::make_error(ec::format_error, "invalid flatbuffer container");
+  auto result = std::vector<catalog_snapshot>{};
+  result.reserve(container.size());
+  for (size_t i = 0; i < container.size(); ++i) {
+    auto segment = catalog_snapshot::make(container.get_raw(i));
+    if (!segment)
+      return std::move(segment.error());
+    if ((*segment)->catalog_snapshot_type()
+        != fbs::catalog_snapshot::CatalogSnapshot::v0)
+      return caf::make_error(ec::format_error, "invalid catalog snapshot "
+                                               "version");
+    result.push_back(std::move(*segment));
+  }
+  return result;
+}
+
+caf::expected<partition_synopsis_ptr>
+unpack_catalog_snapshot_entry(const fbs::catalog_snapshot::Partition& entry) {
+  const auto* ps_flatbuffer = entry.synopsis();
+  if (not ps_flatbuffer
+      or ps_flatbuffer->partition_synopsis_type()
+           != fbs::partition_synopsis::PartitionSynopsis::legacy)
+    return caf::make_error(ec::format_error, "invalid partition synopsis "
+                                             "version");
+  partition_synopsis_ptr ps = caf::make_copy_on_write<partition_synopsis>();
+  if (auto error
+      = unpack(*ps_flatbuffer->partition_synopsis_as_legacy(), ps.unshared()))
+    return error;
+  ps.unshared().indexes_file = unpack_resource(entry.indexes_file());
+  ps.unshared().sketches_file = unpack_resource(entry.sketches_file());
+  ps.unshared().store_file = unpack_resource(entry.store_file());
+  return ps;
+}
+
 // -- partition_factory --------------------------------------------------------
 
 partition_factory::partition_factory(index_state& state) : state_{state} {
@@ -352,6 +473,82 @@ std::string index_state::transformer_partition_synopsis_path_template() const {
   return (dir / "markers" / "{:l}.mdx").string();
 }
 
+std::filesystem::path index_state::catalog_snapshot_path() const {
+  return synopsisdir / "catalog.snapshot";
+}
+
+caf::expected<partition_synopsis_ptr> index_state::load_partition_synopsis(
+  const uuid& id,
+  const std::map<uuid, std::filesystem::path>& store_map) const {
+  auto err = std::error_code{};
+  auto part_path = partition_path(id);
+  // Generate external partition synopsis file if it doesn't exist.
+  auto synopsis_path = partition_synopsis_path(id);
+  if (!exists(synopsis_path)) {
+    if (auto error = extract_partition_synopsis(part_path, synopsis_path))
+      return error;
+  }
+  auto chunk = chunk::mmap(synopsis_path);
+  if (!chunk)
+    return chunk.error();
+  const auto* ps_flatbuffer = fbs::GetPartitionSynopsis(chunk->get()->data());
+  partition_synopsis_ptr ps = caf::make_copy_on_write<partition_synopsis>();
+  if (ps_flatbuffer->partition_synopsis_type()
+      != fbs::partition_synopsis::PartitionSynopsis::legacy)
+    return caf::make_error(ec::format_error, "invalid partition synopsis "
+                                             "version");
+  const auto& synopsis_legacy = *ps_flatbuffer->partition_synopsis_as_legacy();
+  if (auto error = unpack(synopsis_legacy, ps.unshared()))
+    return error;
+  // Add partition file sizes.
+  uint64_t bitmap_file_size = std::filesystem::file_size(part_path, err);
+  if (err) {
+    TENZIR_WARN("failed to get the size of the partition index file at "
+                "{}: {}",
+                part_path, err.message());
+    bitmap_file_size = 0u;
+  }
+  if (const auto canonical_part_path = canonical(part_path, err); not err) {
+    ps.unshared().indexes_file = {
+      .url = fmt::format("file://{}", canonical_part_path),
+      .size = bitmap_file_size,
+    };
+  }
+  if (const auto canonical_synopsis_path = canonical(synopsis_path, err);
+      not err) {
+    ps.unshared().sketches_file = {
+      .url = fmt::format("file://{}", canonical_synopsis_path),
+      .size = chunk->get()->size(),
+    };
+  }
+  auto f = store_map.find(id);
+  if (f == store_map.end()) {
+    // For completeness sake we could open the partition and look if the
+    // data is somewhere else entirely, but no known implementation ever
+    // deviated from the default path scheme, so we assume filesystem
+    // corruption here.
+    return add_context(ec::no_such_file,
+                       "discarding partition {} due to a missing store "
+                       "file",
+                       id);
+  }
+  auto store_path = f->second;
+  auto store_size = std::filesystem::file_size(store_path, err);
+  if (err) {
+    TENZIR_WARN("failed to get the size of the partition store file at "
+                "{}: {}",
+                store_path, err.message());
+    store_size = 0u;
+  }
+  if (const auto canonical_store_path = canonical(store_path, err); not err) {
+    ps.unshared().store_file = {
+      .url = fmt::format("file://{}", canonical_store_path),
+      .size = store_size,
+    };
+  }
+  return ps;
+}
+
 caf::error index_state::load_from_disk() {
   // We dont use the filesystem actor here because this function is only
   // called once during startup, when no other actors exist yet.
@@ -518,92 +715,101 @@ caf::error index_state::load_from_disk() {
     }
     return result;
   }();
-  // Now try to load the partitions - with a progress indicator.
-  for (size_t idx = 0; idx < partitions.size(); ++idx) {
-    auto partition_uuid = partitions[idx];
+  // Restore as many synopses as possible from the catalog snapshot. Only the
+  // partitions that are missing from the snapshot or whose synopsis file was
+  // modified after the snapshot was taken need to be read from disk.
+  auto snapshot = std::vector<catalog_snapshot>{};
+  auto snapshot_entries
+    = std::unordered_map<uuid, const fbs::catalog_snapshot::Partition*>{};
+  auto snapshot_generation = int64_t{};
+  if (std::filesystem::exists(catalog_snapshot_path(), err)) {
     auto error = [&]() -> caf::error {
-      auto part_path = partition_path(partition_uuid);
-      TENZIR_DEBUG("{} unpacks partition {} ({}/{})", *self, partition_uuid,
-                   idx, partitions.size());
-      // Generate external partition synopsis file if it doesn't exist.
-      auto synopsis_path = partition_synopsis_path(partition_uuid);
-      if (!exists(synopsis_path)) {
-        if (auto error = extract_partition_synopsis(part_path, synopsis_path))
-          return error;
-      }
-      auto chunk = chunk::mmap(synopsis_path);
+      auto chunk = chunk::mmap(catalog_snapshot_path());
       if (!chunk)
-        return chunk.error();
-      const auto* ps_flatbuffer
-        = fbs::GetPartitionSynopsis(chunk->get()->data());
-      partition_synopsis_ptr ps = caf::make_copy_on_write<partition_synopsis>();
-      if (ps_flatbuffer->partition_synopsis_type()
-          != fbs::partition_synopsis::PartitionSynopsis::legacy)
-        return caf::make_error(ec::format_error, "invalid partition synopsis "
-                                                 "version");
-      const auto& synopsis_legacy
-        = *ps_flatbuffer->partition_synopsis_as_legacy();
-      if (auto error = unpack(synopsis_legacy, ps.unshared()))
-        return error;
-      // Add partition file sizes.
-      {
-        uint64_t bitmap_file_size = std::filesystem::file_size(part_path, err);
-        if (err) {
-          TENZIR_WARN("failed to get the size of the partition index file at "
-                      "{}: {}",
-                      part_path, err.message());
-          bitmap_file_size = 0u;
-        }
-        if (const auto canonical_part_path = canonical(part_path, err);
-            not err) {
-          ps.unshared().indexes_file = {
-            .url = fmt::format("file://{}", canonical_part_path),
-            .size = bitmap_file_size,
-          };
-        }
-        if (const auto canonical_synopsis_path = canonical(synopsis_path, err);
-            not err) {
-          ps.unshared().sketches_file = {
-            .url = fmt::format("file://{}", canonical_synopsis_path),
-            .size = chunk->get()->size(),
-          };
-        }
-        auto f = store_map.find(partition_uuid);
-        if (f == store_map.end()) {
-          // For completeness sake we could open the partition and look if the
-          // data is somewhere else entirely, but no known implementation ever
-          // deviated from the default path scheme, so we assume filesystem
-          // corruption here.
-          return add_context(ec::no_such_file,
-                             "discarding partition {} due to a missing store "
-                             "file",
-                             partition_uuid);
-        }
-        auto store_path = f->second;
-        auto store_size = std::filesystem::file_size(store_path, err);
-        if (err) {
-          TENZIR_WARN("failed to get the size of the partition store file at "
-                      "{}: {}",
-                      store_path, err.message());
-          store_size = 0u;
-        }
-        if (const auto canonical_store_path = canonical(store_path, err);
-            not err) {
-          ps.unshared().store_file = {
-            .url = fmt::format("file://{}", canonical_store_path),
-            .size = store_size,
-          };
+        return std::move(chunk.error());
+      auto segments = unpack_catalog_snapshot(std::move(*chunk));
+      if (!segments)
+        return std::move(segments.error());
+      snapshot = std::move(*segments);
+      for (const auto& segment : snapshot) {
+        const auto* snapshot_v0 = segment->catalog_snapshot_as_v0();
+        snapshot_generation = snapshot_v0->generation();
+        if (const auto* entries = snapshot_v0->partitions()) {
+          snapshot_entries.reserve(snapshot_entries.size() + entries->size());
+          for (const auto* entry : *entries) {
+            if (entry->id())
+              snapshot_entries.emplace(uuid::from_flatbuffer(*entry->id()),
+                                       entry);
+          }
         }
       }
-      persisted_partitions.emplace(partition_uuid);
-      synopses->emplace(partition_uuid, std::move(ps));
       return caf::none;
     }();
     if (error) {
+      TENZIR_WARN("{} ignores the catalog snapshot at {}: {}", *self,
+                  catalog_snapshot_path(), error);
+      snapshot_entries.clear();
+    }
+  }
+  // Now load the partition synopses. This is the bulk of the work at startup,
+  // so we spread it over all available cores.
+  auto results = std::vector<caf::expected<partition_synopsis_ptr>>(
+    partitions.size(), caf::make_error(ec::unspecified, "not loaded"));
+  auto next_partition = std::atomic<size_t>{0};
+  auto num_restored = std::atomic<size_t>{0};
+  auto load = [&] {
+    for (auto idx = next_partition++; idx < partitions.size();
+         idx = next_partition++) {
+      const auto& partition_uuid = partitions[idx];
+      auto entry = snapshot_entries.find(partition_uuid);
+      if (entry != snapshot_entries.end()
+          and store_map.contains(partition_uuid)) {
+        auto ec = std::error_code{};
+        const auto last_write_time = std::filesystem::last_write_time(
+          partition_synopsis_path(partition_uuid), ec);
+        const auto modified
+          = not ec
+            and std::chrono::duration_cast<std::chrono::nanoseconds>(
+                  last_write_time.time_since_epoch())
+                    .count()
+                  > snapshot_generation;
+        if (not modified) {
+          if (auto ps = unpack_catalog_snapshot_entry(*entry->second)) {
+            results[idx] = std::move(*ps);
+            ++num_restored;
+            continue;
+          }
+        }
+      }
+      results[idx] = load_partition_synopsis(partition_uuid, store_map);
+    }
+  };
+  const auto num_threads
+    = std::min(partitions.size(),
+               size_t{std::max(1u, std::thread::hardware_concurrency())});
+  auto threads = std::vector<std::thread>{};
+  for (size_t i = 1; i < num_threads; ++i)
+    threads.emplace_back(load);
+  load();
+  for (auto& thread : threads)
+    thread.join();
+  for (size_t idx = 0; idx < partitions.size(); ++idx) {
+    auto& ps = results[idx];
+    if (!ps) {
       TENZIR_VERBOSE("{} failed to load partition {}: {}", *self,
-                     partition_uuid, error);
+                     partitions[idx], ps.error());
+      continue;
     }
+    persisted_partitions.emplace(partitions[idx]);
+    synopses->emplace(partitions[idx], std::move(*ps));
   }
+  TENZIR_VERBOSE("{} restored {}/{} partition synopses from the catalog "
+                 "snapshot",
+                 *self, num_restored.load(), synopses->size());
+  // Write a new snapshot soon if we had to read synopses from disk, so that
+  // the next startup does not have to read them again.
+  catalog_snapshot_dirty = num_restored.load() != synopses->size()
+                           or snapshot_entries.size() != synopses->size();
   //  Recommend the user to run 'tenzir-ctl rebuild' if any partition syopses
   //  are outdated. We need to nudge them a bit so we can drop support for older
   //  partition versions more freely.
@@ -666,6 +872,43 @@ void index_state::flush_to_disk() {
       });
 }
 
+void index_state::write_catalog_snapshot() {
+  if (!catalog_snapshot_dirty)
+    return;
+  catalog_snapshot_dirty = false;
+  // Synopsis files that are modified after this point in time may not be
+  // reflected in the snapshot, so they must be read again on startup.
+  const auto generation
+    = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::filesystem::file_time_type::clock::now().time_since_epoch())
+        .count();
+  // Packing the snapshot of a large catalog takes a while, so we leave it to
+  // the catalog snapshot writer to keep the index responsive.
+  self->request(catalog, caf::infinite, atom::get_v)
+    .then(
+      [this, generation](std::vector<partition_synopsis_pair>& synopses) {
+        const auto num_partitions = synopses.size();
+        self
+          ->request(catalog_snapshot_writer, caf::infinite, atom::write_v,
+                    generation, std::move(synopses))
+          .then(
+            [this, num_partitions](atom::ok) {
+              TENZIR_DEBUG("{} wrote catalog snapshot with {} partitions",
+                           *self, num_partitions);
+            },
+            [this](const caf::error& err) {
+              TENZIR_WARN("{} failed to write catalog snapshot: {}", *self,
+                          err);
+              catalog_snapshot_dirty = true;
+            });
+      },
+      [this](const caf::error& err) {
+        TENZIR_WARN("{} failed to get partition synopses from catalog: {}",
+                    *self, err);
+        catalog_snapshot_dirty = true;
+      });
+}
+
 // -- flush handling -----------------------------------------------------------
 
 void index_state::add_flush_listener(flush_listener_actor listener) {
@@ -712,13 +955,15 @@ bool i_partition_selector::operator()(const type& filter,
   return filter == slice.schema();
 }
 
-caf::expected<std::unordered_map<type, active_partition_info>::iterator>
-index_state::create_active_partition(const type& schema) {
+caf::expected<
+  std::unordered_map<active_partition_key, active_partition_info>::iterator>
+index_state::create_active_partition(const active_partition_key& key) {
   TENZIR_ASSERT(taxonomies);
-  TENZIR_ASSERT(schema);
+  TENZIR_ASSERT(key.schema);
+  const auto& schema = key.schema;
   auto id = uuid::random();
   const auto [active_partition, inserted]
-    = active_partitions.emplace(schema, active_partition_info{});
+    = active_partitions.emplace(key, active_partition_info{});
   TENZIR_ASSERT(inserted);
   TENZIR_ASSERT(active_partition != active_partitions.end());
   active_partition->second.actor
@@ -727,11 +972,14 @@ index_state::create_active_partition(const type& schema) {
                   taxonomies);
   active_partition->second.stream_slot
     = stage->add_outbound_path(active_partition->second.actor);
-  stage->out().set_filter(active_partition->second.stream_slot, schema);
+  // Events are pushed directly into the buffer of the partition's path, so the
+  // filter must never match.
+  stage->out().set_filter(active_partition->second.stream_slot, type{});
   active_partition->second.capacity = partition_capacity;
   active_partition->second.id = id;
-  detail::weak_run_delayed(self, active_partition_timeout, [schema, id, this] {
-    const auto it = active_partitions.find(schema);
+  detail::weak_run_delayed(self, active_partition_timeout, [key, id, this] {
+    const auto& schema = key.schema;
+    const auto it = active_partitions.find(key);
     if (it == active_partitions.end() or it->second.id != id) {
       // If the partition was already rotated then there's nothing to do for us.
       return;
@@ -741,8 +989,8 @@ index_state::create_active_partition(const type& schema) {
                    *self, it->second.id,
                    partition_capacity - it->second.capacity, partition_capacity,
                    schema, data{active_partition_timeout});
-    decommission_active_partition(schema, [this, schema,
-                                           id](const caf::error& err) mutable {
+    decommission_active_partition(key, [this, schema,
+                                        id](const caf::error& err) mutable {
       if (err) {
         TENZIR_WARN("{} failed to flush active partition {} ({}) after {} "
                     "timeout: {}",
@@ -760,12 +1008,14 @@ index_state::create_active_partition(const type& schema) {
 }
 
 void index_state::decommission_active_partition(
-  const type& schema, std::function<void(const caf::error&)> completion) {
-  const auto active_partition = active_partitions.find(schema);
+  const active_partition_key& key,
+  std::function<void(const caf::error&)> completion) {
+  const auto& schema = key.schema;
+  const auto active_partition = active_partitions.find(key);
   TENZIR_ASSERT(active_partition != active_partitions.end());
   const auto id = active_partition->second.id;
   const auto actor = std::exchange(active_partition->second.actor, {});
-  const auto type = active_partition->first;
+  const auto type = active_partition->first.schema;
   auto stream_slot = active_partition->second.stream_slot;
   // Send buffered batches and remove active partition from the stream.
   stage->out().fan_out_flush();
@@ -813,6 +1063,7 @@ void index_state::decommission_active_partition(
               unpersisted.erase(id);
               self->erase_stream_manager(stream_slot);
               persisted_partitions.emplace(id);
+              catalog_snapshot_dirty = true;
               self->send_exit(actor, caf::exit_reason::normal);
               if (completion)
                 completion(caf::none);
@@ -843,6 +1094,98 @@ void index_state::decommission_active_partition(
       });
 }
 
+namespace {
+
+/// Assigns every row of a key column to an ingest shard by the hash of its
+/// value. The column is hashed in a single typed pass; null values go to the
+/// first shard.
+auto hash_into_shards(const type& key_type, const arrow::Array& key_array,
+                      size_t shards) -> std::vector<size_t> {
+  auto result = std::vector<size_t>{};
+  result.reserve(key_array.length());
+  auto f = [&]<concrete_type Type>(const Type& type) {
+    const auto& typed_array = caf::get<type_to_arrow_array_t<Type>>(key_array);
+    for (auto&& value : values(type, typed_array))
+      result.push_back(value ? hash(*value) % shards : 0);
+  };
+  caf::visit(f, key_type);
+  return result;
+}
+
+} // namespace
+
+caf::expected<std::vector<std::pair<size_t, table_slice>>>
+index_state::split_into_shards(table_slice slice) {
+  auto result = std::vector<std::pair<size_t, table_slice>>{};
+  if (ingest_shards <= 1) {
+    result.emplace_back(0, std::move(slice));
+    return result;
+  }
+  const auto key
+    = ingest_shard_key.empty()
+        ? std::nullopt
+        : slice.schema().resolve_key_or_concept_once(ingest_shard_key);
+  if (!key) {
+    auto& [shard, events] = round_robin_shards[slice.schema()];
+    if (events >= defaults::import::table_slice_size) {
+      shard = (shard + 1) % ingest_shards;
+      events = 0;
+    }
+    events += slice.rows();
+    result.emplace_back(shard, std::move(slice));
+    return result;
+  }
+  // Group the rows by shard with a counting sort over the hashed key column,
+  // gather them with a single take, and then cut the result into one
+  // zero-copy part per shard.
+  auto [key_type, key_array] = key->get(slice);
+  const auto shards = hash_into_shards(key_type, *key_array, ingest_shards);
+  auto offsets = std::vector<int64_t>(ingest_shards + 1);
+  for (const auto shard : shards)
+    ++offsets[shard + 1];
+  std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+  for (size_t shard = 0; shard < ingest_shards; ++shard) {
+    if (offsets[shard + 1] - offsets[shard]
+        == detail::narrow_cast<int64_t>(slice.rows())) {
+      result.emplace_back(shard, std::move(slice));
+      return result;
+    }
+  }
+  auto indices = std::vector<int64_t>(shards.size());
+  auto next = offsets;
+  for (auto row = size_t{0}; row < shards.size(); ++row)
+    indices[next[shards[row]]++] = detail::narrow_cast<int64_t>(row);
+  auto builder = arrow::Int64Builder{};
+  if (auto status = builder.AppendValues(indices); not status.ok())
+    return caf::make_error(ec::system_error,
+                           fmt::format("failed to group rows by ingest shard: "
+                                       "{}",
+                                       status.ToString()));
+  auto index_array = builder.Finish();
+  if (not index_array.ok())
+    return caf::make_error(ec::system_error,
+                           fmt::format("failed to group rows by ingest shard: "
+                                       "{}",
+                                       index_array.status().ToString()));
+  auto gathered = arrow::compute::Take(to_record_batch(slice), *index_array);
+  if (not gathered.ok())
+    return caf::make_error(ec::system_error,
+                           fmt::format("failed to group rows by ingest shard: "
+                                       "{}",
+                                       gathered.status().ToString()));
+  TENZIR_ASSERT(gathered->kind() == arrow::Datum::Kind::RECORD_BATCH);
+  const auto batch = gathered->record_batch();
+  for (size_t shard = 0; shard < ingest_shards; ++shard) {
+    const auto rows = offsets[shard + 1] - offsets[shard];
+    if (rows == 0)
+      continue;
+    auto part = table_slice{batch->Slice(offsets[shard], rows), slice.schema()};
+    part.import_time(slice.import_time());
+    result.emplace_back(shard, std::move(part));
+  }
+  return result;
+}
+
 void index_state::add_partition_creation_listener(
   partition_creation_listener_actor listener) {
   partition_creation_listeners.push_back(listener);
@@ -1067,8 +1410,8 @@ std::size_t index_state::memusage() const {
     return collection.size() * sizeof(typename T::value_type);
   };
   auto usage = std::size_t{sizeof(*this)};
-  for (const auto& [type, partition_info] : active_partitions) {
-    usage += as_bytes(type).size() + sizeof(partition_info);
+  for (const auto& [key, partition_info] : active_partitions) {
+    usage += as_bytes(key.schema).size() + sizeof(partition_info);
   }
   usage += persisted_partitions.size()
            * sizeof(decltype(persisted_partitions)::value_type);
@@ -1192,12 +1535,41 @@ index_state::status(status_verbosity v, duration d) const {
   return rs->promise;
 }
 
+namespace {
+
+/// Packs catalog snapshots and writes them to disk. This runs in a detached
+/// actor because packing the synopses of a large catalog stalls the thread.
+catalog_snapshot_writer_actor::behavior_type
+catalog_snapshot_writer(catalog_snapshot_writer_actor::pointer self,
+                        filesystem_actor filesystem,
+                        std::filesystem::path path) {
+  return {
+    [self, filesystem = std::move(filesystem), path = std::move(path)](
+      atom::write, int64_t generation,
+      std::vector<partition_synopsis_pair>& synopses)
+      -> caf::result<atom::ok> {
+      auto chunk = pack_catalog_snapshot(generation, synopses);
+      if (!chunk)
+        return caf::make_error(ec::serialization_error,
+                               fmt::format("failed to pack catalog snapshot: "
+                                           "{}",
+                                           chunk.error()));
+      return self->delegate(filesystem, atom::write_v, path,
+                            std::move(*chunk));
+    },
+  };
+}
+
+} // namespace
+
 index_actor::behavior_type
 index(index_actor::stateful_pointer<index_state> self,
       accountant_actor accountant, filesystem_actor filesystem,
       catalog_actor catalog, const std::filesystem::path& dir,
       std::string store_backend, size_t partition_capacity,
-      duration active_partition_timeout, size_t max_inmem_partitions,
+      duration active_partition_timeout, duration catalog_snapshot_interval,
+      size_t ingest_shards, std::string ingest_shard_key,
+      size_t max_inmem_partitions,
       size_t taste_partitions, size_t max_concurrent_partition_lookups,
       const std::filesystem::path& catalog_dir, index_config index_config) {
   TENZIR_TRACE_SCOPE(
@@ -1242,6 +1614,8 @@ index(index_actor::stateful_pointer<index_state> self,
   self->state.markersdir = dir / "markers";
   self->state.partition_capacity = partition_capacity;
   self->state.active_partition_timeout = active_partition_timeout;
+  self->state.ingest_shards = std::max(ingest_shards, size_t{1});
+  self->state.ingest_shard_key = std::move(ingest_shard_key);
   self->state.taste_partitions = taste_partitions;
   self->state.inmem_partitions.factory().filesystem() = self->state.filesystem;
   self->state.inmem_partitions.resize(max_inmem_partitions);
@@ -1252,58 +1626,74 @@ index(index_actor::stateful_pointer<index_state> self,
     [](caf::unit_t&) {
       // nop
     },
-    [self](caf::unit_t&, caf::downstream<table_slice>& out, table_slice x) {
-      TENZIR_ASSERT(x.rows() != 0);
+    [self](caf::unit_t&, caf::downstream<table_slice>&, table_slice slice) {
+      TENZIR_ASSERT(slice.rows() != 0);
       if (!self->state.stage->running())
         return;
-      auto&& schema = x.schema();
-      // TODO: Consider switching schemas to a robin map to take advantage of
-      // transparent key lookup with string views, avoding the copy of the name
-      // here.
-      auto active_partition = self->state.active_partitions.find(schema);
-      if (active_partition == self->state.active_partitions.end()) {
-        auto part = self->state.create_active_partition(schema);
-        if (!part) {
-          self->quit(caf::make_error(ec::logic_error,
-                                     fmt::format("{} failed to create active "
-                                                 "partition: {}",
-                                                 *self, part.error())));
-          return;
+      auto parts = self->state.split_into_shards(std::move(slice));
+      if (!parts) {
+        self->quit(caf::make_error(ec::logic_error,
+                                   fmt::format("{} failed to split events into "
+                                               "ingest shards: {}",
+                                               *self, parts.error())));
+        return;
+      }
+      // Every part goes straight into the buffer of the path of its active
+      // partition, so the parts of a batch need no fan-out flush in between.
+      auto& paths = self->state.stage->out().states();
+      for (auto& [shard, x] : *parts) {
+        // TODO: Consider switching schemas to a robin map to take advantage of
+        // transparent key lookup with string views, avoding the copy of the
+        // name here.
+        const auto key = active_partition_key{x.schema(), shard};
+        const auto& schema = key.schema;
+        auto active_partition = self->state.active_partitions.find(key);
+        if (active_partition == self->state.active_partitions.end()) {
+          auto part = self->state.create_active_partition(key);
+          if (!part) {
+            self->quit(caf::make_error(ec::logic_error,
+                                       fmt::format("{} failed to create active "
+                                                   "partition: {}",
+                                                   *self, part.error())));
+            return;
+          }
+          active_partition = *part;
+        } else if (x.rows() > active_partition->second.capacity) {
+          TENZIR_DEBUG("{} exceeds active capacity by {} rows", *self,
+                       x.rows() - active_partition->second.capacity);
+          TENZIR_VERBOSE(
+            "{} flushes active partition {} with {}/{} events", *self, schema,
+            self->state.partition_capacity - active_partition->second.capacity,
+            self->state.partition_capacity);
+          self->state.decommission_active_partition(key, {});
+          self->state.flush_to_disk();
+          auto part = self->state.create_active_partition(key);
+          if (!part) {
+            self->quit(caf::make_error(ec::logic_error,
+                                       fmt::format("{} failed to create active "
+                                                   "partition: {}",
+                                                   *self, part.error())));
+            return;
+          }
+          active_partition = *part;
         }
-        active_partition = *part;
-      } else if (x.rows() > active_partition->second.capacity) {
-        TENZIR_DEBUG("{} exceeds active capacity by {} rows", *self,
-                     x.rows() - active_partition->second.capacity);
-        TENZIR_VERBOSE(
-          "{} flushes active partition {} with {}/{} events", *self, schema,
-          self->state.partition_capacity - active_partition->second.capacity,
-          self->state.partition_capacity);
-        self->state.decommission_active_partition(schema, {});
-        self->state.flush_to_disk();
-        auto part = self->state.create_active_partition(schema);
-        if (!part) {
-          self->quit(caf::make_error(ec::logic_error,
-                                     fmt::format("{} failed to create active "
-                                                 "partition: {}",
-                                                 *self, part.error())));
-          return;
+        TENZIR_ASSERT(active_partition->second.actor);
+        const auto offset
+          = self->state.partition_capacity - active_partition->second.capacity;
+        x.offset(offset);
+        const auto path = paths.find(active_partition->second.stream_slot);
+        TENZIR_ASSERT(path != paths.end());
+        path->second.buf.push_back(x);
+        if (active_partition->second.capacity == self->state.partition_capacity
+            && x.rows() > active_partition->second.capacity) {
+          TENZIR_WARN("{} got table slice with {} rows that exceeds the "
+                      "default partition capacity of {} rows",
+                      *self, x.rows(), self->state.partition_capacity);
+          active_partition->second.capacity = 0;
+        } else {
+          TENZIR_ASSERT(active_partition->second.capacity >= x.rows());
+          active_partition->second.capacity -= x.rows();
         }
-        active_partition = *part;
-      }
-      TENZIR_ASSERT(active_partition->second.actor);
-      const auto offset
-        = self->state.partition_capacity - active_partition->second.capacity;
-      x.offset(offset);
-      out.push(x);
-      if (active_partition->second.capacity == self->state.partition_capacity
-          && x.rows() > active_partition->second.capacity) {
-        TENZIR_WARN("{} got table slice with {} rows that exceeds the "
-                    "default partition capacity of {} rows",
-                    *self, x.rows(), self->state.partition_capacity);
-        active_partition->second.capacity = 0;
-      } else {
-        TENZIR_ASSERT(active_partition->second.capacity >= x.rows());
-        active_partition->second.capacity -= x.rows();
       }
     },
     [self](caf::unit_t&, const caf::error& err) {
@@ -1323,14 +1713,14 @@ index(index_actor::stateful_pointer<index_state> self,
         // importer.
         self->send_exit(self, err);
       }
-      // We gather the schemas first before we call decomission active partition
+      // We gather the keys first before we call decomission active partition
       // on every active partition to avoid iterator invalidation.
-      auto schemas = std::vector<type>{};
-      schemas.reserve(self->state.active_partitions.size());
-      for (const auto& [schema, _] : self->state.active_partitions)
-        schemas.push_back(schema);
-      for (const auto& schema : schemas)
-        self->state.decommission_active_partition(schema, {});
+      auto keys = std::vector<active_partition_key>{};
+      keys.reserve(self->state.active_partitions.size());
+      for (const auto& [key, _] : self->state.active_partitions)
+        keys.push_back(key);
+      for (const auto& key : keys)
+        self->state.decommission_active_partition(key, {});
       // Collect partitions for termination.
       // TODO: We must actor_cast to caf::actor here because 'shutdown' operates
       // on 'std::vector<caf::actor>' only. That should probably be generalized
@@ -1392,6 +1782,19 @@ index(index_actor::stateful_pointer<index_state> self,
     }
     self->state.monitored_queries.erase(it);
   });
+  // Start catalog snapshot loop.
+  if (catalog_snapshot_interval > duration::zero()) {
+    self->state.catalog_snapshot_writer
+      = self->spawn<caf::detached + caf::linked>(
+        catalog_snapshot_writer, self->state.filesystem,
+        self->state.catalog_snapshot_path());
+    detail::weak_run_delayed_loop(
+      self, catalog_snapshot_interval,
+      [self] {
+        self->state.write_catalog_snapshot();
+      },
+      false);
+  }
   // Start metrics loop.
   if (self->state.accountant) {
     self->send(self->state.accountant, atom::announce_v, self->name());
@@ -1599,6 +2002,7 @@ index(index_actor::stateful_pointer<index_state> self,
             TENZIR_DEBUG("{} erased partition {} from catalog", *self,
                          partition_id);
             self->state.persisted_partitions.erase(partition_id);
+            self->state.catalog_snapshot_dirty = true;
             // We don't remove the partition from the queue directly because the
             // query API requires clients to keep track of the number of
             // candidate partitions. Removing the partition from the queue
@@ -1928,6 +2332,7 @@ index(index_actor::stateful_pointer<index_state> self,
                                     self->state.persisted_partitions.emplace(
                                       aps.uuid);
                                   }
+                                  self->state.catalog_snapshot_dirty = true;
                                   self->state.flush_to_disk();
                                   deliver(std::move(result));
                                 },
@@ -1947,6 +2352,7 @@ index(index_actor::stateful_pointer<index_state> self,
                                   self->state.persisted_partitions.emplace(
                                     aps.uuid);
                                 }
+                                self->state.catalog_snapshot_dirty = true;
                                 self->state.flush_to_disk();
                                 self
                                   ->request(static_cast<index_actor>(self),
@@ -1997,15 +2403,15 @@ index(index_actor::stateful_pointer<index_state> self,
         [rp](caf::error error) mutable {
           rp.deliver(std::move(error));
         });
-      // We gather the schemas first before we call decomission active partition
+      // We gather the keys first before we call decomission active partition
       // on every active partition to avoid iterator invalidation.
-      auto schemas = std::vector<type>{};
-      schemas.reserve(self->state.active_partitions.size());
-      for (const auto& [schema, _] : self->state.active_partitions)
-        schemas.push_back(schema);
-      for (const auto& schema : schemas) {
+      auto keys = std::vector<active_partition_key>{};
+      keys.reserve(self->state.active_partitions.size());
+      for (const auto& [key, _] : self->state.active_partitions)
+        keys.push_back(key);
+      for (const auto& key : keys) {
         self->state.decommission_active_partition(
-          schema, [counter](const caf::error& err) mutable {
+          key, [counter](const caf::error& err) mutable {
             if (err)
               counter->receive_error(err);
             else
@@ -0,0 +1,195 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2024 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "tenzir/interval_index.hpp"
+
+#include "tenzir/detail/assert.hpp"
+#include "tenzir/detail/narrow.hpp"
+
+#include <algorithm>
+
+namespace tenzir {
+
+namespace {
+
+template <class Interval>
+auto compare_min(const Interval& lhs, const Interval& rhs) -> bool {
+  return lhs.min < rhs.min;
+}
+
+template <class Interval>
+auto compare_max(const Interval& lhs, const Interval& rhs) -> bool {
+  return lhs.max < rhs.max;
+}
+
+/// Removes the interval *x* from a sequence sorted by *less*.
+template <class Interval, class Less>
+void erase_sorted(std::vector<Interval>& xs, const Interval& x, Less less) {
+  const auto [first, last] = std::equal_range(xs.begin(), xs.end(), x, less);
+  const auto it = std::find_if(first, last, [&](const auto& y) {
+    return y.id == x.id;
+  });
+  TENZIR_ASSERT(it != last);
+  xs.erase(it);
+}
+
+/// Merges the sorted range starting at *mid* into the sorted range before it.
+template <class Interval, class Less>
+void merge_sorted(std::vector<Interval>& xs, size_t mid, Less less) {
+  const auto first = xs.begin() + detail::narrow<ptrdiff_t>(mid);
+  std::stable_sort(first, xs.end(), less);
+  std::inplace_merge(xs.begin(), first, xs.end(), less);
+}
+
+} // namespace
+
+template <class T>
+void basic_interval_index<T>::insert(const uuid& id, T min, T max) {
+  erase(id);
+  // Partitions are usually added in the order of their import time, so the
+  // insertion point is almost always at the end.
+  auto x = interval{min, max, id};
+  by_min_.insert(
+    std::upper_bound(by_min_.begin(), by_min_.end(), x, compare_min<interval>),
+    x);
+  by_max_.insert(
+    std::upper_bound(by_max_.begin(), by_max_.end(), x, compare_max<interval>),
+    x);
+  ranges_.emplace(id, std::pair{min, max});
+}
+
+template <class T>
+void basic_interval_index<T>::insert(std::vector<interval> xs) {
+  if (xs.empty()) {
+    return;
+  }
+  for (const auto& x : xs) {
+    erase(x.id);
+    ranges_.emplace(x.id, std::pair{x.min, x.max});
+  }
+  const auto mid = by_min_.size();
+  by_min_.insert(by_min_.end(), xs.begin(), xs.end());
+  merge_sorted(by_min_, mid, compare_min<interval>);
+  by_max_.insert(by_max_.end(), xs.begin(), xs.end());
+  merge_sorted(by_max_, mid, compare_max<interval>);
+}
+
+template <class T>
+auto basic_interval_index<T>::erase(const uuid& id) -> bool {
+  const auto it = ranges_.find(id);
+  if (it == ranges_.end()) {
+    return false;
+  }
+  const auto x = interval{it->second.first, it->second.second, id};
+  ranges_.erase(it);
+  erase_sorted(by_min_, x, compare_min<interval>);
+  erase_sorted(by_max_, x, compare_max<interval>);
+  return true;
+}
+
+template <class T>
+auto basic_interval_index<T>::lookup(relational_operator op, T x) const
+  -> std::optional<std::vector<uuid>> {
+  auto min_less = [](const interval& lhs, const T& rhs) {
+    return lhs.min < rhs;
+  };
+  auto min_greater = [](const T& lhs, const interval& rhs) {
+    return lhs < rhs.min;
+  };
+  auto max_less = [](const interval& lhs, const T& rhs) {
+    return lhs.max < rhs;
+  };
+  auto max_greater = [](const T& lhs, const interval& rhs) {
+    return lhs < rhs.max;
+  };
+  auto result = std::vector<uuid>{};
+  auto add = [&](auto first, auto last) {
+    result.reserve(std::distance(first, last));
+    for (; first != last; ++first) {
+      result.push_back(first->id);
+    }
+  };
+  // The semantics of the lookup mirror the ones of the `min_max_synopsis`.
+  switch (op) {
+    case relational_operator::less:
+      add(by_min_.begin(), std::lower_bound(by_min_.begin(), by_min_.end(),
+                                            x, min_less));
+      break;
+    case relational_operator::less_equal:
+      add(by_min_.begin(), std::upper_bound(by_min_.begin(), by_min_.end(),
+                                            x, min_greater));
+      break;
+    case relational_operator::greater:
+      add(std::upper_bound(by_max_.begin(), by_max_.end(), x, max_greater),
+          by_max_.end());
+      break;
+    case relational_operator::greater_equal:
+      add(std::lower_bound(by_max_.begin(), by_max_.end(), x, max_less),
+          by_max_.end());
+      break;
+    case relational_operator::equal: {
+      // We need all intervals with `min <= x` and `max >= x`. We can use
+      // either of the sorted sequences for the first condition, so we pick
+      // the one that leaves fewer intervals to check the second condition
+      // for.
+      const auto min_last
+        = std::upper_bound(by_min_.begin(), by_min_.end(), x, min_greater);
+      const auto max_first
+        = std::lower_bound(by_max_.begin(), by_max_.end(), x, max_less);
+      if (min_last - by_min_.begin() < by_max_.end() - max_first) {
+        for (auto it = by_min_.begin(); it != min_last; ++it) {
+          if (it->max >= x) {
+            result.push_back(it->id);
+          }
+        }
+      } else {
+        for (auto it = max_first; it != by_max_.end(); ++it) {
+          if (it->min <= x) {
+            result.push_back(it->id);
+          }
+        }
+      }
+      break;
+    }
+    case relational_operator::not_equal:
+      // An interval can only be ruled out for inequality if it contains just
+      // a single value, which the min-max synopsis does not do either.
+      add(by_min_.begin(), by_min_.end());
+      break;
+    default:
+      return std::nullopt;
+  }
+  std::sort(result.begin(), result.end());
+  return result;
+}
+
+template <class T>
+auto basic_interval_index<T>::size() const -> size_t {
+  return by_min_.size();
+}
+
+template <class T>
+auto basic_interval_index<T>::empty() const -> bool {
+  return by_min_.empty();
+}
+
+template <class T>
+auto basic_interval_index<T>::memusage() const -> size_t {
+  return sizeof(*this)
+         + (by_min_.capacity() + by_max_.capacity()) * sizeof(interval)
+         + ranges_.size() * sizeof(decltype(ranges_)::value_type)
+         + ranges_.bucket_count() * sizeof(void*);
+}
+
+template class basic_interval_index<int64_t>;
+template class basic_interval_index<uint64_t>;
+template class basic_interval_index<double>;
+template class basic_interval_index<duration>;
+template class basic_interval_index<time>;
+
+} // namespace tenzir
@@ -14,6 +14,7 @@
 #include "tenzir/accountant_config.hpp"
 #include "tenzir/atoms.hpp"
 #include "tenzir/data.hpp"
+#include "tenzir/defaults.hpp"
 #include "tenzir/detail/assert.hpp"
 #include "tenzir/execution_node.hpp"
 #include "tenzir/logger.hpp"
@@ -295,8 +296,11 @@ node(node_actor::stateful_pointer<node_state> self, std::string /*name*/,
   // Initialize the accountant.
   auto accountant = spawn_accountant(self);
   // Initialize the file system with the node directory as root.
-  auto fs
-    = self->spawn<caf::detached>(posix_filesystem, self->state.dir, accountant);
+  const auto filesystem_workers
+    = caf::get_or(content(self->system().config()), "tenzir.filesystem-workers",
+                  defaults::filesystem_workers);
+  auto fs = self->spawn<caf::detached>(posix_filesystem, self->state.dir,
+                                       accountant, filesystem_workers);
   auto err
     = register_component(self, caf::actor_cast<caf::actor>(fs), "filesystem");
   TENZIR_ASSERT(err == caf::none); // Registration cannot fail; empty registry.
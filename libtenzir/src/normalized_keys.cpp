@@ -0,0 +1,237 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2024 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "tenzir/normalized_keys.hpp"
+
+#include "tenzir/arrow_table_slice.hpp"
+#include "tenzir/detail/assert.hpp"
+#include "tenzir/detail/byteswap.hpp"
+#include "tenzir/detail/type_traits.hpp"
+#include "tenzir/die.hpp"
+
+#include <arrow/array.h>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace tenzir {
+
+namespace {
+
+/// The marker bytes that precede every value. Null values order either before
+/// or after all other values, regardless of the sort order of the column.
+constexpr auto null_first_marker = char{0x00};
+constexpr auto valid_marker = char{0x01};
+constexpr auto null_last_marker = char{0x02};
+
+constexpr auto sign_bit = uint64_t{1} << 63;
+
+auto write_uint64(uint64_t x, char* out) -> char* {
+  x = detail::to_network_order(x);
+  std::memcpy(out, &x, sizeof(x));
+  return out + sizeof(x);
+}
+
+auto encode_int64(int64_t x) -> uint64_t {
+  return static_cast<uint64_t>(x) ^ sign_bit;
+}
+
+auto encode_double(double x) -> uint64_t {
+  // Negative and positive zero compare equal, and all NaNs order after
+  // positive infinity.
+  if (x == 0.0) {
+    x = 0.0;
+  } else if (std::isnan(x)) {
+    x = std::numeric_limits<double>::quiet_NaN();
+  }
+  const auto bits = std::bit_cast<uint64_t>(x);
+  return (bits & sign_bit) != 0 ? ~bits : bits | sign_bit;
+}
+
+/// Returns the number of bytes that `write_escaped` writes.
+auto escaped_size(std::string_view x) -> size_t {
+  return x.size() + std::count(x.begin(), x.end(), '\0') + 2;
+}
+
+/// Writes a variable-length value such that the byte-wise order of the result
+/// matches the byte-wise order of the value: zero bytes become `00 FF`, and the
+/// value ends with `00 00`, which orders before any escaped byte.
+auto write_escaped(std::string_view x, char* out) -> char* {
+  for (auto c : x) {
+    *out++ = c;
+    if (c == '\0') {
+      *out++ = '\xff';
+    }
+  }
+  *out++ = '\0';
+  *out++ = '\0';
+  return out;
+}
+
+/// Encodes the valid values of a column of a single type.
+template <concrete_type Type>
+class value_encoder {
+public:
+  value_encoder(const Type& type, const arrow::Array& array)
+    : type_{type}, array_{array} {
+  }
+
+  /// Returns the number of bytes that encode the value at a row.
+  auto size([[maybe_unused]] int64_t row) const -> size_t {
+    if constexpr (std::is_same_v<Type, null_type>) {
+      return 0;
+    } else if constexpr (std::is_same_v<Type, bool_type>) {
+      return 1;
+    } else if constexpr (std::is_same_v<Type, ip_type>) {
+      return 16;
+    } else if constexpr (std::is_same_v<Type, subnet_type>) {
+      return 17;
+    } else if constexpr (std::is_same_v<Type, string_type>
+                         or std::is_same_v<Type, blob_type>
+                         or std::is_same_v<Type, enumeration_type>) {
+      return escaped_size(view(row));
+    } else {
+      return 8;
+    }
+  }
+
+  /// Writes the value at a row, and returns the end of the written bytes.
+  auto write(int64_t row, char* out) const -> char* {
+    if constexpr (std::is_same_v<Type, null_type>) {
+      return out;
+    } else if constexpr (std::is_same_v<Type, bool_type>) {
+      *out = typed_array().Value(row) ? char{1} : char{0};
+      return out + 1;
+    } else if constexpr (std::is_same_v<Type, int64_type>
+                         or std::is_same_v<Type, duration_type>
+                         or std::is_same_v<Type, time_type>) {
+      return write_uint64(encode_int64(typed_array().Value(row)), out);
+    } else if constexpr (std::is_same_v<Type, uint64_type>) {
+      return write_uint64(typed_array().Value(row), out);
+    } else if constexpr (std::is_same_v<Type, double_type>) {
+      return write_uint64(encode_double(typed_array().Value(row)), out);
+    } else if constexpr (std::is_same_v<Type, ip_type>) {
+      const auto& storage = static_cast<const arrow::FixedSizeBinaryArray&>(
+        *typed_array().storage());
+      std::memcpy(out, storage.GetValue(row), 16);
+      return out + 16;
+    } else if constexpr (std::is_same_v<Type, subnet_type>) {
+      const auto value = value_at(type_, array_, row);
+      const auto bytes = as_bytes(value.network());
+      std::memcpy(out, bytes.data(), bytes.size());
+      out[16] = static_cast<char>(value.length());
+      return out + 17;
+    } else if constexpr (std::is_same_v<Type, string_type>
+                         or std::is_same_v<Type, blob_type>
+                         or std::is_same_v<Type, enumeration_type>) {
+      return write_escaped(view(row), out);
+    } else {
+      static_assert(detail::always_false_v<Type>, "unsupported key type");
+    }
+  }
+
+private:
+  auto typed_array() const -> const type_to_arrow_array_t<Type>& {
+    return static_cast<const type_to_arrow_array_t<Type>&>(array_);
+  }
+
+  /// Returns the bytes of a variable-length value. Enumerations order by the
+  /// names of their fields.
+  auto view(int64_t row) const -> std::string_view {
+    if constexpr (std::is_same_v<Type, enumeration_type>) {
+      return type_.field(value_at(type_, array_, row));
+    } else {
+      const auto result = typed_array().GetView(row);
+      return {reinterpret_cast<const char*>(result.data()), result.size()};
+    }
+  }
+
+  const Type& type_;
+  const arrow::Array& array_;
+};
+
+/// Calls `f` with the encoder for a column.
+/// @pre `normalized_keys::is_supported(column.type)`
+auto visit_encoder(const normalized_key_column& column, auto&& f) -> void {
+  caf::visit(
+    [&]<concrete_type Type>(const Type& type) {
+      if constexpr (std::is_same_v<Type, list_type>
+                    or std::is_same_v<Type, map_type>
+                    or std::is_same_v<Type, record_type>) {
+        die(fmt::format("unsupported normalized key type: {}", column.type));
+      } else {
+        f(value_encoder<Type>{type, *column.array});
+      }
+    },
+    column.type);
+}
+
+} // namespace
+
+auto normalized_keys::make(std::span<const normalized_key_column> columns,
+                           int64_t rows) -> normalized_keys {
+  auto result = normalized_keys{};
+  // We encode the keys column by column. The first pass computes the size of
+  // every key, which lets the second pass write every column directly to its
+  // final position.
+  result.offsets_.resize(rows + 1, 0);
+  for (const auto& column : columns) {
+    TENZIR_ASSERT(column.array->length() == rows);
+    visit_encoder(column, [&](const auto& encoder) {
+      for (auto row = int64_t{0}; row < rows; ++row) {
+        result.offsets_[row + 1] += 1;
+        if (column.array->IsValid(row)) {
+          result.offsets_[row + 1] += encoder.size(row);
+        }
+      }
+    });
+  }
+  for (auto row = int64_t{0}; row < rows; ++row) {
+    result.offsets_[row + 1] += result.offsets_[row];
+  }
+  result.bytes_.resize(result.offsets_.back());
+  auto cursors = std::vector<size_t>(result.offsets_.begin(),
+                                     result.offsets_.end() - 1);
+  for (const auto& column : columns) {
+    visit_encoder(column, [&](const auto& encoder) {
+      for (auto row = int64_t{0}; row < rows; ++row) {
+        auto* out = result.bytes_.data() + cursors[row];
+        if (column.array->IsNull(row)) {
+          *out = column.nulls_first ? null_first_marker : null_last_marker;
+          cursors[row] += 1;
+          continue;
+        }
+        *out++ = valid_marker;
+        auto* end = encoder.write(row, out);
+        if (column.descending) {
+          std::transform(out, end, out, [](char c) {
+            return static_cast<char>(~c);
+          });
+        }
+        cursors[row] = end - result.bytes_.data();
+      }
+    });
+  }
+  return result;
+}
+
+auto normalized_keys::is_supported(const type& type) -> bool {
+  return not caf::holds_alternative<list_type>(type)
+         and not caf::holds_alternative<map_type>(type)
+         and not caf::holds_alternative<record_type>(type);
+}
+
+auto normalized_keys::memusage() const -> size_t {
+  return sizeof(*this) + bytes_.capacity()
+         + offsets_.capacity() * sizeof(size_t);
+}
+
+} // namespace tenzir
@@ -66,6 +66,10 @@ public:
     TENZIR_UNIMPLEMENTED();
   }
 
+  auto make_waker() noexcept -> std::function<void()> override {
+    TENZIR_UNIMPLEMENTED();
+  }
+
 private:
   caf::error error_{};
   std::unique_ptr<diagnostic_handler> handler_{};
@@ -148,7 +152,7 @@ auto pipeline::optimize_if_closed() const -> pipeline {
   if (not is_closed()) {
     return *this;
   }
-  auto [filter, pipe] = optimize_into_filter();
+  auto [filter, optimized] = optimize_into_filter();
   if (filter != trivially_true_expression()) {
     // This could also be an assertion as it always points to an error in the
     // operator implementation, but we try to continue with the original
@@ -157,6 +161,13 @@ auto pipeline::optimize_if_closed() const -> pipeline {
                  *this, filter);
     return *this;
   }
+  // The projection runs after the filter optimization because that may merge
+  // operators into the source, which would otherwise act as a barrier.
+  auto projected = optimized.optimize_projection(std::nullopt);
+  auto* projected_pipe = dynamic_cast<pipeline*>(projected.replacement.get());
+  // We know that `pipeline::optimize_projection` yields a pipeline.
+  TENZIR_ASSERT(projected_pipe);
+  auto pipe = std::move(*projected_pipe);
   auto out = pipe.infer_type<void>();
   if (not out) {
     TENZIR_ERROR("closed pipeline was optimized into invalid pipeline: {}",
@@ -168,7 +179,7 @@ auto pipeline::optimize_if_closed() const -> pipeline {
                  operator_type_name(*out));
     return *this;
   }
-  return std::move(pipe);
+  return pipe;
 }
 
 auto pipeline::optimize_into_filter() const -> std::pair<expression, pipeline> {
@@ -191,9 +202,16 @@ auto pipeline::optimize(expression const& filter, event_order order) const
   auto current_order = order;
   // Collect the optimized pipeline in reversed order.
   auto result = std::vector<operator_ptr>{};
+  auto downstream_limit = std::optional<uint64_t>{};
   for (auto it = operators_.rbegin(); it != operators_.rend(); ++it) {
     TENZIR_ASSERT(*it);
-    auto const& op = **it;
+    // Operators may make use of the fact that their direct successor only
+    // forwards a prefix of their output, e.g., `sort | head` only needs to
+    // keep the first events.
+    auto fused = downstream_limit ? (*it)->with_event_limit(*downstream_limit)
+                                  : operator_ptr{};
+    auto const& op = fused ? *fused : **it;
+    downstream_limit = op.event_limit();
     auto opt = op.optimize(current_filter, current_order);
     if (opt.filter) {
       current_filter = std::move(*opt.filter);
@@ -217,6 +235,24 @@ auto pipeline::optimize(expression const& filter, event_order order) const
                          std::make_unique<pipeline>(std::move(result))};
 }
 
+auto pipeline::optimize_projection(
+  const std::optional<std::vector<std::string>>& fields) const
+  -> projection_result {
+  auto current_fields = fields;
+  // Collect the optimized pipeline in reversed order.
+  auto result = std::vector<operator_ptr>{};
+  for (auto it = operators_.rbegin(); it != operators_.rend(); ++it) {
+    TENZIR_ASSERT(*it);
+    auto opt = (*it)->optimize_projection(current_fields);
+    TENZIR_ASSERT(opt.replacement);
+    result.push_back(std::move(opt.replacement));
+    current_fields = std::move(opt.fields);
+  }
+  std::reverse(result.begin(), result.end());
+  return projection_result{std::move(current_fields),
+                           std::make_unique<pipeline>(std::move(result))};
+}
+
 auto pipeline::copy() const -> operator_ptr {
   auto copied = std::make_unique<pipeline>();
   copied->operators_.reserve(operators_.size());
@@ -293,6 +329,13 @@ auto operator_base::copy() const -> operator_ptr {
   return copy;
 }
 
+auto operator_base::optimize_projection(
+  const std::optional<std::vector<std::string>>& fields) const
+  -> projection_result {
+  (void)fields;
+  return projection_result{std::nullopt, copy()};
+}
+
 auto operator_base::infer_signature() const -> operator_signature {
   const auto void_output = infer_type<void>();
   const auto bytes_output = infer_type<chunk_ptr>();
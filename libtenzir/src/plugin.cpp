@@ -8,6 +8,7 @@
 
 #include "tenzir/plugin.hpp"
 
+#include "tenzir/aggregation_function.hpp"
 #include "tenzir/arrow_table_slice.hpp"
 #include "tenzir/chunk.hpp"
 #include "tenzir/collect.hpp"
@@ -419,6 +420,18 @@ auto saver_parser_plugin::supported_uri_schemes() const
   return {this->name()};
 }
 
+// -- aggregation function plugin ---------------------------------------------
+
+caf::expected<std::unique_ptr<aggregation_function>>
+aggregation_function_plugin::make_aggregation_function_with_argument(
+  const type& input_type, const data& argument) const {
+  (void)input_type;
+  return caf::make_error(ec::invalid_argument,
+                         fmt::format("aggregation function `{}` does not "
+                                     "accept an argument, but got `{}`",
+                                     name(), argument));
+}
+
 // -- store plugin -------------------------------------------------------------
 
 caf::expected<store_actor_plugin::builder_and_header>
@@ -9,6 +9,7 @@
 #include "tenzir/posix_filesystem.hpp"
 
 #include "tenzir/chunk.hpp"
+#include "tenzir/detail/assert.hpp"
 #include "tenzir/detail/weak_run_delayed.hpp"
 #include "tenzir/io/read.hpp"
 #include "tenzir/io/save.hpp"
@@ -22,34 +23,225 @@
 #include <caf/settings.hpp>
 
 #include <filesystem>
+#include <thread>
 
 namespace tenzir {
 
-caf::expected<atom::done>
-posix_filesystem_state::rename_single_file(const std::filesystem::path& from,
-                                           const std::filesystem::path& to) {
+namespace {
+
+auto resolve(const std::filesystem::path& root,
+             const std::filesystem::path& filename) -> std::filesystem::path {
+  return filename.is_absolute() ? filename : root / filename;
+}
+
+// The blocking filesystem operations are free functions so that both the
+// workers and the filesystem itself can execute them.
+
+auto write_file(const std::filesystem::path& root,
+                shared_filesystem_statistics& stats,
+                const std::filesystem::path& filename, const chunk_ptr& chk)
+  -> caf::expected<atom::ok> {
+  const auto path = resolve(root, filename);
+  if (chk == nullptr)
+    return caf::make_error(ec::invalid_argument,
+                           fmt::format("tried to write a nullptr to {}", path));
+  if (auto err = io::save(path, as_bytes(chk))) {
+    stats.update([](auto& x) {
+      ++x.writes.failed;
+    });
+    return err;
+  }
+  stats.update([&](auto& x) {
+    ++x.writes.successful;
+    x.writes.bytes += chk->size();
+  });
+  return atom::ok_v;
+}
+
+auto read_file(const std::filesystem::path& root,
+               shared_filesystem_statistics& stats,
+               const std::filesystem::path& filename)
+  -> caf::expected<chunk_ptr> {
+  const auto path = resolve(root, filename);
+  std::error_code err;
+  if (!std::filesystem::exists(path, err)) {
+    stats.update([](auto& x) {
+      ++x.checks.failed;
+    });
+    return caf::make_error(ec::no_such_file,
+                           fmt::format("no such file: {}", path));
+  }
+  auto bytes = io::read(path);
+  stats.update([&](auto& x) {
+    ++x.checks.successful;
+    if (bytes) {
+      ++x.reads.successful;
+      x.reads.bytes += bytes->size();
+    } else {
+      ++x.reads.failed;
+    }
+  });
+  if (!bytes)
+    return std::move(bytes.error());
+  return chunk::make(std::move(*bytes));
+}
+
+auto mmap_file(const std::filesystem::path& root,
+               shared_filesystem_statistics& stats,
+               const std::filesystem::path& filename)
+  -> caf::expected<chunk_ptr> {
+  const auto path = resolve(root, filename);
+  std::error_code err;
+  if (!std::filesystem::exists(path, err)) {
+    stats.update([](auto& x) {
+      ++x.checks.failed;
+    });
+    return caf::make_error(ec::no_such_file,
+                           fmt::format("{}: {}", path, err.message()));
+  }
+  auto chk = chunk::mmap(path);
+  stats.update([&](auto& x) {
+    ++x.checks.successful;
+    if (chk) {
+      ++x.mmaps.successful;
+      x.mmaps.bytes += chk->get()->size();
+    } else {
+      ++x.mmaps.failed;
+    }
+  });
+  return chk;
+}
+
+auto erase_file(const std::filesystem::path& root,
+                shared_filesystem_statistics& stats,
+                const std::filesystem::path& filename)
+  -> caf::expected<atom::done> {
+  const auto path = resolve(root, filename);
+  std::error_code err;
+  auto size = std::filesystem::file_size(path, err);
+  if (err) {
+    stats.update([](auto& x) {
+      ++x.checks.failed;
+    });
+    return caf::make_error(ec::no_such_file,
+                           fmt::format("failed to erase {}: {}", path,
+                                       err.message()));
+  }
+  std::filesystem::remove_all(path, err);
+  stats.update([&](auto& x) {
+    ++x.checks.successful;
+    if (err) {
+      ++x.erases.failed;
+    } else {
+      ++x.erases.successful;
+      x.erases.bytes += size;
+    }
+  });
+  if (err)
+    return caf::make_error(ec::system_error,
+                           fmt::format("failed to erase {}: {}", path,
+                                       err.message()));
+  return atom::done_v;
+}
+
+auto move_file(const std::filesystem::path& root,
+               shared_filesystem_statistics& stats,
+               const std::filesystem::path& from,
+               const std::filesystem::path& to) -> caf::expected<atom::done> {
   const auto from_absolute = root / from;
   const auto to_absolute = root / to;
   if (from_absolute == to_absolute)
     return atom::done_v;
   std::error_code err;
-  std::filesystem::rename(from, to, err);
+  std::filesystem::rename(from_absolute, to_absolute, err);
   if (err) {
-    ++stats.moves.failed;
+    stats.update([](auto& x) {
+      ++x.moves.failed;
+    });
     return caf::make_error(ec::system_error,
                            fmt::format("failed to move {} to {}: {}", from, to,
                                        err.message()));
   }
-  ++stats.moves.successful;
+  stats.update([](auto& x) {
+    ++x.moves.successful;
+  });
   return atom::done_v;
 }
 
+auto move_files(
+  const std::filesystem::path& root, shared_filesystem_statistics& stats,
+  const std::vector<std::pair<std::filesystem::path, std::filesystem::path>>&
+    files) -> caf::expected<atom::done> {
+  for (const auto& [from, to] : files) {
+    auto result = move_file(root, stats, from, to);
+    if (!result)
+      return result.error();
+  }
+  return atom::done_v;
+}
+
+} // namespace
+
+auto posix_filesystem_state::worker_for(const std::filesystem::path& path) const
+  -> const filesystem_actor& {
+  TENZIR_ASSERT(!workers.empty());
+  const auto hash = std::filesystem::hash_value(resolve(root, path));
+  return workers[hash % workers.size()];
+}
+
+filesystem_actor::behavior_type posix_filesystem_worker(
+  filesystem_actor::stateful_pointer<posix_filesystem_worker_state> self,
+  std::filesystem::path root,
+  std::shared_ptr<shared_filesystem_statistics> stats) {
+  if (self->getf(caf::local_actor::is_detached_flag))
+    caf::detail::set_thread_name("tenzir.posix-filesystem-worker");
+  self->state.root = std::move(root);
+  self->state.stats = std::move(stats);
+  return {
+    [self](atom::write, const std::filesystem::path& filename,
+           const chunk_ptr& chk) -> caf::result<atom::ok> {
+      return write_file(self->state.root, *self->state.stats, filename, chk);
+    },
+    [self](atom::read,
+           const std::filesystem::path& filename) -> caf::result<chunk_ptr> {
+      return read_file(self->state.root, *self->state.stats, filename);
+    },
+    [self](atom::move, const std::filesystem::path& from,
+           const std::filesystem::path& to) -> caf::result<atom::done> {
+      return move_file(self->state.root, *self->state.stats, from, to);
+    },
+    [self](
+      atom::move,
+      const std::vector<std::pair<std::filesystem::path, std::filesystem::path>>&
+        files) -> caf::result<atom::done> {
+      return move_files(self->state.root, *self->state.stats, files);
+    },
+    [self](atom::mmap,
+           const std::filesystem::path& filename) -> caf::result<chunk_ptr> {
+      return mmap_file(self->state.root, *self->state.stats, filename);
+    },
+    [self](atom::erase,
+           const std::filesystem::path& filename) -> caf::result<atom::done> {
+      return erase_file(self->state.root, *self->state.stats, filename);
+    },
+    [](atom::status, status_verbosity, duration) {
+      // The POSIX filesystem reports the status for all of its workers.
+      return record{};
+    },
+  };
+}
+
 filesystem_actor::behavior_type posix_filesystem(
   filesystem_actor::stateful_pointer<posix_filesystem_state> self,
-  std::filesystem::path root, const accountant_actor& accountant) {
+  std::filesystem::path root, const accountant_actor& accountant,
+  size_t num_workers) {
   if (self->getf(caf::local_actor::is_detached_flag))
     caf::detail::set_thread_name("tenzir.posix-filesystem");
   self->state.root = std::move(root);
+  self->state.stats = std::make_shared<shared_filesystem_statistics>();
+  for (size_t i = 0; i < num_workers; ++i)
+    self->state.workers.push_back(self->spawn<caf::detached + caf::linked>(
+      posix_filesystem_worker, self->state.root, self->state.stats));
   if (accountant) {
     self->state.accountant = accountant;
     self->send(accountant, atom::announce_v, self->name());
@@ -57,24 +249,25 @@ filesystem_actor::behavior_type posix_filesystem(
       auto accountant = self->state.accountant.lock();
       if (!accountant)
         return;
+      const auto stats = self->state.stats->get();
       auto msg = report{
           .data = {
-            {"posix-filesystem.checks.sucessful", self->state.stats.checks.successful},
-            {"posix-filesystem.checks.failed", self->state.stats.checks.failed},
-            {"posix-filesystem.writes.sucessful", self->state.stats.writes.successful},
-            {"posix-filesystem.writes.failed", self->state.stats.writes.failed},
-            {"posix-filesystem.writes.bytes", self->state.stats.writes.bytes},
-            {"posix-filesystem.reads.sucessful", self->state.stats.reads.successful},
-            {"posix-filesystem.reads.failed", self->state.stats.reads.failed},
-            {"posix-filesystem.reads.bytes", self->state.stats.reads.bytes},
-            {"posix-filesystem.mmaps.sucessful", self->state.stats.mmaps.successful},
-            {"posix-filesystem.mmaps.failed", self->state.stats.mmaps.failed},
-            {"posix-filesystem.mmaps.bytes", self->state.stats.mmaps.bytes},
-            {"posix-filesystem.erases.sucessful", self->state.stats.erases.successful},
-            {"posix-filesystem.erases.failed", self->state.stats.erases.failed},
-            {"posix-filesystem.erases.bytes", self->state.stats.erases.bytes},
-            {"posix-filesystem.moves.sucessful", self->state.stats.moves.successful},
-            {"posix-filesystem.moves.failed", self->state.stats.moves.failed},
+            {"posix-filesystem.checks.sucessful", stats.checks.successful},
+            {"posix-filesystem.checks.failed", stats.checks.failed},
+            {"posix-filesystem.writes.sucessful", stats.writes.successful},
+            {"posix-filesystem.writes.failed", stats.writes.failed},
+            {"posix-filesystem.writes.bytes", stats.writes.bytes},
+            {"posix-filesystem.reads.sucessful", stats.reads.successful},
+            {"posix-filesystem.reads.failed", stats.reads.failed},
+            {"posix-filesystem.reads.bytes", stats.reads.bytes},
+            {"posix-filesystem.mmaps.sucessful", stats.mmaps.successful},
+            {"posix-filesystem.mmaps.failed", stats.mmaps.failed},
+            {"posix-filesystem.mmaps.bytes", stats.mmaps.bytes},
+            {"posix-filesystem.erases.sucessful", stats.erases.successful},
+            {"posix-filesystem.erases.failed", stats.erases.failed},
+            {"posix-filesystem.erases.bytes", stats.erases.bytes},
+            {"posix-filesystem.moves.sucessful", stats.moves.successful},
+            {"posix-filesystem.moves.failed", stats.moves.failed},
           },
           .metadata = {},
         };
@@ -84,109 +277,54 @@ filesystem_actor::behavior_type posix_filesystem(
   return {
     [self](atom::write, const std::filesystem::path& filename,
            const chunk_ptr& chk) -> caf::result<atom::ok> {
-      const auto path
-        = filename.is_absolute() ? filename : self->state.root / filename;
-      if (chk == nullptr)
-        return caf::make_error(ec::invalid_argument,
-                               fmt::format("{} tried to write a nullptr to {}",
-                                           *self, path));
-      if (auto err = io::save(path, as_bytes(chk))) {
-        ++self->state.stats.writes.failed;
-        return err;
-      }
-      ++self->state.stats.writes.successful;
-      self->state.stats.writes.bytes += chk->size();
-      return atom::ok_v;
+      if (self->state.workers.empty())
+        return write_file(self->state.root, *self->state.stats, filename, chk);
+      return self->delegate(self->state.worker_for(filename), atom::write_v,
+                            filename, chk);
     },
     [self](atom::read,
            const std::filesystem::path& filename) -> caf::result<chunk_ptr> {
-      const auto path
-        = filename.is_absolute() ? filename : self->state.root / filename;
-      std::error_code err;
-      if (std::filesystem::exists(path, err)) {
-        ++self->state.stats.checks.successful;
-      } else {
-        ++self->state.stats.checks.failed;
-        return caf::make_error(ec::no_such_file,
-                               fmt::format("{} no such file: {}", *self, path));
-      }
-      if (auto bytes = io::read(path)) {
-        ++self->state.stats.reads.successful;
-        self->state.stats.reads.bytes += bytes->size();
-        return chunk::make(std::move(*bytes));
-      } else {
-        ++self->state.stats.reads.failed;
-        return bytes.error();
-      }
+      if (self->state.workers.empty())
+        return read_file(self->state.root, *self->state.stats, filename);
+      return self->delegate(self->state.worker_for(filename), atom::read_v,
+                            filename);
     },
+    // Moves touch two paths that may belong to different workers, so the
+    // filesystem executes them itself. Renames only change metadata and do not
+    // block for long.
     [self](atom::move, const std::filesystem::path& from,
            const std::filesystem::path& to) -> caf::result<atom::done> {
-      return self->state.rename_single_file(from, to);
+      return move_file(self->state.root, *self->state.stats, from, to);
     },
     [self](
       atom::move,
       const std::vector<std::pair<std::filesystem::path, std::filesystem::path>>&
         files) -> caf::result<atom::done> {
-      std::error_code err;
-      for (const auto& [from, to] : files) {
-        auto result = self->state.rename_single_file(from, to);
-        if (!result)
-          return result.error();
-      }
-      return atom::done_v;
+      return move_files(self->state.root, *self->state.stats, files);
     },
     [self](atom::mmap,
            const std::filesystem::path& filename) -> caf::result<chunk_ptr> {
-      const auto path
-        = filename.is_absolute() ? filename : self->state.root / filename;
-      std::error_code err;
-      if (std::filesystem::exists(path, err)) {
-        ++self->state.stats.checks.successful;
-      } else {
-        ++self->state.stats.checks.failed;
-        return caf::make_error(ec::no_such_file,
-                               fmt::format("{} {}: {}", *self, path,
-                                           err.message()));
-      }
-      if (auto chk = chunk::mmap(path)) {
-        ++self->state.stats.mmaps.successful;
-        self->state.stats.mmaps.bytes += chk->get()->size();
-        return chk;
-      } else {
-        ++self->state.stats.mmaps.failed;
-        return chk.error();
-      }
+      if (self->state.workers.empty())
+        return mmap_file(self->state.root, *self->state.stats, filename);
+      return self->delegate(self->state.worker_for(filename), atom::mmap_v,
+                            filename);
     },
     [self](atom::erase,
            const std::filesystem::path& filename) -> caf::result<atom::done> {
       TENZIR_DEBUG("{} got request to erase {}", *self, filename);
-      const auto path
-        = filename.is_absolute() ? filename : self->state.root / filename;
-      std::error_code err;
-      auto size = std::filesystem::file_size(path, err);
-      if (err) {
-        ++self->state.stats.checks.failed;
-        return caf::make_error(ec::no_such_file,
-                               fmt::format("{} failed to erase {}: {}", *self,
-                                           path, err.message()));
-      }
-      ++self->state.stats.checks.successful;
-      std::filesystem::remove_all(path, err);
-      if (err) {
-        ++self->state.stats.erases.failed;
-        return caf::make_error(ec::system_error,
-                               fmt::format("{} failed to erase {}: {}", *self,
-                                           path, err.message()));
-      }
-      ++self->state.stats.erases.successful;
-      self->state.stats.erases.bytes += size;
-      return atom::done_v;
+      if (self->state.workers.empty())
+        return erase_file(self->state.root, *self->state.stats, filename);
+      return self->delegate(self->state.worker_for(filename), atom::erase_v,
+                            filename);
     },
     [self](atom::status, status_verbosity v, duration) {
       auto result = record{};
       if (v >= status_verbosity::info)
         result["type"] = "POSIX";
+      if (v >= status_verbosity::detailed)
+        result["workers"] = uint64_t{self->state.workers.size()};
       if (v >= status_verbosity::debug) {
+        const auto current = self->state.stats->get();
         auto ops = record{};
         auto add_stats = [&](auto& name, auto& stats) {
           auto dict = record{};
@@ -195,13 +333,13 @@ filesystem_actor::behavior_type posix_filesystem(
           dict["bytes"] = uint64_t{stats.bytes};
           ops[name] = std::move(dict);
         };
-        add_stats("checks", self->state.stats.checks);
-        add_stats("writes", self->state.stats.writes);
-        add_stats("reads", self->state.stats.reads);
-        add_stats("mmaps", self->state.stats.mmaps);
+        add_stats("checks", current.checks);
+        add_stats("writes", current.writes);
+        add_stats("reads", current.reads);
+        add_stats("mmaps", current.mmaps);
         // TODO: this should be called "deletes" or "erasures".
-        add_stats("erases", self->state.stats.erases);
-        add_stats("moves", self->state.stats.moves);
+        add_stats("erases", current.erases);
+        add_stats("moves", current.moves);
         result["operations"] = std::move(ops);
       }
       return result;
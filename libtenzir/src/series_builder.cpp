@@ -738,6 +738,7 @@ public:
 
   auto append() -> record_ref {
     length_ += 1;
+    shape_cursor_ = 0;
     return record_ref{this};
   }
 
@@ -772,6 +773,9 @@ public:
       }
       if (remove) {
         TENZIR_TRACE("removing field `{}`", name);
+        // The shape may refer to the removed builder.
+        shape_.clear();
+        shape_cursor_ = 0;
         it = fields_.erase(it);
       } else {
         ++it;
@@ -860,13 +864,12 @@ public:
   auto prepare(std::string_view name) -> detail::typed_builder<Type>* {
     static_assert(not std::same_as<Type, null_type>);
     static_assert(not std::same_as<Type, enumeration_type>);
-    auto it = fields_.find(name);
-    if (it == fields_.end()) {
-      auto* builder = insert_new_field(std::string{name});
+    auto* builder = this->builder(name);
+    if (not builder) {
+      builder = insert_new_field(std::string{name});
       builder->resize(length_ - 1);
       return builder->prepare<Type>();
     }
-    auto* builder = it->second.get();
     builder->resize(length_ - 1);
     // We temporarily force the field to stay alive. This is because, in the
     // event of a type conflict, the builder will finish the previous events. At
@@ -889,6 +892,7 @@ public:
       inserted,
       fmt::format("tried to insert field `{}`, but it already exists", name)
         .c_str());
+    remember_shape(it->first, it->second.get());
     return it->second.get();
   }
 
@@ -903,13 +907,36 @@ private:
   }
 
   auto builder(std::string_view name) -> dynamic_builder* {
+    // Consecutive records mostly have the same fields in the same order, so we
+    // first check whether the field is the one that followed the previous
+    // field in an earlier record, or the previous field itself.
+    if (shape_cursor_ < shape_.size()
+        and shape_[shape_cursor_].first == name) {
+      return shape_[shape_cursor_++].second;
+    }
+    if (shape_cursor_ > 0 and shape_[shape_cursor_ - 1].first == name) {
+      return shape_[shape_cursor_ - 1].second;
+    }
     auto it = fields_.find(name);
     if (it == fields_.end()) {
       return nullptr;
     }
+    remember_shape(it->first, it->second.get());
     return it->second.get();
   }
 
+  /// Records that the field follows the previous field of the current record.
+  void remember_shape(std::string_view name, dynamic_builder* builder) {
+    if (shape_cursor_ < shape_.size()) {
+      auto& [shape_name, shape_builder] = shape_[shape_cursor_];
+      shape_name.assign(name);
+      shape_builder = builder;
+    } else {
+      shape_.emplace_back(std::string{name}, builder);
+    }
+    shape_cursor_ += 1;
+  }
+
   /// Missing values in fields shall be considered null.
   ///
   /// We have to use `unique_ptr` here because a type conflict might occur in
@@ -927,6 +954,14 @@ private:
   /// Used to keep a field builder alive during conflict flushing.
   dynamic_builder* keep_alive_ = nullptr;
 
+  /// The fields in the order in which they were accessed by recent records,
+  /// which lets us skip the map lookup for records of the same shape.
+  std::vector<std::pair<std::string, dynamic_builder*>> shape_;
+
+  /// The position of the next expected field of the current record in
+  /// `shape_`.
+  size_t shape_cursor_ = 0;
+
   series_builder_impl* root_;
 };
 
@@ -56,9 +56,12 @@ spawn_index(node_actor::stateful_pointer<node_state> self,
   auto handle = self->spawn<caf::detached>(
     index, accountant, filesystem, catalog, indexdir,
     // TODO: Pass these options as a tenzir::data object instead.
-    std::string{sd::store_backend},
+    opt("tenzir.store-backend", std::string{sd::store_backend}),
     opt("tenzir.max-partition-size", sd::max_partition_size),
     opt("tenzir.active-partition-timeout", sd::active_partition_timeout),
+    opt("tenzir.catalog-snapshot-interval", sd::catalog_snapshot_interval),
+    opt("tenzir.ingest-shards", sd::ingest_shards),
+    opt("tenzir.ingest-shard-key", std::string{}),
     opt("tenzir.max-resident-partitions", sd::max_in_mem_partitions),
     opt("tenzir.max-taste-partitions", sd::taste_partitions),
     opt("tenzir.max-queries", sd::num_query_supervisors),
@@ -8,9 +8,12 @@
 
 #include "tenzir/store.hpp"
 
+#include "tenzir/arrow_table_slice.hpp"
 #include "tenzir/atoms.hpp"
 #include "tenzir/detail/narrow.hpp"
 #include "tenzir/error.hpp"
+#include "tenzir/evaluate.hpp"
+#include "tenzir/expression.hpp"
 #include "tenzir/ids.hpp"
 #include "tenzir/query_context.hpp"
 #include "tenzir/report.hpp"
@@ -67,8 +70,8 @@ handle_query(const auto& self, const query_context& query_context) {
                                        *self, query_context.id)));
         return;
       }
-      state->second.result_generator
-        = self->state.store->extract(*tailored_expr, query_context.ids);
+      state->second.result_generator = self->state.store->extract(
+        *tailored_expr, query_context.ids, extract.fields);
       state->second.result_iterator = state->second.result_generator.begin();
       state->second.sink = extract.sink;
       state->second.start = start;
@@ -157,13 +160,97 @@ generator<uint64_t> base_store::count(expression expr, ids selection) const {
 }
 
 generator<table_slice>
-base_store::extract(expression expr, ids selection) const {
+base_store::extract(expression expr, ids selection,
+                    std::optional<std::vector<std::string>> fields) const {
+  auto columns = std::optional<std::vector<offset>>{};
+  auto programs = evaluation_program_cache{std::move(expr)};
   for (const auto& slice : slices()) {
-    if (auto filtered_slice = filter(slice, expr, selection))
-      co_yield std::move(*filtered_slice);
+    const auto* program = programs.get(slice.schema());
+    if (not program) {
+      continue;
+    }
+    auto filtered_slice = filter(slice, *program, selection);
+    if (not filtered_slice) {
+      continue;
+    }
+    if (fields) {
+      if (not columns) {
+        columns = project_columns(slice.schema(), *fields);
+      }
+      // We must not drop events entirely, so we keep all columns if none of
+      // the fields exist in the schema.
+      if (not columns->empty()) {
+        *filtered_slice = select_columns(*filtered_slice, *columns);
+      }
+    }
+    co_yield std::move(*filtered_slice);
   }
 }
 
+auto project_columns(const type& schema, const std::vector<std::string>& fields)
+  -> std::vector<offset> {
+  auto result = std::vector<offset>{};
+  for (const auto& field : fields) {
+    for (auto index : schema.resolve(field)) {
+      TENZIR_ASSERT(not index.empty());
+      result.push_back(offset{index[0]});
+    }
+  }
+  std::sort(result.begin(), result.end());
+  result.erase(std::unique(result.begin(), result.end()), result.end());
+  return result;
+}
+
+auto expression_columns(const type& schema, const expression& expr)
+  -> std::vector<offset> {
+  const auto& layout = caf::get<record_type>(schema);
+  auto result = std::vector<offset>{};
+  const auto add = [&](const operand& x) {
+    if (const auto* extractor = caf::get_if<data_extractor>(&x)) {
+      const auto index = layout.resolve_flat_index(extractor->column);
+      TENZIR_ASSERT(not index.empty());
+      result.push_back(offset{index[0]});
+    }
+  };
+  for_each_predicate(expr, [&](const predicate& pred) -> expression {
+    add(pred.lhs);
+    add(pred.rhs);
+    return expression{pred};
+  });
+  std::sort(result.begin(), result.end());
+  result.erase(std::unique(result.begin(), result.end()), result.end());
+  return result;
+}
+
+auto project_offset(offset index, const std::vector<int>& included) -> offset {
+  TENZIR_ASSERT(not index.empty());
+  const auto field = detail::narrow_cast<int>(index[0]);
+  const auto it = std::lower_bound(included.begin(), included.end(), field);
+  TENZIR_ASSERT(it != included.end() and *it == field);
+  index[0] = detail::narrow_cast<size_t>(std::distance(included.begin(), it));
+  return index;
+}
+
+auto project_expression(const expression& expr, const type& schema,
+                        const type& projected_schema,
+                        const std::vector<int>& included) -> expression {
+  const auto& layout = caf::get<record_type>(schema);
+  const auto& projected_layout = caf::get<record_type>(projected_schema);
+  return for_each_predicate(expr, [&](const predicate& pred) -> expression {
+    auto result = pred;
+    for (auto* operand : {&result.lhs, &result.rhs}) {
+      if (auto* extractor = caf::get_if<data_extractor>(operand)) {
+        *extractor = data_extractor{
+          projected_layout,
+          project_offset(layout.resolve_flat_index(extractor->column),
+                         included),
+        };
+      }
+    }
+    return expression{std::move(result)};
+  });
+}
+
 default_passive_store_actor::behavior_type default_passive_store(
   default_passive_store_actor::stateful_pointer<default_passive_store_state>
     self,
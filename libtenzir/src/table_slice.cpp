@@ -18,7 +18,9 @@
 #include "tenzir/detail/passthrough.hpp"
 #include "tenzir/detail/string.hpp"
 #include "tenzir/detail/zip_iterator.hpp"
+#include "tenzir/diagnostics.hpp"
 #include "tenzir/error.hpp"
+#include "tenzir/evaluate.hpp"
 #include "tenzir/expression.hpp"
 #include "tenzir/fbs/table_slice.hpp"
 #include "tenzir/fbs/utils.hpp"
@@ -29,6 +31,7 @@
 #include "tenzir/type.hpp"
 #include "tenzir/value_index.hpp"
 
+#include <arrow/array/concatenate.h>
 #include <arrow/record_batch.h>
 
 #include <cstddef>
@@ -580,31 +583,62 @@ table_slice concatenate(std::vector<table_slice> slices) {
                                         return slice.schema() == schema;
                                       }),
                           "concatenate requires slices to be homogeneous");
-  auto builder = caf::get<record_type>(schema).make_arrow_builder(
-    arrow::default_memory_pool());
-  auto arrow_schema = schema.to_arrow_schema();
-  const auto resize_result
-    = builder->Resize(detail::narrow_cast<int64_t>(rows(slices)));
-  TENZIR_ASSERT(resize_result.ok(), resize_result.ToString().c_str());
-
-  for (const auto& slice : slices) {
-    auto batch = to_record_batch(slice);
-    append_columns(caf::get<record_type>(schema),
-                   *batch->ToStructArray().ValueOrDie(), *builder);
+  // We concatenate the columns at the level of their Arrow buffers, which
+  // copies fixed-width values and validity bitmaps as a whole and rebases the
+  // offsets of variable-width and nested arrays, instead of appending every
+  // value to a builder.
+  auto batches = std::vector<std::shared_ptr<arrow::RecordBatch>>{};
+  batches.reserve(slices.size());
+  for (const auto& slice : slices)
+    batches.push_back(to_record_batch(slice));
+  const auto num_columns = batches[0]->num_columns();
+  auto columns = arrow::ArrayVector{};
+  columns.reserve(num_columns);
+  auto arrays = arrow::ArrayVector(batches.size());
+  for (auto column = 0; column < num_columns; ++column) {
+    for (size_t i = 0; i < batches.size(); ++i)
+      arrays[i] = batches[i]->column(column);
+    auto result = arrow::Concatenate(arrays, arrow::default_memory_pool());
+    if (not result.ok()) {
+      diagnostic::error("{}", result.status().ToString())
+        .note("failed to concatenate column `{}` of schema `{}`",
+              batches[0]->schema()->field(column)->name(), schema)
+        .throw_();
+    }
+    columns.push_back(result.MoveValueUnsafe());
   }
-  const auto rows = builder->length();
-  if (rows == 0)
-    return {};
-  const auto array = builder->Finish().ValueOrDie();
   auto batch = arrow::RecordBatch::Make(
-    std::move(arrow_schema), rows,
-    caf::get<type_to_arrow_array_t<record_type>>(*array).fields());
+    schema.to_arrow_schema(), detail::narrow_cast<int64_t>(rows(slices)),
+    std::move(columns));
   auto result = table_slice{batch, schema};
   result.offset(slices[0].offset());
   result.import_time(slices[0].import_time());
   return result;
 }
 
+namespace {
+
+// Selects the rows of a slice that are set in a selection, which must already
+// be limited to the ids of the slice.
+generator<table_slice> select_selection(const table_slice& slice,
+                                        ids selection) {
+  const auto offset = slice.offset() == invalid_id ? 0 : slice.offset();
+  // Do no rows qualify?
+  if (!any(selection))
+    co_return;
+  // Do all rows qualify?
+  if (rank(selection) == slice.rows()) {
+    co_yield slice;
+    co_return;
+  }
+  // Start slicing and dicing.
+  for (const auto [first, last] : select_runs(selection)) {
+    co_yield subslice(slice, first - offset, last - offset);
+  }
+}
+
+} // namespace
+
 generator<table_slice>
 select(const table_slice& slice, expression expr, const ids& hints) {
   if (slice.rows() == 0) {
@@ -627,19 +661,28 @@ select(const table_slice& slice, expression expr, const ids& hints) {
     if (!tailored_expr)
       co_return;
     selection = evaluate(*tailored_expr, slice, selection);
-    // Do no rows qualify?
-    if (!any(selection))
-      co_return;
   }
-  // Do all rows qualify?
-  if (rank(selection) == slice.rows()) {
-    co_yield slice;
+  for (auto&& result : select_selection(slice, std::move(selection))) {
+    co_yield std::move(result);
+  }
+}
+
+generator<table_slice> select(const table_slice& slice,
+                              const evaluation_program& program,
+                              const ids& hints) {
+  if (slice.rows() == 0 || program.matches_nothing()) {
     co_return;
   }
-  // Start slicing and dicing.
-  auto batch = to_record_batch(slice);
-  for (const auto [first, last] : select_runs(selection)) {
-    co_yield subslice(slice, first - offset, last - offset);
+  const auto offset = slice.offset() == invalid_id ? 0 : slice.offset();
+  auto selection = make_ids({{offset, offset + slice.rows()}});
+  if (!hints.empty())
+    selection &= hints;
+  // Do no rows qualify?
+  if (!any(selection))
+    co_return;
+  selection = program.evaluate(slice, selection);
+  for (auto&& result : select_selection(slice, std::move(selection))) {
+    co_yield std::move(result);
   }
 }
 
@@ -749,6 +792,18 @@ filter(const table_slice& slice, expression expr, const ids& hints) {
   return concatenate(std::move(selected));
 }
 
+std::optional<table_slice> filter(const table_slice& slice,
+                                  const evaluation_program& program,
+                                  const ids& hints) {
+  if (slice.rows() == 0) {
+    return {};
+  }
+  auto selected = collect(select(slice, program, hints));
+  if (selected.empty())
+    return {};
+  return concatenate(std::move(selected));
+}
+
 std::optional<table_slice>
 filter(const table_slice& slice, const expression& expr) {
   return filter(slice, expr, ids{});
@@ -0,0 +1,151 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2024 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "tenzir/tdigest.hpp"
+
+#include "tenzir/detail/assert.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+namespace tenzir {
+
+namespace {
+
+/// The number of buffered centroids per unit of compression before we merge
+/// them into the centroids.
+constexpr auto buffer_factor = size_t{5};
+
+} // namespace
+
+tdigest::tdigest(double compression) : compression_{compression} {
+  TENZIR_ASSERT(compression_ > 0.0);
+}
+
+auto tdigest::add(double x, double weight) -> void {
+  TENZIR_ASSERT(not std::isnan(x));
+  TENZIR_ASSERT(weight > 0.0);
+  buffer_.push_back({x, weight});
+  count_ += weight;
+  min_ = std::min(min_, x);
+  max_ = std::max(max_, x);
+  if (buffer_.size()
+      >= buffer_factor * static_cast<size_t>(std::ceil(compression_))) {
+    compress();
+  }
+}
+
+auto tdigest::merge(const tdigest& other) -> void {
+  merge(other.centroids_, other.min_, other.max_);
+  for (const auto& x : other.buffer_) {
+    add(x.mean, x.weight);
+  }
+}
+
+auto tdigest::merge(std::span<const centroid> centroids, double min,
+                    double max) -> void {
+  for (const auto& x : centroids) {
+    add(x.mean, x.weight);
+  }
+  if (not centroids.empty()) {
+    min_ = std::min(min_, min);
+    max_ = std::max(max_, max);
+  }
+}
+
+auto tdigest::quantile(double q) -> double {
+  TENZIR_ASSERT(not empty());
+  TENZIR_ASSERT(q >= 0.0 and q <= 1.0);
+  compress();
+  if (centroids_.size() == 1) {
+    return centroids_.front().mean;
+  }
+  // We treat the mean of every centroid as the value at the center of its
+  // weight, and interpolate linearly between the centers of adjacent
+  // centroids. Below the first and above the last center, we interpolate
+  // towards the extrema.
+  const auto target = q * count_;
+  const auto& first = centroids_.front();
+  if (target < first.weight / 2) {
+    return min_ + (first.mean - min_) * (target / (first.weight / 2));
+  }
+  auto cumulative = first.weight / 2;
+  for (auto i = size_t{1}; i < centroids_.size(); ++i) {
+    const auto& lower = centroids_[i - 1];
+    const auto& upper = centroids_[i];
+    const auto step = (lower.weight + upper.weight) / 2;
+    if (target < cumulative + step) {
+      const auto fraction = (target - cumulative) / step;
+      return lower.mean + (upper.mean - lower.mean) * fraction;
+    }
+    cumulative += step;
+  }
+  const auto& last = centroids_.back();
+  const auto remaining = last.weight / 2;
+  const auto fraction = std::min(1.0, (target - cumulative) / remaining);
+  return last.mean + (max_ - last.mean) * fraction;
+}
+
+auto tdigest::empty() const -> bool {
+  return count_ == 0.0;
+}
+
+auto tdigest::count() const -> double {
+  return count_;
+}
+
+auto tdigest::min() const -> double {
+  return min_;
+}
+
+auto tdigest::max() const -> double {
+  return max_;
+}
+
+auto tdigest::centroids() -> std::span<const centroid> {
+  compress();
+  return centroids_;
+}
+
+auto tdigest::compress() -> void {
+  if (buffer_.empty()) {
+    return;
+  }
+  buffer_.insert(buffer_.end(), centroids_.begin(), centroids_.end());
+  std::sort(buffer_.begin(), buffer_.end(), [](const auto& lhs, const auto& rhs) {
+    return lhs.mean < rhs.mean;
+  });
+  // The scale function maps a quantile to an index such that a centroid may
+  // cover at most one unit of the index. Its slope grows towards the extreme
+  // quantiles, so centroids stay small there.
+  const auto scale = [&](double q) {
+    return compression_ / (2 * std::numbers::pi) * std::asin(2 * q - 1);
+  };
+  centroids_.clear();
+  auto current = buffer_.front();
+  auto weight_before = 0.0;
+  for (auto i = size_t{1}; i < buffer_.size(); ++i) {
+    const auto& next = buffer_[i];
+    const auto q_lower = weight_before / count_;
+    const auto q_upper
+      = std::min(1.0, (weight_before + current.weight + next.weight) / count_);
+    if (scale(q_upper) - scale(q_lower) <= 1.0) {
+      current.weight += next.weight;
+      current.mean += (next.mean - current.mean) * next.weight / current.weight;
+      continue;
+    }
+    weight_before += current.weight;
+    centroids_.push_back(current);
+    current = next;
+  }
+  centroids_.push_back(current);
+  buffer_.clear();
+}
+
+} // namespace tenzir
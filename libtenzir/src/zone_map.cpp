@@ -0,0 +1,316 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2024 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "tenzir/zone_map.hpp"
+
+#include "tenzir/arrow_table_slice.hpp"
+#include "tenzir/detail/overload.hpp"
+#include "tenzir/detail/type_traits.hpp"
+#include "tenzir/error.hpp"
+#include "tenzir/fbs/utils.hpp"
+#include "tenzir/fbs/zone_map.hpp"
+#include "tenzir/flatbuffer.hpp"
+#include "tenzir/operator.hpp"
+#include "tenzir/table_slice.hpp"
+#include "tenzir/type.hpp"
+
+#include <arrow/record_batch.h>
+
+#include <cmath>
+#include <limits>
+
+namespace tenzir {
+
+namespace {
+
+template <class Type>
+auto update_min_max(column_statistics& stats, const Type& type,
+                    const arrow::Array& array) -> void {
+  using data_type = type_to_data_t<Type>;
+  const auto& typed_array
+    = static_cast<const type_to_arrow_array_t<Type>&>(array);
+  auto min = std::optional<data_type>{};
+  auto max = std::optional<data_type>{};
+  for (auto i = int64_t{0}; i < typed_array.length(); ++i) {
+    if (typed_array.IsNull(i))
+      continue;
+    auto value = data_type{value_at(type, typed_array, i)};
+    if constexpr (std::is_same_v<data_type, double>) {
+      // NaN values do not have a meaningful order, so we must not prune
+      // anything for the column.
+      if (std::isnan(value))
+        return;
+    }
+    if (not min or value < *min)
+      min = value;
+    if (not max or value > *max)
+      max = value;
+  }
+  if (min) {
+    stats.min = *min;
+    stats.max = *max;
+  }
+}
+
+/// Checks whether any value in the range [min, max] satisfies `op x`, where
+/// both bounds and `x` are of type T.
+template <class T>
+auto lookup_range(relational_operator op, const T& min, const T& max,
+                  const T& x, bool has_nulls) -> std::optional<bool> {
+  switch (op) {
+    case relational_operator::equal:
+      return not(x < min or x > max);
+    case relational_operator::not_equal:
+      if (has_nulls)
+        return {};
+      return not(min == x and max == x);
+    case relational_operator::less:
+      return min < x;
+    case relational_operator::less_equal:
+      return min <= x;
+    case relational_operator::greater:
+      return max > x;
+    case relational_operator::greater_equal:
+      return max >= x;
+    default:
+      return {};
+  }
+}
+
+auto lookup_range(relational_operator op, const data& min, const data& max,
+                  const data& x, bool has_nulls) -> std::optional<bool> {
+  // Integral literals may be of a different signedness than the column; we
+  // compare them as the type of the column if the value fits.
+  if (const auto* value = caf::get_if<uint64_t>(&x);
+      value and caf::holds_alternative<int64_t>(min)) {
+    if (*value > static_cast<uint64_t>(std::numeric_limits<int64_t>::max()))
+      return {};
+    return lookup_range(op, min, max, data{static_cast<int64_t>(*value)},
+                        has_nulls);
+  }
+  if (const auto* value = caf::get_if<int64_t>(&x);
+      value and caf::holds_alternative<uint64_t>(min)) {
+    if (*value < 0)
+      return {};
+    return lookup_range(op, min, max, data{static_cast<uint64_t>(*value)},
+                        has_nulls);
+  }
+  auto f = [&]<class T>(const T& min_value) -> std::optional<bool> {
+    if constexpr (detail::is_any_v<T, int64_t, uint64_t, double, duration,
+                                   time>) {
+      const auto* max_ptr = caf::get_if<T>(&max);
+      const auto* x_ptr = caf::get_if<T>(&x);
+      if (not max_ptr or not x_ptr)
+        return {};
+      return lookup_range(op, min_value, *max_ptr, *x_ptr, has_nulls);
+    } else {
+      return {};
+    }
+  };
+  return caf::visit(f, min);
+}
+
+} // namespace
+
+auto zone_map::make(const table_slice& slice) -> zone_map {
+  auto result = zone_map{};
+  result.rows = slice.rows();
+  result.import_time = slice.import_time();
+  const auto& schema = caf::get<record_type>(slice.schema());
+  const auto batch = to_record_batch(slice);
+  result.columns.reserve(schema.num_leaves());
+  for (auto&& leaf : schema.leaves()) {
+    auto& stats = result.columns.emplace_back();
+    const auto array = leaf.index.get(*batch);
+    stats.null_count = array->null_count();
+    auto f = [&]<concrete_type Type>(const Type& type) {
+      if constexpr (detail::is_any_v<Type, int64_type, uint64_type,
+                                     double_type, duration_type, time_type>)
+        update_min_max(stats, type, *array);
+    };
+    caf::visit(f, leaf.field.type);
+  }
+  return result;
+}
+
+auto zone_map::may_match(const expression& expr) const -> bool {
+  auto f = detail::overload{
+    [](caf::none_t) {
+      return true;
+    },
+    [&](const conjunction& xs) {
+      for (const auto& x : xs)
+        if (not may_match(x))
+          return false;
+      return true;
+    },
+    [&](const disjunction& xs) {
+      for (const auto& x : xs)
+        if (may_match(x))
+          return true;
+      return false;
+    },
+    [](const negation&) {
+      // Negations would require knowing that all values of a column match,
+      // which the statistics cannot tell us in general.
+      return true;
+    },
+    [&](const predicate& pred) {
+      return may_match(pred).value_or(true);
+    },
+  };
+  return caf::visit(f, expr);
+}
+
+auto zone_map::may_match(const predicate& pred) const -> std::optional<bool> {
+  // Normalize the predicate so that the literal is on the right-hand side.
+  auto op = pred.op;
+  const auto* lhs = &pred.lhs;
+  const auto* rhs = &pred.rhs;
+  if (caf::holds_alternative<data>(*lhs)) {
+    std::swap(lhs, rhs);
+    op = flip(op);
+  }
+  const auto* x = caf::get_if<data>(rhs);
+  if (not x)
+    return {};
+  auto lookup = [&](const data& min, const data& max,
+                    bool has_nulls) -> std::optional<bool> {
+    switch (op) {
+      case relational_operator::in: {
+        const auto* xs = caf::get_if<list>(x);
+        if (not xs)
+          return {};
+        for (const auto& element : *xs) {
+          if (lookup_range(relational_operator::equal, min, max, element,
+                           has_nulls)
+                .value_or(true))
+            return true;
+        }
+        return false;
+      }
+      case relational_operator::equal:
+      case relational_operator::not_equal:
+      case relational_operator::less:
+      case relational_operator::less_equal:
+      case relational_operator::greater:
+      case relational_operator::greater_equal:
+        return lookup_range(op, min, max, *x, has_nulls);
+      default:
+        return {};
+    }
+  };
+  if (const auto* ex = caf::get_if<meta_extractor>(lhs)) {
+    if (ex->kind != meta_extractor::import_time)
+      return {};
+    return lookup(data{import_time}, data{import_time}, false);
+  }
+  const auto* ex = caf::get_if<data_extractor>(lhs);
+  if (not ex or ex->column >= columns.size())
+    return {};
+  const auto& stats = columns[ex->column];
+  if (not stats.null_count)
+    return {};
+  const auto null_count = *stats.null_count;
+  if (caf::holds_alternative<caf::none_t>(*x)) {
+    if (op == relational_operator::equal)
+      return null_count > 0;
+    if (op == relational_operator::not_equal)
+      return null_count < rows;
+    return {};
+  }
+  // A column that consists of nulls only cannot match any non-null literal
+  // for equality and range comparisons.
+  if (null_count == rows
+      and (op == relational_operator::equal or op == relational_operator::less
+           or op == relational_operator::less_equal
+           or op == relational_operator::greater
+           or op == relational_operator::greater_equal))
+    return false;
+  if (caf::holds_alternative<caf::none_t>(stats.min))
+    return {};
+  return lookup(stats.min, stats.max, null_count > 0);
+}
+
+auto pack_zone_maps(const std::vector<zone_map>& zone_maps)
+  -> caf::expected<chunk_ptr> {
+  auto builder = flatbuffers::FlatBufferBuilder{};
+  auto zone_map_offsets
+    = std::vector<flatbuffers::Offset<fbs::zone_map::ZoneMap>>{};
+  zone_map_offsets.reserve(zone_maps.size());
+  for (const auto& zone_map : zone_maps) {
+    auto column_offsets
+      = std::vector<flatbuffers::Offset<fbs::zone_map::ColumnStatistics>>{};
+    column_offsets.reserve(zone_map.columns.size());
+    for (const auto& column : zone_map.columns) {
+      const auto min_offset = pack(builder, column.min);
+      const auto max_offset = pack(builder, column.max);
+      column_offsets.push_back(fbs::zone_map::CreateColumnStatistics(
+        builder, min_offset, max_offset, column.null_count.has_value(),
+        column.null_count.value_or(0)));
+    }
+    zone_map_offsets.push_back(fbs::zone_map::CreateZoneMapDirect(
+      builder, zone_map.rows, zone_map.import_time.time_since_epoch().count(),
+      &column_offsets));
+  }
+  const auto v0_offset
+    = fbs::zone_map::Createv0Direct(builder, &zone_map_offsets);
+  const auto zone_maps_offset = fbs::CreateZoneMaps(
+    builder, fbs::zone_map::ZoneMaps::v0, v0_offset.Union());
+  fbs::FinishZoneMapsBuffer(builder, zone_maps_offset);
+  return fbs::release(builder);
+}
+
+auto unpack_zone_maps(chunk_ptr chunk)
+  -> caf::expected<std::vector<zone_map>> {
+  using packed_type = flatbuffer<fbs::ZoneMaps, fbs::ZoneMapsIdentifier>;
+  auto zone_maps = packed_type::make(std::move(chunk));
+  if (not zone_maps) {
+    return std::move(zone_maps.error());
+  }
+  if ((*zone_maps)->zone_maps_type() != fbs::zone_map::ZoneMaps::v0) {
+    return caf::make_error(
+      ec::version_error,
+      fmt::format("unsupported zone maps version {}",
+                  static_cast<int>((*zone_maps)->zone_maps_type())));
+  }
+  const auto* zone_maps_v0 = (*zone_maps)->zone_maps_as_v0();
+  auto result = std::vector<zone_map>{};
+  if (not zone_maps_v0->zone_maps()) {
+    return result;
+  }
+  result.reserve(zone_maps_v0->zone_maps()->size());
+  for (const auto* entry : *zone_maps_v0->zone_maps()) {
+    auto& zone_map = result.emplace_back();
+    zone_map.rows = entry->rows();
+    zone_map.import_time = time{duration{entry->import_time()}};
+    if (not entry->columns()) {
+      continue;
+    }
+    zone_map.columns.reserve(entry->columns()->size());
+    for (const auto* column : *entry->columns()) {
+      auto& stats = zone_map.columns.emplace_back();
+      if (column->min()) {
+        if (auto err = unpack(*column->min(), stats.min)) {
+          return err;
+        }
+      }
+      if (column->max()) {
+        if (auto err = unpack(*column->max(), stats.max)) {
+          return err;
+        }
+      }
+      if (column->has_null_count()) {
+        stats.null_count = column->null_count();
+      }
+    }
+  }
+  return result;
+}
+
+} // namespace tenzir
@@ -0,0 +1,122 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2024 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "tenzir/aggregation_function.hpp"
+
+#include "tenzir/arrow_table_slice.hpp"
+#include "tenzir/plugin.hpp"
+#include "tenzir/test/test.hpp"
+#include "tenzir/type.hpp"
+
+#include <arrow/builder.h>
+
+#include <memory>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+using namespace tenzir;
+
+namespace {
+
+auto make_function(std::string_view name)
+  -> std::unique_ptr<aggregation_function> {
+  const auto* plugin = plugins::find<aggregation_function_plugin>(name);
+  REQUIRE(plugin);
+  auto function = plugin->make_aggregation_function(type{int64_type{}});
+  REQUIRE_NOERROR(function);
+  return std::move(*function);
+}
+
+auto make_array(const std::vector<std::optional<int64_t>>& xs)
+  -> std::shared_ptr<arrow::Array> {
+  auto builder = arrow::Int64Builder{};
+  for (const auto& x : xs) {
+    const auto status = x ? builder.Append(*x) : builder.AppendNull();
+    REQUIRE(status.ok());
+  }
+  return builder.Finish().ValueOrDie();
+}
+
+/// Adds the selected rows once through the bulk interface and once row by
+/// row, and checks that both yield the same result.
+auto check_selection(std::string_view name, const arrow::Array& array,
+                     std::vector<int64_t> selection) -> data {
+  auto bulk = make_function(name);
+  bulk->add(array, std::span<const int64_t>{selection});
+  auto single = make_function(name);
+  for (auto row : selection) {
+    single->add(value_at(type{int64_type{}}, array, row));
+  }
+  auto result = std::move(*bulk).finish();
+  REQUIRE_NOERROR(result);
+  auto expected = std::move(*single).finish();
+  REQUIRE_NOERROR(expected);
+  CHECK_EQUAL(*result, *expected);
+  return std::move(*result);
+}
+
+} // namespace
+
+TEST(aggregation function selection with runs and single rows) {
+  const auto array = make_array({1, 2, 3, 4, 5, 6, std::nullopt, 8, 9});
+  // The selection mixes runs of consecutive rows, single rows, and nulls.
+  const auto selection = std::vector<int64_t>{0, 1, 2, 5, 6, 7, 8};
+  CHECK_EQUAL(check_selection("sum", *array, selection), data{int64_t{29}});
+  CHECK_EQUAL(check_selection("count", *array, selection), data{uint64_t{6}});
+  CHECK_EQUAL(check_selection("min", *array, selection), data{int64_t{1}});
+  CHECK_EQUAL(check_selection("max", *array, selection), data{int64_t{9}});
+}
+
+TEST(aggregation function selection without nulls) {
+  const auto array = make_array({1, 2, 3, 4});
+  CHECK_EQUAL(check_selection("sum", *array, {1, 3}), data{int64_t{6}});
+  CHECK_EQUAL(check_selection("count", *array, {1, 3}), data{uint64_t{2}});
+}
+
+TEST(aggregation function selection of a sliced array) {
+  // Selections refer to the rows of the array, which may be a slice of a
+  // larger array with a non-zero offset.
+  const auto array
+    = make_array({100, 200, 1, std::nullopt, 3, 4})->Slice(2);
+  CHECK_EQUAL(check_selection("sum", *array, {0, 1, 2}), data{int64_t{4}});
+  CHECK_EQUAL(check_selection("count", *array, {0, 1, 2, 3}),
+              data{uint64_t{3}});
+}
+
+TEST(aggregation function empty selection) {
+  const auto array = make_array({1, 2, 3});
+  CHECK_EQUAL(check_selection("count", *array, {}), data{uint64_t{0}});
+}
+
+TEST(aggregation function merge of instances) {
+  // Merging another instance directly must yield the same result as merging
+  // its saved partial state.
+  const auto lhs = make_array({1, 2, 2, std::nullopt});
+  const auto rhs = make_array({2, 3, 3, 4});
+  for (auto name : {"sum", "collect", "distinct", "count_distinct",
+                    "approximate_count_distinct"}) {
+    MESSAGE(name);
+    auto other = make_function(name);
+    other->add(*rhs);
+    auto direct = make_function(name);
+    direct->add(*lhs);
+    REQUIRE_EQUAL(direct->merge(*other), caf::error{});
+    auto saved = make_function(name);
+    saved->add(*lhs);
+    auto state = other->save();
+    REQUIRE_NOERROR(state);
+    REQUIRE_EQUAL(saved->merge(*state), caf::error{});
+    auto result = std::move(*direct).finish();
+    REQUIRE_NOERROR(result);
+    auto expected = std::move(*saved).finish();
+    REQUIRE_NOERROR(expected);
+    CHECK_EQUAL(*result, *expected);
+  }
+}
@@ -0,0 +1,265 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2024 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "tenzir/catalog.hpp"
+
+#include "tenzir/expression.hpp"
+#include "tenzir/index.hpp"
+#include "tenzir/index_config.hpp"
+#include "tenzir/partition_synopsis.hpp"
+#include "tenzir/series_builder.hpp"
+#include "tenzir/table_slice.hpp"
+#include "tenzir/test/test.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace tenzir;
+using namespace std::chrono_literals;
+
+namespace {
+
+auto at(std::chrono::seconds x) -> time {
+  return time{x};
+}
+
+/// Creates the synopsis of a partition with one event per second in the
+/// closed interval [first, last], which is also its import time range.
+auto make_synopsis(int64_t first, int64_t last) -> partition_synopsis_ptr {
+  auto b = series_builder{};
+  for (auto i = first; i <= last; ++i) {
+    auto r = b.record();
+    r.field("ts", at(std::chrono::seconds{i}));
+    r.field("x", i);
+    r.field("d", static_cast<double>(i) / 2);
+  }
+  auto slice = b.finish_assert_one_slice("tenzir.test");
+  partition_synopsis_ptr result
+    = caf::make_copy_on_write<partition_synopsis>();
+  auto& ps = result.unshared();
+  ps.add(slice, 1'000, index_config{});
+  ps.shrink();
+  ps.events = slice.rows();
+  ps.min_import_time = at(std::chrono::seconds{first});
+  ps.max_import_time = at(std::chrono::seconds{last});
+  return result;
+}
+
+auto ts_at_least(time x) -> expression {
+  return expression{predicate{field_extractor{"ts"},
+                              relational_operator::greater_equal, data{x}}};
+}
+
+struct fixture {
+  fixture() {
+    const auto ranges = std::vector<std::pair<int64_t, int64_t>>{
+      {0, 10},
+      {20, 30},
+      {40, 50},
+    };
+    for (const auto& [first, last] : ranges) {
+      ids.push_back(uuid::random());
+      partitions.push_back({ids.back(), make_synopsis(first, last)});
+    }
+    (void)state.merge(partitions);
+  }
+
+  /// Looks up an expression and returns the sorted candidate IDs.
+  auto candidates(const expression& expr) const -> std::vector<uuid> {
+    auto result = state.lookup(expr);
+    REQUIRE_NOERROR(result);
+    auto ids = std::vector<uuid>{};
+    for (const auto& [_, info] : result->candidate_infos) {
+      for (const auto& partition : info.partition_infos) {
+        ids.push_back(partition.uuid);
+      }
+    }
+    std::ranges::sort(ids);
+    return ids;
+  }
+
+  /// Returns the sorted IDs of the partitions with the given indices.
+  auto expected(std::vector<size_t> indices) const -> std::vector<uuid> {
+    auto result = std::vector<uuid>{};
+    for (auto i : indices) {
+      result.push_back(ids[i]);
+    }
+    std::ranges::sort(result);
+    return result;
+  }
+
+  /// Restores the partition synopses from all segments of a catalog snapshot
+  /// in order, checking that each segment has the expected generation.
+  static auto unpack(chunk_ptr chunk, int64_t generation)
+    -> std::vector<partition_synopsis_pair> {
+    auto segments = unpack_catalog_snapshot(std::move(chunk));
+    REQUIRE_NOERROR(segments);
+    REQUIRE(not segments->empty());
+    auto result = std::vector<partition_synopsis_pair>{};
+    for (const auto& segment : *segments) {
+      const auto* snapshot_v0 = segment->catalog_snapshot_as_v0();
+      REQUIRE(snapshot_v0);
+      CHECK_EQUAL(snapshot_v0->generation(), generation);
+      if (not snapshot_v0->partitions()) {
+        continue;
+      }
+      for (const auto* entry : *snapshot_v0->partitions()) {
+        REQUIRE(entry->id());
+        auto ps = unpack_catalog_snapshot_entry(*entry);
+        REQUIRE_NOERROR(ps);
+        result.push_back({uuid::from_flatbuffer(*entry->id()), std::move(*ps)});
+      }
+    }
+    return result;
+  }
+
+  catalog_state state = {};
+  std::vector<uuid> ids = {};
+  std::vector<partition_synopsis_pair> partitions = {};
+};
+
+} // namespace
+
+FIXTURE_SCOPE(catalog_tests, fixture)
+
+TEST(catalog time field lookup) {
+  CHECK_EQUAL(candidates(ts_at_least(at(25s))), expected({1, 2}));
+  CHECK_EQUAL(candidates(ts_at_least(at(45s))), expected({2}));
+  CHECK_EQUAL(candidates(ts_at_least(at(60s))), expected({}));
+  auto before = expression{predicate{
+    field_extractor{"ts"}, relational_operator::less, data{at(15s)}}};
+  CHECK_EQUAL(candidates(before), expected({0}));
+}
+
+TEST(catalog import time lookup) {
+  auto expr = expression{predicate{meta_extractor{meta_extractor::import_time},
+                                   relational_operator::less_equal,
+                                   data{at(20s)}}};
+  CHECK_EQUAL(candidates(expr), expected({0, 1}));
+}
+
+TEST(catalog integer and double field lookups) {
+  const auto lookup = [&](std::string field, relational_operator op, data x) {
+    return candidates(
+      expression{predicate{field_extractor{std::move(field)}, op, x}});
+  };
+  CHECK_EQUAL(lookup("x", relational_operator::greater_equal, int64_t{25}),
+              expected({1, 2}));
+  CHECK_EQUAL(lookup("x", relational_operator::less, int64_t{20}),
+              expected({0}));
+  CHECK_EQUAL(lookup("x", relational_operator::equal, int64_t{45}),
+              expected({2}));
+  CHECK_EQUAL(lookup("x", relational_operator::equal, int64_t{15}),
+              expected({}));
+  CHECK_EQUAL(lookup("d", relational_operator::less_equal, 5.0),
+              expected({0}));
+  CHECK_EQUAL(lookup("d", relational_operator::greater, 25.0), expected({}));
+  // NaN is not ordered, so the lookup falls back to the synopses.
+  CHECK_EQUAL(lookup("d", relational_operator::equal,
+                     std::numeric_limits<double>::quiet_NaN()),
+              expected({0, 1, 2}));
+}
+
+TEST(catalog conjunction with a string field) {
+  // The predicate on the schema name is not indexed, so it falls back to the
+  // synopses of the candidates that remain after the time predicate.
+  auto name = expression{predicate{meta_extractor{meta_extractor::schema},
+                                   relational_operator::equal,
+                                   data{"tenzir.test"}}};
+  auto expr = expression{conjunction{name, ts_at_least(at(25s))}};
+  CHECK_EQUAL(candidates(expr), expected({1, 2}));
+}
+
+TEST(catalog erase) {
+  state.erase(ids[1]);
+  CHECK_EQUAL(candidates(ts_at_least(at(25s))), expected({2}));
+  (void)state.merge({{ids[1], make_synopsis(60, 70)}});
+  CHECK_EQUAL(candidates(ts_at_least(at(55s))), expected({1}));
+}
+
+TEST(catalog snapshot round-trip) {
+  // The resources are not part of the partition synopsis flatbuffer, so the
+  // snapshot must store them separately.
+  for (auto& [id, ps] : partitions) {
+    auto& synopsis = ps.unshared();
+    synopsis.store_file = {
+      .url = fmt::format("file:///archive/{}.store", id),
+      .size = 1,
+    };
+    synopsis.indexes_file = {
+      .url = fmt::format("file:///index/{}", id),
+      .size = 2,
+    };
+    synopsis.sketches_file = {
+      .url = fmt::format("file:///index/{}.mdx", id),
+      .size = 3,
+    };
+  }
+  auto chunk = pack_catalog_snapshot(1'234, partitions);
+  REQUIRE_NOERROR(chunk);
+  auto restored = unpack(std::move(*chunk), 1'234);
+  REQUIRE_EQUAL(restored.size(), partitions.size());
+  for (auto i = size_t{0}; i < partitions.size(); ++i) {
+    const auto& original = *partitions[i].synopsis;
+    const auto& actual = *restored[i].synopsis;
+    CHECK_EQUAL(restored[i].uuid, partitions[i].uuid);
+    CHECK_EQUAL(actual.events, original.events);
+    CHECK_EQUAL(actual.min_import_time, original.min_import_time);
+    CHECK_EQUAL(actual.max_import_time, original.max_import_time);
+    CHECK_EQUAL(actual.version, original.version);
+    CHECK_EQUAL(actual.schema, original.schema);
+    CHECK_EQUAL(actual.field_synopses_.size(), original.field_synopses_.size());
+    CHECK_EQUAL(actual.store_file.url, original.store_file.url);
+    CHECK_EQUAL(actual.store_file.size, original.store_file.size);
+    CHECK_EQUAL(actual.indexes_file.url, original.indexes_file.url);
+    CHECK_EQUAL(actual.indexes_file.size, original.indexes_file.size);
+    CHECK_EQUAL(actual.sketches_file.url, original.sketches_file.url);
+    CHECK_EQUAL(actual.sketches_file.size, original.sketches_file.size);
+  }
+  // A catalog restored from the snapshot answers queries like the original.
+  for (const auto& id : ids) {
+    state.erase(id);
+  }
+  CHECK_EQUAL(candidates(ts_at_least(at(25s))), expected({}));
+  (void)state.merge(restored);
+  CHECK_EQUAL(candidates(ts_at_least(at(25s))), expected({1, 2}));
+  CHECK_EQUAL(candidates(ts_at_least(at(45s))), expected({2}));
+  auto expr = expression{predicate{meta_extractor{meta_extractor::import_time},
+                                   relational_operator::less_equal,
+                                   data{at(20s)}}};
+  CHECK_EQUAL(candidates(expr), expected({0, 1}));
+}
+
+TEST(catalog snapshot with multiple segments) {
+  // A segment size of a single byte forces a new segment per partition.
+  auto chunk = pack_catalog_snapshot(1'234, partitions, 1);
+  REQUIRE_NOERROR(chunk);
+  auto segments = unpack_catalog_snapshot(*chunk);
+  REQUIRE_NOERROR(segments);
+  CHECK_EQUAL(segments->size(), partitions.size());
+  auto restored = unpack(std::move(*chunk), 1'234);
+  REQUIRE_EQUAL(restored.size(), partitions.size());
+  for (auto i = size_t{0}; i < partitions.size(); ++i) {
+    CHECK_EQUAL(restored[i].uuid, partitions[i].uuid);
+    CHECK_EQUAL(restored[i].synopsis->events, partitions[i].synopsis->events);
+  }
+}
+
+TEST(catalog snapshot of an empty catalog) {
+  auto chunk = pack_catalog_snapshot(0, {});
+  REQUIRE_NOERROR(chunk);
+  CHECK(unpack(std::move(*chunk), 0).empty());
+}
+
+FIXTURE_SCOPE_END()
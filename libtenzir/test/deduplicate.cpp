@@ -0,0 +1,95 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2024 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "tenzir/data.hpp"
+#include "tenzir/series_builder.hpp"
+#include "tenzir/table_slice.hpp"
+#include "tenzir/test/pipeline.hpp"
+#include "tenzir/test/test.hpp"
+
+#include <vector>
+
+using namespace tenzir;
+
+namespace {
+
+auto make_slice(std::vector<int64_t> xs) -> table_slice {
+  auto b = series_builder{};
+  for (auto x : xs) {
+    b.record().field("x", x);
+  }
+  return b.finish_assert_one_slice("tenzir.test");
+}
+
+} // namespace
+
+TEST(deduplicate treats missing fields as null) {
+  auto b = series_builder{};
+  {
+    auto r = b.record();
+    r.field("x", int64_t{1});
+    r.field("y").null();
+  }
+  {
+    auto r = b.record();
+    r.field("x", int64_t{2});
+    r.field("y", int64_t{5});
+  }
+  auto with_y = b.finish_assert_one_slice("tenzir.test");
+  auto without_y = make_slice({1, 2});
+  auto ctrl = test::control_plane{};
+  // The event `{x: 1}` lacks `y`, so it is a duplicate of `{x: 1, y: null}`.
+  // The event `{x: 2}` is not a duplicate of `{x: 2, y: 5}`.
+  auto output
+    = test::run_pipeline("deduplicate x, y", {with_y, without_y}, ctrl);
+  CHECK_EQUAL(test::column<int64_t>(output, 0),
+              (std::vector<int64_t>{1, 2, 2}));
+}
+
+TEST(deduplicate distinguishes types of non-null values) {
+  auto b = series_builder{};
+  b.record().field("x", uint64_t{1});
+  auto unsigned_x = b.finish_assert_one_slice("tenzir.test");
+  auto ctrl = test::control_plane{};
+  auto output
+    = test::run_pipeline("deduplicate x", {make_slice({1}), unsigned_x}, ctrl);
+  auto num_rows = size_t{0};
+  for (const auto& slice : output) {
+    num_rows += slice.rows();
+  }
+  CHECK_EQUAL(num_rows, 2u);
+}
+
+TEST(deduplicate evicts the least recently seen keys) {
+  // A budget of a single byte still remembers one key.
+  auto config = test::plugin_config{
+    "deduplicate", record{{"deduplicate-memory-budget", uint64_t{1}}}};
+  auto ctrl = test::control_plane{};
+  auto output = test::run_pipeline(
+    "deduplicate x", {make_slice({1, 2, 1, 1}), make_slice({3, 1})}, ctrl);
+  CHECK_EQUAL(test::column<int64_t>(output, 0),
+              (std::vector<int64_t>{1, 2, 1, 3, 1}));
+  // Forgetting keys changes the result, which the operator warns about once.
+  const auto diagnostics = ctrl.collect();
+  REQUIRE_EQUAL(diagnostics.size(), 1u);
+  CHECK(diagnostics[0].severity == severity::warning);
+}
+
+TEST(deduplicate without a memory budget) {
+  auto config = test::plugin_config{
+    "deduplicate", record{{"deduplicate-memory-budget", uint64_t{0}}}};
+  auto input = std::vector<int64_t>{};
+  for (auto i = int64_t{0}; i < 10'000; ++i) {
+    input.push_back(i);
+  }
+  auto ctrl = test::control_plane{};
+  auto output = test::run_pipeline(
+    "deduplicate x", {make_slice(input), make_slice(input)}, ctrl);
+  CHECK_EQUAL(test::column<int64_t>(output, 0), input);
+  CHECK(ctrl.collect().empty());
+}
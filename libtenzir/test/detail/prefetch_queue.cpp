@@ -0,0 +1,84 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2024 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "tenzir/detail/prefetch_queue.hpp"
+
+#include "tenzir/test/test.hpp"
+
+#include <vector>
+
+using namespace tenzir;
+
+namespace {
+
+struct fixture {
+  fixture() {
+    for (auto i = 0; i < 10; ++i) {
+      queue.push(i);
+    }
+  }
+
+  void schedule() {
+    queue.schedule(
+      [&](int x) {
+        prefetched.push_back(x);
+        return x;
+      },
+      [&](int x) {
+        started.push_back(x);
+      });
+    CHECK_LESS_EQUAL(queue.num_running(), 2u);
+    CHECK_LESS_EQUAL(queue.num_running() + queue.num_prefetched(), 5u);
+  }
+
+  detail::prefetch_queue<int, int> queue{2, 3};
+  std::vector<int> prefetched;
+  std::vector<int> started;
+};
+
+} // namespace
+
+FIXTURE_SCOPE(prefetch_queue_tests, fixture)
+
+TEST(initial schedule) {
+  schedule();
+  CHECK_EQUAL(prefetched, (std::vector{0, 1, 2, 3, 4}));
+  CHECK_EQUAL(started, (std::vector{0, 1}));
+  CHECK_EQUAL(queue.num_queued(), 5u);
+  CHECK_EQUAL(queue.num_prefetched(), 3u);
+  CHECK_EQUAL(queue.num_running(), 2u);
+}
+
+TEST(steady state) {
+  schedule();
+  // Finishing a running item starts a prefetched one, and prefetches exactly
+  // one more item to replace it.
+  queue.finish();
+  schedule();
+  CHECK_EQUAL(prefetched, (std::vector{0, 1, 2, 3, 4, 5}));
+  CHECK_EQUAL(started, (std::vector{0, 1, 2}));
+  CHECK_EQUAL(queue.num_prefetched(), 3u);
+  CHECK_EQUAL(queue.num_running(), 2u);
+  // Scheduling without finishing anything changes nothing.
+  schedule();
+  CHECK_EQUAL(prefetched.size(), 6u);
+  CHECK_EQUAL(started.size(), 3u);
+}
+
+TEST(drain) {
+  schedule();
+  while (queue.num_running() > 0) {
+    queue.finish();
+    schedule();
+  }
+  CHECK_EQUAL(started, (std::vector{0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+  CHECK_EQUAL(queue.num_queued(), 0u);
+  CHECK_EQUAL(queue.num_prefetched(), 0u);
+}
+
+FIXTURE_SCOPE_END()
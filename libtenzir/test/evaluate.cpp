@@ -0,0 +1,140 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2024 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "tenzir/evaluate.hpp"
+
+#include "tenzir/bitmap_algorithms.hpp"
+#include "tenzir/concept/parseable/tenzir/expression.hpp"
+#include "tenzir/concept/parseable/to.hpp"
+#include "tenzir/expression.hpp"
+#include "tenzir/ids.hpp"
+#include "tenzir/series_builder.hpp"
+#include "tenzir/table_slice.hpp"
+#include "tenzir/test/test.hpp"
+
+namespace tenzir {
+
+namespace {
+
+// The number of rows is chosen such that the kernels have to deal with
+// multiple blocks, including a partial one at the end.
+constexpr auto num_rows = int64_t{150};
+
+struct fixture {
+  fixture() {
+    auto b = series_builder{};
+    for (auto i = int64_t{0}; i < num_rows; ++i) {
+      auto r = b.record();
+      r.field("i", i);
+      r.field("u", static_cast<uint64_t>(i));
+      // Every third value is null.
+      r.field("d", i % 3 == 0 ? data_view2{caf::none}
+                              : data_view2{static_cast<double>(i) / 2});
+      r.field("t", time{std::chrono::seconds{i}});
+      r.field("s", i % 2 == 0 ? "even" : "odd");
+      r.field("a", ip::v4(static_cast<uint32_t>(0x0a000000 + i)));
+      r.field("b", i % 4 == 0);
+    }
+    slice = b.finish_assert_one_slice("test");
+  }
+
+  auto count(std::string_view str, const ids& hints = {}) const -> uint64_t {
+    auto expr = unbox(tailor(unbox(to<expression>(str)), slice.schema()));
+    auto result = evaluate(expr, slice, hints);
+    const auto offset = slice.offset() == invalid_id ? 0 : slice.offset();
+    REQUIRE_EQUAL(result.size(), offset + num_rows);
+    return rank(result);
+  }
+
+  table_slice slice = {};
+};
+
+} // namespace
+
+FIXTURE_SCOPE(evaluate_tests, fixture)
+
+TEST(numeric predicates) {
+  CHECK_EQUAL(count("i == 42"), 1u);
+  CHECK_EQUAL(count("i != 42"), 149u);
+  CHECK_EQUAL(count("i < 70"), 70u);
+  CHECK_EQUAL(count("i <= 70"), 71u);
+  CHECK_EQUAL(count("i > 63"), 86u);
+  CHECK_EQUAL(count("i >= 64"), 86u);
+  CHECK_EQUAL(count("u >= 64"), 86u);
+  CHECK_EQUAL(count("d > 70.0"), 6u);
+  CHECK_EQUAL(count("d != 1.0"), 99u);
+  CHECK_EQUAL(count("d == null"), 50u);
+  CHECK_EQUAL(count("d != null"), 100u);
+}
+
+TEST(time predicates) {
+  CHECK_EQUAL(count("t < 1970-01-01T00:01:00"), 60u);
+  CHECK_EQUAL(count("t >= 1970-01-01T00:02:00"), 30u);
+}
+
+TEST(string and bool predicates) {
+  CHECK_EQUAL(count("s == \"even\""), 75u);
+  CHECK_EQUAL(count("s != \"even\""), 75u);
+  CHECK_EQUAL(count("b == true"), 38u);
+  CHECK_EQUAL(count("b == false"), 112u);
+  CHECK_EQUAL(count("b != true"), 112u);
+}
+
+TEST(ip predicates) {
+  CHECK_EQUAL(count("a == 10.0.0.100"), 1u);
+  CHECK_EQUAL(count("a != 10.0.0.100"), 149u);
+  CHECK_EQUAL(count("a in 10.0.0.0/26"), 64u);
+  CHECK_EQUAL(count("a !in 10.0.0.0/26"), 86u);
+}
+
+TEST(connectives) {
+  CHECK_EQUAL(count("i >= 64 && s == \"even\""), 43u);
+  CHECK_EQUAL(count("i < 10 || i >= 140"), 20u);
+  CHECK_EQUAL(count("!(i < 10 || i >= 140)"), 130u);
+  CHECK_EQUAL(count("!(d == null) && d < 10.0"), 13u);
+}
+
+TEST(offset and hints) {
+  slice.offset(100);
+  CHECK_EQUAL(count("i >= 64"), 86u);
+  CHECK_EQUAL(count("d == null"), 50u);
+  auto hints = make_ids({{100, 110}, {200, 250}});
+  CHECK_EQUAL(count("i >= 64", hints), 50u);
+  CHECK_EQUAL(count("i < 64", hints), 10u);
+  CHECK_EQUAL(count("b == true", hints), 3u + 13u);
+}
+
+TEST(programs) {
+  auto programs = evaluation_program_cache{
+    unbox(to<expression>("#schema == \"test\" && (i < 10 || s == \"odd\")"))};
+  const auto* program = programs.get(slice.schema());
+  REQUIRE(program);
+  CHECK_EQUAL(program->schema(), slice.schema());
+  CHECK(not program->matches_nothing());
+  CHECK_EQUAL(rank(program->evaluate(slice, {})), 80u);
+  CHECK_EQUAL(programs.get(slice.schema()), program);
+  auto filtered = filter(slice, *program, make_ids({{0, 20}}));
+  REQUIRE(filtered);
+  CHECK_EQUAL(filtered->rows(), 15u);
+  programs = evaluation_program_cache{
+    unbox(to<expression>("#schema == \"other\" && i < 10"))};
+  program = programs.get(slice.schema());
+  REQUIRE(program);
+  CHECK(program->matches_nothing());
+  CHECK_EQUAL(rank(program->evaluate(slice, {})), 0u);
+  programs = evaluation_program_cache{unbox(to<expression>("foo == 42"))};
+  CHECK(not programs.get(slice.schema()));
+  programs = evaluation_program_cache{expression{}};
+  program = programs.get(slice.schema());
+  REQUIRE(program);
+  CHECK_EQUAL(rank(program->evaluate(slice, {})), 150u);
+}
+
+FIXTURE_SCOPE_END()
+
+} // namespace tenzir
@@ -0,0 +1,174 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2024 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "tenzir/data.hpp"
+#include "tenzir/expression.hpp"
+#include "tenzir/ids.hpp"
+#include "tenzir/plugin.hpp"
+#include "tenzir/series_builder.hpp"
+#include "tenzir/store.hpp"
+#include "tenzir/table_slice.hpp"
+#include "tenzir/test/pipeline.hpp"
+#include "tenzir/test/test.hpp"
+#include "tenzir/type.hpp"
+
+#include <fmt/format.h>
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+using namespace tenzir;
+
+namespace {
+
+/// Creates a slice with the fields `a`, `b`, and `c.d`, where `a` counts up
+/// from *first*.
+auto make_slice(int64_t first, int64_t rows) -> table_slice {
+  auto b = series_builder{};
+  for (auto a = first; a < first + rows; ++a) {
+    auto r = b.record();
+    r.field("a", a);
+    r.field("b", fmt::format("b{}", a));
+    r.field("c").record().field("d", static_cast<uint64_t>(a * 2));
+  }
+  return b.finish_assert_one_slice("tenzir.test");
+}
+
+auto field_names(const table_slice& slice) -> std::vector<std::string> {
+  auto result = std::vector<std::string>{};
+  for (const auto& field : caf::get<record_type>(slice.schema()).fields()) {
+    result.emplace_back(field.name);
+  }
+  return result;
+}
+
+struct fixture {
+  fixture() {
+    const auto* plugin = plugins::find<store_plugin>("feather");
+    REQUIRE(plugin);
+    auto active = plugin->make_active_store();
+    REQUIRE_NOERROR(active);
+    input.push_back(make_slice(0, 10));
+    input.push_back(make_slice(10, 10));
+    REQUIRE_EQUAL((*active)->add(input), caf::error{});
+    auto chunk = (*active)->finish();
+    REQUIRE_NOERROR(chunk);
+    auto passive = plugin->make_passive_store();
+    REQUIRE_NOERROR(passive);
+    store = std::move(*passive);
+    REQUIRE_EQUAL(store->load(std::move(*chunk)), caf::error{});
+  }
+
+  /// Runs an extract query, tailoring the expression to the store's schema.
+  auto extract(const expression& expr,
+               std::optional<std::vector<std::string>> fields)
+    -> std::vector<table_slice> {
+    auto tailored = tailor(expr, store->schema());
+    REQUIRE_NOERROR(tailored);
+    auto result = std::vector<table_slice>{};
+    for (auto&& slice : store->extract(*tailored, ids{}, std::move(fields))) {
+      result.push_back(std::move(slice));
+    }
+    return result;
+  }
+
+  std::vector<table_slice> input = {};
+  std::unique_ptr<passive_store> store = {};
+};
+
+auto a_at_least(int64_t x) -> expression {
+  return expression{predicate{field_extractor{"a"},
+                              relational_operator::greater_equal, data{x}}};
+}
+
+} // namespace
+
+FIXTURE_SCOPE(feather_store_tests, fixture)
+
+TEST(feather store round-trip) {
+  CHECK_EQUAL(store->num_events(), 20u);
+  CHECK_EQUAL(store->schema(), input[0].schema());
+  auto output = extract(trivially_true_expression(), std::nullopt);
+  auto rows = uint64_t{0};
+  for (const auto& slice : output) {
+    CHECK_EQUAL(slice.schema(), input[0].schema());
+    rows += slice.rows();
+  }
+  CHECK_EQUAL(rows, 20u);
+  for (auto col = size_t{0}; col < input[0].columns(); ++col) {
+    CHECK_EQUAL(test::column(output, col), test::column(input, col));
+  }
+}
+
+TEST(feather store projection) {
+  auto output = extract(trivially_true_expression(),
+                        std::vector<std::string>{"b"});
+  REQUIRE(not output.empty());
+  for (const auto& slice : output) {
+    CHECK_EQUAL(field_names(slice), std::vector<std::string>{"b"});
+    CHECK_EQUAL(slice.columns(), 1u);
+  }
+  CHECK_EQUAL(test::column(output, 0), test::column(input, 1));
+}
+
+TEST(feather store projection of a nested field) {
+  // Stores return the top-level fields that contain the requested fields.
+  auto output = extract(trivially_true_expression(),
+                        std::vector<std::string>{"c.d"});
+  REQUIRE(not output.empty());
+  for (const auto& slice : output) {
+    CHECK_EQUAL(field_names(slice), std::vector<std::string>{"c"});
+  }
+  CHECK_EQUAL(test::column(output, 0), test::column(input, 2));
+}
+
+TEST(feather store projection with a filter on another field) {
+  // The expression accesses `a`, which the store must read even though the
+  // results contain only `b`.
+  auto output = extract(a_at_least(15), std::vector<std::string>{"b"});
+  auto expected = std::vector<data>{};
+  for (auto a = 15; a < 20; ++a) {
+    expected.emplace_back(fmt::format("b{}", a));
+  }
+  for (const auto& slice : output) {
+    CHECK_EQUAL(field_names(slice), std::vector<std::string>{"b"});
+  }
+  CHECK_EQUAL(test::column(output, 0), expected);
+}
+
+TEST(feather store projection with a filter on a nested field) {
+  // The projected batches contain `a` and `c`, so the store must adjust the
+  // column of the extractor for `c.d` to the projected schema.
+  auto expr = expression{predicate{field_extractor{"c.d"},
+                                   relational_operator::less,
+                                   data{uint64_t{10}}}};
+  auto output = extract(expr, std::vector<std::string>{"a"});
+  auto expected = std::vector<data>{};
+  for (auto a = int64_t{0}; a < 5; ++a) {
+    expected.emplace_back(a);
+  }
+  for (const auto& slice : output) {
+    CHECK_EQUAL(field_names(slice), std::vector<std::string>{"a"});
+  }
+  CHECK_EQUAL(test::column(output, 0), expected);
+}
+
+TEST(feather store projection of all fields) {
+  auto output = extract(a_at_least(5),
+                        std::vector<std::string>{"a", "b", "c"});
+  auto rows = uint64_t{0};
+  for (const auto& slice : output) {
+    CHECK_EQUAL(field_names(slice), (std::vector<std::string>{"a", "b", "c"}));
+    rows += slice.rows();
+  }
+  CHECK_EQUAL(rows, 15u);
+}
+
+FIXTURE_SCOPE_END()
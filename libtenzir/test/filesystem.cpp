@@ -110,6 +110,25 @@ TEST(mmap) {
       });
 }
 
+TEST(ordered operations on the same file) {
+  MESSAGE("write file repeatedly without waiting for responses");
+  const auto filename = std::filesystem::path{"foo"};
+  for (auto i = 0; i < 100; ++i) {
+    auto chk = chunk::make(std::to_string(i));
+    self->send(filesystem, atom::write_v, filename, chk);
+  }
+  MESSAGE("read file via actor");
+  self->request(filesystem, caf::infinite, atom::read_v, filename)
+    .receive(
+      [&](const chunk_ptr& chk) {
+        const auto expected = "99"s;
+        CHECK_EQUAL(as_bytes(chk), as_bytes(std::span{expected}));
+      },
+      [&](const caf::error& err) {
+        FAIL(err);
+      });
+}
+
 TEST(status) {
   MESSAGE("create file");
   self
@@ -0,0 +1,102 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2024 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "tenzir/hyperloglog.hpp"
+
+#include "tenzir/hash/hash.hpp"
+#include "tenzir/test/test.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace tenzir {
+
+namespace {
+
+/// Checks that an estimate is within a relative error of the expected count.
+auto near(double estimate, double expected, double relative_error) -> bool {
+  return std::abs(estimate - expected) <= relative_error * expected;
+}
+
+} // namespace
+
+TEST(empty and small inputs) {
+  auto sketch = hyperloglog{};
+  CHECK_EQUAL(sketch.estimate(), 0.0);
+  for (auto i = uint64_t{0}; i < 10; ++i) {
+    sketch.add(hash(i));
+    sketch.add(hash(i));
+  }
+  CHECK(near(sketch.estimate(), 10.0, 0.01));
+}
+
+TEST(large inputs) {
+  for (auto precision : {uint8_t{10}, uint8_t{14}}) {
+    auto sketch = hyperloglog{precision};
+    CHECK_EQUAL(sketch.registers().size(), size_t{1} << precision);
+    for (auto i = uint64_t{0}; i < 1'000'000; ++i) {
+      sketch.add(hash(i));
+    }
+    // We allow for five times the standard error.
+    const auto error = 5 * 1.04 / std::sqrt(std::pow(2.0, precision));
+    CHECK(near(sketch.estimate(), 1'000'000.0, error));
+  }
+}
+
+TEST(merge) {
+  auto lhs = hyperloglog{12};
+  auto rhs = hyperloglog{12};
+  auto all = hyperloglog{12};
+  for (auto i = uint64_t{0}; i < 100'000; ++i) {
+    all.add(hash(i));
+    // The sketches overlap in a third of their values.
+    if (i < 66'000) {
+      lhs.add(hash(i));
+    }
+    if (i >= 33'000) {
+      rhs.add(hash(i));
+    }
+  }
+  auto merged = lhs;
+  merged.merge(rhs);
+  CHECK_EQUAL(merged.estimate(), all.estimate());
+  auto restored = lhs;
+  restored.merge(rhs.registers());
+  CHECK_EQUAL(restored.estimate(), all.estimate());
+}
+
+TEST(sparse representation) {
+  auto sketch = hyperloglog{14};
+  auto dense = std::vector<uint8_t>(sketch.num_registers());
+  for (auto i = uint64_t{0}; i < 100; ++i) {
+    sketch.add(hash(i));
+  }
+  // A handful of values needs far less memory than the dense registers.
+  CHECK(sketch.sparse());
+  CHECK_LESS(sketch.memusage(), sketch.num_registers() / 4);
+  CHECK(near(sketch.estimate(), 100.0, 0.01));
+  // Sparse and dense sketches with the same values have the same estimate.
+  auto densified = hyperloglog{14};
+  densified.merge(dense);
+  densified.merge(sketch);
+  CHECK(not densified.sparse());
+  CHECK_EQUAL(densified.estimate(), sketch.estimate());
+  CHECK(densified.registers() == sketch.registers());
+  auto restored = hyperloglog{14};
+  restored.merge_sparse(sketch.sparse_entries());
+  CHECK_EQUAL(restored.estimate(), sketch.estimate());
+  // The sketch switches to the dense representation once that is smaller.
+  for (auto i = uint64_t{100}; i < 100'000; ++i) {
+    sketch.add(hash(i));
+  }
+  CHECK(not sketch.sparse());
+  CHECK_EQUAL(sketch.memusage(), sketch.num_registers());
+}
+
+} // namespace tenzir
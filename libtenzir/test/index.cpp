@@ -0,0 +1,118 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2024 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "tenzir/index.hpp"
+
+#include "tenzir/defaults.hpp"
+#include "tenzir/detail/narrow.hpp"
+#include "tenzir/series_builder.hpp"
+#include "tenzir/table_slice.hpp"
+#include "tenzir/test/test.hpp"
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+namespace tenzir {
+
+namespace {
+
+auto make_slice(int64_t rows) -> table_slice {
+  auto b = series_builder{};
+  for (auto i = int64_t{0}; i < rows; ++i) {
+    auto r = b.record();
+    r.field("x", i);
+    r.field("y", i % 5);
+  }
+  return b.finish_assert_one_slice("tenzir.test");
+}
+
+/// Checks that the parts contain every row of a slice with *rows* rows exactly
+/// once, and that all rows with the same key end up in the same shard.
+auto check_shards(const std::vector<std::pair<size_t, table_slice>>& parts,
+                  int64_t rows) -> void {
+  auto xs = std::vector<int64_t>{};
+  auto shard_of_key = std::map<int64_t, size_t>{};
+  for (const auto& [shard, part] : parts) {
+    for (auto row = size_t{0}; row < part.rows(); ++row) {
+      xs.push_back(caf::get<int64_t>(part.at(row, 0)));
+      const auto y = caf::get<int64_t>(part.at(row, 1));
+      const auto it = shard_of_key.emplace(y, shard).first;
+      CHECK_EQUAL(it->second, shard);
+    }
+  }
+  std::ranges::sort(xs);
+  REQUIRE_EQUAL(xs.size(), static_cast<size_t>(rows));
+  for (auto i = int64_t{0}; i < rows; ++i) {
+    CHECK_EQUAL(xs[i], i);
+  }
+}
+
+} // namespace
+
+TEST(ingest shards round robin) {
+  auto state = index_state{nullptr};
+  state.ingest_shards = 3;
+  // Every shard receives a full batch of events before the next one takes
+  // over, so a batch split into four slices goes to the same shard.
+  const auto rows = detail::narrow_cast<int64_t>(
+    defaults::import::table_slice_size / 4);
+  const auto slice = make_slice(rows);
+  for (auto i = size_t{0}; i < 24; ++i) {
+    auto parts = state.split_into_shards(slice);
+    REQUIRE_NOERROR(parts);
+    REQUIRE_EQUAL(parts->size(), 1u);
+    CHECK_EQUAL((*parts)[0].first, i / 4 % 3);
+    CHECK_EQUAL((*parts)[0].second.rows(), static_cast<uint64_t>(rows));
+  }
+}
+
+TEST(ingest shards by key) {
+  auto state = index_state{nullptr};
+  state.ingest_shards = 3;
+  state.ingest_shard_key = "y";
+  auto parts = state.split_into_shards(make_slice(50));
+  REQUIRE_NOERROR(parts);
+  CHECK_GREATER(parts->size(), 1u);
+  check_shards(*parts, 50);
+}
+
+TEST(ingest shards by key with a single shard) {
+  auto state = index_state{nullptr};
+  state.ingest_shards = 3;
+  state.ingest_shard_key = "y";
+  // All rows share the same key, so the slice goes to a single shard as a
+  // whole.
+  auto b = series_builder{};
+  for (auto i = int64_t{0}; i < 10; ++i) {
+    auto r = b.record();
+    r.field("x", i);
+    r.field("y", int64_t{42});
+  }
+  auto parts
+    = state.split_into_shards(b.finish_assert_one_slice("tenzir.test"));
+  REQUIRE_NOERROR(parts);
+  REQUIRE_EQUAL(parts->size(), 1u);
+  check_shards(*parts, 10);
+}
+
+TEST(ingest shards by key with an offset) {
+  auto state = index_state{nullptr};
+  state.ingest_shards = 3;
+  state.ingest_shard_key = "y";
+  // Slices may arrive with a valid offset, e.g., when re-importing exported
+  // events. Splitting must not depend on that offset.
+  auto slice = make_slice(50);
+  slice.offset(1'000);
+  auto parts = state.split_into_shards(slice);
+  REQUIRE_NOERROR(parts);
+  CHECK_GREATER(parts->size(), 1u);
+  check_shards(*parts, 50);
+}
+
+} // namespace tenzir
@@ -0,0 +1,125 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2024 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "tenzir/interval_index.hpp"
+
+#include "tenzir/test/test.hpp"
+
+namespace tenzir {
+
+namespace {
+
+auto at(int64_t seconds) -> time {
+  return time{std::chrono::seconds{seconds}};
+}
+
+auto id(uint8_t x) -> uuid {
+  auto bytes = std::array<std::byte, uuid::num_bytes>{};
+  bytes.back() = std::byte{x};
+  return uuid{bytes};
+}
+
+auto ids(std::vector<uint8_t> xs) -> std::vector<uuid> {
+  auto result = std::vector<uuid>{};
+  for (auto x : xs) {
+    result.push_back(id(x));
+  }
+  return result;
+}
+
+struct fixture {
+  fixture() {
+    // Partition 3 is inserted out of order to check that the index stays
+    // sorted.
+    index.insert(id(1), at(0), at(10));
+    index.insert(id(2), at(10), at(20));
+    index.insert(id(4), at(30), at(40));
+    index.insert(id(3), at(15), at(25));
+  }
+
+  auto lookup(relational_operator op, int64_t seconds) const
+    -> std::vector<uuid> {
+    auto result = index.lookup(op, at(seconds));
+    REQUIRE(result);
+    return std::move(*result);
+  }
+
+  interval_index index;
+};
+
+} // namespace
+
+FIXTURE_SCOPE(interval_index_tests, fixture)
+
+TEST(range lookups) {
+  CHECK_EQUAL(index.size(), 4u);
+  CHECK_EQUAL(lookup(relational_operator::less, 10), ids({1}));
+  CHECK_EQUAL(lookup(relational_operator::less_equal, 10), ids({1, 2}));
+  CHECK_EQUAL(lookup(relational_operator::greater, 25), ids({4}));
+  CHECK_EQUAL(lookup(relational_operator::greater_equal, 25), ids({3, 4}));
+  CHECK_EQUAL(lookup(relational_operator::less, 0), ids({}));
+  CHECK_EQUAL(lookup(relational_operator::greater, 40), ids({}));
+}
+
+TEST(point lookups) {
+  CHECK_EQUAL(lookup(relational_operator::equal, 10), ids({1, 2}));
+  CHECK_EQUAL(lookup(relational_operator::equal, 17), ids({2, 3}));
+  CHECK_EQUAL(lookup(relational_operator::equal, 28), ids({}));
+  CHECK_EQUAL(lookup(relational_operator::not_equal, 28), ids({1, 2, 3, 4}));
+  CHECK(not index.lookup(relational_operator::in, at(0)));
+}
+
+TEST(updates) {
+  index.insert(id(2), at(100), at(200));
+  CHECK_EQUAL(index.size(), 4u);
+  CHECK_EQUAL(lookup(relational_operator::equal, 17), ids({3}));
+  CHECK_EQUAL(lookup(relational_operator::greater, 100), ids({2}));
+  CHECK(index.erase(id(3)));
+  CHECK(not index.erase(id(3)));
+  CHECK_EQUAL(index.size(), 3u);
+  CHECK_EQUAL(lookup(relational_operator::equal, 17), ids({}));
+}
+
+TEST(bulk insertion) {
+  // The batch replaces partition 2 and adds partitions out of order.
+  index.insert({
+    {at(50), at(60), id(6)},
+    {at(100), at(200), id(2)},
+    {at(5), at(12), id(5)},
+  });
+  CHECK_EQUAL(index.size(), 6u);
+  CHECK_EQUAL(lookup(relational_operator::equal, 11), ids({5}));
+  CHECK_EQUAL(lookup(relational_operator::less, 10), ids({1, 5}));
+  CHECK_EQUAL(lookup(relational_operator::greater, 45), ids({2, 6}));
+  CHECK(index.erase(id(5)));
+  CHECK_EQUAL(lookup(relational_operator::equal, 11), ids({}));
+}
+
+FIXTURE_SCOPE_END()
+
+TEST(integer intervals) {
+  auto index = basic_interval_index<int64_t>{};
+  index.insert({
+    {-10, 0, id(1)},
+    {5, 5, id(2)},
+    {0, 20, id(3)},
+  });
+  const auto lookup = [&](relational_operator op, int64_t x) {
+    auto result = index.lookup(op, x);
+    REQUIRE(result);
+    return std::move(*result);
+  };
+  CHECK_EQUAL(lookup(relational_operator::less, 0), ids({1}));
+  CHECK_EQUAL(lookup(relational_operator::equal, 0), ids({1, 3}));
+  CHECK_EQUAL(lookup(relational_operator::equal, 5), ids({2, 3}));
+  CHECK_EQUAL(lookup(relational_operator::greater_equal, 20), ids({3}));
+  CHECK(index.erase(id(3)));
+  CHECK_EQUAL(lookup(relational_operator::greater, 5), ids({}));
+}
+
+} // namespace tenzir
@@ -0,0 +1,127 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2024 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "tenzir/chunk.hpp"
+#include "tenzir/concept/parseable/tenzir/ip.hpp"
+#include "tenzir/concept/parseable/tenzir/subnet.hpp"
+#include "tenzir/concept/parseable/to.hpp"
+#include "tenzir/data.hpp"
+#include "tenzir/table_slice.hpp"
+#include "tenzir/test/pipeline.hpp"
+#include "tenzir/test/test.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+using namespace tenzir;
+using namespace std::chrono_literals;
+
+namespace {
+
+/// Splits a string into chunks of at most *size* bytes.
+auto make_chunks(std::string_view str, size_t size) -> std::vector<chunk_ptr> {
+  auto result = std::vector<chunk_ptr>{};
+  while (not str.empty()) {
+    const auto n = std::min(size, str.size());
+    result.push_back(chunk::make(std::string{str.substr(0, n)}));
+    str.remove_prefix(n);
+  }
+  return result;
+}
+
+auto day(int d) -> time {
+  return time{std::chrono::sys_days{std::chrono::year{2024} / 1 / d}};
+}
+
+} // namespace
+
+TEST(parallel ndjson preserves order and diagnostics) {
+  auto config
+    = test::plugin_config{"json", record{{"json-parallelism", uint64_t{4}}}};
+  // The input spans several blocks, so that multiple workers parse it at the
+  // same time. Every 10,000th line is invalid.
+  constexpr auto num_lines = int64_t{100'000};
+  auto input = std::string{};
+  auto num_invalid = size_t{0};
+  for (auto i = int64_t{0}; i < num_lines; ++i) {
+    if (i % 10'000 == 5'000) {
+      input += "invalid\n";
+      ++num_invalid;
+      continue;
+    }
+    input += fmt::format("{{\"x\": {}, \"padding\": \"{:>16}\"}}\n", i, i);
+  }
+  auto ctrl = test::control_plane{};
+  auto output
+    = test::run_pipeline("read json --ndjson", make_chunks(input, 65'536),
+                         ctrl);
+  auto xs = test::column<int64_t>(output, 0);
+  REQUIRE_EQUAL(xs.size(), static_cast<size_t>(num_lines) - num_invalid);
+  CHECK(std::ranges::is_sorted(xs));
+  auto diagnostics = ctrl.collect();
+  CHECK_EQUAL(diagnostics.size(), num_invalid);
+  for (const auto& diag : diagnostics) {
+    CHECK(diag.severity == severity::warning);
+  }
+}
+
+TEST(ndjson string inference when the kind of a field changes) {
+  // The parser first tries the kind that the previous string of a field was
+  // inferred as, which must not affect the result when the kind changes.
+  const auto input = std::string{R"({"x": "2024-01-01"}
+{"x": "hello"}
+{"x": "2024-01-02"}
+{"x": "10.0.0.0/8"}
+{"x": "1.2.3.4"}
+{"x": "1.2.3.4/8"}
+{"x": "10s"}
+{"x": "fe80::1"}
+{"x": "deadbeef"}
+{"x": "2024-01-03"}
+)"};
+  auto ctrl = test::control_plane{};
+  auto output
+    = test::run_pipeline("read json --ndjson", make_chunks(input, 1'024), ctrl);
+  const auto expected = std::vector<std::vector<data>>{
+    {data{day(1)}},
+    {data{"hello"}},
+    {data{day(2)}},
+    {data{unbox(to<subnet>("10.0.0.0/8"))}},
+    {data{unbox(to<ip>("1.2.3.4"))}},
+    {data{unbox(to<subnet>("1.2.3.4/8"))}},
+    {data{duration{10s}}},
+    {data{unbox(to<ip>("fe80::1"))}},
+    {data{"deadbeef"}},
+    {data{day(3)}},
+  };
+  CHECK_EQUAL(test::rows(output), expected);
+  CHECK(ctrl.collect().empty());
+}
+
+TEST(ndjson string inference for fields with the same name) {
+  // Nested fields with the same name share their inferred kind, but still
+  // yield the kind of their own values.
+  const auto input = std::string{R"({"x": "10s", "y": {"x": "2024-01-01"}}
+{"x": "20s", "y": {"x": "message"}}
+{"x": "a message", "y": {"x": "2024-01-02"}}
+)"};
+  auto ctrl = test::control_plane{};
+  auto output
+    = test::run_pipeline("read json --ndjson", make_chunks(input, 1'024), ctrl);
+  const auto expected = std::vector<std::vector<data>>{
+    {data{duration{10s}}, data{day(1)}},
+    {data{duration{20s}}, data{"message"}},
+    {data{"a message"}, data{day(2)}},
+  };
+  CHECK_EQUAL(test::rows(output), expected);
+  CHECK(ctrl.collect().empty());
+}
@@ -0,0 +1,129 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2024 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "tenzir/normalized_keys.hpp"
+
+#include "tenzir/concept/parseable/tenzir/ip.hpp"
+#include "tenzir/concept/parseable/tenzir/subnet.hpp"
+#include "tenzir/concept/parseable/to.hpp"
+#include "tenzir/series_builder.hpp"
+#include "tenzir/test/test.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+namespace tenzir {
+
+namespace {
+
+template <class T>
+auto column(const std::vector<std::optional<T>>& xs, bool descending = false,
+            bool nulls_first = false) -> normalized_key_column {
+  auto b = series_builder{};
+  for (const auto& x : xs) {
+    if (x) {
+      b.data(*x);
+    } else {
+      b.null();
+    }
+  }
+  auto result = b.finish_assert_one_array();
+  return {result.type, result.array, descending, nulls_first};
+}
+
+auto make_keys(const std::vector<normalized_key_column>& columns)
+  -> normalized_keys {
+  REQUIRE(not columns.empty());
+  return normalized_keys::make(columns, columns.front().array->length());
+}
+
+/// Checks that the keys of all rows are in strictly ascending order.
+auto strictly_ascending(const normalized_keys& keys) -> bool {
+  for (auto i = size_t{1}; i < keys.size(); ++i) {
+    if (not(keys[i - 1] < keys[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+auto addr(std::string_view str) -> std::optional<ip> {
+  return unbox(to<ip>(str));
+}
+
+auto net(std::string_view str) -> std::optional<subnet> {
+  return unbox(to<subnet>(str));
+}
+
+} // namespace
+
+TEST(integers) {
+  auto xs = std::vector<std::optional<int64_t>>{
+    std::nullopt, std::numeric_limits<int64_t>::min(), -5, -1, 0, 3, 1000,
+    std::numeric_limits<int64_t>::max()};
+  CHECK(strictly_ascending(make_keys({column(xs, false, true)})));
+  std::reverse(xs.begin(), xs.end());
+  CHECK(strictly_ascending(make_keys({column(xs, true, false)})));
+  auto ys = std::vector<std::optional<uint64_t>>{
+    0u, 1u, 256u, std::numeric_limits<uint64_t>::max(), std::nullopt};
+  CHECK(strictly_ascending(make_keys({column(ys)})));
+}
+
+TEST(doubles) {
+  constexpr auto inf = std::numeric_limits<double>::infinity();
+  auto xs = std::vector<std::optional<double>>{
+    -inf, -2.5, -1e-300, 0.0, 1e-300, 1.5, inf,
+    std::numeric_limits<double>::quiet_NaN()};
+  CHECK(strictly_ascending(make_keys({column(xs)})));
+  const auto zeros
+    = make_keys({column(std::vector<std::optional<double>>{-0.0, 0.0})});
+  CHECK_EQUAL(zeros[0], zeros[1]);
+}
+
+TEST(strings) {
+  using namespace std::string_view_literals;
+  auto xs = std::vector<std::optional<std::string_view>>{
+    ""sv, "\0"sv, "\0\0"sv, "a"sv, "a\0"sv, "a\0b"sv, "ab"sv, "b"sv};
+  CHECK(strictly_ascending(make_keys({column(xs)})));
+  std::reverse(xs.begin(), xs.end());
+  CHECK(strictly_ascending(make_keys({column(xs, true)})));
+}
+
+TEST(ip addresses and subnets) {
+  auto xs = std::vector<std::optional<ip>>{
+    addr("::1"),         addr("0.0.0.1"),     addr("10.0.0.1"),
+    addr("10.0.0.2"),    addr("192.168.0.1"), addr("255.255.255.255"),
+    addr("2001:db8::1"), std::nullopt};
+  CHECK(strictly_ascending(make_keys({column(xs)})));
+  auto ys = std::vector<std::optional<subnet>>{
+    std::nullopt,       net("10.0.0.0/8"),     net("10.0.0.0/16"),
+    net("10.1.0.0/16"), net("192.168.0.0/16"), net("2001:db8::/32"),
+    net("2001:db8::/48")};
+  CHECK(strictly_ascending(make_keys({column(ys, false, true)})));
+}
+
+TEST(multiple columns) {
+  // Rows sort by the first column ascending with nulls last, then by the
+  // second column descending.
+  auto keys = make_keys({
+    column(std::vector<std::optional<std::string_view>>{
+      "b", std::nullopt, "a", "b", "a", "ab"}),
+    column(std::vector<std::optional<int64_t>>{1, 7, 2, 3, -1, 0}, true),
+  });
+  auto indices = std::vector<size_t>(keys.size());
+  std::iota(indices.begin(), indices.end(), size_t{0});
+  std::sort(indices.begin(), indices.end(), [&](size_t lhs, size_t rhs) {
+    return keys[lhs] < keys[rhs];
+  });
+  CHECK_EQUAL(indices, (std::vector<size_t>{2, 4, 5, 3, 0, 1}));
+  CHECK(not normalized_keys::is_supported(type{list_type{int64_type{}}}));
+  CHECK(normalized_keys::is_supported(type{subnet_type{}}));
+}
+
+} // namespace tenzir
@@ -398,6 +398,44 @@ TEST(conflict with list from current event within another conflict) {
 ])"}});
 }
 
+TEST(records with varying field order) {
+  auto b = series_builder{};
+  auto r = b.record();
+  r.field("a").data(int64_t{1});
+  r.field("b").data(int64_t{2});
+  r = b.record();
+  r.field("a").data(int64_t{3});
+  r.field("b").data(int64_t{4});
+  r = b.record();
+  r.field("b").data(int64_t{5});
+  r.field("a").data(int64_t{6});
+  r = b.record();
+  r.field("a").data(int64_t{7});
+  r.field("c").data(int64_t{8});
+  r.field("b").data(int64_t{9});
+  r = b.record();
+  r.field("a").data(int64_t{10});
+  r.field("a").data(int64_t{11});
+  r.field("b").data(int64_t{12});
+  auto slices = b.finish_as_table_slice("hi");
+  REQUIRE_EQUAL(slices.size(), size_t{1});
+  auto& slice = slices[0];
+  REQUIRE_EQUAL(slice.rows(), uint64_t{5});
+  REQUIRE_EQUAL(slice.columns(), uint64_t{3});
+  const auto expected = std::vector<std::vector<data>>{
+    {int64_t{1}, int64_t{2}, caf::none},
+    {int64_t{3}, int64_t{4}, caf::none},
+    {int64_t{6}, int64_t{5}, caf::none},
+    {int64_t{7}, int64_t{9}, int64_t{8}},
+    {int64_t{11}, int64_t{12}, caf::none},
+  };
+  for (auto row = size_t{0}; row < expected.size(); ++row) {
+    for (auto column = size_t{0}; column < 3; ++column) {
+      CHECK_EQUAL(materialize(slice.at(row, column)), expected[row][column]);
+    }
+  }
+}
+
 TEST(to table slice) {
   auto b = series_builder{};
   b.record().field("foo").data(42);
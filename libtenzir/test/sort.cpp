@@ -0,0 +1,232 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2024 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "tenzir/data.hpp"
+#include "tenzir/series_builder.hpp"
+#include "tenzir/table_slice.hpp"
+#include "tenzir/test/pipeline.hpp"
+#include "tenzir/test/test.hpp"
+#include "tenzir/uuid.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+using namespace tenzir;
+
+namespace {
+
+/// An event with a nullable sort key `k` and its position `i` in the input.
+using event = std::pair<std::optional<int64_t>, int64_t>;
+
+/// Creates events with many ties and nulls, split into slices of *rows*
+/// events each.
+auto make_input(size_t num_slices, int64_t rows)
+  -> std::pair<std::vector<table_slice>, std::vector<event>> {
+  auto slices = std::vector<table_slice>{};
+  auto events = std::vector<event>{};
+  for (auto s = size_t{0}; s < num_slices; ++s) {
+    auto b = series_builder{};
+    for (auto j = int64_t{0}; j < rows; ++j) {
+      const auto i = static_cast<int64_t>(events.size());
+      auto k = i % 13 == 0 ? std::nullopt : std::optional{(i * 37) % 11};
+      auto r = b.record();
+      if (k) {
+        r.field("k", *k);
+      } else {
+        r.field("k").null();
+      }
+      r.field("i", i);
+      events.emplace_back(k, i);
+    }
+    slices.push_back(b.finish_assert_one_slice("tenzir.test"));
+  }
+  return {std::move(slices), std::move(events)};
+}
+
+auto to_events(const std::vector<table_slice>& output) -> std::vector<event> {
+  auto result = std::vector<event>{};
+  for (const auto& slice : output) {
+    for (auto row = size_t{0}; row < slice.rows(); ++row) {
+      auto k = slice.at(row, 0);
+      result.emplace_back(caf::holds_alternative<caf::none_t>(k)
+                            ? std::nullopt
+                            : std::optional{caf::get<int64_t>(k)},
+                          caf::get<int64_t>(slice.at(row, 1)));
+    }
+  }
+  return result;
+}
+
+/// Sorts events stably by their key.
+auto stable_sorted(std::vector<event> events, bool descending,
+                   bool nulls_first) -> std::vector<event> {
+  std::ranges::stable_sort(events, [&](const event& lhs, const event& rhs) {
+    if (not lhs.first or not rhs.first) {
+      if (lhs.first.has_value() == rhs.first.has_value()) {
+        return false;
+      }
+      return nulls_first ? not lhs.first : not rhs.first;
+    }
+    return descending ? *lhs.first > *rhs.first : *lhs.first < *rhs.first;
+  });
+  return events;
+}
+
+} // namespace
+
+TEST(sort spills runs and merges them stably) {
+  const auto cache_directory
+    = std::filesystem::temp_directory_path()
+      / fmt::format("tenzir-sort-test-{}", uuid::random());
+  // A budget of a single byte writes every slice as a separate run.
+  auto config = test::plugin_config{
+    "sort",
+    record{
+      {"sort-memory-budget", uint64_t{1}},
+      {"cache-directory", cache_directory.string()},
+    },
+  };
+  auto [input, events] = make_input(5, 40);
+  auto ctrl = test::control_plane{};
+  auto ascending = test::run_pipeline("sort --stable k", input, ctrl);
+  CHECK_EQUAL(to_events(ascending), stable_sorted(events, false, false));
+  auto descending
+    = test::run_pipeline("sort --stable k desc nulls-first", input, ctrl);
+  CHECK_EQUAL(to_events(descending), stable_sorted(events, true, true));
+  CHECK(ctrl.collect().empty());
+  // The runs were written below the cache directory, and removed afterwards.
+  const auto spill_directory = cache_directory / "sort";
+  CHECK(std::filesystem::exists(spill_directory));
+  CHECK(std::filesystem::is_empty(spill_directory));
+  std::filesystem::remove_all(cache_directory);
+}
+
+TEST(sort merges runs in multiple passes) {
+  const auto cache_directory
+    = std::filesystem::temp_directory_path()
+      / fmt::format("tenzir-sort-test-{}", uuid::random());
+  // Merging two runs at a time takes two intermediate passes over the seven
+  // runs before the final merge.
+  auto config = test::plugin_config{
+    "sort",
+    record{
+      {"sort-memory-budget", uint64_t{1}},
+      {"sort-merge-fan-in", uint64_t{2}},
+      {"cache-directory", cache_directory.string()},
+    },
+  };
+  auto [input, events] = make_input(7, 30);
+  auto ctrl = test::control_plane{};
+  auto output = test::run_pipeline("sort --stable k", input, ctrl);
+  CHECK_EQUAL(to_events(output), stable_sorted(events, false, false));
+  CHECK(ctrl.collect().empty());
+  CHECK(std::filesystem::is_empty(cache_directory / "sort"));
+  std::filesystem::remove_all(cache_directory);
+}
+
+TEST(sort in memory) {
+  auto [input, events] = make_input(3, 100);
+  auto ctrl = test::control_plane{};
+  auto config
+    = test::plugin_config{"sort", record{{"sort-memory-budget", uint64_t{0}}}};
+  auto in_memory = test::run_pipeline("sort --stable k", input, ctrl);
+  CHECK_EQUAL(to_events(in_memory), stable_sorted(events, false, false));
+}
+
+namespace {
+
+/// Parses and optimizes a pipeline.
+auto optimize(std::string_view repr) -> pipeline {
+  auto pipe = pipeline::internal_parse(repr);
+  REQUIRE_NOERROR(pipe);
+  auto opt = pipe->optimize(trivially_true_expression(), event_order::ordered);
+  auto* result = dynamic_cast<pipeline*>(opt.replacement.get());
+  REQUIRE(result);
+  return std::move(*result);
+}
+
+auto operator_names(const pipeline& pipe) -> std::vector<std::string> {
+  auto result = std::vector<std::string>{};
+  for (const auto& op : pipe.operators()) {
+    result.push_back(op->name());
+  }
+  return result;
+}
+
+} // namespace
+
+TEST(sort followed by head becomes top-k) {
+  using names = std::vector<std::string>;
+  CHECK_EQUAL(operator_names(optimize("sort k | head 7")),
+              (names{"internal-sort-top-k", "slice"}));
+  CHECK_EQUAL(operator_names(optimize("sort k | slice :7")),
+              (names{"internal-sort-top-k", "slice"}));
+  // Only a prefix of the input with a small enough limit allows for the
+  // fusion.
+  CHECK_EQUAL(operator_names(optimize("sort k | slice 2:7")),
+              (names{"sort", "slice"}));
+  CHECK_EQUAL(operator_names(optimize("sort k | head 1000000000")),
+              (names{"sort", "slice"}));
+  // The limit must directly follow the sort.
+  CHECK_EQUAL(operator_names(optimize("sort k | select k, i | head 7")),
+              (names{"sort", "select", "slice"}));
+}
+
+TEST(sort followed by a nested head becomes top-k) {
+  // `head` expands to a nested pipeline, which the outer pipeline flattens.
+  auto sort = pipeline::internal_parse_as_operator("sort k");
+  REQUIRE_NOERROR(sort);
+  auto head = pipeline::internal_parse_as_operator("head 7");
+  REQUIRE_NOERROR(head);
+  auto ops = std::vector<operator_ptr>{};
+  ops.push_back(std::move(*sort));
+  ops.push_back(std::move(*head));
+  auto pipe = pipeline{std::move(ops)};
+  auto opt = pipe.optimize(trivially_true_expression(), event_order::ordered);
+  auto* optimized = dynamic_cast<pipeline*>(opt.replacement.get());
+  REQUIRE(optimized);
+  CHECK_EQUAL(operator_names(*optimized),
+              (std::vector<std::string>{"internal-sort-top-k", "slice"}));
+}
+
+TEST(top-k matches sort followed by head) {
+  auto [input, events] = make_input(5, 40);
+  auto ctrl = test::control_plane{};
+  for (auto [keys, descending, nulls_first] : {
+         std::tuple{"k", false, false},
+         std::tuple{"k desc", true, false},
+         std::tuple{"k nulls-first", false, true},
+         std::tuple{"k desc nulls-first", true, true},
+       }) {
+    for (auto limit : {size_t{1}, size_t{25}, size_t{500}}) {
+      auto fused = optimize(fmt::format("sort --stable {} | head {}", keys,
+                                        limit));
+      REQUIRE_EQUAL(operator_names(fused).front(), "internal-sort-top-k");
+      auto expected = stable_sorted(events, descending, nulls_first);
+      expected.resize(std::min(limit, expected.size()));
+      CHECK_EQUAL(to_events(test::run_pipeline(fused, input, ctrl)), expected);
+    }
+  }
+  // Without `--stable`, only the keys must match.
+  auto fused = optimize("sort k | head 25");
+  auto actual = to_events(test::run_pipeline(fused, input, ctrl));
+  auto expected = stable_sorted(events, false, false);
+  REQUIRE_EQUAL(actual.size(), 25u);
+  for (auto i = size_t{0}; i < actual.size(); ++i) {
+    CHECK_EQUAL(actual[i].first, expected[i].first);
+  }
+  CHECK(ctrl.collect().empty());
+}
@@ -0,0 +1,209 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2024 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "tenzir/data.hpp"
+#include "tenzir/series_builder.hpp"
+#include "tenzir/table_slice.hpp"
+#include "tenzir/test/pipeline.hpp"
+#include "tenzir/test/test.hpp"
+#include "tenzir/time.hpp"
+#include "tenzir/uuid.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+using namespace tenzir;
+using namespace std::chrono_literals;
+
+namespace {
+
+auto at(std::chrono::seconds x) -> time {
+  return time{x};
+}
+
+/// Creates a slice with one event per given second, where `x` is the second
+/// and `ts` the corresponding event time.
+auto make_slice(std::vector<int64_t> seconds) -> table_slice {
+  auto b = series_builder{};
+  for (auto second : seconds) {
+    auto r = b.record();
+    r.field("ts", at(std::chrono::seconds{second}));
+    r.field("x", second);
+  }
+  return b.finish_assert_one_slice("tenzir.test");
+}
+
+using window_sum = std::tuple<time, time, int64_t>;
+
+/// Extracts the window bounds and the sum from the output of a windowed
+/// summarize with a single aggregation and *num_groups* group-by columns.
+auto window_sums(const std::vector<table_slice>& output, size_t num_groups = 0)
+  -> std::vector<window_sum> {
+  auto result = std::vector<window_sum>{};
+  for (const auto& slice : output) {
+    for (auto row = size_t{0}; row < slice.rows(); ++row) {
+      result.emplace_back(caf::get<time>(slice.at(row, 0)),
+                          caf::get<time>(slice.at(row, 1)),
+                          caf::get<int64_t>(slice.at(row, 2 + num_groups)));
+    }
+  }
+  return result;
+}
+
+auto count_messages(const std::vector<diagnostic>& diagnostics,
+                    std::string_view needle) -> size_t {
+  return std::ranges::count_if(diagnostics, [&](const diagnostic& diag) {
+    return diag.message.find(needle) != std::string::npos;
+  });
+}
+
+} // namespace
+
+TEST(summarize tumbling windows) {
+  auto ctrl = test::control_plane{};
+  auto output = test::run_pipeline(
+    "summarize s=sum(x) window 10s on ts",
+    {make_slice({0, 1, 5}), make_slice({12, 15}), make_slice({25})}, ctrl);
+  const auto expected = std::vector<window_sum>{
+    {at(0s), at(10s), 6},
+    {at(10s), at(20s), 27},
+    {at(20s), at(30s), 25},
+  };
+  CHECK_EQUAL(window_sums(output), expected);
+  CHECK(ctrl.collect().empty());
+}
+
+TEST(summarize sliding windows) {
+  auto ctrl = test::control_plane{};
+  auto output = test::run_pipeline(
+    "summarize s=sum(x) window 10s slide 5s on ts",
+    {make_slice({0, 1, 5}), make_slice({12, 15}), make_slice({25})}, ctrl);
+  const auto expected = std::vector<window_sum>{
+    {at(-5s), at(5s), 1},    {at(0s), at(10s), 6},   {at(5s), at(15s), 17},
+    {at(10s), at(20s), 27},  {at(15s), at(25s), 15}, {at(20s), at(30s), 25},
+    {at(25s), at(35s), 25},
+  };
+  CHECK_EQUAL(window_sums(output), expected);
+  CHECK(ctrl.collect().empty());
+}
+
+TEST(summarize drops late events) {
+  auto ctrl = test::control_plane{};
+  // The first slice advances the watermark to 15s, which closes the window
+  // that the event at 3s belongs to.
+  auto output
+    = test::run_pipeline("summarize s=sum(x) window 10s on ts",
+                         {make_slice({0, 15}), make_slice({3, 16})}, ctrl);
+  const auto expected = std::vector<window_sum>{
+    {at(0s), at(10s), 0},
+    {at(10s), at(20s), 31},
+  };
+  CHECK_EQUAL(window_sums(output), expected);
+  auto diagnostics = ctrl.collect();
+  CHECK_EQUAL(diagnostics.size(), 1u);
+  CHECK_EQUAL(count_messages(diagnostics, "dropped 1 events"), 1u);
+}
+
+TEST(summarize accepts late events within the lateness) {
+  auto ctrl = test::control_plane{};
+  auto output
+    = test::run_pipeline("summarize s=sum(x) window 10s on ts lateness 10s",
+                         {make_slice({0, 15}), make_slice({3, 16})}, ctrl);
+  const auto expected = std::vector<window_sum>{
+    {at(0s), at(10s), 3},
+    {at(10s), at(20s), 31},
+  };
+  CHECK_EQUAL(window_sums(output), expected);
+  CHECK(ctrl.collect().empty());
+}
+
+TEST(summarize windows warn once per schema) {
+  auto ctrl = test::control_plane{};
+  // The events span three windows, but the missing group-by column must only
+  // be reported once.
+  auto output = test::run_pipeline(
+    "summarize s=sum(x) by y window 10s on ts",
+    {make_slice({0, 1, 5}), make_slice({12, 15}), make_slice({25})}, ctrl);
+  CHECK_EQUAL(window_sums(output, 1).size(), 3u);
+  auto diagnostics = ctrl.collect();
+  CHECK_EQUAL(count_messages(diagnostics, "group-by column `y`"), 1u);
+}
+
+namespace {
+
+/// Creates slices with 1,000 groups that spread across all slices.
+auto make_groups(size_t num_slices, int64_t rows) -> std::vector<table_slice> {
+  auto result = std::vector<table_slice>{};
+  auto i = int64_t{0};
+  for (auto s = size_t{0}; s < num_slices; ++s) {
+    auto b = series_builder{};
+    for (auto j = int64_t{0}; j < rows; ++j, ++i) {
+      const auto g = (i * 7'919) % 1'000;
+      auto r = b.record();
+      r.field("g", g);
+      r.field("s", fmt::format("group-{}", g % 3));
+      r.field("x", i);
+    }
+    result.push_back(b.finish_assert_one_slice("tenzir.test"));
+  }
+  return result;
+}
+
+/// Runs a pipeline and returns all rows of its output in a canonical order.
+auto sorted_rows(std::string_view pipeline, std::vector<table_slice> input,
+                 test::control_plane& ctrl) -> std::vector<std::vector<data>> {
+  auto result
+    = test::rows(test::run_pipeline(pipeline, std::move(input), ctrl));
+  std::ranges::sort(result);
+  return result;
+}
+
+} // namespace
+
+TEST(summarize with spilling matches summarize in memory) {
+  constexpr auto pipeline = std::string_view{
+    "summarize n=count(.), total=sum(x), lo=min(x), hi=max(x) by g, s"};
+  const auto input = make_groups(10, 500);
+  auto ctrl = test::control_plane{};
+  auto in_memory = std::vector<std::vector<data>>{};
+  {
+    auto config = test::plugin_config{
+      "summarize", record{{"summarize-memory-budget", uint64_t{0}}}};
+    in_memory = sorted_rows(pipeline, input, ctrl);
+  }
+  const auto cache_directory
+    = std::filesystem::temp_directory_path()
+      / fmt::format("tenzir-summarize-test-{}", uuid::random());
+  // A budget of a single byte spills the groups after every batch, so every
+  // partition file holds several partial aggregations per group. Every
+  // partition also exceeds the budget on its own when restoring it, which
+  // splits it again recursively.
+  auto config = test::plugin_config{
+    "summarize",
+    record{
+      {"summarize-memory-budget", uint64_t{1}},
+      {"cache-directory", cache_directory.string()},
+    },
+  };
+  const auto spilled = sorted_rows(pipeline, input, ctrl);
+  CHECK_EQUAL(in_memory.size(), 1'000u);
+  CHECK_EQUAL(spilled, in_memory);
+  CHECK(ctrl.collect().empty());
+  // The spill files were written below the cache directory, and removed
+  // afterwards.
+  const auto spill_directory = cache_directory / "summarize";
+  CHECK(std::filesystem::exists(spill_directory));
+  CHECK(std::filesystem::is_empty(spill_directory));
+  std::filesystem::remove_all(cache_directory);
+}
@@ -0,0 +1,109 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2024 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "tenzir/table_slice.hpp"
+
+#include "tenzir/concept/parseable/tenzir/ip.hpp"
+#include "tenzir/concept/parseable/to.hpp"
+#include "tenzir/series_builder.hpp"
+#include "tenzir/subnet.hpp"
+#include "tenzir/test/test.hpp"
+
+namespace tenzir {
+
+namespace {
+
+/// Creates a slice with fixed-width, variable-width, extension, and nested
+/// columns, with a null in every column.
+auto make_slice(int64_t rows) -> table_slice {
+  auto b = series_builder{};
+  for (auto i = int64_t{0}; i < rows; ++i) {
+    auto r = b.record();
+    const auto is_null = i % 3 == 1;
+    if (is_null) {
+      r.field("x").null();
+      r.field("s").null();
+      r.field("ip").null();
+    } else {
+      r.field("x").data(i);
+      r.field("s").data(fmt::format("value-{}", i));
+      r.field("ip").data(unbox(to<ip>(fmt::format("10.0.0.{}", i))));
+    }
+    auto l = r.field("l").list();
+    for (auto j = int64_t{0}; j < i % 4; ++j) {
+      l.data(j);
+    }
+    auto nested = r.field("r").record();
+    nested.field("a").data(fmt::format("{}", i * i));
+    auto strings = nested.field("b").list();
+    for (auto j = int64_t{0}; j < i % 2; ++j) {
+      strings.data(fmt::format("{}", j));
+    }
+  }
+  return b.finish_assert_one_slice("tenzir.test");
+}
+
+} // namespace
+
+TEST(concatenate) {
+  const auto slice = make_slice(10);
+  REQUIRE_EQUAL(slice.rows(), 10u);
+  // Subslices share the buffers of their input at an offset, which the
+  // concatenation must take into account.
+  auto parts = std::vector<table_slice>{
+    subslice(slice, 0, 3),
+    subslice(slice, 3, 3),
+    subslice(slice, 3, 7),
+    subslice(slice, 7, 10),
+  };
+  const auto result = concatenate(parts);
+  CHECK_EQUAL(result.rows(), 10u);
+  CHECK_EQUAL(result.schema(), slice.schema());
+  CHECK_EQUAL(result, slice);
+  CHECK_EQUAL(concatenate({subslice(slice, 1, 5)}), subslice(slice, 1, 5));
+  CHECK_EQUAL(concatenate({}).rows(), 0u);
+}
+
+TEST(concatenate extension types) {
+  // Enumerations are dictionary arrays and subnets are structs below their
+  // extension types, which both need their storage concatenated.
+  const auto schema = type{
+    "tenzir.test",
+    record_type{
+      {"e", enumeration_type{{"foo"}, {"bar"}, {"baz"}}},
+      {"sn", subnet_type{}},
+    },
+  };
+  auto b = series_builder{schema};
+  for (auto i = uint32_t{0}; i < 10; ++i) {
+    auto r = b.record();
+    if (i % 4 == 3) {
+      r.field("e").null();
+      r.field("sn").null();
+    } else {
+      r.field("e").data(enumeration{static_cast<uint8_t>(i % 3)});
+      r.field("sn").data(subnet{ip::v4(0x0A000000 + (i << 8)), 24});
+    }
+  }
+  const auto slice = b.finish_assert_one_slice();
+  REQUIRE_EQUAL(slice.rows(), 10u);
+  auto parts = std::vector<table_slice>{
+    subslice(slice, 0, 4),
+    subslice(slice, 4, 5),
+    subslice(slice, 5, 10),
+  };
+  const auto result = concatenate(parts);
+  CHECK_EQUAL(result.schema(), schema);
+  CHECK_EQUAL(result, slice);
+  CHECK_EQUAL(materialize(result.at(2, 0)), data{enumeration{2}});
+  CHECK_EQUAL(materialize(result.at(3, 1)), data{});
+  CHECK_EQUAL(materialize(result.at(9, 1)),
+              data{subnet{ip::v4(0x0A000900), 24}});
+}
+
+} // namespace tenzir
@@ -0,0 +1,83 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2024 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "tenzir/tdigest.hpp"
+
+#include "tenzir/test/test.hpp"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace tenzir {
+
+namespace {
+
+auto near(double x, double expected, double tolerance) -> bool {
+  return std::abs(x - expected) <= tolerance;
+}
+
+} // namespace
+
+TEST(small inputs) {
+  auto digest = tdigest{};
+  CHECK(digest.empty());
+  digest.add(3.0);
+  CHECK_EQUAL(digest.quantile(0.5), 3.0);
+  for (auto i = 1; i <= 5; ++i) {
+    digest.add(i);
+  }
+  CHECK_EQUAL(digest.count(), 6.0);
+  CHECK_EQUAL(digest.min(), 1.0);
+  CHECK_EQUAL(digest.max(), 5.0);
+  CHECK_EQUAL(digest.quantile(0.0), 1.0);
+  CHECK_EQUAL(digest.quantile(1.0), 5.0);
+}
+
+TEST(uniform distribution) {
+  auto digest = tdigest{};
+  auto engine = std::mt19937_64{42};
+  auto distribution = std::uniform_real_distribution<double>{0.0, 10'000.0};
+  for (auto i = 0; i < 100'000; ++i) {
+    digest.add(distribution(engine));
+  }
+  CHECK(near(digest.quantile(0.5), 5'000.0, 50.0));
+  CHECK(near(digest.quantile(0.25), 2'500.0, 50.0));
+  CHECK(near(digest.quantile(0.99), 9'900.0, 10.0));
+  CHECK(near(digest.quantile(0.001), 10.0, 5.0));
+  CHECK_LESS_EQUAL(digest.centroids().size(), size_t{200});
+}
+
+TEST(merge) {
+  auto lhs = tdigest{};
+  auto rhs = tdigest{};
+  auto all = tdigest{};
+  for (auto i = 0; i < 10'000; ++i) {
+    auto x = static_cast<double>(i);
+    all.add(x);
+    (i % 3 == 0 ? lhs : rhs).add(x);
+  }
+  auto merged = lhs;
+  merged.merge(rhs);
+  CHECK_EQUAL(merged.count(), all.count());
+  CHECK_EQUAL(merged.min(), 0.0);
+  CHECK_EQUAL(merged.max(), 9'999.0);
+  CHECK(near(merged.quantile(0.5), all.quantile(0.5), 20.0));
+  // Merging the centroids of a digest yields the same estimates as merging the
+  // digest itself.
+  auto restored = lhs;
+  auto centroids = std::vector<tdigest::centroid>{};
+  for (const auto& x : rhs.centroids()) {
+    centroids.push_back(x);
+  }
+  restored.merge(centroids, rhs.min(), rhs.max());
+  CHECK_EQUAL(restored.count(), merged.count());
+  CHECK(near(restored.quantile(0.5), merged.quantile(0.5), 20.0));
+}
+
+} // namespace tenzir
@@ -0,0 +1,186 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2024 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "tenzir/chunk.hpp"
+#include "tenzir/data.hpp"
+#include "tenzir/table_slice.hpp"
+#include "tenzir/test/pipeline.hpp"
+#include "tenzir/test/test.hpp"
+#include "tenzir/type.hpp"
+
+#include <fmt/format.h>
+
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace tenzir;
+using namespace std::chrono_literals;
+
+namespace {
+
+auto parse(std::string_view pipeline, std::string input,
+           test::control_plane& ctrl) -> std::vector<table_slice> {
+  auto chunks = std::vector<chunk_ptr>{};
+  chunks.push_back(chunk::make(std::move(input)));
+  return test::run_pipeline(pipeline, std::move(chunks), ctrl);
+}
+
+/// Returns every event as a record of its top-level fields.
+auto events(const std::vector<table_slice>& output) -> std::vector<record> {
+  auto result = std::vector<record>{};
+  for (const auto& slice : output) {
+    const auto& schema = caf::get<record_type>(slice.schema());
+    for (auto row = size_t{0}; row < slice.rows(); ++row) {
+      auto& event = result.emplace_back();
+      for (auto col = size_t{0}; col < slice.columns(); ++col) {
+        event.emplace(std::string{schema.field(col).name},
+                      materialize(slice.at(row, col)));
+      }
+    }
+  }
+  return result;
+}
+
+auto str(std::string_view x) -> data {
+  return data{std::string{x}};
+}
+
+} // namespace
+
+TEST(xsv quoted fields) {
+  auto ctrl = test::control_plane{};
+  // Quoted fields may contain both separators and escaped quotes, and they
+  // always remain strings.
+  auto output = parse("read csv",
+                      "a,b,c\n"
+                      "\"x,y\",\"say \\\"hi\\\"\",\"1\"\n"
+                      "\"a much longer, quoted field\",\"a;b\",\"2\"\n",
+                      ctrl);
+  const auto expected = std::vector<record>{
+    {{"a", str("x,y")}, {"b", str("say \"hi\"")}, {"c", str("1")}},
+    {{"a", str("a much longer, quoted field")},
+     {"b", str("a;b")},
+     {"c", str("2")}},
+  };
+  CHECK_EQUAL(events(output), expected);
+  // Quoted list elements may contain separators as well.
+  auto lists = parse("read csv",
+                     "l\n"
+                     "\"a;b\";c;\"d,e\"\n",
+                     ctrl);
+  const auto expected_lists = std::vector<record>{
+    {{"l", list{str("a;b"), str("c"), str("d,e")}}},
+  };
+  CHECK_EQUAL(events(lists), expected_lists);
+  CHECK(ctrl.collect().empty());
+}
+
+TEST(xsv values spanning separators) {
+  // A space may occur within a time, so the time in the first cell spans the
+  // separator that follows its date.
+  auto ctrl = test::control_plane{};
+  auto output = parse("read ssv",
+                      "ts x\n"
+                      "2024-01-01 10:00:00 1\n",
+                      ctrl);
+  const auto ts = time{std::chrono::sys_days{std::chrono::year{2024} / 1 / 1}
+                       + 10h};
+  const auto expected = std::vector<record>{
+    {{"ts", data{ts}}, {"x", data{uint64_t{1}}}},
+  };
+  CHECK_EQUAL(events(output), expected);
+  CHECK(ctrl.collect().empty());
+}
+
+TEST(xsv separators at word boundaries) {
+  // The scan for separators looks at eight bytes at a time, so we move both
+  // separators across the first few words of the line.
+  constexpr auto width = size_t{24};
+  auto input = std::string{"a\tb\n"};
+  auto expected = std::vector<record>{};
+  for (auto n = size_t{0}; n <= width; ++n) {
+    const auto a = std::string(n, 'x');
+    const auto b = std::string(width - n, 'y');
+    input += fmt::format("{}\t{},z\xc3\xa9\n", a, b);
+    expected.push_back(
+      {{"a", str(a)}, {"b", list{str(b), str("z\xc3\xa9")}}});
+  }
+  auto ctrl = test::control_plane{};
+  auto output = parse("read tsv", std::move(input), ctrl);
+  CHECK_EQUAL(events(output), expected);
+  CHECK(ctrl.collect().empty());
+}
+
+TEST(xsv empty cells) {
+  // The null value of CSV is the empty string, but TSV uses `-` instead.
+  auto ctrl = test::control_plane{};
+  auto csv = parse("read csv",
+                   "a,b,c\n"
+                   ",1,\n"
+                   ",,\n",
+                   ctrl);
+  const auto expected_csv = std::vector<record>{
+    {{"a", data{}}, {"b", data{uint64_t{1}}}, {"c", data{}}},
+    {{"a", data{}}, {"b", data{}}, {"c", data{}}},
+  };
+  CHECK_EQUAL(events(csv), expected_csv);
+  auto tsv = parse("read tsv",
+                   "a\tb\tc\n"
+                   "\t1\t\n"
+                   "-\t-\t-\n",
+                   ctrl);
+  const auto expected_tsv = std::vector<record>{
+    {{"a", str("")}, {"b", data{uint64_t{1}}}, {"c", str("")}},
+    {{"a", data{}}, {"b", data{}}, {"c", data{}}},
+  };
+  CHECK_EQUAL(events(tsv), expected_tsv);
+  CHECK(ctrl.collect().empty());
+}
+
+TEST(xsv ragged rows) {
+  auto ctrl = test::control_plane{};
+  auto output = parse("read csv",
+                      "a,b,c\n"
+                      "1\n"
+                      "1,2,3,4,5\n",
+                      ctrl);
+  const auto expected = std::vector<record>{
+    {{"a", data{uint64_t{1}}}, {"b", data{}}, {"c", data{}}},
+    {{"a", data{uint64_t{1}}},
+     {"b", data{uint64_t{2}}},
+     {"c", data{uint64_t{3}}}},
+  };
+  CHECK_EQUAL(events(output), expected);
+  auto diagnostics = ctrl.collect();
+  REQUIRE_EQUAL(diagnostics.size(), 1u);
+  CHECK(diagnostics[0].severity == severity::warning);
+  CHECK_EQUAL(diagnostics[0].message, "skips 2 excess values in line");
+}
+
+TEST(xsv ragged rows with auto-expand) {
+  auto ctrl = test::control_plane{};
+  auto output = parse("read csv --auto-expand",
+                      "a,b\n"
+                      "1,2\n"
+                      "1,2,3,4\n",
+                      ctrl);
+  const auto expected = std::vector<record>{
+    {{"a", data{uint64_t{1}}},
+     {"b", data{uint64_t{2}}},
+     {"unnamed1", data{}},
+     {"unnamed2", data{}}},
+    {{"a", data{uint64_t{1}}},
+     {"b", data{uint64_t{2}}},
+     {"unnamed1", data{uint64_t{3}}},
+     {"unnamed2", data{uint64_t{4}}}},
+  };
+  CHECK_EQUAL(events(output), expected);
+  CHECK(ctrl.collect().empty());
+}
@@ -0,0 +1,134 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2024 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "tenzir/chunk.hpp"
+#include "tenzir/data.hpp"
+#include "tenzir/table_slice.hpp"
+#include "tenzir/test/pipeline.hpp"
+#include "tenzir/test/test.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace tenzir;
+
+namespace {
+
+/// Creates a Zeek document with a string, a count, and a vector column.
+auto make_document(std::string_view path, std::string_view rows)
+  -> std::string {
+  return fmt::format("#separator \\x09\n"
+                     "#set_separator\t,\n"
+                     "#empty_field\t(empty)\n"
+                     "#unset_field\t-\n"
+                     "#path\t{}\n"
+                     "#fields\ts\tn\tv\n"
+                     "#types\tstring\tcount\tvector[string]\n"
+                     "{}"
+                     "#close\t2024-01-01-00-00-00\n",
+                     path, rows);
+}
+
+auto parse(std::string input, test::control_plane& ctrl)
+  -> std::vector<table_slice> {
+  auto chunks = std::vector<chunk_ptr>{};
+  chunks.push_back(chunk::make(std::move(input)));
+  return test::run_pipeline("read zeek-tsv", std::move(chunks), ctrl);
+}
+
+auto num_errors(const std::vector<diagnostic>& diagnostics) -> size_t {
+  return std::ranges::count_if(diagnostics, [](const diagnostic& diag) {
+    return diag.severity == severity::error;
+  });
+}
+
+} // namespace
+
+TEST(zeek tsv set unset and empty fields) {
+  auto ctrl = test::control_plane{};
+  auto output = parse(make_document("test", "a\t1\tx,y\n"
+                                            "-\t-\t-\n"
+                                            "(empty)\t(empty)\t(empty)\n"),
+                      ctrl);
+  const auto expected = std::vector<std::vector<data>>{
+    {data{"a"}, data{uint64_t{1}}, data{list{data{"x"}, data{"y"}}}},
+    {data{}, data{}, data{}},
+    {data{""}, data{uint64_t{0}}, data{list{}}},
+  };
+  CHECK_EQUAL(test::rows(output), expected);
+  CHECK(ctrl.collect().empty());
+}
+
+TEST(zeek tsv rejects empty values) {
+  // Empty values must use the empty field marker.
+  for (const auto* row : {"\t1\tx\n", "a\t\tx\n", "a\t1\t\n", "a\t1\tx,,y\n"}) {
+    auto ctrl = test::control_plane{};
+    auto output = parse(make_document("test", row), ctrl);
+    CHECK(output.empty());
+    CHECK_EQUAL(num_errors(ctrl.collect()), 1u);
+  }
+}
+
+TEST(zeek tsv mid-row parse failure) {
+  auto ctrl = test::control_plane{};
+  // The first document is complete, and the second document fails in the
+  // middle of its second row after appending the first value of that row.
+  auto output = parse(make_document("first", "a\t1\tx\n"
+                                             "b\t2\ty\n")
+                        + make_document("second", "c\t3\tz\n"
+                                                  "d\tnope\tz\n"),
+                      ctrl);
+  REQUIRE_EQUAL(output.size(), 1u);
+  CHECK_EQUAL(output[0].schema().name(), "zeek.first");
+  CHECK_EQUAL(output[0].rows(), 2u);
+  CHECK_EQUAL(num_errors(ctrl.collect()), 1u);
+}
+
+TEST(zeek tsv reuses layouts across documents) {
+  auto ctrl = test::control_plane{};
+  auto output = parse(make_document("test", "a\t1\tx\n")
+                        + make_document("other", "b\t2\ty\n")
+                        + make_document("test", "c\t3\tz\n"),
+                      ctrl);
+  REQUIRE_EQUAL(output.size(), 3u);
+  CHECK_EQUAL(output[0].schema(), output[2].schema());
+  CHECK_NOT_EQUAL(output[0].schema(), output[1].schema());
+  const auto expected = std::vector<std::vector<data>>{
+    {data{"a"}, data{uint64_t{1}}, data{list{data{"x"}}}},
+    {data{"b"}, data{uint64_t{2}}, data{list{data{"y"}}}},
+    {data{"c"}, data{uint64_t{3}}, data{list{data{"z"}}}},
+  };
+  CHECK_EQUAL(test::rows(output), expected);
+  CHECK(ctrl.collect().empty());
+}
+
+TEST(zeek tsv with more layouts than the cache holds) {
+  // The parser caches up to 1,024 layouts, so the last document must create
+  // its layout again after the cache was cleared.
+  constexpr auto num_documents = size_t{1'100};
+  auto input = std::string{};
+  for (auto i = size_t{0}; i < num_documents; ++i) {
+    input += make_document(fmt::format("path{}", i),
+                           fmt::format("a\t{}\tx\n", i));
+  }
+  input += make_document("path0", "b\t0\ty\n");
+  auto ctrl = test::control_plane{};
+  auto output = parse(std::move(input), ctrl);
+  REQUIRE_EQUAL(output.size(), num_documents + 1);
+  for (auto i = size_t{0}; i < num_documents; ++i) {
+    CHECK_EQUAL(output[i].schema().name(), fmt::format("zeek.path{}", i));
+    CHECK_EQUAL(materialize(output[i].at(0, 1)), data{uint64_t{i}});
+  }
+  CHECK_EQUAL(output.back().schema(), output.front().schema());
+  CHECK_EQUAL(materialize(output.back().at(0, 0)), data{"b"});
+  CHECK(ctrl.collect().empty());
+}
@@ -0,0 +1,109 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2024 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "tenzir/zone_map.hpp"
+
+#include "tenzir/concept/parseable/tenzir/expression.hpp"
+#include "tenzir/concept/parseable/to.hpp"
+#include "tenzir/expression.hpp"
+#include "tenzir/fbs/utils.hpp"
+#include "tenzir/fbs/zone_map.hpp"
+#include "tenzir/series_builder.hpp"
+#include "tenzir/table_slice.hpp"
+#include "tenzir/test/test.hpp"
+
+namespace tenzir {
+
+namespace {
+
+auto make_slice() -> table_slice {
+  auto b = series_builder{};
+  for (auto i = int64_t{10}; i <= 20; ++i) {
+    auto r = b.record();
+    r.field("x", i);
+    r.field("y", i % 2 == 0 ? data_view2{1.5} : data_view2{caf::none});
+    r.field("z", "foo");
+  }
+  return b.finish_assert_one_slice("test");
+}
+
+auto may_match(const zone_map& zm, const table_slice& slice,
+               std::string_view str) -> bool {
+  auto expr = unbox(tailor(unbox(to<expression>(str)), slice.schema()));
+  return zm.may_match(expr);
+}
+
+} // namespace
+
+TEST(statistics) {
+  auto slice = make_slice();
+  auto zm = zone_map::make(slice);
+  CHECK_EQUAL(zm.rows, 11u);
+  REQUIRE_EQUAL(zm.columns.size(), 3u);
+  CHECK_EQUAL(zm.columns[0].min, data{int64_t{10}});
+  CHECK_EQUAL(zm.columns[0].max, data{int64_t{20}});
+  CHECK_EQUAL(zm.columns[0].null_count.value_or(1), 0u);
+  CHECK_EQUAL(zm.columns[1].min, data{1.5});
+  CHECK_EQUAL(zm.columns[1].max, data{1.5});
+  CHECK_EQUAL(zm.columns[1].null_count.value_or(0), 5u);
+  CHECK_EQUAL(zm.columns[2].min, data{});
+}
+
+TEST(pruning) {
+  auto slice = make_slice();
+  auto zm = zone_map::make(slice);
+  CHECK(may_match(zm, slice, "x == 15"));
+  CHECK(may_match(zm, slice, "x == 10"));
+  CHECK(not may_match(zm, slice, "x == 9"));
+  CHECK(not may_match(zm, slice, "x == 21"));
+  CHECK(not may_match(zm, slice, "x > 20"));
+  CHECK(may_match(zm, slice, "x >= 20"));
+  CHECK(not may_match(zm, slice, "x < 10"));
+  CHECK(may_match(zm, slice, "x <= 10"));
+  CHECK(not may_match(zm, slice, "9 >= x"));
+  CHECK(may_match(zm, slice, "x in [1, 2, 15]"));
+  CHECK(not may_match(zm, slice, "x in [1, 2, 3]"));
+  CHECK(may_match(zm, slice, "x != 10"));
+  CHECK(not may_match(zm, slice, "y > 2.0"));
+  CHECK(may_match(zm, slice, "y != 1.5"));
+  CHECK(may_match(zm, slice, "y == null"));
+  CHECK(not may_match(zm, slice, "x == null"));
+  CHECK(may_match(zm, slice, "z == \"bar\""));
+  CHECK(not may_match(zm, slice, "x > 20 && z == \"foo\""));
+  CHECK(may_match(zm, slice, "x > 20 || z == \"foo\""));
+  CHECK(not may_match(zm, slice, "x > 20 || x < 10"));
+  CHECK(may_match(zm, slice, "! (x > 20)"));
+}
+
+TEST(packing) {
+  auto zone_maps = std::vector<zone_map>{zone_map::make(make_slice())};
+  auto chunk = unbox(pack_zone_maps(zone_maps));
+  auto result = unbox(unpack_zone_maps(chunk));
+  REQUIRE_EQUAL(result.size(), 1u);
+  const auto& zm = zone_maps[0];
+  CHECK_EQUAL(result[0].rows, zm.rows);
+  CHECK_EQUAL(result[0].import_time, zm.import_time);
+  REQUIRE_EQUAL(result[0].columns.size(), zm.columns.size());
+  for (auto i = size_t{0}; i < zm.columns.size(); ++i) {
+    CHECK_EQUAL(result[0].columns[i].min, zm.columns[i].min);
+    CHECK_EQUAL(result[0].columns[i].max, zm.columns[i].max);
+    CHECK(result[0].columns[i].null_count == zm.columns[i].null_count);
+  }
+}
+
+TEST(unknown version) {
+  auto builder = flatbuffers::FlatBufferBuilder{};
+  const auto v0_offset = fbs::zone_map::Createv0(builder);
+  const auto zone_maps_offset = fbs::CreateZoneMaps(
+    builder, static_cast<fbs::zone_map::ZoneMaps>(42), v0_offset.Union());
+  fbs::FinishZoneMapsBuffer(builder, zone_maps_offset);
+  CHECK(not unpack_zone_maps(fbs::release(builder)));
+  CHECK(not unpack_zone_maps(chunk::copy(std::string_view{"garbage"})));
+}
+
+} // namespace tenzir
@@ -0,0 +1,143 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2024 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "tenzir/test/pipeline.hpp"
+
+#include "tenzir/die.hpp"
+#include "tenzir/error.hpp"
+#include "tenzir/generator.hpp"
+#include "tenzir/plugin.hpp"
+#include "tenzir/test/test.hpp"
+
+#include <fmt/format.h>
+
+namespace tenzir::test {
+
+namespace {
+
+template <class T>
+auto make_input(std::vector<T> xs) -> generator<T> {
+  for (auto& x : xs) {
+    co_yield std::move(x);
+  }
+}
+
+/// Re-initializes all plugins called *name* with the given global options.
+auto initialize(std::string_view name, const record& options) -> caf::error {
+  auto found = false;
+  for (auto& plugin : plugins::get_mutable()) {
+    if (plugin->name() == name) {
+      found = true;
+      if (auto err = plugin->initialize({}, record{{"tenzir", options}})) {
+        return err;
+      }
+    }
+  }
+  if (not found) {
+    return caf::make_error(ec::lookup_error,
+                           fmt::format("plugin `{}` not found", name));
+  }
+  return {};
+}
+
+} // namespace
+
+auto control_plane::self() noexcept -> exec_node_actor::base& {
+  die("not implemented");
+}
+
+auto control_plane::node() noexcept -> node_actor {
+  die("not implemented");
+}
+
+auto control_plane::diagnostics() noexcept -> diagnostic_handler& {
+  return diagnostics_;
+}
+
+auto control_plane::no_location_overrides() const noexcept -> bool {
+  return true;
+}
+
+auto control_plane::has_terminal() const noexcept -> bool {
+  return false;
+}
+
+auto control_plane::set_waiting(bool value) noexcept -> void {
+  // We poll the operators until they are done, so there is nothing to wait
+  // for.
+  (void)value;
+}
+
+auto control_plane::make_waker() noexcept -> std::function<void()> {
+  // See `set_waiting`; operators never wait, so there is nothing to resume.
+  return [] {};
+}
+
+auto control_plane::collect() -> std::vector<diagnostic> {
+  return std::exchange(diagnostics_, {}).collect();
+}
+
+auto run_pipeline(const pipeline& pipe, operator_input input,
+                  control_plane& ctrl) -> std::vector<table_slice> {
+  auto output = pipe.instantiate(std::move(input), ctrl);
+  REQUIRE_NOERROR(output);
+  auto* events = std::get_if<generator<table_slice>>(&*output);
+  REQUIRE(events);
+  auto result = std::vector<table_slice>{};
+  for (auto&& slice : *events) {
+    if (slice.rows() > 0) {
+      result.push_back(std::move(slice));
+    }
+  }
+  return result;
+}
+
+auto run_pipeline(const pipeline& pipe, std::vector<table_slice> input,
+                  control_plane& ctrl) -> std::vector<table_slice> {
+  return run_pipeline(pipe, make_input(std::move(input)), ctrl);
+}
+
+auto run_pipeline(std::string_view repr, std::vector<table_slice> input,
+                  control_plane& ctrl) -> std::vector<table_slice> {
+  auto pipe = pipeline::internal_parse(repr);
+  REQUIRE_NOERROR(pipe);
+  return run_pipeline(*pipe, std::move(input), ctrl);
+}
+
+auto run_pipeline(std::string_view repr, std::vector<chunk_ptr> input,
+                  control_plane& ctrl) -> std::vector<table_slice> {
+  auto pipe = pipeline::internal_parse(repr);
+  REQUIRE_NOERROR(pipe);
+  return run_pipeline(*pipe, make_input(std::move(input)), ctrl);
+}
+
+plugin_config::plugin_config(std::string name, const record& options)
+  : name_{std::move(name)} {
+  REQUIRE_EQUAL(initialize(name_, options), caf::error{});
+}
+
+plugin_config::~plugin_config() noexcept {
+  // Requirements must not throw from a destructor, so we only check here.
+  CHECK_EQUAL(initialize(name_, record{}), caf::error{});
+}
+
+auto rows(const std::vector<table_slice>& output)
+  -> std::vector<std::vector<data>> {
+  auto result = std::vector<std::vector<data>>{};
+  for (const auto& slice : output) {
+    for (auto row = size_t{0}; row < slice.rows(); ++row) {
+      auto& values = result.emplace_back();
+      for (auto col = size_t{0}; col < slice.columns(); ++col) {
+        values.push_back(materialize(slice.at(row, col)));
+      }
+    }
+  }
+  return result;
+}
+
+} // namespace tenzir::test
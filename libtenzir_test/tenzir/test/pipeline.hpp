@@ -0,0 +1,110 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2024 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include "tenzir/chunk.hpp"
+#include "tenzir/data.hpp"
+#include "tenzir/diagnostics.hpp"
+#include "tenzir/operator_control_plane.hpp"
+#include "tenzir/pipeline.hpp"
+#include "tenzir/table_slice.hpp"
+#include "tenzir/view.hpp"
+
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace tenzir::test {
+
+/// A control plane for running operators without an actor context. It
+/// collects all diagnostics, and operators must not access the actor system.
+class control_plane final : public operator_control_plane {
+public:
+  auto self() noexcept -> exec_node_actor::base& override;
+
+  auto node() noexcept -> node_actor override;
+
+  auto diagnostics() noexcept -> diagnostic_handler& override;
+
+  auto no_location_overrides() const noexcept -> bool override;
+
+  auto has_terminal() const noexcept -> bool override;
+
+  auto set_waiting(bool value) noexcept -> void override;
+
+  auto make_waker() noexcept -> std::function<void()> override;
+
+  /// Returns all diagnostics emitted so far.
+  auto collect() -> std::vector<diagnostic>;
+
+private:
+  collecting_diagnostic_handler diagnostics_;
+};
+
+/// Runs an unoptimized pipeline to completion and returns all non-empty
+/// output events.
+/// @pre The pipeline accepts the given input and returns events.
+auto run_pipeline(const pipeline& pipe, operator_input input,
+                  control_plane& ctrl) -> std::vector<table_slice>;
+
+/// Runs a pipeline on events without optimizing it, and returns its output
+/// events.
+auto run_pipeline(const pipeline& pipe, std::vector<table_slice> input,
+                  control_plane& ctrl) -> std::vector<table_slice>;
+
+/// Parses a pipeline, runs it on events, and returns its output events.
+auto run_pipeline(std::string_view repr, std::vector<table_slice> input,
+                  control_plane& ctrl) -> std::vector<table_slice>;
+
+/// Parses a pipeline, runs it on bytes, and returns its output events.
+auto run_pipeline(std::string_view repr, std::vector<chunk_ptr> input,
+                  control_plane& ctrl) -> std::vector<table_slice>;
+
+/// Re-initializes a plugin with options below `tenzir` for the lifetime of
+/// this object, and restores the defaults of the plugin afterwards. Since
+/// failing test requirements unwind the stack, they do not leak the options
+/// into other tests.
+class plugin_config {
+public:
+  plugin_config(std::string name, const record& options);
+  ~plugin_config() noexcept;
+
+  plugin_config(const plugin_config&) = delete;
+  auto operator=(const plugin_config&) -> plugin_config& = delete;
+  plugin_config(plugin_config&&) = delete;
+  auto operator=(plugin_config&&) -> plugin_config& = delete;
+
+private:
+  std::string name_;
+};
+
+/// Returns the values of all leaf columns of every event.
+auto rows(const std::vector<table_slice>& output)
+  -> std::vector<std::vector<data>>;
+
+/// Returns the values of the leaf column *col* of every event.
+/// @pre Unless *T* is `data`, all values of the column are of type *T*.
+template <class T = data>
+auto column(const std::vector<table_slice>& output, size_t col)
+  -> std::vector<T> {
+  auto result = std::vector<T>{};
+  for (const auto& slice : output) {
+    for (auto row = size_t{0}; row < slice.rows(); ++row) {
+      if constexpr (std::is_same_v<T, data>) {
+        result.push_back(materialize(slice.at(row, col)));
+      } else {
+        result.push_back(materialize(caf::get<view<T>>(slice.at(row, col))));
+      }
+    }
+  }
+  return result;
+}
+
+} // namespace tenzir::test
@@ -0,0 +1,110 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2024 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include <tenzir/chunk.hpp>
+#include <tenzir/defaults.hpp>
+#include <tenzir/store.hpp>
+#include <tenzir/table_slice.hpp>
+#include <tenzir/type.hpp>
+#include <tenzir/zone_map.hpp>
+
+#include <arrow/type_fwd.h>
+#include <parquet/arrow/reader.h>
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace tenzir::plugins::parquet {
+
+/// Options for writing Parquet stores.
+struct store_options {
+  /// The maximum number of events per row group.
+  uint64_t row_group_size = defaults::import::table_slice_size;
+
+  /// Whether to use dictionary encoding for columns.
+  bool dictionary_encoding = true;
+
+  /// The Zstd compression level.
+  int zstd_compression_level = 3;
+};
+
+/// A store that reads partitions written as Parquet files. Extract queries
+/// read only the row groups whose statistics may match the query expression,
+/// and only the columns needed for the query.
+class passive_parquet_store final : public passive_store {
+public:
+  [[nodiscard]] caf::error load(chunk_ptr chunk) override;
+
+  [[nodiscard]] generator<table_slice> slices() const override;
+
+  [[nodiscard]] generator<table_slice>
+  extract(expression expr, ids selection,
+          std::optional<std::vector<std::string>> fields) const override;
+
+  [[nodiscard]] uint64_t num_events() const override;
+
+  [[nodiscard]] type schema() const override;
+
+private:
+  /// Returns the row group at the given index as a table slice, reading it
+  /// from the file if it was not read before.
+  auto slice_at(int index, id offset) const -> const table_slice&;
+
+  /// Reads the row group at the given index, including only the given
+  /// top-level fields, or all fields if `included` is empty. The resulting
+  /// table slice has the given schema, which must contain exactly the included
+  /// fields.
+  auto read_row_group(int index, const std::vector<int>& included,
+                      const std::shared_ptr<arrow::Schema>& arrow_schema,
+                      const type& schema) const -> table_slice;
+
+  /// Executes an extract query, skipping all row groups that cannot match the
+  /// expression according to their statistics. If `included` is non-empty,
+  /// only the included top-level fields are read from the file. If `columns`
+  /// is non-empty, only the given columns are returned.
+  auto extract_row_groups(expression expr, ids selection,
+                          std::vector<offset> columns,
+                          std::vector<int> included) const
+    -> generator<table_slice>;
+
+  chunk_ptr chunk_ = {};
+  std::unique_ptr<::parquet::arrow::FileReader> reader_ = {};
+  std::shared_ptr<arrow::Schema> arrow_schema_ = {};
+  type schema_ = {};
+  std::vector<time> import_times_ = {};
+  std::vector<zone_map> zone_maps_ = {};
+  mutable std::vector<table_slice> cached_slices_ = {};
+};
+
+/// A store that accumulates events in memory and writes them as a Parquet
+/// file with one row group per batch of events.
+class active_parquet_store final : public active_store {
+public:
+  explicit active_parquet_store(store_options options);
+
+  [[nodiscard]] caf::error add(std::vector<table_slice> new_slices) override;
+
+  [[nodiscard]] caf::expected<chunk_ptr> finish() override;
+
+  [[nodiscard]] generator<table_slice> slices() const override;
+
+  [[nodiscard]] uint64_t num_events() const override;
+
+private:
+  store_options options_ = {};
+  std::vector<table_slice> new_slices_ = {};
+  std::vector<table_slice> rebatched_slices_ = {};
+  uint64_t num_new_events_ = {};
+  uint64_t num_events_ = {};
+};
+
+} // namespace tenzir::plugins::parquet
@@ -7,8 +7,10 @@
 // SPDX-License-Identifier: BSD-3-Clause
 
 #include "parquet/chunked_buffer_output_stream.hpp"
+#include "parquet/store.hpp"
 
 #include <tenzir/argument_parser.hpp>
+#include <tenzir/detail/narrow.hpp>
 #include <tenzir/drain_bytes.hpp>
 #include <tenzir/fwd.hpp>
 #include <tenzir/plugin.hpp>
@@ -269,7 +271,38 @@ private:
 };
 
 class plugin final : public virtual parser_plugin<parquet_parser>,
-                     public virtual printer_plugin<parquet_printer> {
+                     public virtual printer_plugin<parquet_printer>,
+                     public virtual store_plugin {
+  auto initialize(const record& plugin_config,
+                  [[maybe_unused]] const record& global_config)
+    -> caf::error override {
+    auto row_group_size = try_get_or<uint64_t>(
+      plugin_config, "row-group-size", store_options_.row_group_size);
+    if (not row_group_size) {
+      return std::move(row_group_size.error());
+    }
+    if (*row_group_size == 0) {
+      return caf::make_error(ec::invalid_configuration,
+                             "plugins.parquet.row-group-size must be nonzero");
+    }
+    auto dictionary_encoding = try_get_or<bool>(
+      plugin_config, "dictionary-encoding", store_options_.dictionary_encoding);
+    if (not dictionary_encoding) {
+      return std::move(dictionary_encoding.error());
+    }
+    auto zstd_compression_level
+      = try_get_or<int64_t>(plugin_config, "zstd-compression-level",
+                            store_options_.zstd_compression_level);
+    if (not zstd_compression_level) {
+      return std::move(zstd_compression_level.error());
+    }
+    store_options_.row_group_size = *row_group_size;
+    store_options_.dictionary_encoding = *dictionary_encoding;
+    store_options_.zstd_compression_level
+      = detail::narrow_cast<int>(*zstd_compression_level);
+    return {};
+  }
+
   auto parse_parser(parser_interface& p) const
     -> std::unique_ptr<plugin_parser> override {
     auto parser = argument_parser{"parquet", "https://docs.tenzir.com/"
@@ -292,6 +325,19 @@ class plugin final : public virtual parser_plugin<parquet_parser>,
   [[nodiscard]] std::string name() const override {
     return "parquet";
   }
+
+  [[nodiscard]] caf::expected<std::unique_ptr<passive_store>>
+  make_passive_store() const override {
+    return std::make_unique<passive_parquet_store>();
+  }
+
+  [[nodiscard]] caf::expected<std::unique_ptr<active_store>>
+  make_active_store() const override {
+    return std::make_unique<active_parquet_store>(store_options_);
+  }
+
+private:
+  store_options store_options_ = {};
 };
 } // namespace
 
@@ -0,0 +1,464 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2024 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "parquet/store.hpp"
+
+#include <tenzir/arrow_table_slice.hpp>
+#include <tenzir/collect.hpp>
+#include <tenzir/detail/narrow.hpp>
+#include <tenzir/detail/overload.hpp>
+#include <tenzir/die.hpp>
+#include <tenzir/error.hpp>
+#include <tenzir/evaluate.hpp>
+#include <tenzir/logger.hpp>
+
+#include <arrow/io/memory.h>
+#include <arrow/record_batch.h>
+#include <arrow/table.h>
+#include <arrow/type.h>
+#include <arrow/util/key_value_metadata.h>
+#include <parquet/arrow/schema.h>
+#include <parquet/arrow/writer.h>
+#include <parquet/exception.h>
+#include <parquet/file_reader.h>
+#include <parquet/statistics.h>
+
+#include <charconv>
+
+namespace tenzir::plugins::parquet {
+
+namespace {
+
+/// The key of the schema metadata that holds the comma-separated import times
+/// of all row groups in nanoseconds since the epoch.
+constexpr auto import_times_key = std::string_view{"TENZIR:import_times"};
+
+/// Parses the comma-separated import times of all row groups.
+auto parse_import_times(std::string_view str)
+  -> std::optional<std::vector<time>> {
+  auto result = std::vector<time>{};
+  while (not str.empty()) {
+    auto value = int64_t{};
+    const auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(),
+                                           value);
+    if (ec != std::errc{}) {
+      return std::nullopt;
+    }
+    result.emplace_back(duration{value});
+    str.remove_prefix(ptr - str.data());
+    if (not str.empty()) {
+      if (str.front() != ',') {
+        return std::nullopt;
+      }
+      str.remove_prefix(1);
+    }
+  }
+  return result;
+}
+
+/// Appends the indices of all Parquet leaf columns of a field.
+auto collect_column_indices(const ::parquet::arrow::SchemaField& field,
+                            std::vector<int>& result) -> void {
+  if (field.column_index >= 0) {
+    result.push_back(field.column_index);
+  }
+  for (const auto& child : field.children) {
+    collect_column_indices(child, result);
+  }
+}
+
+/// Creates a zone map from the statistics of a row group. Minimum and maximum
+/// values are only taken from 64-bit integer columns. We do not use them for
+/// double columns because Parquet statistics ignore NaN values.
+auto make_zone_map(const ::parquet::RowGroupMetaData& metadata,
+                   const ::parquet::arrow::SchemaManifest& manifest,
+                   const type& schema, time import_time) -> zone_map {
+  auto result = zone_map{};
+  result.rows = detail::narrow_cast<uint64_t>(metadata.num_rows());
+  result.import_time = import_time;
+  const auto& layout = caf::get<record_type>(schema);
+  result.columns.reserve(layout.num_leaves());
+  for (auto&& leaf : layout.leaves()) {
+    auto& stats = result.columns.emplace_back();
+    // Lists and maps are leaves for us, but not for Parquet, so we can only
+    // use the statistics of fields that are nested in records exclusively.
+    const auto* field = &manifest.schema_fields[leaf.index[0]];
+    for (auto i = size_t{1}; i < leaf.index.size(); ++i) {
+      field = &field->children[leaf.index[i]];
+    }
+    if (field->column_index < 0) {
+      continue;
+    }
+    const auto column = metadata.ColumnChunk(field->column_index);
+    if (not column->is_stats_set()) {
+      continue;
+    }
+    const auto statistics = column->statistics();
+    if (not statistics) {
+      continue;
+    }
+    if (statistics->HasNullCount()) {
+      stats.null_count = detail::narrow_cast<uint64_t>(
+        statistics->null_count());
+    }
+    if (not statistics->HasMinMax()
+        or statistics->physical_type() != ::parquet::Type::INT64) {
+      continue;
+    }
+    const auto& typed_statistics
+      = static_cast<const ::parquet::Int64Statistics&>(*statistics);
+    const auto min = typed_statistics.min();
+    const auto max = typed_statistics.max();
+    auto f = detail::overload{
+      [&](const int64_type&) {
+        stats.min = min;
+        stats.max = max;
+      },
+      [&](const uint64_type&) {
+        // Unsigned integers are stored as signed integers, but their
+        // statistics use the unsigned sort order.
+        stats.min = static_cast<uint64_t>(min);
+        stats.max = static_cast<uint64_t>(max);
+      },
+      [&](const duration_type&) {
+        stats.min = duration{min};
+        stats.max = duration{max};
+      },
+      [&](const time_type&) {
+        stats.min = time{duration{min}};
+        stats.max = time{duration{max}};
+      },
+      [](const auto&) {},
+    };
+    caf::visit(f, leaf.field.type);
+  }
+  return result;
+}
+
+} // namespace
+
+// -- passive store -----------------------------------------------------------
+
+caf::error passive_parquet_store::load(chunk_ptr chunk) {
+  auto properties = ::parquet::ReaderProperties(arrow::default_memory_pool());
+  auto arrow_properties = ::parquet::ArrowReaderProperties();
+  auto reader = std::unique_ptr<::parquet::arrow::FileReader>{};
+  try {
+    auto file_reader
+      = ::parquet::ParquetFileReader::Open(as_arrow_file(chunk), properties);
+    auto status = ::parquet::arrow::FileReader::Make(
+      arrow::default_memory_pool(), std::move(file_reader), arrow_properties,
+      &reader);
+    if (not status.ok()) {
+      return caf::make_error(ec::format_error,
+                             fmt::format("failed to load parquet store: {}",
+                                         status.ToString()));
+    }
+  } catch (const ::parquet::ParquetException& err) {
+    return caf::make_error(ec::format_error,
+                           fmt::format("failed to load parquet store: {}",
+                                       err.what()));
+  }
+  auto arrow_schema = std::shared_ptr<arrow::Schema>{};
+  if (auto status = reader->GetSchema(&arrow_schema); not status.ok()) {
+    return caf::make_error(ec::format_error,
+                           fmt::format("failed to load parquet store: {}",
+                                       status.ToString()));
+  }
+  // The import times are part of the schema metadata, so we need to remove
+  // them before converting the schema.
+  const auto& metadata = arrow_schema->metadata();
+  if (not metadata or not metadata->Contains("TENZIR:name:0")
+      or not metadata->Contains(std::string{import_times_key})) {
+    return caf::make_error(ec::format_error,
+                           "failed to load parquet store: missing metadata");
+  }
+  auto import_times = parse_import_times(
+    metadata->Get(std::string{import_times_key}).ValueOrDie());
+  if (not import_times
+      or detail::narrow_cast<int>(import_times->size())
+           != reader->num_row_groups()) {
+    return caf::make_error(ec::format_error,
+                           "failed to load parquet store: invalid import times");
+  }
+  auto schema_metadata = metadata->Copy();
+  const auto delete_status
+    = schema_metadata->Delete(std::string{import_times_key});
+  TENZIR_ASSERT(delete_status.ok());
+  chunk_ = std::move(chunk);
+  reader_ = std::move(reader);
+  arrow_schema_ = arrow_schema->WithMetadata(std::move(schema_metadata));
+  schema_ = type::from_arrow(*arrow_schema_);
+  import_times_ = std::move(*import_times);
+  const auto file_metadata = reader_->parquet_reader()->metadata();
+  zone_maps_.reserve(import_times_.size());
+  for (auto i = 0; i < reader_->num_row_groups(); ++i) {
+    zone_maps_.push_back(make_zone_map(*file_metadata->RowGroup(i),
+                                       reader_->manifest(), schema_,
+                                       import_times_[i]));
+  }
+  cached_slices_.resize(import_times_.size());
+  return {};
+}
+
+generator<table_slice> passive_parquet_store::slices() const {
+  auto offset = id{};
+  for (auto i = 0; i < reader_->num_row_groups(); ++i) {
+    const auto& slice = slice_at(i, offset);
+    co_yield slice;
+    offset += slice.rows();
+  }
+}
+
+generator<table_slice> passive_parquet_store::extract(
+  expression expr, ids selection,
+  std::optional<std::vector<std::string>> fields) const {
+  // Determine which top-level fields we need to read: the ones we need to
+  // return, and the ones we need for evaluating the expression.
+  auto columns = std::vector<offset>{};
+  auto included = std::vector<int>{};
+  if (fields) {
+    columns = project_columns(schema_, *fields);
+  }
+  if (not columns.empty()) {
+    for (const auto& column : columns) {
+      included.push_back(detail::narrow_cast<int>(column[0]));
+    }
+    for (const auto& column : expression_columns(schema_, expr)) {
+      included.push_back(detail::narrow_cast<int>(column[0]));
+    }
+    std::sort(included.begin(), included.end());
+    included.erase(std::unique(included.begin(), included.end()),
+                   included.end());
+    if (detail::narrow_cast<int>(included.size())
+        == arrow_schema_->num_fields()) {
+      included.clear();
+    }
+  }
+  return extract_row_groups(std::move(expr), std::move(selection),
+                            std::move(columns), std::move(included));
+}
+
+uint64_t passive_parquet_store::num_events() const {
+  return detail::narrow_cast<uint64_t>(
+    reader_->parquet_reader()->metadata()->num_rows());
+}
+
+type passive_parquet_store::schema() const {
+  return schema_;
+}
+
+auto passive_parquet_store::slice_at(int index, id offset) const
+  -> const table_slice& {
+  auto& slice = cached_slices_[index];
+  if (slice.rows() == 0) {
+    slice = read_row_group(index, {}, arrow_schema_, schema_);
+    slice.offset(offset);
+  }
+  TENZIR_ASSERT(offset == slice.offset());
+  return slice;
+}
+
+auto passive_parquet_store::read_row_group(
+  int index, const std::vector<int>& included,
+  const std::shared_ptr<arrow::Schema>& arrow_schema, const type& schema) const
+  -> table_slice {
+  auto table = std::shared_ptr<arrow::Table>{};
+  auto status = arrow::Status{};
+  if (included.empty()) {
+    status = reader_->ReadRowGroup(index, &table);
+  } else {
+    auto column_indices = std::vector<int>{};
+    for (auto field : included) {
+      collect_column_indices(reader_->manifest().schema_fields[field],
+                             column_indices);
+    }
+    status = reader_->ReadRowGroup(index, column_indices, &table);
+  }
+  if (not status.ok()) {
+    die(fmt::format("failed to read row group {} of parquet store: {}", index,
+                    status.ToString()));
+  }
+  auto batch = table->CombineChunksToBatch().ValueOrDie();
+  TENZIR_ASSERT(batch->num_columns() == arrow_schema->num_fields());
+  auto slice = table_slice{
+    arrow::RecordBatch::Make(arrow_schema, batch->num_rows(), batch->columns()),
+    schema,
+  };
+  slice.import_time(import_times_[index]);
+  return slice;
+}
+
+auto passive_parquet_store::extract_row_groups(expression expr, ids selection,
+                                               std::vector<offset> columns,
+                                               std::vector<int> included) const
+  -> generator<table_slice> {
+  auto projected_arrow_schema = arrow_schema_;
+  auto projected_schema = schema_;
+  auto projected_expr = expr;
+  if (not included.empty()) {
+    auto fields = arrow::FieldVector{};
+    fields.reserve(included.size());
+    for (auto field : included) {
+      fields.push_back(arrow_schema_->field(field));
+    }
+    projected_arrow_schema
+      = arrow::schema(std::move(fields), arrow_schema_->metadata());
+    projected_schema = type::from_arrow(*projected_arrow_schema);
+    // The expression and the columns refer to the full schema, but the
+    // projected row groups contain only the included top-level fields.
+    projected_expr
+      = project_expression(expr, schema_, projected_schema, included);
+    for (auto& column : columns) {
+      column = project_offset(std::move(column), included);
+    }
+  }
+  auto offset = id{};
+  auto programs = evaluation_program_cache{projected_expr};
+  for (auto i = 0; i < reader_->num_row_groups(); ++i) {
+    const auto& zone_map = zone_maps_[i];
+    const auto begin = offset;
+    offset += zone_map.rows;
+    if (not zone_map.may_match(expr)) {
+      continue;
+    }
+    auto slice = included.empty()
+                   ? slice_at(i, begin)
+                   : read_row_group(i, included, projected_arrow_schema,
+                                    projected_schema);
+    TENZIR_ASSERT(slice.rows() == zone_map.rows);
+    slice.offset(begin);
+    const auto* program = programs.get(slice.schema());
+    if (not program) {
+      continue;
+    }
+    auto filtered_slice = filter(slice, *program, selection);
+    if (not filtered_slice) {
+      continue;
+    }
+    if (not columns.empty()) {
+      *filtered_slice = select_columns(*filtered_slice, columns);
+    }
+    co_yield std::move(*filtered_slice);
+  }
+}
+
+// -- active store ------------------------------------------------------------
+
+active_parquet_store::active_parquet_store(store_options options)
+  : options_{options} {
+}
+
+caf::error active_parquet_store::add(std::vector<table_slice> new_slices) {
+  new_slices_.reserve(new_slices.size() + new_slices_.size());
+  for (auto& slice : new_slices) {
+    if (slice.offset() == invalid_id) {
+      slice.offset(num_events_);
+    }
+    TENZIR_ASSERT(slice.offset() == num_events_);
+    num_events_ += slice.rows();
+    num_new_events_ += slice.rows();
+    new_slices_.push_back(std::move(slice));
+  }
+  // Every rebatched slice becomes exactly one row group.
+  while (num_new_events_ >= options_.row_group_size) {
+    auto [lhs, rhs] = split(new_slices_, options_.row_group_size);
+    rebatched_slices_.push_back(concatenate(std::move(lhs)));
+    new_slices_ = std::move(rhs);
+    num_new_events_ -= options_.row_group_size;
+  }
+  TENZIR_ASSERT(num_new_events_ == rows(new_slices_));
+  return {};
+}
+
+caf::expected<chunk_ptr> active_parquet_store::finish() {
+  if (num_new_events_ > 0) {
+    rebatched_slices_.push_back(concatenate(std::exchange(new_slices_, {})));
+  }
+  if (rebatched_slices_.empty()) {
+    return caf::make_error(ec::logic_error, "cannot persist empty store");
+  }
+  // Parquet has no per-row-group metadata that the Arrow API exposes, so we
+  // store the import times of all row groups in the schema metadata.
+  auto import_times = std::string{};
+  for (const auto& slice : rebatched_slices_) {
+    if (not import_times.empty()) {
+      import_times.push_back(',');
+    }
+    fmt::format_to(std::back_inserter(import_times), "{}",
+                   slice.import_time().time_since_epoch().count());
+  }
+  auto schema = to_record_batch(rebatched_slices_.front())->schema();
+  auto schema_metadata
+    = schema->metadata() ? schema->metadata()->Copy()
+                         : std::make_shared<arrow::KeyValueMetadata>();
+  schema_metadata->Append(std::string{import_times_key},
+                          std::move(import_times));
+  schema = schema->WithMetadata(std::move(schema_metadata));
+  auto writer_properties_builder = ::parquet::WriterProperties::Builder{};
+  writer_properties_builder.version(::parquet::ParquetVersion::PARQUET_2_6)
+    ->compression(arrow::Compression::ZSTD)
+    ->compression_level(options_.zstd_compression_level)
+    ->max_row_group_length(
+      detail::narrow_cast<int64_t>(options_.row_group_size))
+    ->enable_statistics()
+    ->enable_write_page_index();
+  if (options_.dictionary_encoding) {
+    writer_properties_builder.enable_dictionary();
+  } else {
+    writer_properties_builder.disable_dictionary();
+  }
+  auto arrow_writer_properties
+    = ::parquet::ArrowWriterProperties::Builder().store_schema()->build();
+  auto output_stream = arrow::io::BufferOutputStream::Create().ValueOrDie();
+  auto writer = ::parquet::arrow::FileWriter::Open(
+    *schema, arrow::default_memory_pool(), output_stream,
+    writer_properties_builder.build(), std::move(arrow_writer_properties));
+  if (not writer.ok()) {
+    return caf::make_error(ec::system_error, writer.status().ToString());
+  }
+  for (const auto& slice : rebatched_slices_) {
+    auto table = arrow::Table::FromRecordBatches(schema,
+                                                 {to_record_batch(slice)});
+    if (not table.ok()) {
+      return caf::make_error(ec::system_error, table.status().ToString());
+    }
+    const auto write_status = (*writer)->WriteTable(
+      **table, detail::narrow_cast<int64_t>(options_.row_group_size));
+    if (not write_status.ok()) {
+      return caf::make_error(ec::system_error, write_status.ToString());
+    }
+  }
+  if (auto close_status = (*writer)->Close(); not close_status.ok()) {
+    return caf::make_error(ec::system_error, close_status.ToString());
+  }
+  auto buffer = output_stream->Finish();
+  if (not buffer.ok()) {
+    return caf::make_error(ec::system_error, buffer.status().ToString());
+  }
+  return chunk::make(buffer.MoveValueUnsafe());
+}
+
+generator<table_slice> active_parquet_store::slices() const {
+  // We need to make a copy of the slices here because the slices_ vector
+  // may get invalidated while we iterate over it.
+  auto rebatched_slices = rebatched_slices_;
+  auto new_slices = new_slices_;
+  for (auto& slice : rebatched_slices) {
+    co_yield std::move(slice);
+  }
+  for (auto& slice : new_slices) {
+    co_yield std::move(slice);
+  }
+}
+
+uint64_t active_parquet_store::num_events() const {
+  return num_events_;
+}
+
+} // namespace tenzir::plugins::parquet
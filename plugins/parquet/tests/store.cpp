@@ -0,0 +1,243 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2024 The Tenzir Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "parquet/store.hpp"
+
+#include <tenzir/data.hpp>
+#include <tenzir/expression.hpp>
+#include <tenzir/ids.hpp>
+#include <tenzir/series_builder.hpp>
+#include <tenzir/table_slice.hpp>
+#include <tenzir/test/test.hpp>
+#include <tenzir/type.hpp>
+
+#include <fmt/format.h>
+
+#include <chrono>
+#include <optional>
+#include <string>
+#include <vector>
+
+using namespace tenzir;
+using namespace tenzir::plugins::parquet;
+using namespace std::chrono_literals;
+
+namespace {
+
+/// Creates a slice with *rows* events of various types, where the field `a`
+/// counts up from *first*. Every third event has nulls in all fields but `a`.
+auto make_slice(int64_t first, int64_t rows, time import_time) -> table_slice {
+  auto b = series_builder{};
+  for (auto a = first; a < first + rows; ++a) {
+    auto r = b.record();
+    r.field("a", a);
+    if (a % 3 == 0) {
+      r.field("b").null();
+      r.field("c").null();
+      r.field("r").record().field("d").null();
+      r.field("l").null();
+      continue;
+    }
+    r.field("b", fmt::format("b{}", a));
+    r.field("c", static_cast<uint64_t>(a * 2));
+    auto nested = r.field("r").record();
+    nested.field("d", static_cast<double>(a) / 2);
+    nested.field("t", time{std::chrono::seconds{a}});
+    nested.field("u", duration{std::chrono::milliseconds{a}});
+    auto l = r.field("l").list();
+    l.data(a);
+    l.data(-a);
+  }
+  auto result = b.finish_assert_one_slice("tenzir.test");
+  result.import_time(import_time);
+  return result;
+}
+
+/// Returns the values of all leaf columns of every event.
+auto rows(const std::vector<table_slice>& slices)
+  -> std::vector<std::vector<data>> {
+  auto result = std::vector<std::vector<data>>{};
+  for (const auto& slice : slices) {
+    for (auto row = size_t{0}; row < slice.rows(); ++row) {
+      auto& values = result.emplace_back();
+      for (auto col = size_t{0}; col < slice.columns(); ++col) {
+        values.push_back(materialize(slice.at(row, col)));
+      }
+    }
+  }
+  return result;
+}
+
+auto field_names(const table_slice& slice) -> std::vector<std::string> {
+  auto result = std::vector<std::string>{};
+  for (const auto& field : caf::get<record_type>(slice.schema()).fields()) {
+    result.emplace_back(field.name);
+  }
+  return result;
+}
+
+auto a_at_least(int64_t x) -> expression {
+  return expression{predicate{field_extractor{"a"},
+                              relational_operator::greater_equal, data{x}}};
+}
+
+struct fixture {
+  fixture() {
+    input.push_back(make_slice(0, 10, time{1s}));
+    input.push_back(make_slice(10, 10, time{2s}));
+    input.push_back(make_slice(20, 10, time{3s}));
+  }
+
+  /// Writes the input to a store with the given row group size, and loads it
+  /// again.
+  void round_trip(uint64_t row_group_size) {
+    auto active = active_parquet_store{store_options{
+      .row_group_size = row_group_size,
+    }};
+    REQUIRE_EQUAL(active.add(input), caf::error{});
+    CHECK_EQUAL(active.num_events(), 30u);
+    auto chunk = active.finish();
+    REQUIRE_NOERROR(chunk);
+    store.emplace();
+    REQUIRE_EQUAL(store->load(std::move(*chunk)), caf::error{});
+  }
+
+  /// Runs an extract query, tailoring the expression to the store's schema.
+  auto extract(const expression& expr,
+               std::optional<std::vector<std::string>> fields = std::nullopt)
+    -> std::vector<table_slice> {
+    auto tailored = tailor(expr, store->schema());
+    REQUIRE_NOERROR(tailored);
+    auto result = std::vector<table_slice>{};
+    for (auto&& slice : store->extract(*tailored, ids{}, std::move(fields))) {
+      result.push_back(std::move(slice));
+    }
+    return result;
+  }
+
+  /// Returns the rows of the input that satisfy the predicate.
+  auto expected_rows(auto predicate) const -> std::vector<std::vector<data>> {
+    auto result = std::vector<std::vector<data>>{};
+    for (auto& row : rows(input)) {
+      if (predicate(caf::get<int64_t>(row[0]))) {
+        result.push_back(std::move(row));
+      }
+    }
+    return result;
+  }
+
+  std::vector<table_slice> input = {};
+  std::optional<passive_parquet_store> store = {};
+};
+
+} // namespace
+
+FIXTURE_SCOPE(parquet_store_tests, fixture)
+
+TEST(parquet store round-trip) {
+  round_trip(10);
+  CHECK_EQUAL(store->num_events(), 30u);
+  CHECK_EQUAL(store->schema(), input[0].schema());
+  // Every input slice becomes a row group of its own, and keeps its import
+  // time and offset.
+  auto output = std::vector<table_slice>{};
+  for (const auto& slice : store->slices()) {
+    output.push_back(slice);
+  }
+  REQUIRE_EQUAL(output.size(), input.size());
+  for (auto i = size_t{0}; i < output.size(); ++i) {
+    CHECK_EQUAL(output[i].schema(), input[i].schema());
+    CHECK_EQUAL(output[i].import_time(), input[i].import_time());
+    CHECK_EQUAL(output[i].offset(), i * 10);
+  }
+  CHECK_EQUAL(rows(output), rows(input));
+  CHECK_EQUAL(rows(extract(trivially_true_expression())), rows(input));
+}
+
+TEST(parquet store round-trip with row groups across slices) {
+  round_trip(7);
+  auto output = std::vector<table_slice>{};
+  for (const auto& slice : store->slices()) {
+    output.push_back(slice);
+  }
+  REQUIRE_EQUAL(output.size(), 5u);
+  auto offset = id{0};
+  for (const auto& slice : output) {
+    CHECK_EQUAL(slice.offset(), offset);
+    offset += slice.rows();
+  }
+  CHECK_EQUAL(output.back().rows(), 2u);
+  CHECK_EQUAL(rows(output), rows(input));
+}
+
+TEST(parquet store extract with row group statistics) {
+  // The row group statistics allow for skipping row groups, which must not
+  // change the results.
+  round_trip(10);
+  for (auto x : {int64_t{-1}, int64_t{0}, int64_t{9}, int64_t{10},
+                 int64_t{25}, int64_t{29}, int64_t{30}}) {
+    auto output = extract(a_at_least(x));
+    CHECK_EQUAL(rows(output), expected_rows([&](int64_t a) {
+                  return a >= x;
+                }));
+  }
+}
+
+TEST(parquet store projection) {
+  round_trip(10);
+  auto output = extract(trivially_true_expression(),
+                        std::vector<std::string>{"b"});
+  REQUIRE(not output.empty());
+  auto expected = std::vector<std::vector<data>>{};
+  for (const auto& row : rows(input)) {
+    expected.push_back({row[1]});
+  }
+  for (const auto& slice : output) {
+    CHECK_EQUAL(field_names(slice), std::vector<std::string>{"b"});
+  }
+  CHECK_EQUAL(rows(output), expected);
+}
+
+TEST(parquet store projection with a filter on another field) {
+  round_trip(10);
+  // The expression accesses `a`, which the store must read even though the
+  // results contain only the nested record `r`.
+  auto output = extract(a_at_least(15), std::vector<std::string>{"r.t"});
+  auto expected = std::vector<std::vector<data>>{};
+  for (const auto& row : expected_rows([](int64_t a) {
+         return a >= 15;
+       })) {
+    expected.push_back({row[3], row[4], row[5]});
+  }
+  for (const auto& slice : output) {
+    CHECK_EQUAL(field_names(slice), std::vector<std::string>{"r"});
+  }
+  CHECK_EQUAL(rows(output), expected);
+}
+
+TEST(parquet store projection with a filter on a nested field) {
+  round_trip(10);
+  // The store reads only `a` and `r`, so it must evaluate the expression for
+  // `r.d` against the projected schema. Events with a null `r.d` never match.
+  auto expr = expression{predicate{field_extractor{"r.d"},
+                                   relational_operator::less, data{5.0}}};
+  auto output = extract(expr, std::vector<std::string>{"a"});
+  REQUIRE(not output.empty());
+  const auto expected_schema
+    = type{"tenzir.test", record_type{{"a", int64_type{}}}};
+  for (const auto& slice : output) {
+    CHECK_EQUAL(slice.schema(), expected_schema);
+  }
+  auto expected = std::vector<std::vector<data>>{};
+  for (auto a : {1, 2, 4, 5, 7, 8}) {
+    expected.push_back({data{int64_t{a}}});
+  }
+  CHECK_EQUAL(rows(output), expected);
+}
+
+FIXTURE_SCOPE_END()